@@ -0,0 +1,119 @@
+#include "common/cd_image.h"
+#include "common/cd_xa.h"
+#include "common/timer.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using SectorBuffer = std::array<u8, CDImage::RAW_SECTOR_SIZE>;
+using SampleBuffer = std::array<s16, CDXA::XA_ADPCM_SAMPLES_PER_SECTOR_4BIT>;
+
+static SectorBuffer GenerateSector(std::mt19937& rng, bool stereo, bool eight_bit)
+{
+  SectorBuffer sector;
+  for (u8& byte : sector)
+    byte = static_cast<u8>(rng());
+
+  CDXA::XASubHeader subheader = {};
+  subheader.submode.audio = true;
+  subheader.codinginfo.mono_stereo = stereo ? 1 : 0;
+  subheader.codinginfo.bits_per_sample = eight_bit ? 1 : 0;
+  std::memcpy(&sector[CDImage::SECTOR_SYNC_SIZE + sizeof(CDImage::SectorHeader)], &subheader, sizeof(subheader));
+  return sector;
+}
+
+static void TestDecoderMatchesScalar(bool stereo, bool eight_bit)
+{
+  static constexpr u32 NUM_SECTORS = 256;
+
+  std::mt19937 rng(stereo * 2 + eight_bit);
+  std::array<s32, 4> scalar_last_samples = {};
+  std::array<s32, 4> vector_last_samples = {};
+
+  // run a stream of sectors through both decoders, so the filter state carries across sectors
+  for (u32 i = 0; i < NUM_SECTORS; i++)
+  {
+    const SectorBuffer sector = GenerateSector(rng, stereo, eight_bit);
+    SampleBuffer scalar_samples = {};
+    SampleBuffer vector_samples = {};
+    CDXA::DecodeADPCMSectorScalar(sector.data(), scalar_samples.data(), scalar_last_samples.data());
+    CDXA::DecodeADPCMSector(sector.data(), vector_samples.data(), vector_last_samples.data());
+
+    ASSERT_EQ(scalar_samples, vector_samples) << "sector " << i;
+    ASSERT_EQ(scalar_last_samples, vector_last_samples) << "sector " << i;
+  }
+}
+
+TEST(CDXA, Mono4BitMatchesScalar)
+{
+  TestDecoderMatchesScalar(false, false);
+}
+
+TEST(CDXA, Stereo4BitMatchesScalar)
+{
+  TestDecoderMatchesScalar(true, false);
+}
+
+TEST(CDXA, Mono8BitMatchesScalar)
+{
+  TestDecoderMatchesScalar(false, true);
+}
+
+TEST(CDXA, Stereo8BitMatchesScalar)
+{
+  TestDecoderMatchesScalar(true, true);
+}
+
+TEST(CDXA, FilterStateSaturates)
+{
+  // large filter state pushes the intermediate values well outside 16 bits, the output has to clamp identically
+  std::mt19937 rng(1234);
+  for (const bool stereo : {false, true})
+  {
+    const SectorBuffer sector = GenerateSector(rng, stereo, false);
+    std::array<s32, 4> scalar_last_samples = {0x7FFFFF, -0x7FFFFF, -0x7FFFFF, 0x7FFFFF};
+    std::array<s32, 4> vector_last_samples = scalar_last_samples;
+    SampleBuffer scalar_samples = {};
+    SampleBuffer vector_samples = {};
+    CDXA::DecodeADPCMSectorScalar(sector.data(), scalar_samples.data(), scalar_last_samples.data());
+    CDXA::DecodeADPCMSector(sector.data(), vector_samples.data(), vector_last_samples.data());
+    ASSERT_EQ(scalar_samples, vector_samples);
+    ASSERT_EQ(scalar_last_samples, vector_last_samples);
+  }
+}
+
+// Run with --gtest_also_run_disabled_tests to compare decoder throughput.
+TEST(CDXA, DISABLED_Benchmark)
+{
+  static constexpr u32 NUM_SECTORS = 64;
+  static constexpr u32 ITERATIONS = 200;
+
+  std::mt19937 rng(5678);
+  std::vector<SectorBuffer> sectors;
+  for (u32 i = 0; i < NUM_SECTORS; i++)
+    sectors.push_back(GenerateSector(rng, (i & 1) != 0, false));
+
+  SampleBuffer samples;
+  std::array<s32, 4> last_samples = {};
+  for (const bool scalar : {true, false})
+  {
+    Common::Timer timer;
+    for (u32 iteration = 0; iteration < ITERATIONS; iteration++)
+    {
+      for (const SectorBuffer& sector : sectors)
+      {
+        if (scalar)
+          CDXA::DecodeADPCMSectorScalar(sector.data(), samples.data(), last_samples.data());
+        else
+          CDXA::DecodeADPCMSector(sector.data(), samples.data(), last_samples.data());
+      }
+    }
+
+    const double time = timer.GetTimeMilliseconds();
+    std::printf("%s: %.2f ms for %u sectors, %.0f sectors/sec\n", scalar ? "Scalar" : "Vector", time,
+                NUM_SECTORS * ITERATIONS, (NUM_SECTORS * ITERATIONS) / (time / 1000.0));
+  }
+}
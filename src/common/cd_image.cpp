@@ -260,6 +260,11 @@ bool CDImage::HasNonStandardSubchannel() const
   return false;
 }
 
+bool CDImage::Precache()
+{
+  return false;
+}
+
 const CDImage::Index* CDImage::GetIndexForDiscPosition(LBA pos)
 {
   for (const Index& index : m_indices)
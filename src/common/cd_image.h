@@ -245,6 +245,11 @@ public:
   // Returns true if the image has replacement subchannel data.
   virtual bool HasNonStandardSubchannel() const;
 
+  // Hints that the whole image is going to be read, and starts pulling it into memory in the background. Images which
+  // can be memory mapped are mapped here and return true, in which case there is no need to copy the image to memory.
+  // Otherwise sectors are read from the file.
+  virtual bool Precache();
+
   // Reads a single sector from an index.
   virtual bool ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index) = 0;
 
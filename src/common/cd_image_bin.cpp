@@ -2,7 +2,9 @@
 #include "cd_subchannel_replacement.h"
 #include "file_system.h"
 #include "log.h"
+#include "mapped_file.h"
 #include <cerrno>
+#include <cstring>
 Log_SetChannel(CDImageBin);
 
 class CDImageBin : public CDImage
@@ -15,6 +17,7 @@ public:
 
   bool ReadSubChannelQ(SubChannelQ* subq) override;
   bool HasNonStandardSubchannel() const override;
+  bool Precache() override;
 
 protected:
   bool ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index) override;
@@ -23,6 +26,9 @@ private:
   std::FILE* m_fp = nullptr;
   u64 m_file_position = 0;
 
+  // only mapped by Precache(), since an I/O error on a mapping can't be handled like a failed read
+  Common::MappedFile m_mapping;
+
   CDSubChannelReplacement m_sbi;
 };
 
@@ -109,9 +115,35 @@ bool CDImageBin::HasNonStandardSubchannel() const
   return (m_sbi.GetReplacementSectorCount() > 0);
 }
 
+bool CDImageBin::Precache()
+{
+  if (!m_mapping.IsOpen())
+  {
+    if (!m_mapping.Open(m_filename.c_str()))
+    {
+      Log_WarningPrintf("Failed to map binfile '%s'", m_filename.c_str());
+      return false;
+    }
+
+    m_mapping.SetAccessPattern(Common::MappedFile::AccessPattern::Sequential);
+  }
+
+  m_mapping.Prefetch();
+  return true;
+}
+
 bool CDImageBin::ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index)
 {
   const u64 file_position = index.file_offset + (static_cast<u64>(lba_in_index) * index.file_sector_size);
+  if (m_mapping.IsOpen())
+  {
+    if ((file_position + index.file_sector_size) > m_mapping.GetSize())
+      return false;
+
+    std::memcpy(buffer, m_mapping.GetData() + file_position, index.file_sector_size);
+    return true;
+  }
+
   if (m_file_position != file_position)
   {
     if (std::fseek(m_fp, static_cast<long>(file_position), SEEK_SET) != 0)
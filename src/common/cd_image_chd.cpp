@@ -12,10 +12,15 @@
 #include "log.h"
 #include <algorithm>
 #include <cerrno>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <optional>
+#include <thread>
+#include <unordered_map>
 Log_SetChannel(CDImageCHD);
 
 static std::optional<CDImage::TrackMode> ParseTrackModeString(const char* str)
@@ -58,18 +63,65 @@ private:
   enum : u32
   {
     CHD_CD_SECTOR_DATA_SIZE = 2352 + 96,
-    CHD_CD_TRACK_ALIGNMENT = 4
+    CHD_CD_TRACK_ALIGNMENT = 4,
+    HUNK_CACHE_SIZE = 4 * 1024 * 1024,
+    PREFETCH_HUNK_COUNT = 4,
+    MAX_PREFETCH_THREADS = 2,
+    PREFETCH_START_MISSES = 16,
+    INVALID_HUNK_INDEX = 0xFFFFFFFFu
   };
 
-  bool ReadHunk(u32 hunk_index);
+  struct CachedHunk
+  {
+    u32 hunk_index = INVALID_HUNK_INDEX;
+    u64 last_used = 0;
+    std::vector<u8> data;
+  };
+
+  /// Each prefetch thread needs its own handle, as chd_file isn't thread safe.
+  struct PrefetchThread
+  {
+    std::FILE* fp = nullptr;
+    chd_file* chd = nullptr;
+    std::vector<u8> buffer;
+    std::thread thread;
+  };
 
+  /// Returns the cached copy of the hunk, decompressing it if needed. The cache lock must be held.
+  const CachedHunk* GetHunk(u32 hunk_index, std::unique_lock<std::mutex>& lock);
+
+  /// Moves a decompressed hunk into the cache, evicting the least recently used hunk. The cache lock must be held.
+  void InsertHunk(u32 hunk_index, std::vector<u8>* buffer);
+
+  bool IsHunkQueuedOrInFlight(u32 hunk_index) const;
+  void QueuePrefetch(u32 hunk_index);
+  void StartPrefetchThreads();
+  void StopPrefetchThreads();
+  void PrefetchThreadEntryPoint(PrefetchThread* pt);
+
+  std::string m_open_filename;
   std::FILE* m_fp = nullptr;
   chd_file* m_chd = nullptr;
   u32 m_hunk_size = 0;
+  u32 m_hunk_count = 0;
   u32 m_sectors_per_hunk = 0;
 
+  // LRU cache of decompressed hunks, shared with the prefetch threads
+  std::mutex m_cache_mutex;
+  std::vector<CachedHunk> m_hunk_cache;
+  std::unordered_map<u32, u32> m_hunk_cache_map;
   std::vector<u8> m_hunk_buffer;
-  u32 m_current_hunk_index = static_cast<u32>(-1);
+  u64 m_hunk_use_counter = 0;
+  u32 m_last_hunk_index = INVALID_HUNK_INDEX;
+  u32 m_cache_misses = 0;
+
+  std::vector<std::unique_ptr<PrefetchThread>> m_prefetch_threads;
+  std::condition_variable m_prefetch_cv;
+  std::condition_variable m_prefetch_done_cv;
+  std::deque<u32> m_prefetch_queue;
+  std::vector<u32> m_prefetch_in_flight;
+  bool m_prefetch_started = false;
+  bool m_prefetch_shutdown = false;
 
   CDSubChannelReplacement m_sbi;
 };
@@ -78,6 +130,8 @@ CDImageCHD::CDImageCHD() = default;
 
 CDImageCHD::~CDImageCHD()
 {
+  StopPrefetchThreads();
+
   if (m_chd)
     chd_close(m_chd);
   if (m_fp)
@@ -110,7 +164,10 @@ bool CDImageCHD::Open(const char* filename)
   }
 
   m_sectors_per_hunk = m_hunk_size / CHD_CD_SECTOR_DATA_SIZE;
+  m_hunk_count = header->totalhunks;
   m_hunk_buffer.resize(m_hunk_size);
+  m_hunk_cache.resize(std::max<u32>(HUNK_CACHE_SIZE / m_hunk_size, PREFETCH_HUNK_COUNT * 2));
+  m_open_filename = filename;
   m_filename = filename;
 
   u32 disc_lba = 0;
@@ -315,32 +372,199 @@ bool CDImageCHD::ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_i
   const u32 hunk_offset = static_cast<u32>((disc_frame % m_sectors_per_hunk) * CHD_CD_SECTOR_DATA_SIZE);
   DebugAssert((m_hunk_size - hunk_offset) >= CHD_CD_SECTOR_DATA_SIZE);
 
-  if (m_current_hunk_index != hunk_index && !ReadHunk(hunk_index))
+  std::unique_lock<std::mutex> lock(m_cache_mutex);
+  const CachedHunk* hunk = GetHunk(hunk_index, lock);
+  if (!hunk)
     return false;
 
   // Audio data is in big-endian, so we have to swap it for little endian hosts...
   if (index.mode == TrackMode::Audio)
-    CopyAndSwap(buffer, &m_hunk_buffer[hunk_offset], RAW_SECTOR_SIZE);
+    CopyAndSwap(buffer, &hunk->data[hunk_offset], RAW_SECTOR_SIZE);
   else
-    std::memcpy(buffer, &m_hunk_buffer[hunk_offset], RAW_SECTOR_SIZE);
+    std::memcpy(buffer, &hunk->data[hunk_offset], RAW_SECTOR_SIZE);
+
+  // get the following hunks decompressing while the current one is consumed
+  if (hunk_index != m_last_hunk_index)
+  {
+    m_last_hunk_index = hunk_index;
+    if (!m_prefetch_threads.empty())
+    {
+      // anything still queued from the previous position is no longer useful
+      m_prefetch_queue.clear();
+      for (u32 i = 1; i <= PREFETCH_HUNK_COUNT; i++)
+        QueuePrefetch(hunk_index + i);
+    }
+  }
 
   return true;
 }
 
-bool CDImageCHD::ReadHunk(u32 hunk_index)
+const CDImageCHD::CachedHunk* CDImageCHD::GetHunk(u32 hunk_index, std::unique_lock<std::mutex>& lock)
 {
+  for (;;)
+  {
+    auto iter = m_hunk_cache_map.find(hunk_index);
+    if (iter != m_hunk_cache_map.end())
+    {
+      CachedHunk& hunk = m_hunk_cache[iter->second];
+      hunk.last_used = ++m_hunk_use_counter;
+      return &hunk;
+    }
+
+    // don't decompress the same hunk twice if a prefetch thread is already working on it
+    if (std::find(m_prefetch_in_flight.begin(), m_prefetch_in_flight.end(), hunk_index) ==
+        m_prefetch_in_flight.end())
+    {
+      break;
+    }
+
+    m_prefetch_done_cv.wait(lock);
+  }
+
+  auto queue_iter = std::find(m_prefetch_queue.begin(), m_prefetch_queue.end(), hunk_index);
+  if (queue_iter != m_prefetch_queue.end())
+    m_prefetch_queue.erase(queue_iter);
+
+  // m_chd and m_hunk_buffer are only used by this thread, so the prefetch threads can keep going meanwhile
+  lock.unlock();
   const chd_error err = chd_read(m_chd, hunk_index, m_hunk_buffer.data());
+  lock.lock();
+
   if (err != CHDERR_NONE)
   {
     Log_ErrorPrintf("chd_read(%u) failed: %s", hunk_index, chd_error_string(err));
+    return nullptr;
+  }
 
-    // data might have been partially written
-    m_current_hunk_index = static_cast<u32>(-1);
-    return false;
+  InsertHunk(hunk_index, &m_hunk_buffer);
+
+  // only spin up the prefetch threads once the image is being read from, not just probed for metadata
+  if (!m_prefetch_started && ++m_cache_misses >= PREFETCH_START_MISSES)
+    StartPrefetchThreads();
+
+  return &m_hunk_cache[m_hunk_cache_map[hunk_index]];
+}
+
+void CDImageCHD::InsertHunk(u32 hunk_index, std::vector<u8>* buffer)
+{
+  u32 slot = 0;
+  for (u32 i = 0; i < static_cast<u32>(m_hunk_cache.size()); i++)
+  {
+    if (m_hunk_cache[i].last_used < m_hunk_cache[slot].last_used)
+      slot = i;
   }
 
-  m_current_hunk_index = hunk_index;
-  return true;
+  CachedHunk& hunk = m_hunk_cache[slot];
+  if (hunk.hunk_index != INVALID_HUNK_INDEX)
+    m_hunk_cache_map.erase(hunk.hunk_index);
+
+  // the evicted hunk's memory becomes the caller's next decompression buffer
+  hunk.data.swap(*buffer);
+  if (buffer->size() != m_hunk_size)
+    buffer->resize(m_hunk_size);
+
+  hunk.hunk_index = hunk_index;
+  hunk.last_used = ++m_hunk_use_counter;
+  m_hunk_cache_map[hunk_index] = slot;
+}
+
+bool CDImageCHD::IsHunkQueuedOrInFlight(u32 hunk_index) const
+{
+  return (std::find(m_prefetch_queue.begin(), m_prefetch_queue.end(), hunk_index) != m_prefetch_queue.end() ||
+          std::find(m_prefetch_in_flight.begin(), m_prefetch_in_flight.end(), hunk_index) !=
+            m_prefetch_in_flight.end());
+}
+
+void CDImageCHD::QueuePrefetch(u32 hunk_index)
+{
+  if (hunk_index >= m_hunk_count || m_hunk_cache_map.find(hunk_index) != m_hunk_cache_map.end() ||
+      IsHunkQueuedOrInFlight(hunk_index))
+  {
+    return;
+  }
+
+  m_prefetch_queue.push_back(hunk_index);
+  m_prefetch_cv.notify_one();
+}
+
+void CDImageCHD::StartPrefetchThreads()
+{
+  m_prefetch_started = true;
+
+  // leave a core for the emulator itself
+  const u32 num_cpus = std::max<u32>(std::thread::hardware_concurrency(), 1);
+  const u32 num_threads = std::min<u32>(num_cpus - 1, MAX_PREFETCH_THREADS);
+  for (u32 i = 0; i < num_threads; i++)
+  {
+    std::unique_ptr<PrefetchThread> pt = std::make_unique<PrefetchThread>();
+    pt->fp = FileSystem::OpenCFile(m_open_filename.c_str(), "rb");
+    if (!pt->fp)
+    {
+      Log_WarningPrintf("Failed to reopen CHD '%s' for prefetching: errno %d", m_open_filename.c_str(), errno);
+      break;
+    }
+
+    const chd_error err = chd_open_file(pt->fp, CHD_OPEN_READ, nullptr, &pt->chd);
+    if (err != CHDERR_NONE)
+    {
+      Log_WarningPrintf("Failed to reopen CHD '%s' for prefetching: %s", m_open_filename.c_str(),
+                        chd_error_string(err));
+      std::fclose(pt->fp);
+      break;
+    }
+
+    pt->buffer.resize(m_hunk_size);
+    pt->thread = std::thread(&CDImageCHD::PrefetchThreadEntryPoint, this, pt.get());
+    m_prefetch_threads.push_back(std::move(pt));
+  }
+
+  Log_DevPrintf("Started %u CHD prefetch threads", static_cast<u32>(m_prefetch_threads.size()));
+}
+
+void CDImageCHD::StopPrefetchThreads()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_cache_mutex);
+    m_prefetch_shutdown = true;
+    m_prefetch_queue.clear();
+    m_prefetch_cv.notify_all();
+  }
+
+  for (std::unique_ptr<PrefetchThread>& pt : m_prefetch_threads)
+  {
+    pt->thread.join();
+    chd_close(pt->chd);
+    std::fclose(pt->fp);
+  }
+
+  m_prefetch_threads.clear();
+}
+
+void CDImageCHD::PrefetchThreadEntryPoint(PrefetchThread* pt)
+{
+  std::unique_lock<std::mutex> lock(m_cache_mutex);
+  for (;;)
+  {
+    m_prefetch_cv.wait(lock, [this]() { return (m_prefetch_shutdown || !m_prefetch_queue.empty()); });
+    if (m_prefetch_shutdown)
+      break;
+
+    const u32 hunk_index = m_prefetch_queue.front();
+    m_prefetch_queue.pop_front();
+    m_prefetch_in_flight.push_back(hunk_index);
+    lock.unlock();
+
+    const chd_error err = chd_read(pt->chd, hunk_index, pt->buffer.data());
+
+    lock.lock();
+    m_prefetch_in_flight.erase(std::find(m_prefetch_in_flight.begin(), m_prefetch_in_flight.end(), hunk_index));
+    if (err == CHDERR_NONE)
+      InsertHunk(hunk_index, &pt->buffer);
+    else
+      Log_WarningPrintf("Prefetch of hunk %u failed: %s", hunk_index, chd_error_string(err));
+
+    m_prefetch_done_cv.notify_all();
+  }
 }
 
 std::unique_ptr<CDImage> CDImage::OpenCHDImage(const char* filename)
@@ -3,10 +3,13 @@
 #include "cd_subchannel_replacement.h"
 #include "file_system.h"
 #include "log.h"
+#include "mapped_file.h"
 #include <algorithm>
 #include <cerrno>
+#include <cstring>
 #include <libcue/libcue.h>
 #include <map>
+#include <mutex>
 Log_SetChannel(CDImageCueSheet);
 
 class CDImageCueSheet : public CDImage
@@ -19,6 +22,7 @@ public:
 
   bool ReadSubChannelQ(SubChannelQ* subq) override;
   bool HasNonStandardSubchannel() const override;
+  bool Precache() override;
 
 protected:
   bool ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index) override;
@@ -29,8 +33,12 @@ private:
   struct TrackFile
   {
     std::string filename;
+    std::string opened_filename;
     std::FILE* file;
     u64 file_position;
+
+    // only mapped by Precache(), since an I/O error on a mapping can't be handled like a failed read
+    Common::MappedFile mapping;
   };
 
   std::vector<TrackFile> m_files;
@@ -58,7 +66,12 @@ bool CDImageCueSheet::OpenAndParse(const char* filename)
   if (!cuesheet_string->empty() && cuesheet_string->at(cuesheet_string->size() - 1) != '\n')
     *cuesheet_string += '\n';
 
-  m_cd = cue_parse_string(cuesheet_string->c_str());
+  // libcue's parser keeps its state in globals, so images can't be parsed on multiple threads at once
+  {
+    static std::mutex s_cue_parse_mutex;
+    std::unique_lock<std::mutex> lock(s_cue_parse_mutex);
+    m_cd = cue_parse_string(cuesheet_string->c_str());
+  }
   if (!m_cd)
   {
     Log_ErrorPrintf("Failed to parse cuesheet '%s'", filename);
@@ -96,6 +109,7 @@ bool CDImageCueSheet::OpenAndParse(const char* filename)
     if (track_file_index == m_files.size())
     {
       const std::string track_full_filename(basepath + track_filename);
+      std::string track_opened_filename(track_full_filename);
       std::FILE* track_fp = FileSystem::OpenCFile(track_full_filename.c_str(), "rb");
       if (!track_fp && track_file_index == 0)
       {
@@ -105,6 +119,7 @@ bool CDImageCueSheet::OpenAndParse(const char* filename)
         track_fp = FileSystem::OpenCFile(alternative_filename.c_str(), "rb");
         if (track_fp)
         {
+          track_opened_filename = alternative_filename;
           Log_WarningPrintf("Your cue sheet references an invalid file '%s', but this was found at '%s' instead.",
                             track_filename.c_str(), alternative_filename.c_str());
         }
@@ -117,7 +132,11 @@ bool CDImageCueSheet::OpenAndParse(const char* filename)
         return false;
       }
 
-      m_files.push_back(TrackFile{std::move(track_filename), track_fp, 0});
+      TrackFile& tf = m_files.emplace_back();
+      tf.filename = std::move(track_filename);
+      tf.opened_filename = std::move(track_opened_filename);
+      tf.file = track_fp;
+      tf.file_position = 0;
     }
 
     // data type determines the sector size
@@ -266,12 +285,47 @@ bool CDImageCueSheet::HasNonStandardSubchannel() const
   return (m_sbi.GetReplacementSectorCount() > 0);
 }
 
+bool CDImageCueSheet::Precache()
+{
+  // only skip the copy to memory if every file can be mapped
+  for (TrackFile& t : m_files)
+  {
+    if (t.mapping.IsOpen())
+      continue;
+
+    if (!t.mapping.Open(t.opened_filename.c_str()))
+    {
+      Log_WarningPrintf("Failed to map track file '%s'", t.opened_filename.c_str());
+      for (TrackFile& ot : m_files)
+        ot.mapping.Close();
+
+      return false;
+    }
+
+    t.mapping.SetAccessPattern(Common::MappedFile::AccessPattern::Sequential);
+  }
+
+  for (TrackFile& t : m_files)
+    t.mapping.Prefetch();
+
+  return true;
+}
+
 bool CDImageCueSheet::ReadSectorFromIndex(void* buffer, const Index& index, LBA lba_in_index)
 {
   DebugAssert(index.file_index < m_files.size());
 
   TrackFile& tf = m_files[index.file_index];
   const u64 file_position = index.file_offset + (static_cast<u64>(lba_in_index) * index.file_sector_size);
+  if (tf.mapping.IsOpen())
+  {
+    if ((file_position + index.file_sector_size) > tf.mapping.GetSize())
+      return false;
+
+    std::memcpy(buffer, tf.mapping.GetData() + file_position, index.file_sector_size);
+    return true;
+  }
+
   if (tf.file_position != file_position)
   {
     if (std::fseek(tf.file, static_cast<long>(file_position), SEEK_SET) != 0)
@@ -1,74 +1,279 @@
 #include "cd_image_hasher.h"
 #include "cd_image.h"
+#include "cpu_detect.h"
 #include "md5_digest.h"
 #include "string_util.h"
+#include "xxhash.h"
+#if defined(CPU_X86) || defined(CPU_X64)
+#include "xxh_x86dispatch.h"
+#endif
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace CDImageHasher {
 
-static bool ReadIndex(CDImage* image, u8 track, u8 index, MD5Digest* digest, ProgressCallback* progress_callback)
+namespace {
+
+/// Streaming digest of either hash type.
+class Digest
 {
-  const CDImage::LBA index_start = image->GetTrackIndexPosition(track, index);
-  const u32 index_length = image->GetTrackIndexLength(track, index);
-  const u32 update_interval = std::max<u32>(index_length / 100u, 1u);
+public:
+  Digest(HashType type) : m_type(type)
+  {
+    if (m_type == HashType::XXH3)
+    {
+      m_xxh3_state = XXH3_createState();
+      XXH3_128bits_reset(m_xxh3_state);
+    }
+  }
 
-  progress_callback->SetFormattedStatusText("Computing hash for track %u/index %u...", track, index);
-  progress_callback->SetProgressRange(index_length);
+  ~Digest()
+  {
+    if (m_xxh3_state)
+      XXH3_freeState(m_xxh3_state);
+  }
 
-  if (!image->Seek(index_start))
+  Digest(const Digest&) = delete;
+  Digest& operator=(const Digest&) = delete;
+
+  void Update(const void* data, u32 size)
   {
-    progress_callback->DisplayFormattedModalError("Failed to seek to sector %u for track %u index %u", index_start,
-                                                  track, index);
-    return false;
+    if (m_type == HashType::XXH3)
+      XXH3_128bits_update(m_xxh3_state, data, size);
+    else
+      m_md5.Update(data, size);
+  }
+
+  void Final(Hash* hash)
+  {
+    if (m_type == HashType::XXH3)
+    {
+      XXH128_canonical_t canonical;
+      XXH128_canonicalFromHash(&canonical, XXH3_128bits_digest(m_xxh3_state));
+      static_assert(sizeof(canonical.digest) == sizeof(Hash), "hash is 128 bits");
+      std::copy(std::begin(canonical.digest), std::end(canonical.digest), hash->begin());
+    }
+    else
+    {
+      m_md5.Final(hash->data());
+    }
+  }
+
+private:
+  HashType m_type;
+  MD5Digest m_md5;
+  XXH3_state_t* m_xxh3_state = nullptr;
+};
+
+/// A run of sectors which is fed into one digest.
+struct Segment
+{
+  u32 digest_index;
+  CDImage::LBA start;
+  u32 length;
+  u8 track;
+  u8 index;
+};
+
+/// Reads sectors on the calling thread in large chunks, and hashes them on worker threads. Each digest is owned by a
+/// single worker so its chunks are hashed in order, but different digests (i.e. tracks) are hashed concurrently.
+class HashPipeline
+{
+public:
+  HashPipeline(HashType type, u32 num_digests);
+  ~HashPipeline();
+
+  bool Run(CDImage* image, const std::vector<Segment>& segments, ProgressCallback* progress_callback);
+  void GetHash(u32 digest_index, Hash* hash) { m_digests[digest_index]->Final(hash); }
+
+private:
+  enum : u32
+  {
+    CHUNK_SECTORS = 64,
+    NUM_CHUNKS = 16,
+    MAX_HASH_THREADS = 4
+  };
+
+  struct Chunk
+  {
+    std::unique_ptr<u8[]> data;
+    u32 digest_index;
+    u32 size;
+  };
+
+  Chunk* GetFreeChunk();
+  void QueueChunk(Chunk* chunk);
+  void WorkerThreadEntryPoint(u32 worker_index);
+
+  std::vector<std::unique_ptr<Digest>> m_digests;
+  std::vector<Chunk> m_chunks;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_work_cv;
+  std::condition_variable m_free_cv;
+  std::vector<Chunk*> m_free_chunks;
+  std::vector<std::deque<Chunk*>> m_queues;
+  bool m_shutdown_flag = false;
+};
+
+HashPipeline::HashPipeline(HashType type, u32 num_digests)
+{
+  m_digests.reserve(num_digests);
+  for (u32 i = 0; i < num_digests; i++)
+    m_digests.push_back(std::make_unique<Digest>(type));
+
+  m_chunks.resize(NUM_CHUNKS);
+  for (Chunk& chunk : m_chunks)
+  {
+    chunk.data = std::make_unique<u8[]>(CHUNK_SECTORS * CDImage::RAW_SECTOR_SIZE);
+    m_free_chunks.push_back(&chunk);
+  }
+
+  const u32 num_cpus = std::max<u32>(std::thread::hardware_concurrency(), 1);
+  const u32 num_threads = std::min<u32>(std::min<u32>(num_cpus, MAX_HASH_THREADS), std::max<u32>(num_digests, 1));
+  m_queues.resize(num_threads);
+  for (u32 i = 0; i < num_threads; i++)
+    m_threads.emplace_back(&HashPipeline::WorkerThreadEntryPoint, this, i);
+}
+
+HashPipeline::~HashPipeline()
+{
+  // anything left in the queues is hashed before the workers exit
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_shutdown_flag = true;
+    m_work_cv.notify_all();
+  }
+
+  for (std::thread& thread : m_threads)
+    thread.join();
+}
+
+HashPipeline::Chunk* HashPipeline::GetFreeChunk()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_free_cv.wait(lock, [this]() { return !m_free_chunks.empty(); });
+
+  Chunk* chunk = m_free_chunks.back();
+  m_free_chunks.pop_back();
+  return chunk;
+}
+
+void HashPipeline::QueueChunk(Chunk* chunk)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_queues[chunk->digest_index % static_cast<u32>(m_queues.size())].push_back(chunk);
+  m_work_cv.notify_all();
+}
+
+void HashPipeline::WorkerThreadEntryPoint(u32 worker_index)
+{
+  std::deque<Chunk*>& queue = m_queues[worker_index];
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;)
+  {
+    m_work_cv.wait(lock, [this, &queue]() { return (!queue.empty() || m_shutdown_flag); });
+    if (queue.empty())
+      break;
+
+    Chunk* chunk = queue.front();
+    queue.pop_front();
+    lock.unlock();
+
+    m_digests[chunk->digest_index]->Update(chunk->data.get(), chunk->size);
+
+    lock.lock();
+    m_free_chunks.push_back(chunk);
+    m_free_cv.notify_one();
   }
+}
+
+bool HashPipeline::Run(CDImage* image, const std::vector<Segment>& segments, ProgressCallback* progress_callback)
+{
+  u32 total_sectors = 0;
+  for (const Segment& seg : segments)
+    total_sectors += seg.length;
+
+  progress_callback->SetProgressRange(total_sectors);
+  progress_callback->SetProgressValue(0);
 
-  std::array<u8, CDImage::RAW_SECTOR_SIZE> sector;
-  for (u32 lba = 0; lba < index_length; lba++)
+  u32 sectors_done = 0;
+  for (const Segment& seg : segments)
   {
-    if ((lba % update_interval) == 0)
-      progress_callback->SetProgressValue(lba);
+    progress_callback->SetFormattedStatusText("Computing hash for track %u/index %u...", seg.track, seg.index);
 
-    if (!image->ReadRawSector(sector.data()))
+    if (!image->Seek(seg.start))
     {
-      progress_callback->DisplayFormattedModalError("Failed to read sector %u from image", image->GetPositionOnDisc());
+      progress_callback->DisplayFormattedModalError("Failed to seek to sector %u for track %u index %u", seg.start,
+                                                    seg.track, seg.index);
       return false;
     }
 
-    digest->Update(sector.data(), static_cast<u32>(sector.size()));
+    for (u32 offset = 0; offset < seg.length;)
+    {
+      if (progress_callback->IsCancelled())
+        return false;
+
+      Chunk* chunk = GetFreeChunk();
+      const u32 count = std::min<u32>(seg.length - offset, CHUNK_SECTORS);
+      for (u32 i = 0; i < count; i++)
+      {
+        if (!image->ReadRawSector(chunk->data.get() + (i * CDImage::RAW_SECTOR_SIZE)))
+        {
+          {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_free_chunks.push_back(chunk);
+          }
+
+          progress_callback->DisplayFormattedModalError("Failed to read sector %u from image",
+                                                        image->GetPositionOnDisc());
+          return false;
+        }
+      }
+
+      chunk->digest_index = seg.digest_index;
+      chunk->size = count * CDImage::RAW_SECTOR_SIZE;
+      QueueChunk(chunk);
+
+      offset += count;
+      sectors_done += count;
+      progress_callback->SetProgressValue(sectors_done);
+    }
+  }
+
+  // wait for the workers to catch up
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_free_cv.wait(lock, [this]() { return (m_free_chunks.size() == m_chunks.size()); });
   }
 
-  progress_callback->SetProgressValue(index_length);
   return true;
 }
 
-static bool ReadTrack(CDImage* image, u8 track, MD5Digest* digest, ProgressCallback* progress_callback)
+} // namespace
+
+static void AddTrackSegments(CDImage* image, u8 track, u32 digest_index, std::vector<Segment>* segments)
 {
   static constexpr u8 INDICES_TO_READ = 2;
 
-  progress_callback->PushState();
-
-  progress_callback->SetProgressRange(2);
   for (u8 index = 0; index < INDICES_TO_READ; index++)
   {
-    progress_callback->SetProgressValue(index);
-
     // skip index 0 if data track
     if (track == 1 && index == 0)
       continue;
 
-    progress_callback->PushState();
-    if (!ReadIndex(image, track, index, digest, progress_callback))
-    {
-      progress_callback->PopState();
-      progress_callback->PopState();
-      return false;
-    }
+    const u32 length = image->GetTrackIndexLength(track, index);
+    if (length == 0)
+      continue;
 
-    progress_callback->PopState();
+    segments->push_back(Segment{digest_index, image->GetTrackIndexPosition(track, index), length, track, index});
   }
-
-  progress_callback->SetProgressValue(INDICES_TO_READ);
-  progress_callback->PopState();
-  return true;
 }
 
 std::string HashToString(const Hash& hash)
@@ -79,38 +284,53 @@ std::string HashToString(const Hash& hash)
 }
 
 bool GetImageHash(CDImage* image, Hash* out_hash,
-                  ProgressCallback* progress_callback /*= ProgressCallback::NullProgressCallback*/)
+                  ProgressCallback* progress_callback /*= ProgressCallback::NullProgressCallback*/,
+                  HashType type /*= HashType::MD5*/)
 {
-  MD5Digest digest;
-
-  progress_callback->SetProgressRange(image->GetTrackCount());
-  progress_callback->SetProgressValue(0);
-  progress_callback->PushState();
-
+  std::vector<Segment> segments;
   for (u32 i = 1; i <= image->GetTrackCount(); i++)
-  {
-    progress_callback->SetProgressValue(i - 1);
-    if (!ReadTrack(image, i, &digest, progress_callback))
-    {
-      progress_callback->PopState();
-      return false;
-    }
-  }
+    AddTrackSegments(image, static_cast<u8>(i), 0, &segments);
+
+  HashPipeline pipeline(type, 1);
+  if (!pipeline.Run(image, segments, progress_callback))
+    return false;
 
-  progress_callback->SetProgressValue(image->GetTrackCount());
-  digest.Final(out_hash->data());
+  pipeline.GetHash(0, out_hash);
   return true;
 }
 
 bool GetTrackHash(CDImage* image, u8 track, Hash* out_hash,
-                  ProgressCallback* progress_callback /*= ProgressCallback::NullProgressCallback*/)
+                  ProgressCallback* progress_callback /*= ProgressCallback::NullProgressCallback*/,
+                  HashType type /*= HashType::MD5*/)
+{
+  std::vector<Segment> segments;
+  AddTrackSegments(image, track, 0, &segments);
+
+  HashPipeline pipeline(type, 1);
+  if (!pipeline.Run(image, segments, progress_callback))
+    return false;
+
+  pipeline.GetHash(0, out_hash);
+  return true;
+}
+
+bool GetTrackHashes(CDImage* image, std::vector<Hash>* out_hashes,
+                    ProgressCallback* progress_callback /*= ProgressCallback::NullProgressCallback*/,
+                    HashType type /*= HashType::MD5*/)
 {
-  MD5Digest digest;
-  if (!ReadTrack(image, track, &digest, progress_callback))
+  const u32 track_count = image->GetTrackCount();
+  std::vector<Segment> segments;
+  for (u32 i = 1; i <= track_count; i++)
+    AddTrackSegments(image, static_cast<u8>(i), i - 1, &segments);
+
+  HashPipeline pipeline(type, track_count);
+  if (!pipeline.Run(image, segments, progress_callback))
     return false;
 
-  digest.Final(out_hash->data());
+  out_hashes->resize(track_count);
+  for (u32 i = 0; i < track_count; i++)
+    pipeline.GetHash(i, &(*out_hashes)[i]);
   return true;
 }
 
-} // namespace CDImageHasher
\ No newline at end of file
+} // namespace CDImageHasher
@@ -3,17 +3,31 @@
 #include "types.h"
 #include <array>
 #include <string>
+#include <vector>
 
 class CDImage;
 
 namespace CDImageHasher {
 
+enum class HashType
+{
+  MD5,  // Matches redump, use for verifying dumps.
+  XXH3, // 128-bit non-cryptographic hash, much faster. Only suitable for detecting changes.
+};
+
 using Hash = std::array<u8, 16>;
 std::string HashToString(const Hash& hash);
 
 bool GetImageHash(CDImage* image, Hash* out_hash,
-                  ProgressCallback* progress_callback = ProgressCallback::NullProgressCallback);
+                  ProgressCallback* progress_callback = ProgressCallback::NullProgressCallback,
+                  HashType type = HashType::MD5);
 bool GetTrackHash(CDImage* image, u8 track, Hash* out_hash,
-                  ProgressCallback* progress_callback = ProgressCallback::NullProgressCallback);
+                  ProgressCallback* progress_callback = ProgressCallback::NullProgressCallback,
+                  HashType type = HashType::MD5);
+
+/// Computes the hash of every track in a single pass over the image. Tracks are hashed concurrently.
+bool GetTrackHashes(CDImage* image, std::vector<Hash>* out_hashes,
+                    ProgressCallback* progress_callback = ProgressCallback::NullProgressCallback,
+                    HashType type = HashType::MD5);
 
-} // namespace CDImageHasher
\ No newline at end of file
+} // namespace CDImageHasher
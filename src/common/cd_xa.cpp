@@ -1,7 +1,21 @@
 #include "cd_xa.h"
 #include "cd_image.h"
+#include "cpu_detect.h"
 #include <algorithm>
 #include <array>
+#include <cstring>
+
+#if defined(CPU_X64)
+#include <emmintrin.h>
+#define VECTOR_XA_ADPCM 1
+#elif defined(CPU_AARCH64)
+#ifdef _MSC_VER
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#define VECTOR_XA_ADPCM 1
+#endif
 
 namespace CDXA {
 static constexpr std::array<s32, 4> s_xa_adpcm_filter_table_pos = {{0, 60, 115, 98}};
@@ -70,7 +84,8 @@ static void DecodeXA_ADPCMChunks(const u8* chunk_ptr, s16* samples, s32* last_sa
   }
 }
 
-void DecodeADPCMSector(const void* data, s16* samples, s32* last_samples)
+template<template<bool, bool> class Decoder>
+static void DecodeADPCMSectorWith(const void* data, s16* samples, s32* last_samples)
 {
   const XASubHeader* subheader = reinterpret_cast<const XASubHeader*>(
     reinterpret_cast<const u8*>(data) + CDImage::SECTOR_SYNC_SIZE + sizeof(CDImage::SectorHeader));
@@ -82,17 +97,218 @@ void DecodeADPCMSector(const void* data, s16* samples, s32* last_samples)
   if (subheader->codinginfo.bits_per_sample != 1)
   {
     if (subheader->codinginfo.mono_stereo != 1)
-      DecodeXA_ADPCMChunks<false, false>(chunk_ptr, samples, last_samples);
+      Decoder<false, false>::DecodeChunks(chunk_ptr, samples, last_samples);
     else
-      DecodeXA_ADPCMChunks<true, false>(chunk_ptr, samples, last_samples);
+      Decoder<true, false>::DecodeChunks(chunk_ptr, samples, last_samples);
   }
   else
   {
     if (subheader->codinginfo.mono_stereo != 1)
-      DecodeXA_ADPCMChunks<false, true>(chunk_ptr, samples, last_samples);
+      Decoder<false, true>::DecodeChunks(chunk_ptr, samples, last_samples);
     else
-      DecodeXA_ADPCMChunks<true, true>(chunk_ptr, samples, last_samples);
+      Decoder<true, true>::DecodeChunks(chunk_ptr, samples, last_samples);
+  }
+}
+
+template<bool IS_STEREO, bool IS_8BIT>
+struct ScalarDecoder
+{
+  static void DecodeChunks(const u8* chunk_ptr, s16* samples, s32* last_samples)
+  {
+    DecodeXA_ADPCMChunks<IS_STEREO, IS_8BIT>(chunk_ptr, samples, last_samples);
+  }
+};
+
+#ifdef VECTOR_XA_ADPCM
+
+// Vectorized decoder. The filter is a recurrence on the previous two samples, so it stays scalar, but extracting and
+// shifting the nibbles, clamping, and interleaving the stereo output are done a vector at a time.
+template<bool IS_STEREO, bool IS_8BIT>
+struct VectorDecoder
+{
+  static constexpr u32 NUM_BLOCKS = IS_8BIT ? 4 : 8;
+  static constexpr u32 WORDS_PER_BLOCK = 28;
+
+  // 28 words per block, rounded up to a whole number of vectors
+  static constexpr u32 PADDED_WORDS_PER_BLOCK = 32;
+
+  /// Extracts the nibble for one block from each word, and applies the block's shift.
+  static void ExpandBlock(const u8* words_ptr, u32 block, u8 shift, s16* raw_samples)
+  {
+    // Moving the nibble to the top of the word and arithmetic shifting back down sign-extends it. This also handles
+    // 8-bit blocks, where only the low nibble of the byte survives the truncation to 16 bits.
+    const u32 left_shift = 28 - (block * (IS_8BIT ? 8 : 4));
+
+#if defined(CPU_X64)
+    const __m128i v_left_shift = _mm_cvtsi32_si128(static_cast<int>(left_shift));
+    const __m128i v_right_shift = _mm_cvtsi32_si128(static_cast<int>(shift));
+    for (u32 word = 0; word < 24; word += 8)
+    {
+      const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&words_ptr[word * sizeof(u32)]));
+      const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&words_ptr[(word + 4) * sizeof(u32)]));
+      const __m128i nibbles =
+        _mm_packs_epi32(_mm_srai_epi32(_mm_sll_epi32(lo, v_left_shift), 28),
+                        _mm_srai_epi32(_mm_sll_epi32(hi, v_left_shift), 28));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&raw_samples[word]),
+                       _mm_sra_epi16(_mm_slli_epi16(nibbles, 12), v_right_shift));
+    }
+
+    const __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&words_ptr[24 * sizeof(u32)]));
+    const __m128i last_nibbles = _mm_srai_epi32(_mm_sll_epi32(last, v_left_shift), 28);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&raw_samples[24]),
+                     _mm_sra_epi16(_mm_slli_epi16(_mm_packs_epi32(last_nibbles, last_nibbles), 12), v_right_shift));
+#elif defined(CPU_AARCH64)
+    const int32x4_t v_left_shift = vdupq_n_s32(static_cast<s32>(left_shift));
+    const int16x8_t v_right_shift = vdupq_n_s16(-static_cast<s16>(shift));
+    for (u32 word = 0; word < 24; word += 8)
+    {
+      const uint32x4_t lo = vld1q_u32(reinterpret_cast<const u32*>(&words_ptr[word * sizeof(u32)]));
+      const uint32x4_t hi = vld1q_u32(reinterpret_cast<const u32*>(&words_ptr[(word + 4) * sizeof(u32)]));
+      const int16x8_t nibbles =
+        vcombine_s16(vmovn_s32(vshrq_n_s32(vreinterpretq_s32_u32(vshlq_u32(lo, v_left_shift)), 28)),
+                     vmovn_s32(vshrq_n_s32(vreinterpretq_s32_u32(vshlq_u32(hi, v_left_shift)), 28)));
+      vst1q_s16(&raw_samples[word], vshlq_s16(vshlq_n_s16(nibbles, 12), v_right_shift));
+    }
+
+    const uint32x4_t last = vld1q_u32(reinterpret_cast<const u32*>(&words_ptr[24 * sizeof(u32)]));
+    const int16x4_t last_nibbles = vmovn_s32(vshrq_n_s32(vreinterpretq_s32_u32(vshlq_u32(last, v_left_shift)), 28));
+    vst1_s16(&raw_samples[24], vshl_s16(vshl_n_s16(last_nibbles, 12), vget_low_s16(v_right_shift)));
+#endif
+  }
+
+  /// Runs the filter over one block. This is the same arithmetic as the scalar decoder.
+  static void FilterBlock(const s16* raw_samples, u8 filter, s32* prev, s32* filtered)
+  {
+    const s32 filter_pos = s_xa_adpcm_filter_table_pos[filter];
+    const s32 filter_neg = s_xa_adpcm_filter_table_neg[filter];
+    s32 prev0 = prev[0];
+    s32 prev1 = prev[1];
+    for (u32 i = 0; i < WORDS_PER_BLOCK; i++)
+    {
+      const s32 interp_sample = s32(raw_samples[i]) + ((prev0 * filter_pos) + (prev1 * filter_neg) + 32) / 64;
+      prev1 = prev0;
+      prev0 = interp_sample;
+      filtered[i] = interp_sample;
+    }
+
+    prev[0] = prev0;
+    prev[1] = prev1;
+  }
+
+  /// Clamps a block to 16 bits, saturating narrows do the clamp for us.
+  static void StoreMonoBlock(const s32* filtered, s16* out_samples)
+  {
+#if defined(CPU_X64)
+    for (u32 i = 0; i < 24; i += 8)
+    {
+      const __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(&filtered[i]));
+      const __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(&filtered[i + 4]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&out_samples[i]), _mm_packs_epi32(lo, hi));
+    }
+
+    const __m128i last = _mm_load_si128(reinterpret_cast<const __m128i*>(&filtered[24]));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&out_samples[24]), _mm_packs_epi32(last, last));
+#elif defined(CPU_AARCH64)
+    for (u32 i = 0; i < 24; i += 8)
+    {
+      vst1q_s16(&out_samples[i],
+                vcombine_s16(vqmovn_s32(vld1q_s32(&filtered[i])), vqmovn_s32(vld1q_s32(&filtered[i + 4]))));
+    }
+
+    vst1_s16(&out_samples[24], vqmovn_s32(vld1q_s32(&filtered[24])));
+#endif
+  }
+
+  /// Clamps a pair of blocks to 16 bits, and interleaves them with left first.
+  static void StoreStereoBlocks(const s32* left, const s32* right, s16* out_samples)
+  {
+#if defined(CPU_X64)
+    for (u32 i = 0; i < 24; i += 8)
+    {
+      const __m128i l = _mm_packs_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(&left[i])),
+                                        _mm_load_si128(reinterpret_cast<const __m128i*>(&left[i + 4])));
+      const __m128i r = _mm_packs_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(&right[i])),
+                                        _mm_load_si128(reinterpret_cast<const __m128i*>(&right[i + 4])));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&out_samples[i * 2]), _mm_unpacklo_epi16(l, r));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&out_samples[i * 2 + 8]), _mm_unpackhi_epi16(l, r));
+    }
+
+    const __m128i l = _mm_load_si128(reinterpret_cast<const __m128i*>(&left[24]));
+    const __m128i r = _mm_load_si128(reinterpret_cast<const __m128i*>(&right[24]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&out_samples[48]),
+                     _mm_unpacklo_epi16(_mm_packs_epi32(l, l), _mm_packs_epi32(r, r)));
+#elif defined(CPU_AARCH64)
+    for (u32 i = 0; i < 24; i += 8)
+    {
+      int16x8x2_t lr;
+      lr.val[0] = vcombine_s16(vqmovn_s32(vld1q_s32(&left[i])), vqmovn_s32(vld1q_s32(&left[i + 4])));
+      lr.val[1] = vcombine_s16(vqmovn_s32(vld1q_s32(&right[i])), vqmovn_s32(vld1q_s32(&right[i + 4])));
+      vst2q_s16(&out_samples[i * 2], lr);
+    }
+
+    int16x4x2_t lr;
+    lr.val[0] = vqmovn_s32(vld1q_s32(&left[24]));
+    lr.val[1] = vqmovn_s32(vld1q_s32(&right[24]));
+    vst2_s16(&out_samples[48], lr);
+#endif
   }
+
+  static void DecodeChunk(const u8* chunk_ptr, s16* samples, s32* last_samples)
+  {
+    const u8* headers_ptr = chunk_ptr + 4;
+    const u8* words_ptr = chunk_ptr + 16;
+
+    alignas(16) s16 raw_samples[PADDED_WORDS_PER_BLOCK];
+    alignas(16) s32 filtered[2][PADDED_WORDS_PER_BLOCK];
+
+    for (u32 block = 0; block < NUM_BLOCKS; block++)
+    {
+      const XA_ADPCMBlockHeader block_header{headers_ptr[block]};
+      ExpandBlock(words_ptr, block, block_header.GetShift(), raw_samples);
+
+      if constexpr (IS_STEREO)
+      {
+        FilterBlock(raw_samples, block_header.GetFilter(), &last_samples[(block & 1) * 2], filtered[block & 1]);
+        if (block & 1)
+          StoreStereoBlocks(filtered[0], filtered[1], &samples[(block / 2) * (WORDS_PER_BLOCK * 2)]);
+      }
+      else
+      {
+        FilterBlock(raw_samples, block_header.GetFilter(), last_samples, filtered[0]);
+        StoreMonoBlock(filtered[0], &samples[block * WORDS_PER_BLOCK]);
+      }
+    }
+  }
+
+  static void DecodeChunks(const u8* chunk_ptr, s16* samples, s32* last_samples)
+  {
+    constexpr u32 NUM_CHUNKS = 18;
+    constexpr u32 CHUNK_SIZE_IN_BYTES = 128;
+    constexpr u32 SAMPLES_PER_CHUNK = WORDS_PER_BLOCK * NUM_BLOCKS;
+
+    for (u32 i = 0; i < NUM_CHUNKS; i++)
+    {
+      DecodeChunk(chunk_ptr, samples, last_samples);
+      samples += SAMPLES_PER_CHUNK;
+      chunk_ptr += CHUNK_SIZE_IN_BYTES;
+    }
+  }
+};
+
+#endif
+
+void DecodeADPCMSector(const void* data, s16* samples, s32* last_samples)
+{
+#ifdef VECTOR_XA_ADPCM
+  DecodeADPCMSectorWith<VectorDecoder>(data, samples, last_samples);
+#else
+  DecodeADPCMSectorWith<ScalarDecoder>(data, samples, last_samples);
+#endif
+}
+
+void DecodeADPCMSectorScalar(const void* data, s16* samples, s32* last_samples)
+{
+  DecodeADPCMSectorWith<ScalarDecoder>(data, samples, last_samples);
 }
 
 } // namespace CDXA
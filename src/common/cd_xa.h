@@ -67,4 +67,8 @@ static_assert(sizeof(XA_ADPCMBlockHeader) == 1, "XA-ADPCM block header is one by
 // Decodes XA-ADPCM samples in an audio sector. Stereo samples are interleaved with left first.
 void DecodeADPCMSector(const void* data, s16* samples, s32* last_samples);
 
+// Reference decoder which processes a sample at a time. Output is identical to DecodeADPCMSector(), which is
+// vectorized where supported.
+void DecodeADPCMSectorScalar(const void* data, s16* samples, s32* last_samples);
+
 } // namespace CDXA
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "mapped_file.h"
+#include "common/log.h"
+#include "common/string_util.h"
+#include <limits>
+#include <utility>
+Log_SetChannel(Common::MappedFile);
+
+#if defined(WIN32)
+#include "common/windows_headers.h"
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Common {
+
+MappedFile::MappedFile() = default;
+
+MappedFile::MappedFile(MappedFile&& move)
+{
+  *this = std::move(move);
+}
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& move)
+{
+  Close();
+
+  m_data = std::exchange(move.m_data, nullptr);
+  m_size = std::exchange(move.m_size, 0);
+#ifdef WIN32
+  m_file_handle = std::exchange(move.m_file_handle, nullptr);
+  m_mapping_handle = std::exchange(move.m_mapping_handle, nullptr);
+#endif
+
+  return *this;
+}
+
+#if defined(WIN32)
+
+bool MappedFile::Open(const char* filename)
+{
+  Close();
+
+  const std::wstring wfilename(StringUtil::UTF8StringToWideString(filename));
+  HANDLE file_handle = CreateFileW(wfilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file_handle == INVALID_HANDLE_VALUE)
+  {
+    Log_ErrorPrintf("CreateFileW('%s') failed: %u", filename, GetLastError());
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart <= 0 ||
+      static_cast<u64>(file_size.QuadPart) > std::numeric_limits<size_t>::max())
+  {
+    Log_ErrorPrintf("'%s' is empty or too large to map", filename);
+    CloseHandle(file_handle);
+    return false;
+  }
+
+  HANDLE mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping_handle)
+  {
+    Log_ErrorPrintf("CreateFileMappingW('%s') failed: %u", filename, GetLastError());
+    CloseHandle(file_handle);
+    return false;
+  }
+
+  void* data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+  if (!data)
+  {
+    Log_ErrorPrintf("MapViewOfFile('%s') failed: %u", filename, GetLastError());
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+    return false;
+  }
+
+  m_data = static_cast<const u8*>(data);
+  m_size = static_cast<u64>(file_size.QuadPart);
+  m_file_handle = file_handle;
+  m_mapping_handle = mapping_handle;
+  return true;
+}
+
+void MappedFile::Close()
+{
+  if (m_data)
+  {
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping_handle);
+    CloseHandle(m_file_handle);
+    m_data = nullptr;
+    m_size = 0;
+    m_file_handle = nullptr;
+    m_mapping_handle = nullptr;
+  }
+}
+
+void MappedFile::SetAccessPattern(AccessPattern pattern)
+{
+  // no equivalent of madvise(), the cache manager picks up sequential access by itself
+}
+
+void MappedFile::Prefetch()
+{
+  if (!m_data)
+    return;
+
+  // PrefetchVirtualMemory() is only present on Windows 8 and newer
+  struct MEMORY_RANGE_ENTRY
+  {
+    PVOID VirtualAddress;
+    SIZE_T NumberOfBytes;
+  };
+  using PrefetchVirtualMemoryFn = BOOL(WINAPI*)(HANDLE, ULONG_PTR, MEMORY_RANGE_ENTRY*, ULONG);
+  static const PrefetchVirtualMemoryFn prefetch_virtual_memory = reinterpret_cast<PrefetchVirtualMemoryFn>(
+    GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory"));
+  if (!prefetch_virtual_memory)
+    return;
+
+  MEMORY_RANGE_ENTRY range = {const_cast<u8*>(m_data), static_cast<SIZE_T>(m_size)};
+  if (!prefetch_virtual_memory(GetCurrentProcess(), 1, &range, 0))
+    Log_WarningPrintf("PrefetchVirtualMemory() failed: %u", GetLastError());
+}
+
+#else
+
+bool MappedFile::Open(const char* filename)
+{
+  Close();
+
+  const int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+  {
+    Log_ErrorPrintf("open('%s') failed: %d", filename, errno);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+      static_cast<u64>(st.st_size) > std::numeric_limits<size_t>::max())
+  {
+    Log_ErrorPrintf("'%s' is empty or too large to map", filename);
+    close(fd);
+    return false;
+  }
+
+  // the mapping keeps its own reference to the file, so the descriptor isn't needed afterwards
+  void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    Log_ErrorPrintf("mmap('%s') failed: %d", filename, errno);
+    return false;
+  }
+
+  m_data = static_cast<const u8*>(data);
+  m_size = static_cast<u64>(st.st_size);
+  return true;
+}
+
+void MappedFile::Close()
+{
+  if (m_data)
+  {
+    munmap(const_cast<u8*>(m_data), static_cast<size_t>(m_size));
+    m_data = nullptr;
+    m_size = 0;
+  }
+}
+
+void MappedFile::SetAccessPattern(AccessPattern pattern)
+{
+  if (!m_data)
+    return;
+
+  static constexpr int advice[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM};
+  if (madvise(const_cast<u8*>(m_data), static_cast<size_t>(m_size), advice[static_cast<int>(pattern)]) != 0)
+    Log_WarningPrintf("madvise(%d) failed: %d", advice[static_cast<int>(pattern)], errno);
+}
+
+void MappedFile::Prefetch()
+{
+  if (!m_data)
+    return;
+
+  if (madvise(const_cast<u8*>(m_data), static_cast<size_t>(m_size), MADV_WILLNEED) != 0)
+    Log_WarningPrintf("madvise(MADV_WILLNEED) failed: %d", errno);
+}
+
+#endif
+
+} // namespace Common
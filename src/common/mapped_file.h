@@ -0,0 +1,50 @@
+#pragma once
+#include "types.h"
+
+namespace Common {
+
+/// Read-only mapping of a whole file into the address space. Pages are shared with the OS page cache, so multiple
+/// processes mapping the same file don't each hold a copy.
+class MappedFile
+{
+public:
+  enum class AccessPattern
+  {
+    Normal,
+    Sequential,
+    Random
+  };
+
+  MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&& move);
+  ~MappedFile();
+
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&& move);
+
+  bool IsOpen() const { return (m_data != nullptr); }
+  const u8* GetData() const { return m_data; }
+  u64 GetSize() const { return m_size; }
+
+  /// Maps the specified file. Fails for empty files, or if the file can't fit in the address space.
+  bool Open(const char* filename);
+  void Close();
+
+  /// Hints at how the mapping will be accessed, so the OS can adjust its read-ahead.
+  void SetAccessPattern(AccessPattern pattern);
+
+  /// Asks the OS to start reading the whole file into the page cache in the background.
+  void Prefetch();
+
+private:
+  const u8* m_data = nullptr;
+  u64 m_size = 0;
+
+#ifdef WIN32
+  void* m_file_handle = nullptr;
+  void* m_mapping_handle = nullptr;
+#endif
+};
+
+} // namespace Common
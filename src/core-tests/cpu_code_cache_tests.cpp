@@ -0,0 +1,133 @@
+#include "common/timer.h"
+#include "core/bus.h"
+#include "core/cpu_code_cache.h"
+#include "core/cpu_core.h"
+#include "core/cpu_core_private.h"
+#include "core/settings.h"
+#include "core/timing_event.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace CPU;
+
+// Small blocks spread over most of RAM, chained together in a random order so that each one is on a different page to
+// the one before it. The last block jumps back to the first.
+static constexpr u32 NUM_BLOCKS = 8192;
+static constexpr u32 BLOCK_STRIDE = 0xE0;
+static constexpr u32 BLOCK_WORDS = 3;
+static constexpr PhysicalMemoryAddress FIRST_BLOCK_ADDRESS = 0x10000;
+
+static VirtualMemoryAddress GetBlockAddress(u32 slot)
+{
+  return UINT32_C(0x80000000) | (FIRST_BLOCK_ADDRESS + slot * BLOCK_STRIDE);
+}
+
+// Each block counts itself in t0. The delay slot loads the generation into t1, so changing it forces a recompile.
+static void WriteBlocks(const std::vector<u32>& order, u16 generation)
+{
+  for (u32 i = 0; i < NUM_BLOCKS; i++)
+  {
+    const PhysicalMemoryAddress address = GetBlockAddress(order[i]) & Bus::RAM_MASK;
+    const VirtualMemoryAddress next = GetBlockAddress(order[(i + 1) % NUM_BLOCKS]);
+    const u32 code[BLOCK_WORDS] = {
+      (0x09u << 26) | (8u << 21) | (8u << 16) | 1u,          // addiu t0, t0, 1
+      (0x02u << 26) | ((next >> 2) & 0x3FFFFFFu),            // j next
+      (0x0Du << 26) | (9u << 16) | ZeroExtend32(generation), // ori t1, zero, generation
+    };
+    std::memcpy(&Bus::g_ram[address], code, sizeof(code));
+    CodeCache::InvalidateCodePages(address, BLOCK_WORDS);
+  }
+}
+
+// Runs the cached interpreter until the stop event fires, and returns the number of blocks executed.
+static u32 RunBlocks(TimingEvent* stop_event, TickCount ticks)
+{
+  const u32 start_count = g_state.regs.t0;
+  stop_event->SetPeriod(ticks);
+  stop_event->SetInterval(ticks);
+  stop_event->Reset();
+  CodeCache::Execute();
+  return g_state.regs.t0 - start_count;
+}
+
+TEST(CPUCodeCache, DISABLED_Benchmark)
+{
+  static constexpr u32 ITERATIONS = 20;
+
+  g_settings.cpu_execution_mode = CPUExecutionMode::CachedInterpreter;
+  g_settings.cpu_recompiler_icache = false;
+  TimingEvents::Initialize();
+  Bus::Initialize();
+  CPU::Initialize();
+  CodeCache::Initialize();
+  std::unique_ptr<TimingEvent> stop_event = TimingEvents::CreateTimingEvent(
+    "Stop Execution", 1, 1,
+    [](void*, TickCount, TickCount) {
+      g_state.frame_done = true;
+      g_state.downcount = 0;
+    },
+    nullptr, true);
+
+  std::vector<u32> order(NUM_BLOCKS);
+  std::iota(order.begin(), order.end(), 0u);
+  std::shuffle(order.begin(), order.end(), std::mt19937(0x434F4445));
+  u16 generation = 0;
+  WriteBlocks(order, generation);
+
+  CPU::Reset();
+  g_state.regs.npc = GetBlockAddress(order[0]);
+  FetchInstruction();
+  g_state.current_instruction.bits = g_state.next_instruction.bits;
+
+  // work out how long a pass over every block takes, so that each measurement covers roughly one pass
+  const TickCount calibration_ticks = NUM_BLOCKS * 16;
+  const u32 calibration_blocks = RunBlocks(stop_event.get(), calibration_ticks);
+  ASSERT_GT(calibration_blocks, NUM_BLOCKS);
+  const TickCount pass_ticks = static_cast<TickCount>(
+    (static_cast<u64>(calibration_ticks) * NUM_BLOCKS + calibration_blocks / 2) / calibration_blocks);
+
+  enum Phase
+  {
+    Compile,
+    Recompile,
+    Linked,
+    NumPhases
+  };
+  static constexpr const char* phase_names[NumPhases] = {"Compile", "Recompile", "Linked"};
+  double phase_times[NumPhases] = {};
+  u32 phase_blocks[NumPhases] = {};
+
+  for (u32 iteration = 0; iteration < ITERATIONS; iteration++)
+  {
+    for (u32 phase = 0; phase < NumPhases; phase++)
+    {
+      // allocating blocks and inserting them into the table, replacing the instructions of every block, or neither
+      if (phase == Compile)
+        CodeCache::Flush();
+      else if (phase == Recompile)
+        WriteBlocks(order, ++generation);
+
+      Common::Timer timer;
+      phase_blocks[phase] += RunBlocks(stop_event.get(), pass_ticks);
+      phase_times[phase] += timer.GetTimeMilliseconds();
+    }
+  }
+
+  for (u32 phase = 0; phase < NumPhases; phase++)
+  {
+    std::printf("%s: %.2f ms for %u blocks, %.1f ns/block\n", phase_names[phase], phase_times[phase],
+                phase_blocks[phase], (phase_times[phase] * 1000000.0) / phase_blocks[phase]);
+  }
+
+  stop_event.reset();
+  CodeCache::Shutdown();
+  CPU::Shutdown();
+  Bus::Shutdown();
+  TimingEvents::Shutdown();
+}
@@ -0,0 +1,542 @@
+#include "core/bus.h"
+#include "core/cpu_code_cache.h"
+#include "core/cpu_core.h"
+#include "core/cpu_core_private.h"
+#include "core/gte.h"
+#include "core/settings.h"
+#include "core/timing_event.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#ifdef WITH_RECOMPILER
+
+using namespace CPU;
+
+static constexpr u32 R(Reg reg)
+{
+  return static_cast<u32>(reg);
+}
+
+static constexpr u32 RType(u32 rs, u32 rt, u32 rd, u32 shamt, u32 funct)
+{
+  return (rs << 21) | (rt << 16) | (rd << 11) | (shamt << 6) | funct;
+}
+
+static constexpr u32 IType(u32 op, u32 rs, u32 rt, u32 imm)
+{
+  return (op << 26) | (rs << 21) | (rt << 16) | (imm & 0xFFFFu);
+}
+
+// branch offsets are counted in instructions from the delay slot
+static constexpr u32 BranchOffset(u32 branch_index, u32 target_index)
+{
+  return target_index - (branch_index + 1);
+}
+
+static constexpr u32 NOP = 0;
+static constexpr u32 ADDU(Reg rd, Reg rs, Reg rt)
+{
+  return RType(R(rs), R(rt), R(rd), 0, 0x21);
+}
+static constexpr u32 XOR(Reg rd, Reg rs, Reg rt)
+{
+  return RType(R(rs), R(rt), R(rd), 0, 0x26);
+}
+static constexpr u32 SLL(Reg rd, Reg rt, u32 shamt)
+{
+  return RType(0, R(rt), R(rd), shamt, 0x00);
+}
+static constexpr u32 ADDIU(Reg rt, Reg rs, u32 imm)
+{
+  return IType(0x09, R(rs), R(rt), imm);
+}
+static constexpr u32 SLTIU(Reg rt, Reg rs, u32 imm)
+{
+  return IType(0x0B, R(rs), R(rt), imm);
+}
+static constexpr u32 ANDI(Reg rt, Reg rs, u32 imm)
+{
+  return IType(0x0C, R(rs), R(rt), imm);
+}
+static constexpr u32 ORI(Reg rt, Reg rs, u32 imm)
+{
+  return IType(0x0D, R(rs), R(rt), imm);
+}
+static constexpr u32 XORI(Reg rt, Reg rs, u32 imm)
+{
+  return IType(0x0E, R(rs), R(rt), imm);
+}
+static constexpr u32 LW(Reg rt, Reg rs, u32 imm)
+{
+  return IType(0x23, R(rs), R(rt), imm);
+}
+static constexpr u32 LWC2(u32 gte_reg, Reg rs, u32 imm)
+{
+  return IType(0x32, R(rs), gte_reg, imm);
+}
+static constexpr u32 CTC2(u32 gte_control_reg, Reg rt)
+{
+  return (0x12u << 26) | (0x06u << 21) | (R(rt) << 16) | (gte_control_reg << 11);
+}
+static constexpr u32 COP2(GTE::Instruction inst)
+{
+  return (0x12u << 26) | (1u << 25) | inst.bits;
+}
+static constexpr u32 BEQ(Reg rs, Reg rt, u32 offset)
+{
+  return IType(0x04, R(rs), R(rt), offset);
+}
+static constexpr u32 BNE(Reg rs, Reg rt, u32 offset)
+{
+  return IType(0x05, R(rs), R(rt), offset);
+}
+
+class CPURecompilerTest : public testing::Test
+{
+protected:
+  static constexpr VirtualMemoryAddress PROGRAM_ADDRESS = 0x80010000;
+  static constexpr VirtualMemoryAddress DATA_ADDRESS = 0x80100000;
+  static constexpr u32 DATA_SIZE = 0x1000;
+
+  // Long enough for every test program to reach the loop at its end.
+  static constexpr TickCount RUN_TICKS = 4000000;
+
+  using DataArray = std::array<u8, DATA_SIZE>;
+
+  struct MachineState
+  {
+    std::array<u32, 34> regs;
+    std::array<u32, GTE::NUM_REGS> gte_regs;
+    std::vector<u8> data;
+    std::vector<u8> scratchpad;
+  };
+
+  static void SetUpTestSuite()
+  {
+    g_settings.cpu_execution_mode = CPUExecutionMode::Recompiler;
+    g_settings.cpu_recompiler_memory_exceptions = false;
+    g_settings.cpu_recompiler_icache = false;
+    g_settings.cpu_recompiler_background_compile = false;
+    g_settings.cpu_recompiler_superblocks = true;
+    g_settings.cpu_fastmem_mode = CPUFastmemMode::Disabled;
+
+    TimingEvents::Initialize();
+    Bus::Initialize();
+    CPU::Initialize();
+    CodeCache::Initialize();
+    s_stop_event = TimingEvents::CreateTimingEvent(
+      "Stop Execution", RUN_TICKS, RUN_TICKS,
+      [](void*, TickCount, TickCount) {
+        g_state.frame_done = true;
+        g_state.downcount = 0;
+      },
+      nullptr, true);
+  }
+
+  static void TearDownTestSuite()
+  {
+    s_stop_event.reset();
+    CodeCache::Shutdown();
+    CPU::Shutdown();
+    Bus::Shutdown();
+    TimingEvents::Shutdown();
+  }
+
+  void SetUp() override
+  {
+    CodeCache::Flush();
+    for (u32 i = 0; i < DATA_SIZE; i++)
+      s_data[i] = static_cast<u8>(i * 7 + (i >> 8));
+  }
+
+  /// Copies the program to RAM, invalidating any blocks compiled from the previous contents.
+  static void LoadProgram(const std::vector<u32>& code)
+  {
+    const PhysicalMemoryAddress address = PROGRAM_ADDRESS & Bus::RAM_MASK;
+    std::memcpy(&Bus::g_ram[address], code.data(), code.size() * sizeof(u32));
+    CodeCache::InvalidateCodePages(address, static_cast<u32>(code.size()));
+  }
+
+  /// Runs from the start of the program with s_data at DATA_ADDRESS and a cleared scratchpad, until the stop event
+  /// fires.
+  static MachineState Run(bool recompiler, TickCount ticks)
+  {
+    u8* data = &Bus::g_ram[DATA_ADDRESS & Bus::RAM_MASK];
+    std::copy(s_data.begin(), s_data.end(), data);
+
+    CPU::Reset();
+    g_state.dcache.fill(0);
+    g_state.cop0_regs.sr.CE2 = true;
+    g_state.regs.s0 = DATA_ADDRESS;
+    g_state.regs.npc = PROGRAM_ADDRESS;
+    FetchInstruction();
+    g_state.current_instruction.bits = g_state.next_instruction.bits;
+
+    s_stop_event->SetPeriod(ticks);
+    s_stop_event->SetInterval(ticks);
+    s_stop_event->Reset();
+    if (recompiler)
+      CodeCache::ExecuteRecompiler();
+    else
+      CPU::Execute();
+
+    MachineState state;
+    std::copy_n(g_state.regs.r, state.regs.size(), state.regs.begin());
+    for (u32 i = 0; i < GTE::NUM_REGS; i++)
+      state.gte_regs[i] = GTE::ReadRegister(i);
+    state.data.assign(data, data + DATA_SIZE);
+    state.scratchpad.assign(g_state.dcache.begin(), g_state.dcache.end());
+    return state;
+  }
+
+  /// Runs the loaded program with the interpreter and the recompiler, and checks they end up in the same state.
+  static MachineState RunAndCompare(TickCount ticks = RUN_TICKS)
+  {
+    const MachineState expected = Run(false, ticks);
+    const MachineState actual = Run(true, ticks);
+    for (u32 i = 0; i < expected.regs.size(); i++)
+      EXPECT_EQ(actual.regs[i], expected.regs[i]) << "register " << GetRegName(static_cast<Reg>(i));
+    for (u32 i = 0; i < GTE::NUM_REGS; i++)
+      EXPECT_EQ(actual.gte_regs[i], expected.gte_regs[i]) << "GTE register " << i;
+    EXPECT_EQ(actual.data, expected.data);
+    EXPECT_EQ(actual.scratchpad, expected.scratchpad);
+    return actual;
+  }
+
+  static std::unique_ptr<TimingEvent> s_stop_event;
+  static DataArray s_data;
+};
+
+std::unique_ptr<TimingEvent> CPURecompilerTest::s_stop_event;
+CPURecompilerTest::DataArray CPURecompilerTest::s_data;
+
+// Counts down from 3000, and branches to the copy of the join instruction at index 15 when the condition is set. With
+// t0 < 200 as the condition the branch is biased enough to be followed into a trace, which has to side exit once the
+// branch changes direction. t6 points to a word in the data area which depends on the counter.
+static std::vector<u32> BranchingLoop(u32 condition, u32 delay_slot, u32 join_instruction)
+{
+  return {
+    /* 0  */ ORI(Reg::t0, Reg::zero, 3000),
+    /* 1  */ ORI(Reg::t1, Reg::zero, 0),
+    /* 2  */ ADDIU(Reg::t0, Reg::t0, 0xFFFF),
+    /* 3  */ ANDI(Reg::t6, Reg::t0, 0xFFC),
+    /* 4  */ ADDU(Reg::t6, Reg::t6, Reg::s0),
+    /* 5  */ condition,
+    /* 6  */ BNE(Reg::t2, Reg::zero, BranchOffset(6, 15)),
+    /* 7  */ delay_slot,
+    /* 8  */ join_instruction,
+    /* 9  */ SLL(Reg::t3, Reg::t1, 1),
+    /* 10 */ XOR(Reg::t1, Reg::t1, Reg::t3),
+    /* 11 */ BNE(Reg::t0, Reg::zero, BranchOffset(11, 2)),
+    /* 12 */ ADDIU(Reg::t4, Reg::t4, 1),
+    /* 13 */ BEQ(Reg::zero, Reg::zero, BranchOffset(13, 13)),
+    /* 14 */ NOP,
+    /* 15 */ join_instruction,
+    /* 16 */ BEQ(Reg::zero, Reg::zero, BranchOffset(16, 9)),
+    /* 17 */ ADDIU(Reg::t5, Reg::t5, 1),
+  };
+}
+
+static constexpr VirtualMemoryAddress LOOP_HEAD_ADDRESS = 0x80010000 + 2 * sizeof(u32);
+static constexpr VirtualMemoryAddress LOOP_TAIL_ADDRESS = 0x80010000 + 8 * sizeof(u32);
+static constexpr u32 BIASED_CONDITION = SLTIU(Reg::t2, Reg::t0, 200);
+
+TEST_F(CPURecompilerTest, TraceSideExitWhenBranchChangesDirection)
+{
+  LoadProgram(BranchingLoop(BIASED_CONDITION, ADDIU(Reg::t1, Reg::t1, 3), XORI(Reg::t1, Reg::t1, 0x55)));
+  const MachineState state = RunAndCompare();
+  EXPECT_EQ(state.regs[R(Reg::t0)], 0u);
+  EXPECT_EQ(state.regs[R(Reg::t5)], 200u);
+
+  // the blocks in the loop have been turned into traces, which don't count executions
+  EXPECT_LT(CodeCache::GetBlockProfile(LOOP_HEAD_ADDRESS)->execution_count, CodeCache::TRACE_HOT_BLOCK_THRESHOLD);
+  EXPECT_LT(CodeCache::GetBlockProfile(LOOP_TAIL_ADDRESS)->execution_count, CodeCache::TRACE_HOT_BLOCK_THRESHOLD);
+}
+
+TEST_F(CPURecompilerTest, TraceSideExitWithLoadDelay)
+{
+  // the load in the delay slot is still pending at the join, on both sides of the branch
+  LoadProgram(BranchingLoop(BIASED_CONDITION, LW(Reg::t7, Reg::t6, 0), ADDU(Reg::t1, Reg::t1, Reg::t7)));
+  const MachineState state = RunAndCompare();
+  EXPECT_EQ(state.regs[R(Reg::t0)], 0u);
+  EXPECT_EQ(state.regs[R(Reg::t5)], 200u);
+}
+
+TEST_F(CPURecompilerTest, ChangedBlockCanBeTracedAgain)
+{
+  // alternates between both sides of the branch, so the loop is hot, but not worth tracing
+  LoadProgram(BranchingLoop(ANDI(Reg::t2, Reg::t0, 1), ADDIU(Reg::t1, Reg::t1, 3), XORI(Reg::t1, Reg::t1, 0x55)));
+  RunAndCompare();
+
+  const CodeCache::BlockProfile* profile = CodeCache::GetBlockProfile(LOOP_HEAD_ADDRESS);
+  ASSERT_GT(profile->execution_count, CodeCache::TRACE_HOT_BLOCK_THRESHOLD);
+
+  // with the branch biased, the recompiled block should become a trace once it's hot again
+  LoadProgram(BranchingLoop(BIASED_CONDITION, ADDIU(Reg::t1, Reg::t1, 3), XORI(Reg::t1, Reg::t1, 0x55)));
+  RunAndCompare();
+  EXPECT_LT(profile->execution_count, CodeCache::TRACE_HOT_BLOCK_THRESHOLD);
+}
+
+// Picks values which are mostly in range, but regularly overflow or saturate.
+static u32 RandomGTEValue(std::mt19937& rng)
+{
+  switch (rng() % 4)
+  {
+    case 0:
+      return rng();
+    case 1:
+      return rng() & 0x00FF00FF;
+    case 2:
+      return static_cast<u32>(static_cast<s32>(rng() % 0x2000) - 0x1000) & 0xFFFF;
+    default:
+      return (rng() & 0x0FFF0FFF) | ((rng() & 1) ? 0xF000F000 : 0);
+  }
+}
+
+TEST_F(CPURecompilerTest, InlineGTECommandsMatchInterpreter)
+{
+  // RTPS, RTPT, NCLIP, AVSZ3, AVSZ4 and MVMVA are generated inline on x64 and AArch64, the interpreter calls
+  // GTE::ExecuteInstruction() for them
+  static constexpr u8 commands[] = {0x01, 0x30, 0x06, 0x2D, 0x2E, 0x12};
+
+  std::mt19937 rng(0x47544532);
+  for (u32 iteration = 0; iteration < 1200; iteration++)
+  {
+    // every register is loaded from the data area, using the recompiler's GTE register writes
+    std::vector<u32> code;
+    for (u32 reg = 0; reg < GTE::NUM_REGS; reg++)
+    {
+      const u32 value = RandomGTEValue(rng);
+      const u32 offset = reg * sizeof(u32);
+      std::memcpy(&s_data[offset], &value, sizeof(value));
+      if (reg < 32)
+      {
+        code.push_back(LWC2(reg, Reg::s0, offset));
+      }
+      else
+      {
+        code.push_back(LW(Reg::t0, Reg::s0, offset));
+        code.push_back(NOP);
+        code.push_back(CTC2(reg - 32, Reg::t0));
+      }
+    }
+
+    GTE::Instruction inst{static_cast<u32>(rng() & 0x000FE400u)};
+    inst.command = commands[iteration % std::size(commands)];
+    code.push_back(COP2(inst));
+
+    const u32 end = static_cast<u32>(code.size());
+    code.push_back(BEQ(Reg::zero, Reg::zero, BranchOffset(end, end)));
+    code.push_back(NOP);
+    LoadProgram(code);
+
+    SCOPED_TRACE(testing::Message() << std::hex << "command 0x" << static_cast<u32>(inst.command) << " (0x"
+                                    << inst.bits << ")");
+    RunAndCompare(20000);
+    if (HasFailure())
+      return;
+  }
+}
+
+// The random programs leave s0 and s1 alone, they point to the data area and the scratchpad. fp counts the repetitions.
+static constexpr VirtualMemoryAddress SCRATCHPAD_ADDRESS = 0x1F800000;
+static constexpr Reg RANDOM_LOOP_REG = Reg::fp;
+
+static u32 RandomValue(std::mt19937& rng, u32 count)
+{
+  return static_cast<u32>(rng() % count);
+}
+
+static Reg RandomSourceReg(std::mt19937& rng)
+{
+  return (RandomValue(rng, 8) == 0) ? Reg::zero : static_cast<Reg>(RandomValue(rng, 32));
+}
+
+// The interpreter and recompiler disagree on a few load delay cases, which the random programs avoid:
+//  - a delayed load into ra followed by jal/bltzal, so loads never target ra.
+//  - lwl/lwr at the start of a block, merging with a load left pending by the previous block. Only lwl/lwr target
+//    a0-a3, and they aren't put in delay slots, so the load pending at a block start is never to their register.
+static Reg RandomDestReg(std::mt19937& rng, bool load)
+{
+  for (;;)
+  {
+    const Reg reg = static_cast<Reg>(RandomValue(rng, 32));
+    if (reg == Reg::s0 || reg == Reg::s1 || reg == RANDOM_LOOP_REG)
+      continue;
+    if (load && (reg == Reg::ra || (reg >= Reg::a0 && reg <= Reg::a3)))
+      continue;
+
+    return reg;
+  }
+}
+
+// Loads or stores relative to the data area or the scratchpad, aligned to the access size.
+static u32 RandomMemoryInstruction(std::mt19937& rng, bool delay_slot)
+{
+  // lb, lbu, lh, lhu, lw, sb, sh, sw, swl, swr, lwc2, swc2, lwl, lwr
+  static constexpr u32 ops[] = {0x20, 0x24, 0x21, 0x25, 0x23, 0x28, 0x29, 0x2B, 0x2A, 0x2E, 0x32, 0x3A, 0x22, 0x26};
+  const u32 op = ops[RandomValue(rng, static_cast<u32>(std::size(ops)) - (delay_slot ? 2 : 0))];
+  const Reg base = RandomValue(rng, 2) ? Reg::s0 : Reg::s1;
+  u32 offset = RandomValue(rng, 0x400);
+  if (op == 0x21 || op == 0x25 || op == 0x29)
+    offset &= ~1u;
+  else if (op == 0x23 || op == 0x2B || op == 0x32 || op == 0x3A)
+    offset &= ~3u;
+
+  u32 rt;
+  if (op == 0x32 || op == 0x3A)
+    rt = RandomValue(rng, 6);
+  else if (op == 0x22 || op == 0x26)
+    rt = R(Reg::a0) + RandomValue(rng, 4);
+  else if (op >= 0x28)
+    rt = R(RandomSourceReg(rng));
+  else
+    rt = R(RandomDestReg(rng, true));
+  return IType(op, R(base), rt, offset);
+}
+
+static u32 RandomInstruction(std::mt19937& rng, bool delay_slot)
+{
+  switch (RandomValue(rng, 14))
+  {
+    case 0:
+    {
+      // sllv, srlv, srav, addu, subu, and, or, xor, nor, slt, sltu
+      static constexpr u32 functs[] = {0x04, 0x06, 0x07, 0x21, 0x23, 0x24, 0x25, 0x26, 0x27, 0x2A, 0x2B};
+      return RType(R(RandomSourceReg(rng)), R(RandomSourceReg(rng)), R(RandomDestReg(rng, false)), 0,
+                   functs[RandomValue(rng, static_cast<u32>(std::size(functs)))]);
+    }
+
+    case 1:
+    {
+      // sll, srl, sra
+      static constexpr u32 functs[] = {0x00, 0x02, 0x03};
+      return RType(0, R(RandomSourceReg(rng)), R(RandomDestReg(rng, false)), RandomValue(rng, 32),
+                   functs[RandomValue(rng, static_cast<u32>(std::size(functs)))]);
+    }
+
+    case 2:
+      // addiu, slti, sltiu, andi, ori, xori, lui
+      return IType(0x09 + RandomValue(rng, 7), R(RandomSourceReg(rng)), R(RandomDestReg(rng, false)), rng());
+
+    case 3:
+      // mult, multu, div, divu
+      return RType(R(RandomSourceReg(rng)), R(RandomSourceReg(rng)), 0, 0, 0x18 + RandomValue(rng, 4));
+
+    case 4:
+      // mfhi, mflo, mthi, mtlo
+      if (RandomValue(rng, 2))
+        return RType(0, 0, R(RandomDestReg(rng, false)), 0, 0x10 + RandomValue(rng, 2) * 2);
+      else
+        return RType(R(RandomSourceReg(rng)), 0, 0, 0, 0x11 + RandomValue(rng, 2) * 2);
+
+    case 5:
+      // mfc2/mtc2
+      if (RandomValue(rng, 2))
+        return (0x12u << 26) | (0x04u << 21) | (R(RandomSourceReg(rng)) << 16) | (RandomValue(rng, 6) << 11);
+      else
+        return (0x12u << 26) | (R(RandomDestReg(rng, true)) << 16) | (RandomValue(rng, 6) << 11);
+
+    case 6:
+      // mfc0/mtc0 with BPC, which are left to the interpreter
+      if (RandomValue(rng, 2))
+        return (0x10u << 26) | (0x04u << 21) | (R(RandomSourceReg(rng)) << 16) | (3u << 11);
+      else
+        return (0x10u << 26) | (R(RandomDestReg(rng, true)) << 16) | (3u << 11);
+
+    default:
+      return RandomMemoryInstruction(rng, delay_slot);
+  }
+}
+
+// Generates a program which loads every register from the data area, then repeats a random sequence of instructions
+// and forward branches.
+static std::vector<u32> RandomProgram(std::mt19937& rng, VirtualMemoryAddress address, u32 num_units, u32 repeat_count)
+{
+  std::vector<u32> code;
+  code.push_back(IType(0x0F, 0, R(Reg::s1), SCRATCHPAD_ADDRESS >> 16));
+  for (u32 reg = 1; reg < 32; reg++)
+  {
+    if (reg != R(Reg::s0) && reg != R(Reg::s1))
+      code.push_back(LW(static_cast<Reg>(reg), Reg::s0, 0x800 + reg * sizeof(u32)));
+  }
+  code.push_back(RType(R(Reg::at), 0, 0, 0, 0x11)); // mthi
+  code.push_back(RType(R(Reg::v0), 0, 0, 0, 0x13)); // mtlo
+  code.push_back(ORI(RANDOM_LOOP_REG, Reg::zero, repeat_count));
+  const u32 loop_start = static_cast<u32>(code.size());
+
+  // each unit is an instruction, or a branch and its delay slot, which targets one of the next few units
+  std::vector<u32> unit_starts;
+  std::vector<std::pair<u32, u32>> branches;
+  for (u32 unit = 0; unit < num_units; unit++)
+  {
+    unit_starts.push_back(static_cast<u32>(code.size()));
+    if (RandomValue(rng, 5) != 0)
+    {
+      code.push_back(RandomInstruction(rng, false));
+      continue;
+    }
+
+    // beq, bne, blez, bgtz, bltz/bgez/bltzal/bgezal, j, jal
+    static constexpr u32 ops[] = {0x04, 0x05, 0x06, 0x07, 0x01, 0x02, 0x03};
+    const u32 op = ops[RandomValue(rng, static_cast<u32>(std::size(ops)))];
+    branches.emplace_back(static_cast<u32>(code.size()), unit + 1 + RandomValue(rng, 3));
+    if (op == 0x01)
+      code.push_back(IType(op, R(RandomSourceReg(rng)), (RandomValue(rng, 2) * 0x10) | RandomValue(rng, 2), 0));
+    else if (op == 0x02 || op == 0x03)
+      code.push_back(op << 26);
+    else
+      code.push_back(IType(op, R(RandomSourceReg(rng)), (op <= 0x05) ? R(RandomSourceReg(rng)) : 0, 0));
+    code.push_back(RandomInstruction(rng, true));
+  }
+
+  const u32 loop_end = static_cast<u32>(code.size());
+  for (const auto& [index, target_unit] : branches)
+  {
+    const u32 target = (target_unit < num_units) ? unit_starts[target_unit] : loop_end;
+    const u32 op = code[index] >> 26;
+    if (op == 0x02 || op == 0x03)
+      code[index] |= ((address >> 2) + target) & 0x3FFFFFF;
+    else
+      code[index] |= BranchOffset(index, target) & 0xFFFF;
+  }
+
+  code.push_back(ADDIU(RANDOM_LOOP_REG, RANDOM_LOOP_REG, 0xFFFF));
+  code.push_back(BNE(RANDOM_LOOP_REG, Reg::zero, BranchOffset(loop_end + 1, loop_start)));
+  code.push_back(NOP);
+  code.push_back(BEQ(Reg::zero, Reg::zero, BranchOffset(loop_end + 3, loop_end + 3)));
+  code.push_back(NOP);
+  return code;
+}
+
+TEST_F(CPURecompilerTest, RandomProgramsMatchInterpreter)
+{
+  // Exercises the register allocation and dataflow analysis in blocks and traces, with load delays, hi/lo, the GTE
+  // and the interpreter fallback.
+  std::mt19937 rng(0x52414E44);
+  for (u32 iteration = 0; iteration < 300; iteration++)
+  {
+    for (u8& byte : s_data)
+      byte = static_cast<u8>(rng());
+
+    // some of the programs repeat often enough for their blocks to be turned into traces
+    const u32 repeat_count = ((iteration % 8) == 0) ? (CodeCache::TRACE_HOT_BLOCK_THRESHOLD + 500) : 100;
+    const std::vector<u32> code = RandomProgram(rng, PROGRAM_ADDRESS, 8 + RandomValue(rng, 40), repeat_count);
+    LoadProgram(code);
+    CodeCache::Flush();
+
+    SCOPED_TRACE(testing::Message() << "iteration " << iteration);
+    const MachineState state = RunAndCompare(static_cast<TickCount>(repeat_count * 2000));
+    EXPECT_EQ(state.regs[R(RANDOM_LOOP_REG)], 0u);
+    if (HasFailure())
+      return;
+  }
+}
+
+#endif
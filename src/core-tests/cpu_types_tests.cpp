@@ -0,0 +1,142 @@
+#include "core/cpu_types.h"
+#include "gtest/gtest.h"
+#include <initializer_list>
+
+using namespace CPU;
+
+static constexpr u32 R(Reg reg)
+{
+  return static_cast<u32>(reg);
+}
+
+static constexpr u32 RType(InstructionFunct funct, Reg rd, Reg rs, Reg rt, u32 shamt = 0)
+{
+  return (R(rs) << 21) | (R(rt) << 16) | (R(rd) << 11) | (shamt << 6) | static_cast<u32>(funct);
+}
+
+static constexpr u32 IType(InstructionOp op, Reg rt, Reg rs, u16 imm)
+{
+  return (static_cast<u32>(op) << 26) | (R(rs) << 21) | (R(rt) << 16) | imm;
+}
+
+static constexpr u32 Cop(InstructionOp op, CopCommonInstruction common_op, Reg rt, u32 rd)
+{
+  return (static_cast<u32>(op) << 26) | (static_cast<u32>(common_op) << 21) | (R(rt) << 16) | (rd << 11);
+}
+
+static u64 Bits(std::initializer_list<Reg> regs)
+{
+  u64 bits = 0;
+  for (Reg reg : regs)
+    bits |= UINT64_C(1) << R(reg);
+  return bits;
+}
+
+static void CheckUsage(u32 bits, u64 expected_reads, u64 expected_writes)
+{
+  SCOPED_TRACE(testing::Message() << "instruction 0x" << std::hex << bits);
+
+  u64 reads = 0, writes = 0;
+  ASSERT_TRUE(GetInstructionRegisterUsage(Instruction{bits}, &reads, &writes));
+  EXPECT_EQ(reads, expected_reads);
+  EXPECT_EQ(writes, expected_writes);
+}
+
+static void CheckUnknown(u32 bits)
+{
+  SCOPED_TRACE(testing::Message() << "instruction 0x" << std::hex << bits);
+
+  u64 reads = 0, writes = 0;
+  ASSERT_FALSE(GetInstructionRegisterUsage(Instruction{bits}, &reads, &writes));
+  EXPECT_EQ(reads, ~UINT64_C(0));
+  EXPECT_EQ(writes, ~UINT64_C(0));
+}
+
+TEST(CPUTypes, ALUInstructionRegisterUsage)
+{
+  CheckUsage(RType(InstructionFunct::sll, Reg::t0, Reg::zero, Reg::t1, 4), Bits({Reg::t1}), Bits({Reg::t0}));
+  CheckUsage(RType(InstructionFunct::srav, Reg::t0, Reg::t2, Reg::t1), Bits({Reg::t1, Reg::t2}), Bits({Reg::t0}));
+  CheckUsage(RType(InstructionFunct::addu, Reg::v0, Reg::a0, Reg::a1), Bits({Reg::a0, Reg::a1}), Bits({Reg::v0}));
+  CheckUsage(RType(InstructionFunct::nor, Reg::s0, Reg::s0, Reg::s0), Bits({Reg::s0}), Bits({Reg::s0}));
+  CheckUsage(IType(InstructionOp::addiu, Reg::sp, Reg::sp, 0xFFF0), Bits({Reg::sp}), Bits({Reg::sp}));
+  CheckUsage(IType(InstructionOp::ori, Reg::at, Reg::t3, 0x1234), Bits({Reg::t3}), Bits({Reg::at}));
+  CheckUsage(IType(InstructionOp::lui, Reg::at, Reg::t3, 0x8001), 0, Bits({Reg::at}));
+}
+
+TEST(CPUTypes, MultiplyDivideRegisterUsage)
+{
+  CheckUsage(RType(InstructionFunct::mult, Reg::zero, Reg::a0, Reg::a1), Bits({Reg::a0, Reg::a1}),
+             Bits({Reg::hi, Reg::lo}));
+  CheckUsage(RType(InstructionFunct::divu, Reg::zero, Reg::a2, Reg::a3), Bits({Reg::a2, Reg::a3}),
+             Bits({Reg::hi, Reg::lo}));
+  CheckUsage(RType(InstructionFunct::mfhi, Reg::v0, Reg::zero, Reg::zero), Bits({Reg::hi}), Bits({Reg::v0}));
+  CheckUsage(RType(InstructionFunct::mflo, Reg::v1, Reg::zero, Reg::zero), Bits({Reg::lo}), Bits({Reg::v1}));
+  CheckUsage(RType(InstructionFunct::mthi, Reg::zero, Reg::t0, Reg::zero), Bits({Reg::t0}), Bits({Reg::hi}));
+  CheckUsage(RType(InstructionFunct::mtlo, Reg::zero, Reg::t1, Reg::zero), Bits({Reg::t1}), Bits({Reg::lo}));
+}
+
+TEST(CPUTypes, BranchRegisterUsage)
+{
+  // bltz/bgez only read, bltzal/bgezal also write the return address, even when the branch isn't taken.
+  CheckUsage(IType(InstructionOp::b, static_cast<Reg>(0x00), Reg::t0, 4), Bits({Reg::t0}), 0);
+  CheckUsage(IType(InstructionOp::b, static_cast<Reg>(0x01), Reg::t0, 4), Bits({Reg::t0}), 0);
+  CheckUsage(IType(InstructionOp::b, static_cast<Reg>(0x10), Reg::t0, 4), Bits({Reg::t0}), Bits({Reg::ra}));
+  CheckUsage(IType(InstructionOp::b, static_cast<Reg>(0x11), Reg::t0, 4), Bits({Reg::t0}), Bits({Reg::ra}));
+  CheckUsage(IType(InstructionOp::beq, Reg::t1, Reg::t0, 4), Bits({Reg::t0, Reg::t1}), 0);
+  CheckUsage(IType(InstructionOp::bgtz, Reg::zero, Reg::t2, 4), Bits({Reg::t2}), 0);
+  CheckUsage((static_cast<u32>(InstructionOp::j) << 26) | 0x4000, 0, 0);
+  CheckUsage((static_cast<u32>(InstructionOp::jal) << 26) | 0x4000, 0, Bits({Reg::ra}));
+  CheckUsage(RType(InstructionFunct::jr, Reg::zero, Reg::ra, Reg::zero), Bits({Reg::ra}), 0);
+  CheckUsage(RType(InstructionFunct::jalr, Reg::t9, Reg::t8, Reg::zero), Bits({Reg::t8}), Bits({Reg::t9}));
+  CheckUsage(RType(InstructionFunct::syscall, Reg::zero, Reg::zero, Reg::zero), 0, 0);
+}
+
+TEST(CPUTypes, MemoryRegisterUsage)
+{
+  CheckUsage(IType(InstructionOp::lw, Reg::t0, Reg::sp, 0x10), Bits({Reg::sp}), Bits({Reg::t0}));
+  CheckUsage(IType(InstructionOp::lbu, Reg::t0, Reg::t0, 0x10), Bits({Reg::t0}), Bits({Reg::t0}));
+
+  // The unaligned loads merge with the previous value of the register.
+  CheckUsage(IType(InstructionOp::lwl, Reg::t0, Reg::a0, 3), Bits({Reg::a0, Reg::t0}), Bits({Reg::t0}));
+  CheckUsage(IType(InstructionOp::lwr, Reg::t0, Reg::a0, 0), Bits({Reg::a0, Reg::t0}), Bits({Reg::t0}));
+
+  CheckUsage(IType(InstructionOp::sw, Reg::ra, Reg::sp, 0x14), Bits({Reg::sp, Reg::ra}), 0);
+  CheckUsage(IType(InstructionOp::swr, Reg::t1, Reg::a1, 0), Bits({Reg::a1, Reg::t1}), 0);
+
+  // The GTE loads and stores only use the GPR for the address.
+  CheckUsage(IType(InstructionOp::lwc2, static_cast<Reg>(9), Reg::a0, 0), Bits({Reg::a0}), 0);
+  CheckUsage(IType(InstructionOp::swc2, static_cast<Reg>(9), Reg::a0, 0), Bits({Reg::a0}), 0);
+}
+
+TEST(CPUTypes, CoprocessorRegisterUsage)
+{
+  CheckUsage(Cop(InstructionOp::cop0, CopCommonInstruction::mfcn, Reg::k0, 12), 0, Bits({Reg::k0}));
+  CheckUsage(Cop(InstructionOp::cop0, CopCommonInstruction::mtcn, Reg::k0, 12), Bits({Reg::k0}), 0);
+  CheckUsage(Cop(InstructionOp::cop2, CopCommonInstruction::mfcn, Reg::v0, 7), 0, Bits({Reg::v0}));
+  CheckUsage(Cop(InstructionOp::cop2, CopCommonInstruction::cfcn, Reg::v0, 31), 0, Bits({Reg::v0}));
+  CheckUsage(Cop(InstructionOp::cop2, CopCommonInstruction::mtcn, Reg::a0, 0), Bits({Reg::a0}), 0);
+  CheckUsage(Cop(InstructionOp::cop2, CopCommonInstruction::ctcn, Reg::a0, 0), Bits({Reg::a0}), 0);
+
+  // GTE commands and rfe don't touch the GPRs.
+  CheckUsage(0x4A180001u, 0, 0); // rtps
+  CheckUsage(0x4A280030u, 0, 0); // rtpt
+  CheckUsage(0x42000010u, 0, 0); // rfe
+}
+
+TEST(CPUTypes, ZeroRegisterIsIgnored)
+{
+  CheckUsage(RType(InstructionFunct::addu, Reg::zero, Reg::zero, Reg::t0), Bits({Reg::t0}), 0);
+  CheckUsage(IType(InstructionOp::lw, Reg::zero, Reg::zero, 0x100), 0, 0);
+  CheckUsage(IType(InstructionOp::sw, Reg::zero, Reg::zero, 0x100), 0, 0);
+  CheckUsage(Cop(InstructionOp::cop2, CopCommonInstruction::mfcn, Reg::zero, 7), 0, 0);
+}
+
+TEST(CPUTypes, UnknownInstructionsUseEverything)
+{
+  CheckUnknown(RType(static_cast<InstructionFunct>(1), Reg::t0, Reg::t1, Reg::t2));
+  CheckUnknown(RType(static_cast<InstructionFunct>(0x3F), Reg::t0, Reg::t1, Reg::t2));
+  CheckUnknown(IType(static_cast<InstructionOp>(0x3F), Reg::t0, Reg::t1, 0));
+  CheckUnknown(IType(InstructionOp::lwc0, Reg::t0, Reg::t1, 0));
+  CheckUnknown(Cop(InstructionOp::cop0, CopCommonInstruction::bcnc, Reg::zero, 0));
+  CheckUnknown(0x42000001u); // tlbr
+}
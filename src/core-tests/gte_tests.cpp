@@ -0,0 +1,72 @@
+#include "core/gte.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <iterator>
+#include <random>
+
+using RegisterArray = std::array<u32, GTE::NUM_REGS>;
+
+// Picks values which are mostly in range, but regularly overflow or saturate.
+static u32 RandomRegisterValue(std::mt19937& rng)
+{
+  switch (rng() % 4)
+  {
+    case 0:
+      return rng();
+    case 1:
+      return rng() & 0x00FF00FF;
+    case 2:
+      return static_cast<u32>(static_cast<s32>(rng() % 0x2000) - 0x1000) & 0xFFFF;
+    default:
+      return (rng() & 0x0FFF0FFF) | ((rng() & 1) ? 0xF000F000 : 0);
+  }
+}
+
+static void SaveRegisters(RegisterArray& regs)
+{
+  for (u32 i = 0; i < GTE::NUM_REGS; i++)
+    regs[i] = *GTE::GetRegisterPtr(i);
+}
+
+static void LoadRegisters(const RegisterArray& regs)
+{
+  for (u32 i = 0; i < GTE::NUM_REGS; i++)
+    *GTE::GetRegisterPtr(i) = regs[i];
+}
+
+TEST(GTE, VectorizedCommandsMatchScalar)
+{
+  static constexpr u8 commands[] = {0x01, 0x30, 0x12, 0x1E, 0x20, 0x1B, 0x3F,
+                                    0x13, 0x16, 0x1C, 0x14, 0x29, 0x10, 0x2A, 0x11};
+
+  std::mt19937 rng(0x4754450A);
+  RegisterArray input = {};
+  RegisterArray scalar = {};
+  RegisterArray vectorized = {};
+  for (u32 iteration = 0; iteration < 200000; iteration++)
+  {
+    for (u32 i = 0; i < GTE::NUM_REGS; i++)
+    {
+      if (i != 15 && i != 28 && i != 63)
+        GTE::WriteRegister(i, RandomRegisterValue(rng));
+    }
+    GTE::WriteRegister(63, 0);
+    SaveRegisters(input);
+
+    GTE::Instruction inst{static_cast<u32>(rng() & 0x000FE400u)};
+    inst.command = commands[iteration % std::size(commands)];
+
+    GTE::ExecuteInstructionScalar(inst.bits);
+    SaveRegisters(scalar);
+
+    LoadRegisters(input);
+    GTE::ExecuteInstruction(inst.bits);
+    SaveRegisters(vectorized);
+
+    for (u32 i = 0; i < GTE::NUM_REGS; i++)
+    {
+      ASSERT_EQ(vectorized[i], scalar[i]) << "register " << i << " after command " << static_cast<u32>(inst.command)
+                                          << " (0x" << std::hex << inst.bits << ")";
+    }
+  }
+}
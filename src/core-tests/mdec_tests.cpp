@@ -0,0 +1,140 @@
+#include "core/mdec.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <random>
+
+class MDECTest : public testing::Test
+{
+protected:
+  using Block = std::array<s16, 64>;
+
+  // The table games upload with the set scale command, the DCT basis in 1.15 fixed point.
+  static void SetStandardScaleTable(MDEC& mdec)
+  {
+    static constexpr double PI = 3.14159265358979323846;
+    for (u32 u = 0; u < 8; u++)
+    {
+      const double cu = (u == 0) ? std::sqrt(0.5) : 1.0;
+      for (u32 x = 0; x < 8; x++)
+      {
+        const double value = std::round(32768.0 * cu * std::cos((2 * x + 1) * u * PI / 16.0));
+        mdec.m_scale_table[u * 8 + x] = static_cast<s16>(std::clamp(value, -32768.0, 32767.0));
+      }
+    }
+  }
+
+  static void SetRandomScaleTable(MDEC& mdec, std::mt19937& rng)
+  {
+    for (s16& value : mdec.m_scale_table)
+      value = static_cast<s16>(rng());
+  }
+
+  // The run-length decoder clamps the coefficients to 11 bits. Most of them are small or zero in real streams.
+  static Block RandomBlock(std::mt19937& rng)
+  {
+    Block blk;
+    const u32 mode = rng() % 3;
+    for (s16& value : blk)
+    {
+      if (mode == 0)
+        value = static_cast<s16>(static_cast<s32>(rng() % 0x800) - 0x400);
+      else if (mode == 1)
+        value = ((rng() % 4) == 0) ? static_cast<s16>(static_cast<s32>(rng() % 64) - 32) : 0;
+      else
+        value = (rng() & 1) ? 0x3FF : -0x400;
+    }
+    return blk;
+  }
+
+  // IDCT output is 8-bit, but wider values are used too so that every clamp is hit.
+  static void SetRandomColourBlocks(MDEC& mdec, std::mt19937& rng)
+  {
+    const u32 mode = rng() % 3;
+    for (auto& blk : mdec.m_blocks)
+    {
+      for (s16& value : blk)
+      {
+        if (mode == 0)
+          value = static_cast<s16>(static_cast<s32>(rng() % 256) - 128);
+        else if (mode == 1)
+          value = static_cast<s16>(static_cast<s32>(rng() % 1024) - 512);
+        else
+          value = (rng() & 1) ? 127 : -128;
+      }
+    }
+  }
+
+  static void CheckColourConversionMatchesScalar(MDEC& mdec, std::mt19937& rng, u32 num_blocks, bool signed_output)
+  {
+    mdec.m_status.data_output_signed = signed_output;
+    for (u32 i = 0; i < num_blocks; i++)
+    {
+      SetRandomColourBlocks(mdec, rng);
+
+      mdec.yuv_to_rgb_scalar();
+      const std::array<u32, 256> scalar = mdec.m_block_rgb;
+      mdec.m_block_rgb.fill(0xCDCDCDCDu);
+      mdec.yuv_to_rgb();
+      for (u32 j = 0; j < 256; j++)
+        ASSERT_EQ(mdec.m_block_rgb[j], scalar[j]) << "RGB pixel " << j << " of block " << i;
+
+      mdec.y_to_mono_scalar(mdec.m_blocks[2]);
+      const std::array<u32, 256> scalar_mono = mdec.m_block_rgb;
+      mdec.m_block_rgb.fill(0xCDCDCDCDu);
+      mdec.y_to_mono(mdec.m_blocks[2]);
+      for (u32 j = 0; j < 64; j++)
+        ASSERT_EQ(mdec.m_block_rgb[j], scalar_mono[j]) << "mono pixel " << j << " of block " << i;
+    }
+  }
+
+  static void CheckIDCTMatchesScalar(MDEC& mdec, std::mt19937& rng, u32 num_blocks)
+  {
+    for (u32 i = 0; i < num_blocks; i++)
+    {
+      const Block input = RandomBlock(rng);
+      Block scalar = input;
+      Block idct = input;
+      mdec.IDCTScalar(scalar.data());
+      mdec.IDCT(idct.data());
+      for (u32 j = 0; j < 64; j++)
+        ASSERT_EQ(idct[j], scalar[j]) << "coefficient " << j << " of block " << i;
+    }
+  }
+};
+
+TEST_F(MDECTest, IDCTMatchesScalarWithStandardScaleTable)
+{
+  std::unique_ptr<MDEC> mdec = std::make_unique<MDEC>();
+  SetStandardScaleTable(*mdec);
+
+  std::mt19937 rng(0x49444354);
+  CheckIDCTMatchesScalar(*mdec, rng, 100000);
+}
+
+TEST_F(MDECTest, IDCTMatchesScalarWithRandomScaleTables)
+{
+  std::unique_ptr<MDEC> mdec = std::make_unique<MDEC>();
+  std::mt19937 rng(0x5343414C);
+  for (u32 i = 0; i < 1000; i++)
+  {
+    SetRandomScaleTable(*mdec, rng);
+    CheckIDCTMatchesScalar(*mdec, rng, 100);
+  }
+}
+
+TEST_F(MDECTest, ColourConversionMatchesScalarUnsigned)
+{
+  std::unique_ptr<MDEC> mdec = std::make_unique<MDEC>();
+  std::mt19937 rng(0x52474255);
+  CheckColourConversionMatchesScalar(*mdec, rng, 10000, false);
+}
+
+TEST_F(MDECTest, ColourConversionMatchesScalarSigned)
+{
+  std::unique_ptr<MDEC> mdec = std::make_unique<MDEC>();
+  std::mt19937 rng(0x52474253);
+  CheckColourConversionMatchesScalar(*mdec, rng, 10000, true);
+}
@@ -0,0 +1,149 @@
+#include "core/spu.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+class SPUTest : public testing::Test
+{
+protected:
+  static constexpr u32 SAMPLE_ADDRESS = 0x8000;
+  static constexpr u32 NUM_SAMPLE_BLOCKS = 64;
+  static constexpr u32 NUM_TEST_VOICES = 4;
+  static constexpr u32 NUM_FRAMES = 4096;
+
+  // Reverb work area at the end of RAM, the upper 4KB.
+  static constexpr u16 REVERB_BASE = 0xFC00;
+
+  struct Output
+  {
+    std::vector<s16> frames;
+    std::vector<u8> ram;
+  };
+
+  static std::unique_ptr<SPU> CreateSPU(u16 iir_dest_a)
+  {
+    std::unique_ptr<SPU> spu = std::make_unique<SPU>();
+    spu->m_SPUCNT.enable = true;
+    spu->m_SPUCNT.mute_n = true;
+    spu->m_SPUCNT.reverb_master_enable = true;
+    spu->m_main_volume_left.current_level = 0x3FFF;
+    spu->m_main_volume_right.current_level = 0x3FFF;
+    spu->m_noise_level = 1;
+
+    // Looping sample data, which the reverb may overwrite if its destinations wrap around.
+    std::mt19937 rng(0x535055);
+    for (u32 i = 0; i < NUM_SAMPLE_BLOCKS; i++)
+    {
+      SPU::ADPCMBlock block;
+      block.shift_filter.bits = static_cast<u8>(rng() % 13) | static_cast<u8>((rng() % 5) << 4);
+      block.flags.bits = 0;
+      block.flags.loop_start = (i == 0);
+      block.flags.loop_end = (i == NUM_SAMPLE_BLOCKS - 1);
+      block.flags.loop_repeat = (i == NUM_SAMPLE_BLOCKS - 1);
+      for (u8& byte : block.data)
+        byte = static_cast<u8>(rng());
+      std::memcpy(&spu->m_ram[SAMPLE_ADDRESS + i * sizeof(block)], &block, sizeof(block));
+    }
+
+    for (u32 i = 0; i < NUM_TEST_VOICES; i++)
+    {
+      SPU::Voice& voice = spu->m_voices[i];
+      voice.regs.volume_left.bits = 0x3FFF;
+      voice.regs.volume_right.bits = 0x2FFF;
+      voice.regs.adpcm_sample_rate = static_cast<u16>(0x1000 + i * 0x700);
+      voice.regs.adpcm_start_address = static_cast<u16>(SAMPLE_ADDRESS / 8);
+      voice.regs.adpcm_repeat_address = static_cast<u16>(SAMPLE_ADDRESS / 8);
+      voice.current_address = static_cast<u16>(SAMPLE_ADDRESS / 8);
+      voice.regs.adsr.bits_low = 0x00FF;
+      voice.regs.adsr.bits_high = 0;
+      voice.left_volume.Reset(voice.regs.volume_left);
+      voice.right_volume.Reset(voice.regs.volume_right);
+    }
+    spu->m_key_on_register = (1u << NUM_TEST_VOICES) - 1;
+    spu->m_reverb_on_register = (1u << NUM_TEST_VOICES) - 1;
+
+    SPU::ReverbRegisters& rr = spu->m_reverb_registers;
+    rr.vLOUT = 0x4000;
+    rr.vROUT = 0x4000;
+    rr.mBASE = REVERB_BASE;
+    rr.FB_SRC_A = 0x10;
+    rr.FB_SRC_B = 0x20;
+    rr.IIR_ALPHA = 0x6000;
+    rr.ACC_COEF_A = 0x4000;
+    rr.ACC_COEF_B = -0x3000;
+    rr.ACC_COEF_C = 0x2000;
+    rr.ACC_COEF_D = -0x1000;
+    rr.IIR_COEF = -0x5000;
+    rr.FB_ALPHA = 0x5000;
+    rr.FB_X = 0x4000;
+    rr.IIR_DEST_A[0] = iir_dest_a;
+    rr.IIR_DEST_A[1] = static_cast<u16>(iir_dest_a + 1);
+    rr.ACC_SRC_A[0] = 0x30;
+    rr.ACC_SRC_A[1] = 0x31;
+    rr.ACC_SRC_B[0] = 0x40;
+    rr.ACC_SRC_B[1] = 0x41;
+    rr.IIR_SRC_A[0] = 0x50;
+    rr.IIR_SRC_A[1] = 0x51;
+    rr.IIR_DEST_B[0] = 0x60;
+    rr.IIR_DEST_B[1] = 0x61;
+    rr.ACC_SRC_C[0] = 0x70;
+    rr.ACC_SRC_C[1] = 0x71;
+    rr.ACC_SRC_D[0] = 0x80;
+    rr.ACC_SRC_D[1] = 0x81;
+    rr.IIR_SRC_B[0] = 0x90;
+    rr.IIR_SRC_B[1] = 0x91;
+    rr.MIX_DEST_A[0] = 0xA0;
+    rr.MIX_DEST_A[1] = 0xA1;
+    rr.MIX_DEST_B[0] = 0xB0;
+    rr.MIX_DEST_B[1] = 0xB1;
+    rr.IN_COEF[0] = 0x7000;
+    rr.IN_COEF[1] = 0x7000;
+    spu->m_reverb_base_address = spu->m_reverb_current_address = ZeroExtend32(REVERB_BASE) << 2;
+    spu->m_reverb_downsample_buffer = {};
+    spu->m_reverb_upsample_buffer = {};
+    return spu;
+  }
+
+  static bool CanBatchVoices(const SPU& spu) { return spu.CanBatchVoices(SPU::MAX_VOICE_BATCH_FRAMES); }
+
+  static Output Render(SPU& spu, bool batch_voices)
+  {
+    Output out;
+    out.frames.resize(NUM_FRAMES * 2);
+    for (u32 i = 0; i < NUM_FRAMES; i += 256)
+      spu.GenerateFrames(&out.frames[i * 2], 256, batch_voices);
+
+    out.ram.assign(spu.m_ram.begin(), spu.m_ram.end());
+    return out;
+  }
+
+  static void CheckBatchedMatchesPerFrame(u16 iir_dest_a)
+  {
+    std::unique_ptr<SPU> batched = CreateSPU(iir_dest_a);
+    std::unique_ptr<SPU> per_frame = CreateSPU(iir_dest_a);
+    const Output batched_out = Render(*batched, true);
+    const Output per_frame_out = Render(*per_frame, false);
+
+    for (u32 i = 0; i < NUM_FRAMES * 2; i++)
+      ASSERT_EQ(batched_out.frames[i], per_frame_out.frames[i]) << "sample " << i;
+    for (u32 i = 0; i < SPU::RAM_SIZE; i++)
+      ASSERT_EQ(batched_out.ram[i], per_frame_out.ram[i]) << "RAM byte 0x" << std::hex << i;
+  }
+};
+
+TEST_F(SPUTest, BatchedVoicesMatchPerFrameWithReverbAtEndOfRAM)
+{
+  // Writes stay within the work area, so the voices can be batched.
+  ASSERT_TRUE(CanBatchVoices(*CreateSPU(0x100)));
+  CheckBatchedMatchesPerFrame(0x100);
+}
+
+TEST_F(SPUTest, BatchedVoicesMatchPerFrameWithReverbWrappingIntoSamples)
+{
+  // IIR_DEST_A wraps around past the end of RAM, and lands on the sample data at 0x8000.
+  ASSERT_FALSE(CanBatchVoices(*CreateSPU(0x1800)));
+  CheckBatchedMatchesPerFrame(0x1800);
+}
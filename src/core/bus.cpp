@@ -177,7 +177,34 @@ bool DoState(StateWrapper& sw)
   sw.Do(&m_bios_access_time);
   sw.Do(&m_cdrom_access_time);
   sw.Do(&m_spu_access_time);
-  sw.DoBytes(g_ram, RAM_SIZE);
+
+  if (sw.IsReading())
+  {
+    // Only throw away blocks in code pages which actually changed. After a full state load the code cache has already
+    // been flushed, but memory states are loaded every frame for runahead and mostly contain the same code.
+    std::array<u8, HOST_PAGE_SIZE> page_buffer;
+    for (u32 page_index = 0; page_index < (RAM_SIZE / HOST_PAGE_SIZE); page_index++)
+    {
+      u8* page_ptr = &g_ram[page_index * HOST_PAGE_SIZE];
+      if (!m_ram_code_bits[page_index])
+      {
+        sw.DoBytes(page_ptr, HOST_PAGE_SIZE);
+        continue;
+      }
+
+      sw.DoBytes(page_buffer.data(), HOST_PAGE_SIZE);
+      if (std::memcmp(page_ptr, page_buffer.data(), HOST_PAGE_SIZE) != 0)
+      {
+        CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
+        std::memcpy(page_ptr, page_buffer.data(), HOST_PAGE_SIZE);
+      }
+    }
+  }
+  else
+  {
+    sw.DoBytes(g_ram, RAM_SIZE);
+  }
+
   sw.DoBytes(g_bios, BIOS_SIZE);
   sw.DoArray(m_MEMCTRL.regs, countof(m_MEMCTRL.regs));
   sw.Do(&m_ram_size_reg);
@@ -87,6 +87,7 @@ void CDROM::Initialize()
     [](void* param, TickCount ticks, TickCount ticks_late) { static_cast<CDROM*>(param)->ExecuteDrive(ticks_late); },
     this, false);
 
+  m_reader.SetReadaheadCount(g_settings.cdrom_readahead_sectors);
   if (g_settings.cdrom_read_thread)
     m_reader.StartThread();
 
@@ -334,6 +335,11 @@ void CDROM::SetUseReadThread(bool enabled)
     m_reader.StopThread();
 }
 
+void CDROM::SetReadaheadSectors(u32 readahead_sectors)
+{
+  m_reader.SetReadaheadCount(readahead_sectors);
+}
+
 void CDROM::CPUClockChanged()
 {
   // reschedule the disc read event
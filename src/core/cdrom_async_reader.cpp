@@ -4,7 +4,10 @@
 #include "common/timer.h"
 Log_SetChannel(CDROMAsyncReader);
 
-CDROMAsyncReader::CDROMAsyncReader() = default;
+CDROMAsyncReader::CDROMAsyncReader()
+{
+  m_buffers.resize(1 + NUM_HISTORY_SECTORS);
+}
 
 CDROMAsyncReader::~CDROMAsyncReader()
 {
@@ -16,7 +19,7 @@ void CDROMAsyncReader::StartThread()
   if (IsUsingThread())
     return;
 
-  m_shutdown_flag.store(false);
+  m_shutdown_flag = false;
   m_read_thread = std::thread(&CDROMAsyncReader::WorkerThreadEntryPoint, this);
 }
 
@@ -27,25 +30,60 @@ void CDROMAsyncReader::StopThread()
 
   {
     std::unique_lock<std::mutex> lock(m_mutex);
-    if (m_sector_read_pending.load())
-      m_notify_read_complete_cv.wait(lock, [this]() { return !m_sector_read_pending.load(); });
+    WaitForIdle(lock);
 
-    m_shutdown_flag.store(true);
+    m_shutdown_flag = true;
     m_do_read_cv.notify_one();
   }
 
   m_read_thread.join();
 }
 
+void CDROMAsyncReader::SetReadaheadCount(u32 count)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (GetReadaheadCount() == count)
+    return;
+
+  WaitForIdle(lock);
+
+  // keep the current sector around, the CDROM code may not have processed it yet
+  if (m_buffer_count > 0)
+  {
+    BufferSlot current = m_buffers[m_buffer_front];
+    m_buffers.resize(count + 1 + NUM_HISTORY_SECTORS);
+    m_buffers[0] = current;
+    m_buffer_front = 0;
+    m_buffer_back = 1 % static_cast<u32>(m_buffers.size());
+    m_buffer_count = 1;
+    m_buffer_history = 0;
+    m_next_position = current.lba + 1;
+    m_read_active &= current.result;
+  }
+  else
+  {
+    m_buffers.resize(count + 1 + NUM_HISTORY_SECTORS);
+    m_buffer_front = 0;
+    m_buffer_back = 0;
+    m_buffer_history = 0;
+  }
+
+  Log_DevPrintf("Readahead set to %u sectors", count);
+}
+
 void CDROMAsyncReader::SetMedia(std::unique_ptr<CDImage> media)
 {
-  WaitForReadToComplete();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  WaitForIdle(lock);
+  EmptyBuffers();
   m_media = std::move(media);
 }
 
 std::unique_ptr<CDImage> CDROMAsyncReader::RemoveMedia()
 {
-  WaitForReadToComplete();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  WaitForIdle(lock);
+  EmptyBuffers();
   return std::move(m_media);
 }
 
@@ -53,34 +91,74 @@ void CDROMAsyncReader::QueueReadSector(CDImage::LBA lba)
 {
   if (!IsUsingThread())
   {
-    m_sector_read_pending.store(true);
-    m_next_position_set.store(true);
-    m_next_position = lba;
-    DoSectorRead();
+    // don't re-read the same sector if it was the last one we read
+    if (m_buffer_count > 0 && m_buffers[m_buffer_front].lba == lba && m_buffers[m_buffer_front].result)
+      return;
+
+    EmptyBuffers();
+    m_buffers[m_buffer_back].result = ReadSectorIntoBuffer(&m_buffers[m_buffer_back], lba);
+    m_buffer_count = 1;
     return;
   }
 
   std::unique_lock<std::mutex> lock(m_mutex);
-  if (m_sector_read_pending.load())
-    m_notify_read_complete_cv.wait(lock, [this]() { return !m_sector_read_pending.load(); });
+  const u32 num_buffers = static_cast<u32>(m_buffers.size());
 
-  // don't re-read the same sector if it was the last one we read
-  // the CDC code does this when seeking->reading
-  if (m_last_read_sector == lba && m_sector_read_result.load())
+  // is the sector already buffered? this also covers the CDC code re-reading the same sector when seeking->reading
+  const CDImage::LBA front_lba = m_buffers[m_buffer_front].lba;
+  if (m_buffer_count > 0 && lba >= front_lba && (lba - front_lba) < m_buffer_count &&
+      m_buffers[(m_buffer_front + (lba - front_lba)) % num_buffers].result)
   {
-    Log_DebugPrintf("Skipping re-reading same sector %u", lba);
+    const u32 skip = lba - front_lba;
+    if (skip > 0)
+    {
+      Log_TracePrintf("Read-ahead hit for LBA %u, skipping %u sectors", lba, skip);
+      m_buffer_front = (m_buffer_front + skip) % num_buffers;
+      m_buffer_count -= skip;
+      m_buffer_history += skip;
+      m_do_read_cv.notify_one();
+    }
+
     return;
   }
 
-  m_sector_read_pending.store(true);
-  m_next_position_set.store(true);
+  // did we already read past it? memory states loaded by runahead and rewind go back a few sectors every frame
+  if (m_buffer_count > 0 && lba < front_lba && (front_lba - lba) <= m_buffer_history &&
+      m_buffers[(m_buffer_front + num_buffers - (front_lba - lba)) % num_buffers].result)
+  {
+    const u32 back = front_lba - lba;
+    Log_TracePrintf("History hit for LBA %u, going back %u sectors", lba, back);
+    m_buffer_front = (m_buffer_front + num_buffers - back) % num_buffers;
+    m_buffer_count += back;
+    m_buffer_history -= back;
+    return;
+  }
+
+  // is it the sector currently being read, or next to be read?
+  if (m_read_active && lba == m_next_position)
+  {
+    m_buffer_front = m_buffer_back;
+    m_buffer_history += m_buffer_count;
+    m_buffer_count = 0;
+    m_do_read_cv.notify_one();
+    return;
+  }
+
+  Log_DebugPrintf("Read-ahead miss for LBA %u, seeking", lba);
+  m_buffer_front = m_buffer_back;
+  m_buffer_count = 0;
+  m_buffer_history = 0;
   m_next_position = lba;
+  m_read_active = true;
+  m_position_changed = m_is_reading;
   m_do_read_cv.notify_one();
 }
 
 bool CDROMAsyncReader::ReadSectorUncached(CDImage::LBA lba, CDImage::SubChannelQ* subq, SectorBuffer* data)
 {
-  WaitForReadToComplete();
+  // the worker thread re-seeks if the position changes underneath it
+  std::unique_lock<std::mutex> lock(m_mutex);
+  WaitForIdle(lock);
 
   if (m_media->GetPositionOnDisc() != lba && !m_media->Seek(lba))
   {
@@ -97,88 +175,106 @@ bool CDROMAsyncReader::ReadSectorUncached(CDImage::LBA lba, CDImage::SubChannelQ
   return true;
 }
 
-void CDROMAsyncReader::QueueReadNextSector()
-{
-  if (!IsUsingThread())
-  {
-    m_sector_read_pending.store(true);
-    DoSectorRead();
-    return;
-  }
-
-  std::unique_lock<std::mutex> lock(m_mutex);
-  if (m_sector_read_pending.load())
-    m_notify_read_complete_cv.wait(lock, [this]() { return !m_sector_read_pending.load(); });
-
-  m_sector_read_pending.store(true);
-  m_do_read_cv.notify_one();
-}
-
 bool CDROMAsyncReader::WaitForReadToComplete()
 {
   if (!IsUsingThread())
-    return m_sector_read_result.load();
+    return (m_buffer_count > 0 && m_buffers[m_buffer_front].result);
 
   std::unique_lock<std::mutex> lock(m_mutex);
-  if (m_sector_read_pending.load())
+  if (m_buffer_count == 0 && m_read_active)
   {
     Log_DebugPrintf("Sector read pending, waiting");
 
     Common::Timer wait_timer;
-    m_notify_read_complete_cv.wait(lock, [this]() { return !m_sector_read_pending.load(); });
+    m_notify_read_complete_cv.wait(lock, [this]() { return (m_buffer_count > 0 || !m_read_active); });
 
     const double wait_time = wait_timer.GetTimeMilliseconds();
     if (wait_time > 1.0f)
-      Log_WarningPrintf("Had to wait %.2f msec for LBA %u", wait_time, m_last_read_sector);
+      Log_WarningPrintf("Had to wait %.2f msec for LBA %u", wait_time, m_buffers[m_buffer_front].lba);
   }
 
-  return m_sector_read_result.load();
+  return (m_buffer_count > 0 && m_buffers[m_buffer_front].result);
+}
+
+void CDROMAsyncReader::EmptyBuffers()
+{
+  m_buffer_front = 0;
+  m_buffer_back = 0;
+  m_buffer_count = 0;
+  m_buffer_history = 0;
+  m_read_active = false;
 }
 
-void CDROMAsyncReader::DoSectorRead()
+void CDROMAsyncReader::WaitForIdle(std::unique_lock<std::mutex>& lock)
+{
+  if (m_is_reading)
+    m_notify_read_complete_cv.wait(lock, [this]() { return !m_is_reading; });
+}
+
+bool CDROMAsyncReader::ReadSectorIntoBuffer(BufferSlot* slot, CDImage::LBA lba)
 {
   Common::Timer timer;
 
-  if (m_next_position_set.load())
+  slot->lba = lba;
+  if (m_media->GetPositionOnDisc() != lba && !m_media->Seek(lba))
   {
-    if (m_media->GetPositionOnDisc() != m_next_position && !m_media->Seek(m_next_position))
-    {
-      Log_WarningPrintf("Seek to LBA %u failed", m_next_position);
-      m_sector_read_result.store(false);
-      return;
-    }
+    Log_WarningPrintf("Seek to LBA %u failed", lba);
+    return false;
   }
 
-  CDImage::LBA pos = m_media->GetPositionOnDisc();
-  if (!m_media->ReadSubChannelQ(&m_subq) || !m_media->ReadRawSector(m_sector_buffer.data()))
+  if (!m_media->ReadSubChannelQ(&slot->subq) || !m_media->ReadRawSector(slot->data.data()))
   {
-    m_sector_read_result.store(false);
-    Log_WarningPrintf("Read of LBA %u failed", pos);
-    return;
+    Log_WarningPrintf("Read of LBA %u failed", lba);
+    return false;
   }
 
-  m_last_read_sector = pos;
-  m_sector_read_result.store(true);
-
   const double read_time = timer.GetTimeMilliseconds();
   if (read_time > 1.0f)
-    Log_DevPrintf("Read LBA %u took %.2f msec", pos, read_time);
+    Log_DevPrintf("Read LBA %u took %.2f msec", lba, read_time);
+
+  return true;
 }
 
 void CDROMAsyncReader::WorkerThreadEntryPoint()
 {
   std::unique_lock lock(m_mutex);
 
-  while (!m_shutdown_flag.load())
+  for (;;)
   {
-    m_do_read_cv.wait(lock, [this]() { return (m_shutdown_flag.load() || m_sector_read_pending.load()); });
-    if (m_sector_read_pending.load())
+    m_do_read_cv.wait(lock, [this]() {
+      return (m_shutdown_flag || (m_read_active && m_buffer_count <= GetReadaheadCount()));
+    });
+    if (m_shutdown_flag)
+      break;
+
+    // reuse the oldest history slot once the ring is full
+    if ((m_buffer_history + m_buffer_count) == static_cast<u32>(m_buffers.size()))
+      m_buffer_history--;
+
+    // the back slot isn't part of the history or read-ahead, so it can be filled without holding the lock
+    const CDImage::LBA lba = m_next_position;
+    BufferSlot* slot = &m_buffers[m_buffer_back];
+    m_is_reading = true;
+    m_position_changed = false;
+    lock.unlock();
+
+    const bool result = ReadSectorIntoBuffer(slot, lba);
+
+    lock.lock();
+    m_is_reading = false;
+
+    // discard the sector if the CPU thread seeked elsewhere while we were reading
+    if (!m_position_changed)
     {
-      lock.unlock();
-      DoSectorRead();
-      lock.lock();
-      m_sector_read_pending.store(false);
-      m_notify_read_complete_cv.notify_one();
+      slot->result = result;
+      m_buffer_back = (m_buffer_back + 1) % static_cast<u32>(m_buffers.size());
+      m_buffer_count++;
+      m_next_position = lba + 1;
+
+      // stop reading ahead on errors, e.g. the end of the disc
+      m_read_active = result;
     }
+
+    m_notify_read_complete_cv.notify_all();
   }
 }
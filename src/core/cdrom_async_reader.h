@@ -2,9 +2,10 @@
 #include "common/cd_image.h"
 #include "types.h"
 #include <array>
-#include <atomic>
 #include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 class CDROMAsyncReader
 {
@@ -14,22 +15,26 @@ public:
   CDROMAsyncReader();
   ~CDROMAsyncReader();
 
-  const CDImage::LBA GetLastReadSector() const { return m_last_read_sector; }
-  const SectorBuffer& GetSectorBuffer() const { return m_sector_buffer; }
-  const CDImage::SubChannelQ& GetSectorSubQ() const { return m_subq; }
+  const CDImage::LBA GetLastReadSector() const { return m_buffers[m_buffer_front].lba; }
+  const SectorBuffer& GetSectorBuffer() const { return m_buffers[m_buffer_front].data; }
+  const CDImage::SubChannelQ& GetSectorSubQ() const { return m_buffers[m_buffer_front].subq; }
   const bool HasMedia() const { return static_cast<bool>(m_media); }
   const CDImage* GetMedia() const { return m_media.get(); }
   const std::string& GetMediaFileName() const { return m_media->GetFileName(); }
+  const u32 GetReadaheadCount() const { return static_cast<u32>(m_buffers.size() - 1 - NUM_HISTORY_SECTORS); }
 
   bool IsUsingThread() const { return m_read_thread.joinable(); }
   void StartThread();
   void StopThread();
 
+  /// Sets the number of sectors which are read ahead of the current sector. Only applies when the thread is in use.
+  void SetReadaheadCount(u32 count);
+
   void SetMedia(std::unique_ptr<CDImage> media);
   std::unique_ptr<CDImage> RemoveMedia();
 
+  /// Queues a read of the specified sector. Sequential reads are served from the read-ahead buffers.
   void QueueReadSector(CDImage::LBA lba);
-  void QueueReadNextSector();
 
   bool WaitForReadToComplete();
 
@@ -37,7 +42,30 @@ public:
   bool ReadSectorUncached(CDImage::LBA lba, CDImage::SubChannelQ* subq, SectorBuffer* data);
 
 private:
-  void DoSectorRead();
+  enum : u32
+  {
+    // Sectors kept behind the current sector, so going back a little, e.g. when runahead or rewind load a memory
+    // state, doesn't throw away the read-ahead.
+    NUM_HISTORY_SECTORS = 32
+  };
+
+  struct BufferSlot
+  {
+    CDImage::LBA lba;
+    SectorBuffer data;
+    CDImage::SubChannelQ subq;
+    bool result;
+  };
+
+  /// Discards any buffered sectors, including the current sector.
+  void EmptyBuffers();
+
+  /// Waits for the worker thread to finish reading. The lock must be held.
+  void WaitForIdle(std::unique_lock<std::mutex>& lock);
+
+  /// Reads the specified sector into a buffer slot, returning the result.
+  bool ReadSectorIntoBuffer(BufferSlot* slot, CDImage::LBA lba);
+
   void WorkerThreadEntryPoint();
 
   std::unique_ptr<CDImage> m_media;
@@ -47,13 +75,18 @@ private:
   std::condition_variable m_do_read_cv;
   std::condition_variable m_notify_read_complete_cv;
 
+  // ring of sectors, the front slot is the current sector, the rest are read-ahead
+  // the history slots before the front are sectors which were already consumed, until the worker reuses them
+  std::vector<BufferSlot> m_buffers;
+  u32 m_buffer_front = 0;
+  u32 m_buffer_back = 0;
+  u32 m_buffer_count = 0;
+  u32 m_buffer_history = 0;
+
+  // position the worker thread reads next, valid when m_read_active is set
   CDImage::LBA m_next_position{};
-  std::atomic_bool m_next_position_set{false};
-  std::atomic_bool m_sector_read_pending{false};
-  std::atomic_bool m_shutdown_flag{true};
-
-  CDImage::LBA m_last_read_sector{};
-  CDImage::SubChannelQ m_subq{};
-  SectorBuffer m_sector_buffer{};
-  std::atomic_bool m_sector_read_result{false};
+  bool m_read_active = false;
+  bool m_position_changed = false;
+  bool m_is_reading = false;
+  bool m_shutdown_flag = true;
 };
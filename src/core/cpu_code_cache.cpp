@@ -1,23 +1,44 @@
 #include "cpu_code_cache.h"
 #include "bus.h"
 #include "common/assert.h"
+#include "common/file_system.h"
 #include "common/log.h"
 #include "cpu_core.h"
 #include "cpu_core_private.h"
 #include "cpu_disasm.h"
+#include "gte.h"
 #include "settings.h"
 #include "system.h"
 #include "timing_event.h"
+#include <algorithm>
+#include <type_traits>
 Log_SetChannel(CPU::CodeCache);
 
 #ifdef WITH_RECOMPILER
 #include "cpu_recompiler_code_generator.h"
+#include "cpu_recompiler_thunks.h"
+#include "xxhash.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#if defined(CPU_AARCH64) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #endif
 
 namespace CPU::CodeCache {
 
 constexpr bool USE_BLOCK_LINKING = true;
 
+ALWAYS_INLINE static u32 GetFastMapIndex(u32 pc)
+{
+  return ((pc & PHYSICAL_MEMORY_ADDRESS_MASK) >= Bus::BIOS_BASE) ?
+           (FAST_MAP_RAM_SLOT_COUNT + ((pc & Bus::BIOS_MASK) >> 2)) :
+           ((pc & Bus::RAM_MASK) >> 2);
+}
+
 #ifdef WITH_RECOMPILER
 
 // Currently remapping the code buffer doesn't work in macOS or Haiku.
@@ -25,6 +46,12 @@ constexpr bool USE_BLOCK_LINKING = true;
 #define USE_STATIC_CODE_BUFFER 1
 #endif
 
+// Persisted host code is restored at the same offset in the static code buffer, so PC-relative references to globals
+// and functions in the executable stay valid. AArch32 backpatches with absolute addresses, so it can't be supported.
+#if defined(USE_STATIC_CODE_BUFFER) && !defined(CPU_AARCH32)
+#define USE_PERSISTENT_CODE_CACHE 1
+#endif
+
 #if defined(AARCH32)
 // Use a smaller code buffer size on AArch32 to have a better chance of being in range.
 static constexpr u32 RECOMPILER_CODE_CACHE_SIZE = 16 * 1024 * 1024;
@@ -47,16 +74,56 @@ std::array<CodeBlock::HostCodePointer, FAST_MAP_TOTAL_SLOT_COUNT> s_fast_map;
 DispatcherFunction s_asm_dispatcher;
 SingleBlockDispatcherFunction s_single_block_asm_dispatcher;
 
-ALWAYS_INLINE static u32 GetFastMapIndex(u32 pc)
-{
-  return ((pc & PHYSICAL_MEMORY_ADDRESS_MASK) >= Bus::BIOS_BASE) ?
-           (FAST_MAP_RAM_SLOT_COUNT + ((pc & Bus::BIOS_MASK) >> 2)) :
-           ((pc & Bus::RAM_MASK) >> 2);
-}
-
 static void CompileDispatcher();
 static void FastCompileBlockFunction();
 
+/// Hot blocks are recompiled as traces, which continue past the branch at the end of the block into the code it
+/// usually goes to. Conditional branches are only followed when they go the same way at least
+/// (TRACE_BRANCH_BIAS_DIVISOR - 1) / TRACE_BRANCH_BIAS_DIVISOR of the time, the trace is left if they don't.
+static constexpr u32 MAX_TRACE_INSTRUCTIONS = 256;
+static constexpr u32 MAX_TRACE_PAGE_SPAN = 4;
+static constexpr u32 TRACE_MIN_BRANCH_SAMPLES = 64;
+static constexpr u32 TRACE_BRANCH_BIAS_DIVISOR = 16;
+
+static std::array<BlockProfile, FAST_MAP_TOTAL_SLOT_COUNT> s_block_profiles;
+static std::vector<CodeBlockKey> s_pending_traces;
+
+static std::optional<u32> GetTraceContinuation(const CodeBlockInstruction& branch, u32 segment_pc,
+                                               bool* conditional);
+static void CompilePendingTraces();
+static void CompileTrace(CodeBlock* block);
+
+struct BackgroundCompileJob
+{
+  std::unique_ptr<CodeBlock> block;
+
+  // filled in by the compile thread, and copied to the backpatch arena when the block is installed
+  std::vector<Recompiler::LoadStoreBackpatchInfo> loadstore_backpatch_info;
+
+  // the compile thread can't read the CPU state, so the registers for speculative constants are captured at queue time
+  std::array<u32, static_cast<u8>(Reg::count)> speculative_regs;
+  bool out_of_space;
+};
+
+/// Blocks are decoded on the CPU thread, then a copy is handed to the compile thread for code generation. Until the
+/// result is installed, the block is executed with the cached interpreter.
+static std::thread s_compile_thread;
+static std::mutex s_compile_mutex;
+static std::condition_variable s_compile_work_cv;
+static std::condition_variable s_compile_idle_cv;
+static std::deque<BackgroundCompileJob> s_compile_queue;
+static std::vector<BackgroundCompileJob> s_compiled_jobs;
+static std::atomic_bool s_compiled_jobs_pending{false};
+static bool s_compile_thread_busy = false;
+static bool s_compile_thread_shutdown = false;
+
+static void StartCompileThread();
+static void StopCompileThread();
+static void CancelBackgroundCompiles();
+static void QueueBackgroundCompile(CodeBlock* block);
+static void InstallBackgroundCompiledBlocks();
+static void CompileThreadEntryPoint();
+
 static void ResetFastMap()
 {
   s_fast_map.fill(FastCompileBlockFunction);
@@ -67,11 +134,200 @@ static void SetFastMap(u32 pc, CodeBlock::HostCodePointer function)
   s_fast_map[GetFastMapIndex(pc)] = function;
 }
 
+#ifdef USE_PERSISTENT_CODE_CACHE
+
+static constexpr u32 PERSISTENT_CACHE_FILE_VERSION = 1;
+
+#pragma pack(push, 1)
+struct PersistentCacheHeader
+{
+  u32 file_version;
+  u64 fingerprint;
+  u32 near_code_offset;
+  u32 near_code_size;
+  u32 far_code_offset;
+  u32 far_code_size;
+  u32 num_blocks;
+  u32 num_backpatch_infos;
+};
+
+struct PersistentCacheBlock
+{
+  u32 key;
+  u32 instruction_count;
+  u64 instruction_hash;
+  u32 host_code_offset;
+  u32 host_code_size;
+  u32 first_backpatch_info;
+  u32 num_backpatch_infos;
+};
+
+struct PersistentCacheBackpatchInfo
+{
+  u32 host_pc_offset;
+  u32 host_slowmem_pc_offset;
+  u32 host_code_size;
+  u32 address_host_reg;
+  u32 value_host_reg;
+  u32 guest_pc;
+  u32 fault_count;
+};
+#pragma pack(pop)
+
+/// Code space used by blocks restored from the persistent cache, kept so it can be re-applied after a flush.
+static PersistentCacheHeader s_persistent_cache_header;
+static std::vector<u8> s_persistent_near_code;
+static std::vector<u8> s_persistent_far_code;
+static std::unordered_map<u32, PersistentCacheBlock> s_persistent_blocks;
+static std::vector<PersistentCacheBackpatchInfo> s_persistent_backpatch_infos;
+static std::vector<u32> s_persistent_hash_buffer;
+
+/// Start of the code space after the dispatchers, which is what gets written to the persistent cache.
+static u8* s_persistent_near_code_start = nullptr;
+static u8* s_persistent_far_code_start = nullptr;
+
+static u64 GetPersistentCacheFingerprint();
+static u64 GetInstructionHash(const CodeBlock* block);
+static u64 GetCodeStorageOffset(const void* ptr);
+static void ApplyPersistentCache();
+static void ClearPersistentCache();
+static bool LookupPersistentBlock(CodeBlock* block);
+
+#endif
+
 #endif
 
 using BlockMap = std::unordered_map<u32, CodeBlock*>;
 using HostCodeMap = std::map<CodeBlock::HostCodePointer, CodeBlock*>;
 
+/// Blocks are indexed by the same slot as the fast map, one second-level page per guest code page. User mode blocks
+/// live in the upper half. Entries whose slot is taken by a different key (e.g. a mirror of the same physical
+/// address), and addresses which failed to compile, go in the overflow map.
+static constexpr u32 BLOCK_TABLE_PAGE_SIZE = HOST_PAGE_SIZE / sizeof(Instruction);
+static constexpr u32 BLOCK_TABLE_PAGE_COUNT = (FAST_MAP_TOTAL_SLOT_COUNT / BLOCK_TABLE_PAGE_SIZE) * 2;
+using BlockTablePage = std::array<CodeBlock*, BLOCK_TABLE_PAGE_SIZE>;
+
+/// Blocks and links are allocated from chunks and recycled through a free list, instead of going to the heap each time.
+template<typename T, u32 ChunkSize>
+class CodeBlockPool
+{
+public:
+  template<typename... Args>
+  T* Allocate(Args&&... args)
+  {
+    if (!m_free_list)
+    {
+      std::unique_ptr<Storage[]> chunk = std::make_unique<Storage[]>(ChunkSize);
+      for (u32 i = 0; i < (ChunkSize - 1); i++)
+        chunk[i].next_free = &chunk[i + 1];
+      chunk[ChunkSize - 1].next_free = nullptr;
+
+      m_free_list = chunk.get();
+      m_chunks.push_back(std::move(chunk));
+    }
+
+    Storage* storage = m_free_list;
+    m_free_list = storage->next_free;
+    return new (storage->data) T(std::forward<Args>(args)...);
+  }
+
+  void Free(T* object)
+  {
+    object->~T();
+
+    Storage* storage = reinterpret_cast<Storage*>(object);
+    storage->next_free = m_free_list;
+    m_free_list = storage;
+  }
+
+  /// Returns every object to the free list at once. Only for trivially destructible types, since nothing is destroyed.
+  void Reset()
+  {
+    static_assert(std::is_trivially_destructible_v<T>, "objects are not destroyed");
+    m_free_list = nullptr;
+    for (const std::unique_ptr<Storage[]>& chunk : m_chunks)
+    {
+      for (u32 i = 0; i < ChunkSize; i++)
+      {
+        chunk[i].next_free = m_free_list;
+        m_free_list = &chunk[i];
+      }
+    }
+  }
+
+  /// Releases the memory. All objects must have been freed.
+  void Release()
+  {
+    m_chunks.clear();
+    m_free_list = nullptr;
+  }
+
+private:
+  union Storage
+  {
+    Storage* next_free;
+    alignas(T) u8 data[sizeof(T)];
+  };
+
+  std::vector<std::unique_ptr<Storage[]>> m_chunks;
+  Storage* m_free_list = nullptr;
+};
+
+/// Decoded instructions and fastmem fixups are bump-allocated, and only released when the cache is cleared.
+/// Recompiling blocks which are modified leaks their old data, so once an arena gets too large, a flush is requested.
+static constexpr u32 MAX_BLOCK_ARENA_CHUNKS = 32;
+template<typename T, u32 ChunkSize>
+class CodeBlockArena
+{
+public:
+  ALWAYS_INLINE bool IsEmpty() const { return m_chunks.empty(); }
+  ALWAYS_INLINE bool IsFull() const { return m_full; }
+
+  CodeBlockArenaList<T> Allocate(const T* items, u32 count, const char* name)
+  {
+    if (count == 0)
+      return {};
+
+    if (m_chunks.empty() || (m_chunks.back().capacity - m_chunks.back().used) < count)
+    {
+      if (m_chunks.size() >= MAX_BLOCK_ARENA_CHUNKS && !m_full)
+      {
+        Log_WarningPrintf("%s arena is full, flushing all blocks.", name);
+        m_full = true;
+      }
+
+      Chunk chunk;
+      chunk.capacity = std::max(count, ChunkSize);
+      chunk.data = std::make_unique<T[]>(chunk.capacity);
+      chunk.used = 0;
+      m_chunks.push_back(std::move(chunk));
+    }
+
+    Chunk& chunk = m_chunks.back();
+    T* data = &chunk.data[chunk.used];
+    std::uninitialized_copy_n(items, count, data);
+    chunk.used += count;
+    return CodeBlockArenaList<T>(data, count);
+  }
+
+  void Clear()
+  {
+    m_chunks.clear();
+    m_full = false;
+  }
+
+private:
+  struct Chunk
+  {
+    std::unique_ptr<T[]> data;
+    u32 capacity;
+    u32 used;
+  };
+
+  std::vector<Chunk> m_chunks;
+  bool m_full = false;
+};
+
 void LogCurrentState();
 
 /// Returns the block key for the current execution state.
@@ -84,7 +340,8 @@ static CodeBlock* LookupBlock(CodeBlockKey key);
 /// The block can also be flushed if recompilation failed, so ignore the pointer if false is returned.
 static bool RevalidateBlock(CodeBlock* block);
 
-static bool CompileBlock(CodeBlock* block);
+/// Decodes and compiles the block. Traces are only formed when trace is set.
+static bool CompileBlock(CodeBlock* block, bool trace = false);
 static void RemoveReferencesToBlock(CodeBlock* block);
 static void AddBlockToPageMap(CodeBlock* block);
 static void RemoveBlockFromPageMap(CodeBlock* block);
@@ -97,11 +354,27 @@ static void UnlinkBlock(CodeBlock* block);
 
 static void ClearState();
 
-static BlockMap s_blocks;
+static CodeBlock** FindBlockEntry(CodeBlockKey key);
+static void InsertBlockEntry(CodeBlockKey key, CodeBlock* block);
+static void RemoveBlockEntry(CodeBlock* block);
+template<typename T>
+static void EnumerateBlocks(T callback);
+
+/// Flushes the cache if a block arena has grown too large. Must only be called when no blocks are in use.
+static void FlushIfBlockArenaFull();
+
+static std::array<std::unique_ptr<BlockTablePage>, BLOCK_TABLE_PAGE_COUNT> s_block_table;
+static BlockMap s_overflow_blocks;
+static CodeBlockPool<CodeBlock, 1024> s_block_pool;
+static CodeBlockPool<CodeBlockLink, 1024> s_link_pool;
+static CodeBlockArena<CodeBlockInstruction, 65536> s_instruction_arena;
+static std::vector<CodeBlockInstruction> s_decode_buffer;
 static std::array<std::vector<CodeBlock*>, Bus::RAM_CODE_PAGE_COUNT> m_ram_block_map;
 
 #ifdef WITH_RECOMPILER
 static HostCodeMap s_host_code_map;
+static CodeBlockArena<Recompiler::LoadStoreBackpatchInfo, 8192> s_backpatch_arena;
+static std::vector<Recompiler::LoadStoreBackpatchInfo> s_backpatch_buffer;
 
 static void AddBlockToHostCodeMap(CodeBlock* block);
 static void RemoveBlockFromHostCodeMap(CodeBlock* block);
@@ -116,9 +389,103 @@ static Common::PageFaultHandler::HandlerResult MMapPageFaultHandler(void* except
 #endif
 #endif // WITH_RECOMPILER
 
+ALWAYS_INLINE static u32 GetBlockTableIndex(CodeBlockKey key)
+{
+  return (key.user_mode ? FAST_MAP_TOTAL_SLOT_COUNT : 0) + GetFastMapIndex(key.GetPC());
+}
+
+CodeBlock** FindBlockEntry(CodeBlockKey key)
+{
+  const u32 index = GetBlockTableIndex(key);
+  BlockTablePage* page = s_block_table[index / BLOCK_TABLE_PAGE_SIZE].get();
+  if (page)
+  {
+    CodeBlock*& entry = (*page)[index % BLOCK_TABLE_PAGE_SIZE];
+    if (entry && entry->key == key)
+      return &entry;
+  }
+
+  if (s_overflow_blocks.empty())
+    return nullptr;
+
+  const BlockMap::iterator iter = s_overflow_blocks.find(key.bits);
+  return (iter != s_overflow_blocks.end()) ? &iter->second : nullptr;
+}
+
+void InsertBlockEntry(CodeBlockKey key, CodeBlock* block)
+{
+  if (block)
+  {
+    const u32 index = GetBlockTableIndex(key);
+    std::unique_ptr<BlockTablePage>& page = s_block_table[index / BLOCK_TABLE_PAGE_SIZE];
+    if (!page)
+      page = std::make_unique<BlockTablePage>();
+
+    CodeBlock*& entry = (*page)[index % BLOCK_TABLE_PAGE_SIZE];
+    if (!entry)
+    {
+      entry = block;
+      return;
+    }
+  }
+
+  s_overflow_blocks.emplace(key.bits, block);
+}
+
+void RemoveBlockEntry(CodeBlock* block)
+{
+  const u32 index = GetBlockTableIndex(block->key);
+  BlockTablePage* page = s_block_table[index / BLOCK_TABLE_PAGE_SIZE].get();
+  if (page && (*page)[index % BLOCK_TABLE_PAGE_SIZE] == block)
+  {
+    (*page)[index % BLOCK_TABLE_PAGE_SIZE] = nullptr;
+    return;
+  }
+
+  const BlockMap::iterator iter = s_overflow_blocks.find(block->key.bits);
+  Assert(iter != s_overflow_blocks.end() && iter->second == block);
+  s_overflow_blocks.erase(iter);
+}
+
+template<typename T>
+void EnumerateBlocks(T callback)
+{
+  for (const auto& page : s_block_table)
+  {
+    if (!page)
+      continue;
+
+    for (CodeBlock* block : *page)
+    {
+      if (block)
+        callback(block);
+    }
+  }
+
+  for (const auto& it : s_overflow_blocks)
+  {
+    if (it.second)
+      callback(it.second);
+  }
+}
+
+void FlushIfBlockArenaFull()
+{
+#ifdef WITH_RECOMPILER
+  if (s_backpatch_arena.IsFull())
+  {
+    Flush();
+    return;
+  }
+#endif
+
+  if (s_instruction_arena.IsFull())
+    Flush();
+}
+
 void Initialize()
 {
-  Assert(s_blocks.empty());
+  Assert(s_overflow_blocks.empty() && s_instruction_arena.IsEmpty());
 
 #ifdef WITH_RECOMPILER
   if (g_settings.IsUsingRecompiler())
@@ -139,33 +506,62 @@ void Initialize()
 
     ResetFastMap();
     CompileDispatcher();
+#ifdef USE_PERSISTENT_CODE_CACHE
+    ApplyPersistentCache();
+#endif
+
+    if (g_settings.cpu_recompiler_background_compile)
+      StartCompileThread();
   }
 #endif
 }
 
 void ClearState()
 {
+#ifdef WITH_RECOMPILER
+  // the compile thread writes to the code buffer, so it has to be idle before we reset it
+  CancelBackgroundCompiles();
+#endif
+
   Bus::ClearRAMCodePageFlags();
   for (auto& it : m_ram_block_map)
     it.clear();
 
-  for (const auto& it : s_blocks)
-    delete it.second;
+  EnumerateBlocks([](CodeBlock* block) { s_block_pool.Free(block); });
+  s_link_pool.Reset();
+  for (auto& page : s_block_table)
+    page.reset();
+  s_overflow_blocks.clear();
+  s_instruction_arena.Clear();
 
-  s_blocks.clear();
 #ifdef WITH_RECOMPILER
   s_host_code_map.clear();
+  s_backpatch_arena.Clear();
   s_code_buffer.Reset();
   ResetFastMap();
+
+  s_pending_traces.clear();
+  if (g_settings.IsUsingSuperblocks())
+    s_block_profiles.fill({});
 #endif
 }
 
 void Shutdown()
 {
   ClearState();
+  s_block_pool.Release();
+  s_link_pool.Release();
+  std::vector<CodeBlockInstruction>().swap(s_decode_buffer);
+#ifdef USE_PERSISTENT_CODE_CACHE
+  ClearPersistentCache();
+  s_persistent_near_code_start = nullptr;
+  s_persistent_far_code_start = nullptr;
+#endif
 #ifdef WITH_RECOMPILER
+  StopCompileThread();
   ShutdownFastmem();
   s_code_buffer.Destroy();
+  std::vector<Recompiler::LoadStoreBackpatchInfo>().swap(s_backpatch_buffer);
 #endif
 }
 
@@ -185,6 +581,7 @@ static void ExecuteImpl()
       DispatchInterrupt();
     }
 
+    FlushIfBlockArenaFull();
     TimingEvents::UpdateCPUDowncount();
 
     next_block_key = GetNextBlockKey();
@@ -232,8 +629,9 @@ static void ExecuteImpl()
       {
         // Try to find an already-linked block.
         // TODO: Don't need to dereference the block, just store a pointer to the code.
-        for (CodeBlock* linked_block : block->link_successors)
+        for (const CodeBlockLink* link = block->link_successors; link; link = link->next_successor)
         {
+          CodeBlock* linked_block = link->to;
           if (linked_block->key.bits == next_block_key.bits)
           {
             if (linked_block->invalidated && !RevalidateBlock(linked_block))
@@ -294,6 +692,11 @@ void CompileDispatcher()
     Recompiler::CodeGenerator cg(&s_code_buffer);
     s_single_block_asm_dispatcher = cg.CompileSingleBlockDispatcher();
   }
+
+#ifdef USE_PERSISTENT_CODE_CACHE
+  s_persistent_near_code_start = s_code_buffer.GetFreeCodePointer();
+  s_persistent_far_code_start = s_code_buffer.GetFreeFarCodePointer();
+#endif
 }
 
 CodeBlock::HostCodePointer* GetFastMapPointer()
@@ -343,6 +746,7 @@ void Reinitialize()
 
 #ifdef WITH_RECOMPILER
 
+  StopCompileThread();
   ShutdownFastmem();
   s_code_buffer.Destroy();
 
@@ -364,6 +768,12 @@ void Reinitialize()
 
     ResetFastMap();
     CompileDispatcher();
+#ifdef USE_PERSISTENT_CODE_CACHE
+    ApplyPersistentCache();
+#endif
+
+    if (g_settings.cpu_recompiler_background_compile)
+      StartCompileThread();
   }
 #endif
 }
@@ -373,7 +783,191 @@ void Flush()
   ClearState();
 #ifdef WITH_RECOMPILER
   if (g_settings.IsUsingRecompiler())
+  {
     CompileDispatcher();
+#ifdef USE_PERSISTENT_CODE_CACHE
+    ApplyPersistentCache();
+#endif
+  }
+#endif
+}
+
+void LoadPersistentCache(const char* filename)
+{
+#ifdef USE_PERSISTENT_CODE_CACHE
+  ClearPersistentCache();
+  if (!g_settings.IsUsingRecompiler())
+    return;
+
+  std::optional<std::vector<u8>> data = FileSystem::ReadBinaryFile(filename);
+  if (!data.has_value())
+    return;
+
+  PersistentCacheHeader header;
+  if (data->size() < sizeof(header))
+  {
+    Log_WarningPrintf("Persistent cache '%s' is truncated, ignoring", filename);
+    return;
+  }
+
+  std::memcpy(&header, data->data(), sizeof(header));
+  if (header.file_version != PERSISTENT_CACHE_FILE_VERSION || header.fingerprint != GetPersistentCacheFingerprint())
+  {
+    Log_InfoPrintf("Persistent cache '%s' was created by a different build or with different settings, ignoring",
+                   filename);
+    return;
+  }
+
+  const u64 expected_size = static_cast<u64>(sizeof(header)) +
+                            static_cast<u64>(header.num_blocks) * sizeof(PersistentCacheBlock) +
+                            static_cast<u64>(header.num_backpatch_infos) * sizeof(PersistentCacheBackpatchInfo) +
+                            header.near_code_size + header.far_code_size;
+  if (data->size() != expected_size)
+  {
+    Log_WarningPrintf("Persistent cache '%s' is corrupted, ignoring", filename);
+    return;
+  }
+
+  const u8* data_ptr = data->data() + sizeof(header);
+  s_persistent_blocks.reserve(header.num_blocks);
+  for (u32 i = 0; i < header.num_blocks; i++)
+  {
+    PersistentCacheBlock pb;
+    std::memcpy(&pb, data_ptr, sizeof(pb));
+    data_ptr += sizeof(pb);
+
+    if (pb.host_code_offset < header.near_code_offset ||
+        (static_cast<u64>(pb.host_code_offset) + pb.host_code_size) >
+          (static_cast<u64>(header.near_code_offset) + header.near_code_size) ||
+        (static_cast<u64>(pb.first_backpatch_info) + pb.num_backpatch_infos) > header.num_backpatch_infos)
+    {
+      Log_WarningPrintf("Persistent cache '%s' is corrupted, ignoring", filename);
+      ClearPersistentCache();
+      return;
+    }
+
+    s_persistent_blocks.emplace(pb.key, pb);
+  }
+
+  s_persistent_backpatch_infos.resize(header.num_backpatch_infos);
+  std::memcpy(s_persistent_backpatch_infos.data(), data_ptr,
+              sizeof(PersistentCacheBackpatchInfo) * header.num_backpatch_infos);
+  data_ptr += sizeof(PersistentCacheBackpatchInfo) * header.num_backpatch_infos;
+  for (const PersistentCacheBackpatchInfo& pbi : s_persistent_backpatch_infos)
+  {
+    if (pbi.host_pc_offset >= sizeof(s_code_storage) || pbi.host_slowmem_pc_offset >= sizeof(s_code_storage))
+    {
+      Log_WarningPrintf("Persistent cache '%s' is corrupted, ignoring", filename);
+      ClearPersistentCache();
+      return;
+    }
+  }
+
+  s_persistent_near_code.assign(data_ptr, data_ptr + header.near_code_size);
+  data_ptr += header.near_code_size;
+  s_persistent_far_code.assign(data_ptr, data_ptr + header.far_code_size);
+  s_persistent_cache_header = header;
+
+  Log_InfoPrintf("Loaded %u blocks (%u bytes of host code) from persistent cache '%s'", header.num_blocks,
+                 header.near_code_size + header.far_code_size, filename);
+
+  // restore the host code into the code buffer
+  Flush();
+#endif
+}
+
+void SavePersistentCache(const char* filename)
+{
+#ifdef USE_PERSISTENT_CODE_CACHE
+  if (!g_settings.IsUsingRecompiler() || !s_persistent_near_code_start)
+    return;
+
+  // blocks still being compiled are skipped, and the compile thread can't be allowed to write to the buffer
+  CancelBackgroundCompiles();
+
+  std::vector<PersistentCacheBlock> blocks;
+  std::vector<PersistentCacheBackpatchInfo> backpatch_infos;
+  blocks.reserve(s_persistent_blocks.size());
+
+  EnumerateBlocks([&blocks, &backpatch_infos](const CodeBlock* block) {
+    if (!block->host_code || !block->can_persist_host_code)
+      return;
+
+    PersistentCacheBlock pb;
+    pb.key = block->key.bits;
+    pb.instruction_count = static_cast<u32>(block->instructions.size());
+    pb.instruction_hash = GetInstructionHash(block);
+    pb.host_code_offset = static_cast<u32>(GetCodeStorageOffset(reinterpret_cast<const void*>(block->host_code)));
+    pb.host_code_size = block->host_code_size;
+    pb.first_backpatch_info = static_cast<u32>(backpatch_infos.size());
+    pb.num_backpatch_infos = static_cast<u32>(block->loadstore_backpatch_info.size());
+    blocks.push_back(pb);
+
+    for (const Recompiler::LoadStoreBackpatchInfo& lbi : block->loadstore_backpatch_info)
+    {
+      PersistentCacheBackpatchInfo pbi;
+      pbi.host_pc_offset = static_cast<u32>(GetCodeStorageOffset(lbi.host_pc));
+      pbi.host_slowmem_pc_offset = static_cast<u32>(GetCodeStorageOffset(lbi.host_slowmem_pc));
+      pbi.host_code_size = lbi.host_code_size;
+      pbi.address_host_reg = static_cast<u32>(lbi.address_host_reg);
+      pbi.value_host_reg = static_cast<u32>(lbi.value_host_reg);
+      pbi.guest_pc = lbi.guest_pc;
+      pbi.fault_count = lbi.fault_count;
+      backpatch_infos.push_back(pbi);
+    }
+  });
+
+  // Restored blocks which weren't executed this session are still intact in the code buffer.
+  for (const auto& it : s_persistent_blocks)
+  {
+    CodeBlockKey key;
+    key.bits = it.first;
+    if (FindBlockEntry(key))
+      continue;
+
+    PersistentCacheBlock pb = it.second;
+    const auto first_bpi = s_persistent_backpatch_infos.begin() + pb.first_backpatch_info;
+    pb.first_backpatch_info = static_cast<u32>(backpatch_infos.size());
+    backpatch_infos.insert(backpatch_infos.end(), first_bpi, first_bpi + pb.num_backpatch_infos);
+    blocks.push_back(pb);
+  }
+
+  if (blocks.empty())
+    return;
+
+  PersistentCacheHeader header;
+  header.file_version = PERSISTENT_CACHE_FILE_VERSION;
+  header.fingerprint = GetPersistentCacheFingerprint();
+  header.near_code_offset = static_cast<u32>(GetCodeStorageOffset(s_persistent_near_code_start));
+  header.near_code_size = static_cast<u32>(s_code_buffer.GetFreeCodePointer() - s_persistent_near_code_start);
+  header.far_code_offset = static_cast<u32>(GetCodeStorageOffset(s_persistent_far_code_start));
+  header.far_code_size = static_cast<u32>(s_code_buffer.GetFreeFarCodePointer() - s_persistent_far_code_start);
+  header.num_blocks = static_cast<u32>(blocks.size());
+  header.num_backpatch_infos = static_cast<u32>(backpatch_infos.size());
+
+  auto fp = FileSystem::OpenManagedCFile(filename, "wb");
+  if (!fp)
+  {
+    Log_ErrorPrintf("Failed to open persistent cache '%s' for writing", filename);
+    return;
+  }
+
+  const auto write = [&fp](const void* ptr, size_t size) {
+    return (size == 0 || std::fwrite(ptr, size, 1, fp.get()) == 1);
+  };
+  if (!write(&header, sizeof(header)) || !write(blocks.data(), sizeof(PersistentCacheBlock) * blocks.size()) ||
+      !write(backpatch_infos.data(), sizeof(PersistentCacheBackpatchInfo) * backpatch_infos.size()) ||
+      !write(s_persistent_near_code_start, header.near_code_size) ||
+      !write(s_persistent_far_code_start, header.far_code_size))
+  {
+    Log_ErrorPrintf("Failed to write persistent cache '%s'", filename);
+    fp.reset();
+    FileSystem::DeleteFile(filename);
+    return;
+  }
+
+  Log_InfoPrintf("Wrote %u blocks (%u bytes of host code) to persistent cache '%s'", header.num_blocks,
+                 header.near_code_size + header.far_code_size, filename);
 #endif
 }
 
@@ -402,34 +996,35 @@ CodeBlockKey GetNextBlockKey()
 
 CodeBlock* LookupBlock(CodeBlockKey key)
 {
-  BlockMap::iterator iter = s_blocks.find(key.bits);
-  if (iter != s_blocks.end())
+  CodeBlock** entry = FindBlockEntry(key);
+  if (entry)
   {
     // ensure it hasn't been invalidated
-    CodeBlock* existing_block = iter->second;
+    CodeBlock* existing_block = *entry;
     if (!existing_block || !existing_block->invalidated || RevalidateBlock(existing_block))
       return existing_block;
   }
 
-  CodeBlock* block = new CodeBlock(key);
+  CodeBlock* block = s_block_pool.Allocate(key);
   if (CompileBlock(block))
   {
     // add it to the page map if it's in ram
     AddBlockToPageMap(block);
 
 #ifdef WITH_RECOMPILER
-    SetFastMap(block->GetPC(), block->host_code);
+    if (block->host_code)
+      SetFastMap(block->GetPC(), block->host_code);
     AddBlockToHostCodeMap(block);
 #endif
   }
   else
   {
     Log_ErrorPrintf("Failed to compile block at PC=0x%08X", key.GetPC());
-    delete block;
+    s_block_pool.Free(block);
     block = nullptr;
   }
 
-  s_blocks.emplace(key.bits, block);
+  InsertBlockEntry(key, block);
   return block;
 }
 
@@ -451,7 +1046,8 @@ bool RevalidateBlock(CodeBlock* block)
   block->invalidated = false;
   AddBlockToPageMap(block);
 #ifdef WITH_RECOMPILER
-  SetFastMap(block->GetPC(), block->host_code);
+  if (block->host_code)
+    SetFastMap(block->GetPC(), block->host_code);
 #endif
   return true;
 
@@ -463,35 +1059,48 @@ recompile:
 
 #ifdef WITH_RECOMPILER
   RemoveBlockFromHostCodeMap(block);
+
+  // the code changed, so the counts don't apply anymore, and the block must be able to reach the threshold again
+  *GetBlockProfile(block->GetPC()) = {};
 #endif
 
-  block->instructions.clear();
+  block->instructions = {};
   if (!CompileBlock(block))
   {
     Log_WarningPrintf("Failed to recompile block 0x%08X - flushing.", block->GetPC());
-    delete block;
+    s_block_pool.Free(block);
     return false;
   }
 
+  // up-to-date again, otherwise it could never be traced, and wouldn't be removed from the page map
+  block->invalidated = false;
   AddBlockToPageMap(block);
 
 #ifdef WITH_RECOMPILER
   // re-add to page map again
-  SetFastMap(block->GetPC(), block->host_code);
+  if (block->host_code)
+    SetFastMap(block->GetPC(), block->host_code);
   AddBlockToHostCodeMap(block);
 #endif
 
   // re-insert into the block map since we removed it earlier.
-  s_blocks.emplace(block->key.bits, block);
+  InsertBlockEntry(block->key, block);
   return true;
 }
 
-bool CompileBlock(CodeBlock* block)
+bool CompileBlock(CodeBlock* block, bool trace)
 {
   u32 pc = block->GetPC();
   bool is_branch_delay_slot = false;
   bool is_unconditional_branch_delay_slot = false;
   bool is_load_delay_slot = false;
+  bool is_trace_join = false;
+  bool is_conditional_trace_join = false;
+
+  // start of the straight-line run of code the current branch ends, used to find its profile
+  u32 segment_pc = pc;
+  u32 start_page_index = static_cast<u32>(VirtualAddressToPhysical(pc) / HOST_PAGE_SIZE);
+  u32 end_page_index = start_page_index;
 
 #if 0
   if (pc == 0x0005aa90)
@@ -502,9 +1111,11 @@ bool CompileBlock(CodeBlock* block)
   block->uncached_fetch_ticks = 0;
   block->contains_double_branches = false;
   block->contains_loadstore_instructions = false;
+  block->is_trace = false;
 
   u32 last_cache_line = ICACHE_LINES;
 
+  s_decode_buffer.clear();
   for (;;)
   {
     CodeBlockInstruction cbi = {};
@@ -520,6 +1131,10 @@ bool CompileBlock(CodeBlock* block)
     cbi.is_store_instruction = IsMemoryStoreInstruction(cbi.instruction);
     cbi.has_load_delay = InstructionHasLoadDelay(cbi.instruction);
     cbi.can_trap = CanInstructionTrap(cbi.instruction, InUserMode());
+    cbi.is_trace_join = is_trace_join;
+    cbi.is_conditional_trace_join = is_conditional_trace_join;
+    is_trace_join = false;
+    is_conditional_trace_join = false;
 
     if (g_settings.cpu_recompiler_icache)
     {
@@ -536,6 +1151,8 @@ bool CompileBlock(CodeBlock* block)
     block->contains_loadstore_instructions |= cbi.is_store_instruction;
 
     pc += sizeof(cbi.instruction.bits);
+    start_page_index = std::min(start_page_index, static_cast<u32>(VirtualAddressToPhysical(cbi.pc) / HOST_PAGE_SIZE));
+    end_page_index = std::max(end_page_index, static_cast<u32>(VirtualAddressToPhysical(pc) / HOST_PAGE_SIZE));
 
     if (is_branch_delay_slot && cbi.is_branch_instruction)
     {
@@ -551,18 +1168,49 @@ bool CompileBlock(CodeBlock* block)
       }
 
       // change the pc for the second branch's delay slot, it comes from the first branch
-      const CodeBlockInstruction& prev_cbi = block->instructions.back();
+      const CodeBlockInstruction& prev_cbi = s_decode_buffer.back();
       pc = GetBranchInstructionTarget(prev_cbi.instruction, prev_cbi.pc);
       Log_DevPrintf("Double branch at %08X, using delay slot from %08X -> %08X", cbi.pc, prev_cbi.pc, pc);
     }
 
     // instruction is decoded now
-    block->instructions.push_back(cbi);
+    s_decode_buffer.push_back(cbi);
 
     // if we're in a branch delay slot, the block is now done
     // except if this is a branch in a branch delay slot, then we grab the one after that, and so on...
     if (is_branch_delay_slot && !cbi.is_branch_instruction)
-      break;
+    {
+      if (!trace || s_decode_buffer.size() < 2)
+        break;
+
+      const CodeBlockInstruction& branch = s_decode_buffer[s_decode_buffer.size() - 2];
+      bool conditional;
+      const std::optional<u32> next_pc = branch.is_branch_instruction ?
+                                           GetTraceContinuation(branch, segment_pc, &conditional) :
+                                           std::nullopt;
+      if (!next_pc.has_value() || s_decode_buffer.size() >= MAX_TRACE_INSTRUCTIONS ||
+          (VirtualAddressToPhysical(next_pc.value()) < Bus::RAM_SIZE) != block->IsInRAM() ||
+          std::any_of(s_decode_buffer.begin(), s_decode_buffer.end(),
+                      [&next_pc](const CodeBlockInstruction& it) { return it.pc == next_pc.value(); }))
+      {
+        break;
+      }
+
+      // keep the number of pages which can invalidate the trace down
+      const u32 next_page = static_cast<u32>(VirtualAddressToPhysical(next_pc.value()) / HOST_PAGE_SIZE);
+      if ((std::max(next_page, end_page_index) - std::min(next_page, start_page_index)) >= MAX_TRACE_PAGE_SPAN)
+        break;
+
+      pc = next_pc.value();
+      segment_pc = pc;
+      is_branch_delay_slot = false;
+      is_unconditional_branch_delay_slot = false;
+      is_load_delay_slot = cbi.has_load_delay;
+      is_trace_join = true;
+      is_conditional_trace_join = conditional;
+      block->is_trace = true;
+      continue;
+    }
 
     // if this is a branch, we grab the next instruction (delay slot), and then exit
     is_branch_delay_slot = cbi.is_branch_instruction;
@@ -576,9 +1224,14 @@ bool CompileBlock(CodeBlock* block)
       break;
   }
 
-  if (!block->instructions.empty())
+  block->start_page_index = start_page_index;
+  block->end_page_index = end_page_index;
+
+  if (!s_decode_buffer.empty())
   {
-    block->instructions.back().is_last_instruction = true;
+    s_decode_buffer.back().is_last_instruction = true;
+    block->instructions =
+      s_instruction_arena.Allocate(s_decode_buffer.data(), static_cast<u32>(s_decode_buffer.size()), "Instruction");
 
 #ifdef _DEBUG
     SmallString disasm;
@@ -600,6 +1253,20 @@ bool CompileBlock(CodeBlock* block)
 #ifdef WITH_RECOMPILER
   if (g_settings.IsUsingRecompiler())
   {
+    // drop fastmem fixups left over from a previous compile of this block
+    block->loadstore_backpatch_info.clear();
+
+#ifdef USE_PERSISTENT_CODE_CACHE
+    if (LookupPersistentBlock(block))
+      return true;
+#endif
+
+    if (s_compile_thread.joinable())
+    {
+      QueueBackgroundCompile(block);
+      return true;
+    }
+
     // Ensure we're not going to run out of space while compiling this block.
     if (s_code_buffer.GetFreeCodeSpace() <
           (block->instructions.size() * Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION) ||
@@ -607,15 +1274,22 @@ bool CompileBlock(CodeBlock* block)
           (block->instructions.size() * Recompiler::MAX_FAR_HOST_BYTES_PER_INSTRUCTION))
     {
       Log_WarningPrintf("Out of code space, flushing all blocks.");
+#ifdef USE_PERSISTENT_CODE_CACHE
+      // restored blocks would otherwise be copied straight back in, taking up the space again
+      ClearPersistentCache();
+#endif
       Flush();
     }
 
     Recompiler::CodeGenerator codegen(&s_code_buffer);
-    if (!codegen.CompileBlock(block, &block->host_code, &block->host_code_size))
+    if (!codegen.CompileBlock(block, &block->host_code, &block->host_code_size, &s_backpatch_buffer))
     {
       Log_ErrorPrintf("Failed to compile host code for block at 0x%08X", block->key.GetPC());
       return false;
     }
+
+    block->loadstore_backpatch_info =
+      s_backpatch_arena.Allocate(s_backpatch_buffer.data(), static_cast<u32>(s_backpatch_buffer.size()), "Backpatch");
   }
 #endif
 
@@ -626,13 +1300,316 @@ bool CompileBlock(CodeBlock* block)
 
 void FastCompileBlockFunction()
 {
+  if (s_compiled_jobs_pending.load(std::memory_order_acquire))
+    InstallBackgroundCompiledBlocks();
+  FlushIfBlockArenaFull();
+  if (!s_pending_traces.empty())
+    CompilePendingTraces();
+
   CodeBlock* block = LookupBlock(GetNextBlockKey());
-  if (block)
+  if (block && block->host_code)
+  {
     s_single_block_asm_dispatcher(block->host_code);
+  }
+  else if (block)
+  {
+    // still being compiled in the background
+    if (g_settings.cpu_recompiler_icache)
+      CheckAndUpdateICacheTags(block->icache_line_count, block->uncached_fetch_ticks);
+
+    if (g_settings.gpu_pgxp_enable)
+    {
+      if (g_settings.gpu_pgxp_cpu)
+        InterpretCachedBlock<PGXPMode::CPU>(*block);
+      else
+        InterpretCachedBlock<PGXPMode::Memory>(*block);
+    }
+    else
+    {
+      InterpretCachedBlock<PGXPMode::Disabled>(*block);
+    }
+  }
   else if (g_settings.gpu_pgxp_enable)
+  {
     InterpretUncachedBlock<PGXPMode::Memory>();
+  }
   else
+  {
     InterpretUncachedBlock<PGXPMode::Disabled>();
+  }
+}
+
+BlockProfile* GetBlockProfile(u32 pc)
+{
+  return &s_block_profiles[GetFastMapIndex(pc)];
+}
+
+void RequestTrace(u32 key_bits)
+{
+  if (!g_settings.IsUsingSuperblocks())
+    return;
+
+  CodeBlockKey key;
+  key.bits = key_bits;
+  s_pending_traces.push_back(key);
+
+  // send the next execution through FastCompileBlockFunction(), which builds the trace
+  SetFastMap(key.GetPC(), FastCompileBlockFunction);
+}
+
+std::optional<u32> GetTraceContinuation(const CodeBlockInstruction& branch, u32 segment_pc, bool* conditional)
+{
+  const Instruction inst = branch.instruction;
+  if (!IsDirectBranchInstruction(inst))
+    return std::nullopt;
+
+  const u32 target = GetBranchInstructionTarget(inst, branch.pc);
+  *conditional = false;
+  if (inst.op == InstructionOp::j || inst.op == InstructionOp::jal ||
+      (inst.op == InstructionOp::beq && inst.i.rs == Reg::zero && inst.i.rt == Reg::zero) ||
+      (inst.op == InstructionOp::b && inst.i.rs == Reg::zero && (static_cast<u8>(inst.i.rt.GetValue()) & 1u) != 0))
+  {
+    return target;
+  }
+
+  // only follow conditional branches which almost always go the same way
+  const BlockProfile& profile = *GetBlockProfile(segment_pc);
+  if (profile.execution_count < TRACE_MIN_BRANCH_SAMPLES)
+    return std::nullopt;
+
+  *conditional = true;
+  const u32 bias = profile.execution_count / TRACE_BRANCH_BIAS_DIVISOR;
+  if (profile.taken_count >= (profile.execution_count - bias))
+    return target;
+  else if (profile.taken_count <= bias)
+    return branch.pc + (sizeof(Instruction) * 2);
+  else
+    return std::nullopt;
+}
+
+void CompilePendingTraces()
+{
+  std::vector<CodeBlockKey> keys;
+  keys.swap(s_pending_traces);
+
+  for (const CodeBlockKey& key : keys)
+  {
+    CodeBlock** entry = FindBlockEntry(key);
+    CodeBlock* block = entry ? *entry : nullptr;
+    if (!block || block->invalidated)
+      continue;
+
+    bool conditional;
+    const size_t count = block->instructions.size();
+    if (!block->is_trace && !block->compile_pending && block->host_code && count >= 2 &&
+        block->instructions[count - 2].is_branch_instruction &&
+        GetTraceContinuation(block->instructions[count - 2], block->GetPC(), &conditional).has_value())
+    {
+      CompileTrace(block);
+    }
+    else if (block->host_code)
+    {
+      // not worth tracing, put the existing code back
+      SetFastMap(block->GetPC(), block->host_code);
+    }
+  }
+}
+
+void CompileTrace(CodeBlock* block)
+{
+  RemoveReferencesToBlock(block);
+
+  block->instructions = {};
+  if (!CompileBlock(block, true))
+  {
+    Log_WarningPrintf("Failed to compile trace 0x%08X - flushing.", block->GetPC());
+    s_block_pool.Free(block);
+    return;
+  }
+
+  // Traces don't update the profile, so don't leave the counts from before the trace behind. If no branch could be
+  // followed, the count stays past the threshold, so the block isn't traced again.
+  if (block->is_trace)
+    *GetBlockProfile(block->GetPC()) = {};
+
+  AddBlockToPageMap(block);
+  if (block->host_code)
+    SetFastMap(block->GetPC(), block->host_code);
+  AddBlockToHostCodeMap(block);
+  InsertBlockEntry(block->key, block);
+
+  Log_DevPrintf("Compiled trace at 0x%08X with %u instructions", block->GetPC(),
+                static_cast<u32>(block->instructions.size()));
+}
+
+void StartCompileThread()
+{
+  if (s_compile_thread.joinable())
+    return;
+
+  s_compile_thread_shutdown = false;
+  s_compile_thread = std::thread(CompileThreadEntryPoint);
+}
+
+void StopCompileThread()
+{
+  if (!s_compile_thread.joinable())
+    return;
+
+  {
+    std::unique_lock<std::mutex> lock(s_compile_mutex);
+    s_compile_queue.clear();
+    s_compile_thread_shutdown = true;
+    s_compile_work_cv.notify_one();
+  }
+
+  s_compile_thread.join();
+  s_compiled_jobs.clear();
+  s_compiled_jobs_pending.store(false, std::memory_order_release);
+}
+
+void CancelBackgroundCompiles()
+{
+  if (!s_compile_thread.joinable())
+    return;
+
+  std::unique_lock<std::mutex> lock(s_compile_mutex);
+  s_compile_queue.clear();
+  s_compile_idle_cv.wait(lock, []() { return !s_compile_thread_busy; });
+  s_compiled_jobs.clear();
+  s_compiled_jobs_pending.store(false, std::memory_order_release);
+}
+
+void QueueBackgroundCompile(CodeBlock* block)
+{
+  block->host_code = nullptr;
+  block->host_code_size = 0;
+  block->compile_pending = true;
+
+  // the compile thread gets its own copy, since the block can be changed or deleted before it's done
+  BackgroundCompileJob job;
+  job.block = std::make_unique<CodeBlock>(*block);
+  job.block->link_predecessors = nullptr;
+  job.block->link_successors = nullptr;
+  std::copy_n(g_state.regs.r, job.speculative_regs.size(), job.speculative_regs.begin());
+  job.out_of_space = false;
+
+  std::unique_lock<std::mutex> lock(s_compile_mutex);
+  s_compile_queue.push_back(std::move(job));
+  s_compile_work_cv.notify_one();
+}
+
+void InstallBackgroundCompiledBlocks()
+{
+  std::vector<BackgroundCompileJob> jobs;
+  {
+    std::unique_lock<std::mutex> lock(s_compile_mutex);
+    jobs.swap(s_compiled_jobs);
+    s_compiled_jobs_pending.store(false, std::memory_order_release);
+  }
+
+#if defined(CPU_AARCH64)
+  // The compile thread cleaned the new code to the point of unification, but this thread can still have stale
+  // instructions fetched, so the instruction stream has to be synchronized before any of it becomes reachable.
+  if (!jobs.empty())
+  {
+#ifdef _MSC_VER
+    __isb(_ARM64_BARRIER_SY);
+#else
+    asm volatile("isb" ::: "memory");
+#endif
+  }
+#endif
+
+  bool out_of_space = false;
+  for (BackgroundCompileJob& job : jobs)
+  {
+    if (job.out_of_space)
+    {
+      out_of_space = true;
+      continue;
+    }
+
+    // skip the result if the block was flushed or recompiled from different code in the meantime
+    CodeBlock** entry = FindBlockEntry(job.block->key);
+    CodeBlock* block = entry ? *entry : nullptr;
+    if (!block || !block->compile_pending || block->instructions.size() != job.block->instructions.size() ||
+        !std::equal(block->instructions.begin(), block->instructions.end(), job.block->instructions.begin(),
+                    [](const CodeBlockInstruction& lhs, const CodeBlockInstruction& rhs) {
+                      return lhs.instruction.bits == rhs.instruction.bits;
+                    }))
+    {
+      continue;
+    }
+
+    block->compile_pending = false;
+    if (!job.block->host_code)
+    {
+      // leave it with the cached interpreter
+      Log_ErrorPrintf("Failed to compile host code for block at 0x%08X", block->GetPC());
+      continue;
+    }
+
+    block->host_code = job.block->host_code;
+    block->host_code_size = job.block->host_code_size;
+    block->loadstore_backpatch_info = s_backpatch_arena.Allocate(
+      job.loadstore_backpatch_info.data(), static_cast<u32>(job.loadstore_backpatch_info.size()), "Backpatch");
+    block->can_persist_host_code = job.block->can_persist_host_code;
+    AddBlockToHostCodeMap(block);
+
+    // invalidated blocks get their fast map entry back when they're revalidated
+    if (!block->invalidated)
+      SetFastMap(block->GetPC(), block->host_code);
+  }
+
+  if (out_of_space)
+  {
+    Log_WarningPrintf("Out of code space, flushing all blocks.");
+#ifdef USE_PERSISTENT_CODE_CACHE
+    ClearPersistentCache();
+#endif
+    Flush();
+  }
+}
+
+void CompileThreadEntryPoint()
+{
+  std::unique_lock<std::mutex> lock(s_compile_mutex);
+  for (;;)
+  {
+    s_compile_work_cv.wait(lock, []() { return s_compile_thread_shutdown || !s_compile_queue.empty(); });
+    if (s_compile_thread_shutdown)
+      break;
+
+    BackgroundCompileJob job = std::move(s_compile_queue.front());
+    s_compile_queue.pop_front();
+    s_compile_thread_busy = true;
+    lock.unlock();
+
+    // The CPU thread keeps running while the block is compiled, so the CPU state and guest memory must not be read
+    // here. Speculative constants come from the registers captured when the job was queued.
+    CodeBlock* block = job.block.get();
+    if (s_code_buffer.GetFreeCodeSpace() <
+          (block->instructions.size() * Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION) ||
+        s_code_buffer.GetFreeFarCodeSpace() <
+          (block->instructions.size() * Recompiler::MAX_FAR_HOST_BYTES_PER_INSTRUCTION))
+    {
+      job.out_of_space = true;
+    }
+    else
+    {
+      Recompiler::CodeGenerator codegen(&s_code_buffer);
+      codegen.SetSpeculativeRegisterSnapshot(job.speculative_regs.data());
+      if (!codegen.CompileBlock(block, &block->host_code, &block->host_code_size, &job.loadstore_backpatch_info))
+        block->host_code = nullptr;
+    }
+
+    lock.lock();
+    s_compiled_jobs.push_back(std::move(job));
+    s_compiled_jobs_pending.store(true, std::memory_order_release);
+    s_compile_thread_busy = false;
+    s_compile_idle_cv.notify_all();
+  }
 }
 
 #endif
@@ -658,9 +1635,6 @@ void InvalidateBlocksWithPageIndex(u32 page_index)
 
 void RemoveReferencesToBlock(CodeBlock* block)
 {
-  BlockMap::iterator iter = s_blocks.find(block->key.GetPC());
-  Assert(iter != s_blocks.end() && iter->second == block);
-
 #ifdef WITH_RECOMPILER
   SetFastMap(block->GetPC(), FastCompileBlockFunction);
 #endif
@@ -675,7 +1649,7 @@ void RemoveReferencesToBlock(CodeBlock* block)
     RemoveBlockFromHostCodeMap(block);
 #endif
 
-  s_blocks.erase(iter);
+  RemoveBlockEntry(block);
 }
 
 void AddBlockToPageMap(CodeBlock* block)
@@ -711,34 +1685,56 @@ void RemoveBlockFromPageMap(CodeBlock* block)
 void LinkBlock(CodeBlock* from, CodeBlock* to)
 {
   Log_DebugPrintf("Linking block %p(%08x) to %p(%08x)", from, from->GetPC(), to, to->GetPC());
-  from->link_successors.push_back(to);
-  to->link_predecessors.push_back(from);
+  CodeBlockLink* link = s_link_pool.Allocate();
+  link->from = from;
+  link->to = to;
+  link->next_successor = from->link_successors;
+  link->next_predecessor = to->link_predecessors;
+  from->link_successors = link;
+  to->link_predecessors = link;
 }
 
 void UnlinkBlock(CodeBlock* block)
 {
-  for (CodeBlock* predecessor : block->link_predecessors)
+  // Each link is removed from the list of the block at the other end, then freed.
+  for (CodeBlockLink* link = block->link_predecessors; link;)
   {
-    auto iter = std::find(predecessor->link_successors.begin(), predecessor->link_successors.end(), block);
-    Assert(iter != predecessor->link_successors.end());
-    predecessor->link_successors.erase(iter);
+    CodeBlockLink** prev = &link->from->link_successors;
+    while (*prev != link)
+    {
+      Assert(*prev);
+      prev = &(*prev)->next_successor;
+    }
+    *prev = link->next_successor;
+
+    CodeBlockLink* next = link->next_predecessor;
+    s_link_pool.Free(link);
+    link = next;
   }
-  block->link_predecessors.clear();
+  block->link_predecessors = nullptr;
 
-  for (CodeBlock* successor : block->link_successors)
+  for (CodeBlockLink* link = block->link_successors; link;)
   {
-    auto iter = std::find(successor->link_predecessors.begin(), successor->link_predecessors.end(), block);
-    Assert(iter != successor->link_predecessors.end());
-    successor->link_predecessors.erase(iter);
+    CodeBlockLink** prev = &link->to->link_predecessors;
+    while (*prev != link)
+    {
+      Assert(*prev);
+      prev = &(*prev)->next_predecessor;
+    }
+    *prev = link->next_predecessor;
+
+    CodeBlockLink* next = link->next_successor;
+    s_link_pool.Free(link);
+    link = next;
   }
-  block->link_successors.clear();
+  block->link_successors = nullptr;
 }
 
 #ifdef WITH_RECOMPILER
 
 void AddBlockToHostCodeMap(CodeBlock* block)
 {
-  if (!g_settings.IsUsingRecompiler())
+  if (!g_settings.IsUsingRecompiler() || !block->host_code)
     return;
 
   auto ir = s_host_code_map.emplace(block->host_code, block);
@@ -747,7 +1743,7 @@ void AddBlockToHostCodeMap(CodeBlock* block)
 
 void RemoveBlockFromHostCodeMap(CodeBlock* block)
 {
-  if (!g_settings.IsUsingRecompiler())
+  if (!g_settings.IsUsingRecompiler() || !block->host_code)
     return;
 
   HostCodeMap::iterator hc_iter = s_host_code_map.find(block->host_code);
@@ -839,7 +1835,7 @@ Common::PageFaultHandler::HandlerResult MMapPageFaultHandler(void* exception_pc,
       if (Recompiler::CodeGenerator::BackpatchLoadStore(lbi))
       {
         // remove the backpatch entry since we won't be coming back to this one
-        block->loadstore_backpatch_info.erase(bpi_iter);
+        block->loadstore_backpatch_info.erase_unordered(bpi_iter);
         return Common::PageFaultHandler::HandlerResult::ContinueExecution;
       }
       else
@@ -880,7 +1876,7 @@ Common::PageFaultHandler::HandlerResult LUTPageFaultHandler(void* exception_pc,
       if (Recompiler::CodeGenerator::BackpatchLoadStore(lbi))
       {
         // remove the backpatch entry since we won't be coming back to this one
-        block->loadstore_backpatch_info.erase(bpi_iter);
+        block->loadstore_backpatch_info.erase_unordered(bpi_iter);
         return Common::PageFaultHandler::HandlerResult::ContinueExecution;
       }
       else
@@ -896,6 +1892,124 @@ Common::PageFaultHandler::HandlerResult LUTPageFaultHandler(void* exception_pc,
   return Common::PageFaultHandler::HandlerResult::ExecuteNextHandler;
 }
 
+#ifdef USE_PERSISTENT_CODE_CACHE
+
+u64 GetPersistentCacheFingerprint()
+{
+  // Generated code reaches the executable PC-relatively, so any rebuild invalidates it.
+  FILESYSTEM_STAT_DATA program_sd = {};
+  FileSystem::StatFile(FileSystem::GetProgramPath().c_str(), &program_sd);
+
+  const u64 values[] = {
+    PERSISTENT_CACHE_FILE_VERSION,
+    program_sd.Size,
+    program_sd.ModificationTime.AsUnixTimestamp(),
+    sizeof(State),
+    GetCodeStorageOffset(&g_state),
+    GetCodeStorageOffset(s_fast_map.data()),
+    GetCodeStorageOffset(Bus::g_bios),
+    GetCodeStorageOffset(TimingEvents::GetHeadEventPtr()),
+    GetCodeStorageOffset(reinterpret_cast<const void*>(&FastCompileBlockFunction)),
+    GetCodeStorageOffset(reinterpret_cast<const void*>(&Recompiler::Thunks::InterpretInstruction)),
+    GetCodeStorageOffset(GTE::GetUNRTable()),
+    GetCodeStorageOffset(s_block_profiles.data()),
+    GetCodeStorageOffset(reinterpret_cast<const void*>(&RequestTrace)),
+    static_cast<u64>(g_settings.cpu_fastmem_mode),
+    static_cast<u64>(g_settings.cpu_recompiler_memory_exceptions),
+    static_cast<u64>(g_settings.cpu_recompiler_icache),
+    static_cast<u64>(g_settings.cpu_recompiler_superblocks),
+    static_cast<u64>(g_settings.gpu_pgxp_enable),
+    static_cast<u64>(g_settings.gpu_pgxp_cpu),
+    static_cast<u64>(g_settings.gpu_pgxp_culling),
+    static_cast<u64>(g_settings.gpu_widescreen_hack),
+  };
+
+  return XXH64(values, sizeof(values), 0);
+}
+
+u64 GetInstructionHash(const CodeBlock* block)
+{
+  s_persistent_hash_buffer.clear();
+  for (const CodeBlockInstruction& cbi : block->instructions)
+    s_persistent_hash_buffer.push_back(cbi.instruction.bits);
+
+  return XXH64(s_persistent_hash_buffer.data(), s_persistent_hash_buffer.size() * sizeof(u32), 0);
+}
+
+u64 GetCodeStorageOffset(const void* ptr)
+{
+  return static_cast<u64>(reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(s_code_storage));
+}
+
+void ApplyPersistentCache()
+{
+  if (s_persistent_blocks.empty())
+    return;
+
+  const PersistentCacheHeader& header = s_persistent_cache_header;
+  if (header.fingerprint != GetPersistentCacheFingerprint() ||
+      s_code_buffer.GetFreeCodePointer() != &s_code_storage[header.near_code_offset] ||
+      s_code_buffer.GetFreeFarCodePointer() != &s_code_storage[header.far_code_offset] ||
+      s_code_buffer.GetFreeCodeSpace() < header.near_code_size ||
+      s_code_buffer.GetFreeFarCodeSpace() < header.far_code_size)
+  {
+    Log_WarningPrintf("Code buffer layout or settings changed, discarding persistent cache.");
+    ClearPersistentCache();
+    return;
+  }
+
+  std::memcpy(s_code_buffer.GetFreeCodePointer(), s_persistent_near_code.data(), header.near_code_size);
+  s_code_buffer.CommitCode(header.near_code_size);
+  std::memcpy(s_code_buffer.GetFreeFarCodePointer(), s_persistent_far_code.data(), header.far_code_size);
+  s_code_buffer.CommitFarCode(header.far_code_size);
+}
+
+void ClearPersistentCache()
+{
+  s_persistent_cache_header = {};
+  s_persistent_near_code = {};
+  s_persistent_far_code = {};
+  s_persistent_blocks.clear();
+  s_persistent_backpatch_infos = {};
+}
+
+bool LookupPersistentBlock(CodeBlock* block)
+{
+  const auto iter = s_persistent_blocks.find(block->key.bits);
+  if (iter == s_persistent_blocks.end())
+    return false;
+
+  const PersistentCacheBlock& pb = iter->second;
+  if (pb.instruction_count != block->instructions.size() || pb.instruction_hash != GetInstructionHash(block))
+    return false;
+
+  block->host_code = reinterpret_cast<CodeBlock::HostCodePointer>(&s_code_storage[pb.host_code_offset]);
+  block->host_code_size = pb.host_code_size;
+  block->can_persist_host_code = true;
+
+  s_backpatch_buffer.clear();
+  for (u32 i = 0; i < pb.num_backpatch_infos; i++)
+  {
+    const PersistentCacheBackpatchInfo& pbi = s_persistent_backpatch_infos[pb.first_backpatch_info + i];
+    Recompiler::LoadStoreBackpatchInfo lbi;
+    lbi.host_pc = &s_code_storage[pbi.host_pc_offset];
+    lbi.host_slowmem_pc = &s_code_storage[pbi.host_slowmem_pc_offset];
+    lbi.host_code_size = pbi.host_code_size;
+    lbi.address_host_reg = static_cast<Recompiler::HostReg>(pbi.address_host_reg);
+    lbi.value_host_reg = static_cast<Recompiler::HostReg>(pbi.value_host_reg);
+    lbi.guest_pc = pbi.guest_pc;
+    lbi.fault_count = pbi.fault_count;
+    s_backpatch_buffer.push_back(lbi);
+  }
+  block->loadstore_backpatch_info =
+    s_backpatch_arena.Allocate(s_backpatch_buffer.data(), static_cast<u32>(s_backpatch_buffer.size()), "Backpatch");
+
+  Log_DebugPrintf("Using persistent host code for block 0x%08X", block->GetPC());
+  return true;
+}
+
+#endif // USE_PERSISTENT_CODE_CACHE
+
 #endif // WITH_RECOMPILER
 
 } // namespace CPU::CodeCache
@@ -60,6 +60,57 @@ struct CodeBlockInstruction
   bool is_last_instruction : 1;
   bool has_load_delay : 1;
   bool can_trap : 1;
+
+  /// First instruction after a branch which a trace followed. For conditional branches, the trace is left here if
+  /// the branch went the other way.
+  bool is_trace_join : 1;
+  bool is_conditional_trace_join : 1;
+};
+
+/// Data belonging to a block, e.g. its instructions. The storage is owned by one of the code cache's arenas, and
+/// released on flush.
+template<typename T>
+class CodeBlockArenaList
+{
+public:
+  CodeBlockArenaList() = default;
+  CodeBlockArenaList(T* data, u32 size) : m_data(data), m_size(size) {}
+
+  ALWAYS_INLINE T* data() const { return m_data; }
+  ALWAYS_INLINE u32 size() const { return m_size; }
+  ALWAYS_INLINE bool empty() const { return (m_size == 0); }
+
+  ALWAYS_INLINE T* begin() const { return m_data; }
+  ALWAYS_INLINE T* end() const { return m_data + m_size; }
+  ALWAYS_INLINE T& back() const { return m_data[m_size - 1]; }
+  ALWAYS_INLINE T& operator[](u32 index) const { return m_data[index]; }
+
+  /// Removes an element by moving the last one into its place. The storage isn't released until the arena is.
+  ALWAYS_INLINE void erase_unordered(T* element)
+  {
+    *element = m_data[m_size - 1];
+    m_size--;
+  }
+
+  ALWAYS_INLINE void clear() { m_size = 0; }
+
+private:
+  T* m_data = nullptr;
+  u32 m_size = 0;
+};
+
+using CodeBlockInstructionList = CodeBlockArenaList<CodeBlockInstruction>;
+
+struct CodeBlock;
+
+/// Link from one block to another. Each link is on the successor list of the block it's from, and the predecessor list
+/// of the block it goes to. Links are allocated from a pool in the code cache.
+struct CodeBlockLink
+{
+  CodeBlock* from;
+  CodeBlock* to;
+  CodeBlockLink* next_successor;
+  CodeBlockLink* next_predecessor;
 };
 
 struct CodeBlock
@@ -72,28 +123,40 @@ struct CodeBlock
   u32 host_code_size = 0;
   HostCodePointer host_code = nullptr;
 
-  std::vector<CodeBlockInstruction> instructions;
-  std::vector<CodeBlock*> link_predecessors;
-  std::vector<CodeBlock*> link_successors;
+  CodeBlockInstructionList instructions;
+  CodeBlockLink* link_predecessors = nullptr;
+  CodeBlockLink* link_successors = nullptr;
 
   TickCount uncached_fetch_ticks = 0;
   u32 icache_line_count = 0;
 
+  /// RAM code pages covered by the instructions. Traces aren't contiguous, so this can't be derived from the size.
+  u32 start_page_index = 0;
+  u32 end_page_index = 0;
+
 #ifdef WITH_RECOMPILER
-  std::vector<Recompiler::LoadStoreBackpatchInfo> loadstore_backpatch_info;
+  CodeBlockArenaList<Recompiler::LoadStoreBackpatchInfo> loadstore_backpatch_info;
 #endif
 
   bool contains_loadstore_instructions = false;
   bool contains_double_branches = false;
   bool invalidated = false;
 
+  /// Block continues past branches into the code they lead to, see CompileTrace().
+  bool is_trace = false;
+
+#ifdef WITH_RECOMPILER
+  /// Host code only references the executable image PC-relatively, so it can be written to the persistent cache.
+  bool can_persist_host_code = false;
+
+  /// Host code is being generated on the compile thread, execute with the cached interpreter until it's installed.
+  bool compile_pending = false;
+#endif
+
   const u32 GetPC() const { return key.GetPC(); }
   const u32 GetSizeInBytes() const { return static_cast<u32>(instructions.size()) * sizeof(Instruction); }
-  const u32 GetStartPageIndex() const { return (key.GetPCPhysicalAddress() / HOST_PAGE_SIZE); }
-  const u32 GetEndPageIndex() const
-  {
-    return ((key.GetPCPhysicalAddress() + GetSizeInBytes()) / HOST_PAGE_SIZE);
-  }
+  const u32 GetStartPageIndex() const { return start_page_index; }
+  const u32 GetEndPageIndex() const { return end_page_index; }
   bool IsInRAM() const
   {
     // TODO: Constant
@@ -113,6 +176,21 @@ using SingleBlockDispatcherFunction = void(*)(const CodeBlock::HostCodePointer);
 
 CodeBlock::HostCodePointer* GetFastMapPointer();
 void ExecuteRecompiler();
+
+/// Counters updated by recompiled blocks when superblocks are enabled, indexed like the fast map.
+struct BlockProfile
+{
+  u32 execution_count;
+  u32 taken_count;
+};
+
+/// Blocks are turned into traces after this many executions.
+static constexpr u32 TRACE_HOT_BLOCK_THRESHOLD = 1024;
+
+BlockProfile* GetBlockProfile(u32 pc);
+
+/// Called by recompiled code when a block becomes hot. The trace is compiled the next time the dispatcher looks it up.
+void RequestTrace(u32 key_bits);
 #endif
 
 /// Flushes the code cache, forcing all blocks to be recompiled.
@@ -121,6 +199,13 @@ void Flush();
 /// Changes whether the recompiler is enabled.
 void Reinitialize();
 
+/// Loads host code compiled in a previous session from the specified file. Blocks are only reused if the guest code
+/// still matches, and the whole file is ignored if it was written by a different build or with different settings.
+void LoadPersistentCache(const char* filename);
+
+/// Writes the compiled blocks to the specified file, for loading with LoadPersistentCache() in a later session.
+void SavePersistentCache(const char* filename);
+
 /// Invalidates all blocks which are in the range of the specified code page.
 void InvalidateBlocksWithPageIndex(u32 page_index);
 
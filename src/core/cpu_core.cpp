@@ -1861,6 +1861,10 @@ void InterpretCachedBlock(const CodeBlock& block)
 
   for (const CodeBlockInstruction& cbi : block.instructions)
   {
+    // leave the trace if the branch before this went the other way
+    if (cbi.is_trace_join && g_state.regs.pc != cbi.pc)
+      break;
+
     g_state.pending_ticks++;
 
     // now executing the instruction we previously fetched
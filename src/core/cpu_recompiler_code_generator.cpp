@@ -19,14 +19,18 @@ u32 CodeGenerator::CalculateRegisterOffset(Reg reg)
   return u32(offsetof(State, regs.r[0]) + (static_cast<u32>(reg) * sizeof(u32)));
 }
 
-bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size)
+bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size,
+                                 std::vector<LoadStoreBackpatchInfo>* out_loadstore_backpatch_info)
 {
   // TODO: Align code buffer.
 
   m_block = block;
+  m_loadstore_backpatch_info = out_loadstore_backpatch_info;
+  m_loadstore_backpatch_info->clear();
   m_block_start = block->instructions.data();
   m_block_end = block->instructions.data() + block->instructions.size();
 
+  AnalyzeBlock();
   EmitBeginBlock();
   BlockPrologue();
 
@@ -46,6 +50,7 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
       m_block_end = nullptr;
       m_block_start = nullptr;
       m_block = nullptr;
+      m_loadstore_backpatch_info = nullptr;
       return false;
     }
 
@@ -53,10 +58,13 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
   }
 
   BlockEpilogue();
+  if (g_settings.IsUsingSuperblocks() && !block->is_trace)
+    EmitTraceProfiling();
   EmitEndBlock();
 
   FinalizeBlock(out_host_code, out_host_code_size);
-  Log_ProfilePrintf("JIT block 0x%08X: %zu instructions (%u bytes), %u host bytes", block->GetPC(),
+  block->can_persist_host_code = m_can_persist_host_code;
+  Log_ProfilePrintf("JIT block 0x%08X: %u instructions (%u bytes), %u host bytes", block->GetPC(),
                     block->instructions.size(), block->GetSizeInBytes(), *out_host_code_size);
 
   DebugAssert(m_register_cache.GetUsedHostRegisters() == 0);
@@ -65,11 +73,18 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
   m_block_end = nullptr;
   m_block_start = nullptr;
   m_block = nullptr;
+  m_loadstore_backpatch_info = nullptr;
   return true;
 }
 
 bool CodeGenerator::CompileInstruction(const CodeBlockInstruction& cbi)
 {
+  if (cbi.is_trace_join)
+    EmitTraceJoin(cbi);
+
+  if (GetInstructionAnalysis(cbi).dead_write)
+    return Compile_DeadWrite(cbi);
+
   bool result;
   switch (cbi.instruction.op)
   {
@@ -914,6 +929,11 @@ void CodeGenerator::BlockPrologue()
   m_branch_was_taken_dirty = g_settings.cpu_recompiler_memory_exceptions;
   m_current_instruction_was_branch_taken_dirty = false;
   m_load_delay_dirty = true;
+  if (m_flush_load_delay_on_entry)
+  {
+    EmitFlushInterpreterLoadDelay();
+    m_load_delay_dirty = false;
+  }
 
   m_pc_offset = 0;
   m_current_instruction_pc_offset = 0;
@@ -933,6 +953,80 @@ void CodeGenerator::BlockEpilogue()
   AddPendingCycles(true);
 }
 
+void CodeGenerator::EmitTraceJoin(const CodeBlockInstruction& cbi)
+{
+  // The branch wrote the new pc before its delay slot, so it's up to date here.
+  DebugAssert(m_pc_offset == 0);
+
+  if (cbi.is_conditional_trace_join)
+  {
+    // leave the trace if the branch went the other way
+    LabelType stay_in_trace;
+    {
+      Value pc = m_register_cache.AllocateScratch(RegSize_32);
+      EmitLoadGuestRegister(pc.GetHostRegister(), Reg::pc);
+      EmitConditionalBranch(Condition::Equal, false, pc.GetHostRegister(), Value::FromConstantU32(cbi.pc),
+                            &stay_in_trace);
+    }
+
+    m_register_cache.PushState();
+    EmitBranch(GetCurrentFarCodePointer());
+
+    SwitchToFarCode();
+    EmitTraceSideExit();
+    SwitchToNearCode();
+
+    m_register_cache.PopState();
+    EmitBindLabel(&stay_in_trace);
+  }
+
+  // the pc offsets restart from here, like at the start of a block
+  EmitStoreCPUStructField(offsetof(State, current_instruction_pc), Value::FromConstantU32(cbi.pc));
+}
+
+void CodeGenerator::EmitTraceProfiling()
+{
+  // only blocks which end in a direct branch can be continued into a trace
+  if (m_block->instructions.size() < 2)
+    return;
+
+  const CodeBlockInstruction& branch = m_block_end[-2];
+  if (!branch.is_branch_instruction || !m_block_end[-1].is_branch_delay_slot ||
+      !IsDirectBranchInstruction(branch.instruction))
+  {
+    return;
+  }
+
+  CodeCache::BlockProfile* profile = CodeCache::GetBlockProfile(m_block->GetPC());
+  LabelType not_hot;
+  {
+    Value count = m_register_cache.AllocateScratch(RegSize_32);
+    EmitLoadGlobal(count.GetHostRegister(), RegSize_32, &profile->execution_count);
+    EmitAdd(count.GetHostRegister(), count.GetHostRegister(), Value::FromConstantU32(1), false);
+    EmitStoreGlobal(&profile->execution_count, count);
+
+    if (branch.instruction.op != InstructionOp::j && branch.instruction.op != InstructionOp::jal)
+    {
+      // the branch has written the new pc, so comparing it against the target tells us which way it went
+      Value taken = m_register_cache.AllocateScratch(RegSize_32);
+      Value taken_count = m_register_cache.AllocateScratch(RegSize_32);
+      EmitLoadGuestRegister(taken.GetHostRegister(), Reg::pc);
+      EmitCmp(taken.GetHostRegister(),
+              Value::FromConstantU32(GetBranchInstructionTarget(branch.instruction, branch.pc)));
+      EmitSetConditionResult(taken.GetHostRegister(), RegSize_32, Condition::Equal);
+      EmitLoadGlobal(taken_count.GetHostRegister(), RegSize_32, &profile->taken_count);
+      EmitAdd(taken_count.GetHostRegister(), taken_count.GetHostRegister(), taken, false);
+      EmitStoreGlobal(&profile->taken_count, taken_count);
+    }
+
+    EmitConditionalBranch(Condition::NotEqual, false, count.GetHostRegister(),
+                          Value::FromConstantU32(CodeCache::TRACE_HOT_BLOCK_THRESHOLD), &not_hot);
+  }
+
+  EmitFunctionCall(nullptr, &CodeCache::RequestTrace, Value::FromConstantU32(m_block->key.bits));
+  EmitBindLabel(&not_hot);
+}
+
 void CodeGenerator::InstructionPrologue(const CodeBlockInstruction& cbi, TickCount cycles,
                                         bool force_sync /* = false */)
 {
@@ -1100,6 +1194,19 @@ bool CodeGenerator::Compile_Fallback(const CodeBlockInstruction& cbi)
   return true;
 }
 
+bool CodeGenerator::Compile_DeadWrite(const CodeBlockInstruction& cbi)
+{
+  // The result is overwritten before it can be read, so only the timing has to be kept.
+  InstructionPrologue(cbi, 1);
+
+  const Reg dest =
+    (cbi.instruction.op == InstructionOp::funct) ? cbi.instruction.r.rd.GetValue() : cbi.instruction.i.rt.GetValue();
+  SpeculativeWriteReg(dest, std::nullopt);
+
+  InstructionEpilogue(cbi);
+  return true;
+}
+
 bool CodeGenerator::Compile_Bitwise(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1);
@@ -1279,16 +1386,44 @@ bool CodeGenerator::Compile_Shift(const CodeBlockInstruction& cbi)
   return true;
 }
 
+Value CodeGenerator::ReadLoadStoreBase(const CodeBlockInstruction& cbi, SpeculativeValue* base_spec)
+{
+  // The register cache drops constants when it's flushed for an interpreted instruction, but the block analysis
+  // still knows them.
+  const std::optional<u32>& known_base = GetInstructionAnalysis(cbi).known_base;
+  if (known_base)
+  {
+    *base_spec = *known_base;
+    return Value::FromConstantU32(*known_base);
+  }
+
+  *base_spec = SpeculativeReadReg(cbi.instruction.i.rs);
+  return m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
+}
+
+void CodeGenerator::WriteLoadResult(const CodeBlockInstruction& cbi, Reg reg, Value&& value)
+{
+  if (!GetInstructionAnalysis(cbi).skip_load_delay)
+  {
+    m_register_cache.WriteGuestRegisterDelayed(reg, std::move(value));
+    return;
+  }
+
+  // the delay slot doesn't touch the register, so it can't tell when the value arrives
+  EmitCancelInterpreterLoadDelayForReg(reg);
+  m_register_cache.WriteGuestRegister(reg, std::move(value));
+}
+
 bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1);
 
   // rt <- mem[rs + sext(imm)]
-  Value base = m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
+  SpeculativeValue address_spec;
+  Value base = ReadLoadStoreBase(cbi, &address_spec);
   Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
   Value address = AddValues(base, offset, false);
 
-  SpeculativeValue address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
   SpeculativeValue value_spec;
   if (address_spec)
     address_spec = *address_spec + cbi.instruction.i.imm_sext32();
@@ -1347,7 +1482,7 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
       break;
   }
 
-  m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(result));
+  WriteLoadResult(cbi, cbi.instruction.i.rt, std::move(result));
   SpeculativeWriteReg(cbi.instruction.i.rt, value_spec);
 
   InstructionEpilogue(cbi);
@@ -1359,12 +1494,12 @@ bool CodeGenerator::Compile_Store(const CodeBlockInstruction& cbi)
   InstructionPrologue(cbi, 1);
 
   // mem[rs + sext(imm)] <- rt
-  Value base = m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
+  SpeculativeValue address_spec;
+  Value base = ReadLoadStoreBase(cbi, &address_spec);
   Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
   Value address = AddValues(base, offset, false);
   Value value = m_register_cache.ReadGuestRegister(cbi.instruction.i.rt);
 
-  SpeculativeValue address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
   SpeculativeValue value_spec = SpeculativeReadReg(cbi.instruction.i.rt);
   if (address_spec)
     address_spec = *address_spec + cbi.instruction.i.imm_sext32();
@@ -1458,12 +1593,12 @@ bool CodeGenerator::Compile_LoadLeftRight(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1);
 
-  Value base = m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
+  SpeculativeValue address_spec;
+  Value base = ReadLoadStoreBase(cbi, &address_spec);
   Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
   Value address = AddValues(base, offset, false);
   base.ReleaseAndClear();
 
-  SpeculativeValue address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
   if (address_spec)
     address_spec = *address_spec + cbi.instruction.i.imm_sext32();
 
@@ -1511,7 +1646,7 @@ bool CodeGenerator::Compile_LoadLeftRight(const CodeBlockInstruction& cbi)
   if (g_settings.gpu_pgxp_enable)
     EmitFunctionCall(nullptr, PGXP::CPU_LW, Value::FromConstantU32(cbi.instruction.bits), mem, address);
 
-  m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(mem));
+  WriteLoadResult(cbi, cbi.instruction.i.rt, std::move(mem));
 
   // TODO: Speculative values
   SpeculativeWriteReg(cbi.instruction.r.rt, std::nullopt);
@@ -1524,13 +1659,13 @@ bool CodeGenerator::Compile_StoreLeftRight(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1);
 
-  Value base = m_register_cache.ReadGuestRegister(cbi.instruction.i.rs);
+  SpeculativeValue address_spec;
+  Value base = ReadLoadStoreBase(cbi, &address_spec);
   Value offset = Value::FromConstantU32(cbi.instruction.i.imm_sext32());
   Value address = AddValues(base, offset, false);
   base.ReleaseAndClear();
 
   // TODO: Speculative values
-  SpeculativeValue address_spec = SpeculativeReadReg(cbi.instruction.i.rs);
   if (address_spec)
   {
     address_spec = *address_spec + cbi.instruction.i.imm_sext32();
@@ -2245,7 +2380,7 @@ bool CodeGenerator::Compile_cop0(const CodeBlockInstruction& cbi)
           // coprocessor loads are load-delayed
           Value value = m_register_cache.AllocateScratch(RegSize_32);
           EmitLoadCPUStructField(value.host_reg, value.size, offset);
-          m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.r.rt, std::move(value));
+          WriteLoadResult(cbi, cbi.instruction.r.rt, std::move(value));
           SpeculativeWriteReg(cbi.instruction.r.rt, std::nullopt);
         }
         else
@@ -2474,9 +2609,9 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
     InstructionPrologue(cbi, 1);
 
     const u32 reg = static_cast<u32>(cbi.instruction.i.rt.GetValue());
-    Value address = AddValues(m_register_cache.ReadGuestRegister(cbi.instruction.i.rs),
-                              Value::FromConstantU32(cbi.instruction.i.imm_sext32()), false);
-    SpeculativeValue spec_address = SpeculativeReadReg(cbi.instruction.i.rs);
+    SpeculativeValue spec_address;
+    Value address =
+      AddValues(ReadLoadStoreBase(cbi, &spec_address), Value::FromConstantU32(cbi.instruction.i.imm_sext32()), false);
     if (spec_address)
       spec_address = *spec_address + cbi.instruction.i.imm_sext32();
 
@@ -2529,7 +2664,7 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
             Value::FromConstantU32(cbi.instruction.bits), value, value);
         }
 
-        m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.r.rt, std::move(value));
+        WriteLoadResult(cbi, cbi.instruction.r.rt, std::move(value));
         SpeculativeWriteReg(cbi.instruction.r.rt, std::nullopt);
 
         InstructionEpilogue(cbi);
@@ -2567,18 +2702,48 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
     // forward everything to the GTE.
     InstructionPrologue(cbi, 1);
 
-    Value instruction_bits = Value::FromConstantU32(cbi.instruction.bits & GTE::Instruction::REQUIRED_BITS_MASK);
-    EmitFunctionCall(nullptr, GTE::GetInstructionImpl(cbi.instruction.bits), instruction_bits);
+    const GTE::Instruction gte_instruction{cbi.instruction.bits};
+    if (!CanInlineGTEInstruction(gte_instruction) || !EmitInlineGTEInstruction(gte_instruction))
+    {
+      Value instruction_bits = Value::FromConstantU32(cbi.instruction.bits & GTE::Instruction::REQUIRED_BITS_MASK);
+      EmitFunctionCall(nullptr, GTE::GetInstructionImpl(cbi.instruction.bits), instruction_bits);
+    }
 
     InstructionEpilogue(cbi);
     return true;
   }
 }
 
+bool CodeGenerator::CanInlineGTEInstruction(GTE::Instruction inst)
+{
+  switch (inst.command)
+  {
+    case 0x01: // RTPS
+    case 0x30: // RTPT
+      // PGXP and the widescreen hack alter the projection, leave those to the interpreter
+      return !g_settings.gpu_pgxp_enable && !g_settings.gpu_widescreen_hack;
+
+    case 0x06: // NCLIP
+      return !g_settings.gpu_pgxp_enable || !g_settings.gpu_pgxp_culling;
+
+    case 0x12: // MVMVA
+      // the garbage matrix and the buggy far colour translation are rarely used
+      return (inst.mvmva_multiply_matrix != 3 && inst.mvmva_translation_vector != 2);
+
+    case 0x2D: // AVSZ3
+    case 0x2E: // AVSZ4
+      return true;
+
+    default:
+      return false;
+  }
+}
+
 void CodeGenerator::InitSpeculativeRegs()
 {
+  const u32* regs = m_speculative_register_snapshot ? m_speculative_register_snapshot : g_state.regs.r;
   for (u8 i = 0; i < static_cast<u8>(Reg::count); i++)
-    m_speculative_constants.regs[i] = g_state.regs.r[i];
+    m_speculative_constants.regs[i] = regs[i];
 }
 
 void CodeGenerator::InvalidateSpeculativeValues()
@@ -2605,6 +2770,10 @@ CodeGenerator::SpeculativeValue CodeGenerator::SpeculativeReadMemory(VirtualMemo
   if (it != m_speculative_constants.memory.end())
     return it->second;
 
+  // guest memory can be changing underneath a background compile
+  if (m_speculative_register_snapshot)
+    return std::nullopt;
+
   u32 value;
   if ((phys_addr & DCACHE_LOCATION_MASK) == DCACHE_LOCATION)
   {
@@ -2638,4 +2807,215 @@ void CodeGenerator::SpeculativeWriteMemory(u32 address, SpeculativeValue value)
     m_speculative_constants.memory.emplace(address, value);
 }
 
+void CodeGenerator::AnalyzeBlock()
+{
+  const u32 count = static_cast<u32>(m_block_end - m_block_start);
+  m_instruction_analysis.clear();
+  m_instruction_analysis.resize(count);
+
+  for (u32 i = 0; i < count; i++)
+  {
+    InstructionAnalysis& ia = m_instruction_analysis[i];
+    ia.usage_known = GetInstructionRegisterUsage(m_block_start[i].instruction, &ia.reads, &ia.writes);
+  }
+
+  AnalyzeLoadDelays();
+  AnalyzeDeadWrites();
+  AnalyzeConstants();
+
+  // A load delay left pending by the previous block lands after our first instruction. If that instruction doesn't
+  // read any registers, it can't tell the difference, and flushing it before anything is cached saves invalidating
+  // the register cache afterwards.
+  const CodeBlockInstruction& first = m_block_start[0];
+  const InstructionAnalysis& first_ia = m_instruction_analysis[0];
+  m_flush_load_delay_on_entry = (first_ia.usage_known && first_ia.reads == 0 && !first.has_load_delay);
+}
+
+void CodeGenerator::AnalyzeLoadDelays()
+{
+  // The loaded value only becomes visible after the next instruction. If that instruction neither reads nor writes
+  // the register, nothing can tell when the value arrived, so it can be written straight away. That doesn't hold
+  // when a trace might be left before the next instruction.
+  const u32 count = static_cast<u32>(m_instruction_analysis.size());
+  for (u32 i = 0; (i + 1) < count; i++)
+  {
+    InstructionAnalysis& ia = m_instruction_analysis[i];
+    if (!m_block_start[i].has_load_delay || !ia.usage_known || ia.writes == 0 ||
+        m_block_start[i + 1].is_conditional_trace_join)
+    {
+      continue;
+    }
+
+    const InstructionAnalysis& next_ia = m_instruction_analysis[i + 1];
+    ia.skip_load_delay = (next_ia.usage_known && ((next_ia.reads | next_ia.writes) & ia.writes) == 0);
+  }
+}
+
+bool CodeGenerator::CanRaiseException(const CodeBlockInstruction& cbi) const
+{
+  // compiled loads/stores only check for exceptions when memory exceptions are enabled
+  if (cbi.is_load_instruction || cbi.is_store_instruction)
+    return g_settings.cpu_recompiler_memory_exceptions;
+
+  return cbi.can_trap;
+}
+
+bool CodeGenerator::IsDeadWriteCandidate(const CodeBlockInstruction& cbi) const
+{
+  // only simple ALU instructions, which write a single register and have no other effects
+  const InstructionAnalysis& ia = GetInstructionAnalysis(cbi);
+  return (ia.usage_known && !cbi.can_trap && !cbi.has_load_delay && !cbi.is_branch_instruction && ia.writes != 0 &&
+          (ia.writes & (ia.writes - 1)) == 0 && ia.writes < (UINT64_C(1) << static_cast<u8>(Reg::hi)));
+}
+
+void CodeGenerator::AnalyzeDeadWrites()
+{
+  // PGXP tracks values through every instruction, so they all have to run.
+  if (g_settings.gpu_pgxp_enable)
+    return;
+
+  // A write is dead when the register is overwritten before it's read. An exception would expose the whole register
+  // file, so nothing which might raise one can sit in between, and neither can a trace side exit. Delayed writes
+  // (loads) aren't treated as overwrites, the old value is still visible in their delay slot.
+  const u32 count = static_cast<u32>(m_instruction_analysis.size());
+  for (u32 i = 0; i < count; i++)
+  {
+    if (!IsDeadWriteCandidate(m_block_start[i]))
+      continue;
+
+    const u64 dest = m_instruction_analysis[i].writes;
+    for (u32 j = i + 1; j < count; j++)
+    {
+      const CodeBlockInstruction& cbi = m_block_start[j];
+      const InstructionAnalysis& ia = m_instruction_analysis[j];
+      if (cbi.is_conditional_trace_join || !ia.usage_known || (ia.reads & dest) != 0 || CanRaiseException(cbi))
+        break;
+
+      if (ia.writes == dest && IsDeadWriteCandidate(cbi))
+      {
+        Log_DebugPrintf("Write to %s at 0x%08X is dead, overwritten at 0x%08X",
+                        GetRegName(static_cast<Reg>(CountTrailingZeros(dest))), m_block_start[i].pc, cbi.pc);
+        m_instruction_analysis[i].dead_write = true;
+        break;
+      }
+    }
+  }
+}
+
+void CodeGenerator::AnalyzeConstants()
+{
+  // Values of registers which were set to constants earlier in the block. The register cache tracks these too, but
+  // forgets them when the cache is flushed for an interpreted instruction.
+  std::array<std::optional<u32>, 32> values;
+  values[0] = 0;
+
+  const u32 count = static_cast<u32>(m_instruction_analysis.size());
+  for (u32 i = 0; i < count; i++)
+  {
+    const Instruction inst = m_block_start[i].instruction;
+    InstructionAnalysis& ia = m_instruction_analysis[i];
+    if (m_block_start[i].is_load_instruction || m_block_start[i].is_store_instruction)
+      ia.known_base = values[static_cast<u8>(inst.i.rs.GetValue())];
+
+    // add/sub which overflow raise an exception, so anything after them can use the result
+    const std::optional<u32>& rs = values[static_cast<u8>(inst.i.rs.GetValue())];
+    const std::optional<u32>& rt = values[static_cast<u8>(inst.r.rt.GetValue())];
+    std::optional<u32> result;
+    switch (inst.op)
+    {
+      case InstructionOp::lui:
+        result = inst.i.imm_zext32() << 16;
+        break;
+
+      case InstructionOp::ori:
+        if (rs)
+          result = *rs | inst.i.imm_zext32();
+        break;
+
+      case InstructionOp::andi:
+        if (rs)
+          result = *rs & inst.i.imm_zext32();
+        break;
+
+      case InstructionOp::xori:
+        if (rs)
+          result = *rs ^ inst.i.imm_zext32();
+        break;
+
+      case InstructionOp::addi:
+      case InstructionOp::addiu:
+        if (rs)
+          result = *rs + inst.i.imm_sext32();
+        break;
+
+      case InstructionOp::funct:
+      {
+        switch (inst.r.funct)
+        {
+          case InstructionFunct::sll:
+            if (rt)
+              result = *rt << inst.r.shamt;
+            break;
+
+          case InstructionFunct::srl:
+            if (rt)
+              result = *rt >> inst.r.shamt;
+            break;
+
+          case InstructionFunct::sra:
+            if (rt)
+              result = static_cast<u32>(static_cast<s32>(*rt) >> inst.r.shamt);
+            break;
+
+          case InstructionFunct::add:
+          case InstructionFunct::addu:
+            if (rs && rt)
+              result = *rs + *rt;
+            break;
+
+          case InstructionFunct::sub:
+          case InstructionFunct::subu:
+            if (rs && rt)
+              result = *rs - *rt;
+            break;
+
+          case InstructionFunct::and_:
+            if (rs && rt)
+              result = *rs & *rt;
+            break;
+
+          case InstructionFunct::or_:
+            if (rs && rt)
+              result = *rs | *rt;
+            break;
+
+          case InstructionFunct::xor_:
+            if (rs && rt)
+              result = *rs ^ *rt;
+            break;
+
+          case InstructionFunct::nor:
+            if (rs && rt)
+              result = ~(*rs | *rt);
+            break;
+
+          default:
+            break;
+        }
+      }
+      break;
+
+      default:
+        break;
+    }
+
+    // anything else written is unknown from here on, including delayed writes
+    for (u32 reg = 1; reg < static_cast<u32>(values.size()); reg++)
+    {
+      if (ia.writes & (UINT64_C(1) << reg))
+        values[reg] = result;
+    }
+  }
+}
+
 } // namespace CPU::Recompiler
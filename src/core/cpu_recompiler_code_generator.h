@@ -2,6 +2,7 @@
 #include <array>
 #include <initializer_list>
 #include <utility>
+#include <vector>
 
 #include "common/jit_code_buffer.h"
 
@@ -10,6 +11,7 @@
 #include "cpu_recompiler_thunks.h"
 #include "cpu_recompiler_types.h"
 #include "cpu_types.h"
+#include "gte_types.h"
 
 namespace CPU::Recompiler {
 
@@ -27,7 +29,13 @@ public:
 
   static bool BackpatchLoadStore(const LoadStoreBackpatchInfo& lbi);
 
-  bool CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size);
+  /// Fastmem fixups for the block's loads and stores are written to out_loadstore_backpatch_info.
+  bool CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size,
+                    std::vector<LoadStoreBackpatchInfo>* out_loadstore_backpatch_info);
+
+  /// Takes the initial speculative register values from regs instead of the CPU state, and doesn't read guest memory.
+  /// Used when compiling on a thread other than the CPU thread.
+  void SetSpeculativeRegisterSnapshot(const u32* regs) { m_speculative_register_snapshot = regs; }
 
   CodeCache::DispatcherFunction CompileDispatcher();
   CodeCache::SingleBlockDispatcherFunction CompileSingleBlockDispatcher();
@@ -39,6 +47,7 @@ public:
   void EmitEndBlock();
   void EmitExceptionExit();
   void EmitExceptionExitOnBool(const Value& value);
+  void EmitTraceSideExit();
   void FinalizeBlock(CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size);
 
   void EmitSignExtend(HostReg to_reg, RegSize to_size, HostReg from_reg, RegSize from_size);
@@ -194,6 +203,8 @@ private:
   // branch target, memory address, etc
   void BlockPrologue();
   void BlockEpilogue();
+  void EmitTraceJoin(const CodeBlockInstruction& cbi);
+  void EmitTraceProfiling();
   void InstructionPrologue(const CodeBlockInstruction& cbi, TickCount cycles, bool force_sync = false);
   void InstructionEpilogue(const CodeBlockInstruction& cbi);
   void AddPendingCycles(bool commit);
@@ -203,14 +214,22 @@ private:
   void UpdateCurrentInstructionPC(bool commit);
   void WriteNewPC(const Value& value, bool commit);
 
+  Value ReadLoadStoreBase(const CodeBlockInstruction& cbi, SpeculativeValue* base_spec);
+  void WriteLoadResult(const CodeBlockInstruction& cbi, Reg reg, Value&& value);
+
   Value DoGTERegisterRead(u32 index);
   void DoGTERegisterWrite(u32 index, const Value& value);
 
+  // Generates host code for common GTE instructions, returns false if the interpreter should be called instead.
+  static bool CanInlineGTEInstruction(GTE::Instruction inst);
+  bool EmitInlineGTEInstruction(GTE::Instruction inst);
+
   //////////////////////////////////////////////////////////////////////////
   // Instruction Code Generators
   //////////////////////////////////////////////////////////////////////////
   bool CompileInstruction(const CodeBlockInstruction& cbi);
   bool Compile_Fallback(const CodeBlockInstruction& cbi);
+  bool Compile_DeadWrite(const CodeBlockInstruction& cbi);
   bool Compile_Bitwise(const CodeBlockInstruction& cbi);
   bool Compile_Shift(const CodeBlockInstruction& cbi);
   bool Compile_Load(const CodeBlockInstruction& cbi);
@@ -231,6 +250,7 @@ private:
 
   JitCodeBuffer* m_code_buffer;
   CodeBlock* m_block = nullptr;
+  std::vector<LoadStoreBackpatchInfo>* m_loadstore_backpatch_info = nullptr;
   const CodeBlockInstruction* m_block_start = nullptr;
   const CodeBlockInstruction* m_block_end = nullptr;
   const CodeBlockInstruction* m_current_instruction = nullptr;
@@ -254,6 +274,9 @@ private:
   bool m_fastmem_load_base_in_register = false;
   bool m_fastmem_store_base_in_register = false;
 
+  // cleared when the block references an address outside the executable image (e.g. an absolute immediate)
+  bool m_can_persist_host_code = true;
+
   //////////////////////////////////////////////////////////////////////////
   // Speculative Constants
   //////////////////////////////////////////////////////////////////////////
@@ -271,6 +294,42 @@ private:
   void SpeculativeWriteMemory(VirtualMemoryAddress address, SpeculativeValue value);
 
   SpeculativeConstants m_speculative_constants;
+  const u32* m_speculative_register_snapshot = nullptr;
+
+  //////////////////////////////////////////////////////////////////////////
+  // Block Analysis
+  //////////////////////////////////////////////////////////////////////////
+  struct InstructionAnalysis
+  {
+    u64 reads;
+    u64 writes;
+    bool usage_known;
+
+    // the next instruction doesn't touch the loaded register, so the load delay can't be observed
+    bool skip_load_delay;
+
+    // the result is overwritten before anything can read it
+    bool dead_write;
+
+    // value of the base register of a load/store, when it is a constant computed within the block
+    std::optional<u32> known_base;
+  };
+
+  void AnalyzeBlock();
+  void AnalyzeLoadDelays();
+  void AnalyzeDeadWrites();
+  void AnalyzeConstants();
+  bool CanRaiseException(const CodeBlockInstruction& cbi) const;
+  bool IsDeadWriteCandidate(const CodeBlockInstruction& cbi) const;
+  const InstructionAnalysis& GetInstructionAnalysis(const CodeBlockInstruction& cbi) const
+  {
+    return m_instruction_analysis[static_cast<size_t>(&cbi - m_block_start)];
+  }
+
+  std::vector<InstructionAnalysis> m_instruction_analysis;
+
+  // the first instruction can't observe a load delay left by the previous block, so it's flushed up front
+  bool m_flush_load_delay_on_entry = false;
 };
 
 } // namespace CPU::Recompiler
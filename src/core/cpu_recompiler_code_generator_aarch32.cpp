@@ -208,6 +208,20 @@ void CodeGenerator::EmitExceptionExit()
   m_emit->bx(a32::lr);
 }
 
+void CodeGenerator::EmitTraceSideExit()
+{
+  AddPendingCycles(false);
+
+  // same as the end of a block, the pending load delay is left for the next one
+  m_register_cache.FlushAllGuestRegisters(false, false);
+  m_register_cache.WriteLoadDelayToCPU(false);
+
+  m_register_cache.PopCalleeSavedRegisters(false);
+
+  m_emit->add(a32::sp, a32::sp, FUNCTION_STACK_SIZE);
+  m_emit->bx(a32::lr);
+}
+
 void CodeGenerator::EmitExceptionExitOnBool(const Value& value)
 {
   Assert(!value.IsConstant() && value.IsInHostRegister());
@@ -857,6 +871,7 @@ void CodeGenerator::EmitCall(const void* ptr)
   {
     m_emit->Mov(GetHostReg32(RSCRATCH), reinterpret_cast<uintptr_t>(ptr));
     m_emit->blx(GetHostReg32(RSCRATCH));
+    m_can_persist_host_code = false;
   }
   else
   {
@@ -1282,7 +1297,7 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   SwitchToNearCode();
   m_register_cache.UninhibitAllocation();
 
-  m_block->loadstore_backpatch_info.push_back(bpi);
+  m_loadstore_backpatch_info->push_back(bpi);
 }
 
 void CodeGenerator::EmitLoadGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size,
@@ -1432,7 +1447,7 @@ void CodeGenerator::EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   SwitchToNearCode();
   m_register_cache.UninhibitAllocation();
 
-  m_block->loadstore_backpatch_info.push_back(bpi);
+  m_loadstore_backpatch_info->push_back(bpi);
 }
 
 void CodeGenerator::EmitStoreGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address,
@@ -1678,6 +1693,7 @@ void CodeGenerator::EmitBranch(const void* address, bool allow_scratch)
 
   m_emit->Mov(GetHostReg32(RSCRATCH), reinterpret_cast<uintptr_t>(address));
   m_emit->bx(GetHostReg32(RSCRATCH));
+  m_can_persist_host_code = false;
 }
 
 void CodeGenerator::EmitBranch(LabelType* label)
@@ -1914,6 +1930,7 @@ void CodeGenerator::EmitBindLabel(LabelType* label)
 void CodeGenerator::EmitLoadGlobalAddress(HostReg host_reg, const void* ptr)
 {
   m_emit->Mov(GetHostReg32(host_reg), reinterpret_cast<uintptr_t>(ptr));
+  m_can_persist_host_code = false;
 }
 
 CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
@@ -2056,4 +2073,10 @@ CodeCache::SingleBlockDispatcherFunction CodeGenerator::CompileSingleBlockDispat
   return reinterpret_cast<CodeCache::SingleBlockDispatcherFunction>(ptr);
 }
 
+bool CodeGenerator::EmitInlineGTEInstruction(GTE::Instruction inst)
+{
+  // not implemented for this backend, the interpreter handles everything
+  return false;
+}
+
 } // namespace CPU::Recompiler
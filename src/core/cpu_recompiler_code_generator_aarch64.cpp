@@ -5,6 +5,7 @@
 #include "cpu_core_private.h"
 #include "cpu_recompiler_code_generator.h"
 #include "cpu_recompiler_thunks.h"
+#include "gte.h"
 #include "settings.h"
 #include "timing_event.h"
 Log_SetChannel(CPU::Recompiler);
@@ -246,6 +247,20 @@ void CodeGenerator::EmitExceptionExit()
   m_emit->Ret();
 }
 
+void CodeGenerator::EmitTraceSideExit()
+{
+  AddPendingCycles(false);
+
+  // same as the end of a block, the pending load delay is left for the next one
+  m_register_cache.FlushAllGuestRegisters(false, false);
+  m_register_cache.WriteLoadDelayToCPU(false);
+
+  m_register_cache.PopCalleeSavedRegisters(false);
+
+  m_emit->Add(a64::sp, a64::sp, FUNCTION_STACK_SIZE);
+  m_emit->Ret();
+}
+
 void CodeGenerator::EmitExceptionExitOnBool(const Value& value)
 {
   Assert(!value.IsConstant() && value.IsInHostRegister());
@@ -1024,6 +1039,7 @@ void CodeGenerator::EmitCall(const void* ptr)
   {
     m_emit->Mov(GetHostReg64(RSCRATCH), reinterpret_cast<uintptr_t>(ptr));
     m_emit->Blr(GetHostReg64(RSCRATCH));
+    m_can_persist_host_code = false;
   }
   else
   {
@@ -1478,7 +1494,7 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   SwitchToNearCode();
   m_register_cache.UninhibitAllocation();
 
-  m_block->loadstore_backpatch_info.push_back(bpi);
+  m_loadstore_backpatch_info->push_back(bpi);
 }
 
 void CodeGenerator::EmitLoadGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size,
@@ -1645,7 +1661,7 @@ void CodeGenerator::EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   SwitchToNearCode();
   m_register_cache.UninhibitAllocation();
 
-  m_block->loadstore_backpatch_info.push_back(bpi);
+  m_loadstore_backpatch_info->push_back(bpi);
 }
 
 void CodeGenerator::EmitStoreGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address,
@@ -1888,6 +1904,7 @@ void CodeGenerator::EmitBranch(const void* address, bool allow_scratch)
 
   m_emit->Mov(GetHostReg64(RSCRATCH), reinterpret_cast<uintptr_t>(address));
   m_emit->br(GetHostReg64(RSCRATCH));
+  m_can_persist_host_code = false;
 }
 
 void CodeGenerator::EmitBranch(LabelType* label)
@@ -2139,6 +2156,7 @@ void CodeGenerator::EmitLoadGlobalAddress(HostReg host_reg, const void* ptr)
   else
   {
     m_emit->Mov(GetHostReg64(host_reg), reinterpret_cast<uintptr_t>(ptr));
+    m_can_persist_host_code = false;
   }
 }
 
@@ -2279,4 +2297,341 @@ CodeCache::SingleBlockDispatcherFunction CodeGenerator::CompileSingleBlockDispat
   return reinterpret_cast<CodeCache::SingleBlockDispatcherFunction>(ptr);
 }
 
+namespace {
+/// Host registers used by the inline GTE code. None of them are in the allocation order, so they never hold guest
+/// registers, and the code doesn't call out so nothing else needs to be preserved.
+struct GTEInlineRegs
+{
+  a64::WRegister flags;   // accumulated FLAG register
+  a64::XRegister acc;     // 64-bit MAC accumulator
+  a64::XRegister temp;    // general temporaries
+  a64::XRegister temp2;   //
+  a64::XRegister scratch; // overflow checks and constants
+};
+} // namespace
+
+static a64::MemOperand GetGTERegPtr(u32 index, u32 element = 0)
+{
+  return a64::MemOperand(GetCPUPtrReg(), static_cast<s64>(offsetof(State, gte_regs.r32[0]) +
+                                                          (index * sizeof(u32)) + (element * sizeof(u16))));
+}
+
+/// Sets the overflow/underflow flag if value doesn't fit in a signed (bits + 1)-bit integer.
+static void EmitGTECheckMACOverflow(CodeEmitter* emit, const GTEInlineRegs& regs, const a64::XRegister& value,
+                                    u32 bits, u32 index)
+{
+  a64::Label done, underflow;
+  emit->Sbfx(regs.scratch, value, 0, bits + 1);
+  emit->Cmp(regs.scratch, value);
+  emit->B(a64::eq, &done);
+  emit->Tbnz(value, 63, &underflow);
+  emit->Orr(regs.flags, regs.flags, GTE::FLAGS::GetMACOverflowBit(index));
+  emit->B(&done);
+  emit->Bind(&underflow);
+  emit->Orr(regs.flags, regs.flags, GTE::FLAGS::GetMACUnderflowBit(index));
+  emit->Bind(&done);
+}
+
+/// Clamps value to [min_value, max_value], setting flag (if any) when it is out of range.
+static void EmitGTESaturate(CodeEmitter* emit, const GTEInlineRegs& regs, const a64::Register& value, s32 min_value,
+                            s32 max_value, u32 flag)
+{
+  // most of the limits can't be encoded as a compare immediate
+  const a64::Register limit = regs.scratch.W();
+  a64::Label not_below_min, done;
+  emit->Mov(limit, min_value);
+  emit->Cmp(value, limit);
+  emit->B(a64::ge, &not_below_min);
+  emit->Mov(value, limit);
+  if (flag != 0)
+    emit->Orr(regs.flags, regs.flags, flag);
+  emit->B(&done);
+  emit->Bind(&not_below_min);
+  emit->Mov(limit, max_value);
+  emit->Cmp(value, limit);
+  emit->B(a64::le, &done);
+  emit->Mov(value, limit);
+  if (flag != 0)
+    emit->Orr(regs.flags, regs.flags, flag);
+  emit->Bind(&done);
+}
+
+/// acc = (T[row] << 12) + M[row] * V, with the sign-extending overflow checks of the GTE on each partial sum.
+/// The translation is skipped if translation_index is zero.
+static void EmitGTEMatrixRow(CodeEmitter* emit, const GTEInlineRegs& regs, u32 row, u32 matrix_index,
+                             u32 vector_index, u32 translation_index)
+{
+  if (translation_index != 0)
+  {
+    emit->Ldrsw(regs.acc, GetGTERegPtr(translation_index + row));
+    emit->Lsl(regs.acc, regs.acc, 12);
+  }
+  else
+  {
+    // a single product can't overflow, so this is the same as skipping the first check
+    emit->Mov(regs.acc, 0);
+  }
+
+  for (u32 col = 0; col < 3; col++)
+  {
+    emit->Ldrsh(regs.temp, GetGTERegPtr(matrix_index, (row * 3) + col));
+
+    // IR1..3 are one per register, the vectors are packed
+    if (vector_index < 6)
+      emit->Ldrsh(regs.temp2, GetGTERegPtr(vector_index, col));
+    else
+      emit->Ldrsh(regs.temp2, GetGTERegPtr(vector_index + col));
+
+    emit->Madd(regs.acc, regs.temp, regs.temp2, regs.acc);
+    EmitGTECheckMACOverflow(emit, regs, regs.acc, 43, row + 1);
+
+    // the final sum is not truncated to 44 bits before it's shifted
+    if (col != 2)
+      emit->Sbfx(regs.acc, regs.acc, 0, 44);
+  }
+}
+
+/// Transforms the vertex for RTPS/RTPT, and pushes its depth. Leaves the new SZ3 in temp.
+static void EmitGTETransformVertex(CodeEmitter* emit, const GTEInlineRegs& regs, u32 vertex_index, bool sf, bool lm)
+{
+  const s32 ir_min = lm ? 0 : -0x8000;
+
+  for (u32 row = 0; row < 2; row++)
+  {
+    EmitGTEMatrixRow(emit, regs, row, 32, vertex_index, 37);
+    if (sf)
+      emit->Asr(regs.acc, regs.acc, 12);
+    emit->Str(regs.acc.W(), GetGTERegPtr(25 + row));
+    EmitGTESaturate(emit, regs, regs.acc.W(), ir_min, 0x7FFF, GTE::FLAGS::GetIRSaturatedBit(row + 1));
+    emit->Str(regs.acc.W(), GetGTERegPtr(9 + row));
+  }
+
+  EmitGTEMatrixRow(emit, regs, 2, 32, vertex_index, 37);
+  if (sf)
+    emit->Asr(regs.temp, regs.acc, 12);
+  else
+    emit->Mov(regs.temp, regs.acc);
+  emit->Str(regs.temp.W(), GetGTERegPtr(27));
+  EmitGTESaturate(emit, regs, regs.temp.W(), ir_min, 0x7FFF, 0);
+  emit->Str(regs.temp.W(), GetGTERegPtr(11));
+
+  // the IR3 flag is based on MAC3 >> 12 regardless of sf
+  a64::Label ir3_in_range;
+  emit->Asr(regs.temp, regs.acc, 12);
+  emit->Cmp(regs.temp.W(), a64::Operand(regs.temp.W(), a64::SXTH));
+  emit->B(a64::eq, &ir3_in_range);
+  emit->Orr(regs.flags, regs.flags, GTE::FLAGS::GetIRSaturatedBit(3));
+  emit->Bind(&ir3_in_range);
+
+  // SZ0 <- SZ1 <- SZ2 <- SZ3 <- MAC3 >> 12
+  EmitGTESaturate(emit, regs, regs.temp.W(), 0, 0xFFFF, GTE::FLAGS::SZ1_OTZ_SATURATED);
+  for (u32 i = 16; i < 19; i++)
+  {
+    emit->Ldr(regs.temp2.W(), GetGTERegPtr(i + 1));
+    emit->Str(regs.temp2.W(), GetGTERegPtr(i));
+  }
+  emit->Str(regs.temp.W(), GetGTERegPtr(19));
+}
+
+/// Perspective division and projection for RTPS/RTPT. Expects SZ3 in temp and the UNR table address in acc.
+static void EmitGTEProjectVertex(CodeEmitter* emit, const GTEInlineRegs& regs, bool last)
+{
+  const a64::Register divisor = regs.temp.W();
+  const a64::Register result = regs.temp2.W();
+  const a64::Register scratch = regs.scratch.W();
+
+  // result = UNR division of H by SZ3
+  a64::Label no_overflow, divide_done;
+  emit->Ldrh(result, GetGTERegPtr(58));
+  emit->Lsl(scratch, divisor, 1);
+  emit->Cmp(scratch, result);
+  emit->B(a64::hi, &no_overflow);
+  emit->Orr(regs.flags, regs.flags, GTE::FLAGS::DIVIDE_OVERFLOW);
+  emit->Mov(result, 0x1FFFF);
+  emit->B(&divide_done);
+
+  // normalize so that bit 15 of the divisor is set, SZ3 can't be zero here
+  emit->Bind(&no_overflow);
+  emit->Clz(scratch, divisor);
+  emit->Sub(scratch, scratch, 16);
+  emit->Lsl(result, result, scratch);
+  emit->Lsl(divisor, divisor, scratch);
+
+  // x = 0x101 + table[((divisor & 0x7FFF) + 0x40) >> 7]
+  emit->And(scratch, divisor, 0x7FFF);
+  emit->Add(scratch, scratch, 0x40);
+  emit->Lsr(scratch, scratch, 7);
+  emit->Ldrb(scratch, a64::MemOperand(regs.acc, regs.scratch));
+  emit->Add(scratch, scratch, 0x101);
+
+  // d = ((divisor * -x) + 0x80) >> 8, recip = ((x * (0x20000 + d)) + 0x80) >> 8
+  emit->Mul(divisor, divisor, scratch);
+  emit->Neg(divisor, divisor);
+  emit->Add(divisor, divisor, 0x80);
+  emit->Asr(divisor, divisor, 8);
+  emit->Add(divisor, divisor, 0x20000);
+  emit->Mul(divisor, divisor, scratch);
+  emit->Add(divisor, divisor, 0x80);
+  emit->Asr(divisor, divisor, 8);
+
+  // result = min(((lhs * recip) + 0x8000) >> 16, 0x1FFFF)
+  emit->Umull(regs.temp2, result, divisor);
+  emit->Add(regs.temp2, regs.temp2, 0x8000);
+  emit->Lsr(regs.temp2, regs.temp2, 16);
+  emit->Mov(scratch, 0x1FFFF);
+  emit->Cmp(result, scratch);
+  emit->Csel(result, scratch, result, a64::hi);
+  emit->Bind(&divide_done);
+
+  // SX2 = (result * IR1 + OFX) >> 16
+  emit->Ldrsh(regs.acc, GetGTERegPtr(9));
+  emit->Ldrsw(regs.temp, GetGTERegPtr(56));
+  emit->Madd(regs.acc, regs.acc, regs.temp2, regs.temp);
+  EmitGTECheckMACOverflow(emit, regs, regs.acc, 31, 0);
+  emit->Asr(regs.acc, regs.acc, 16);
+  EmitGTESaturate(emit, regs, regs.acc.W(), -0x400, 0x3FF, GTE::FLAGS::SX2_SATURATED);
+
+  // SY2 = (result * IR2 + OFY) >> 16
+  emit->Ldrsh(regs.temp, GetGTERegPtr(10));
+  emit->Ldrsw(regs.scratch, GetGTERegPtr(57));
+  emit->Madd(regs.temp, regs.temp, regs.temp2, regs.scratch);
+  EmitGTECheckMACOverflow(emit, regs, regs.temp, 31, 0);
+  emit->Asr(regs.temp, regs.temp, 16);
+  EmitGTESaturate(emit, regs, regs.temp.W(), -0x400, 0x3FF, GTE::FLAGS::SY2_SATURATED);
+
+  // SXY0 <- SXY1 <- SXY2 <- (SX2, SY2)
+  emit->Bfi(regs.acc.W(), regs.temp.W(), 16, 16);
+  for (u32 i = 12; i < 14; i++)
+  {
+    emit->Ldr(scratch, GetGTERegPtr(i + 1));
+    emit->Str(scratch, GetGTERegPtr(i));
+  }
+  emit->Str(regs.acc.W(), GetGTERegPtr(14));
+
+  if (!last)
+    return;
+
+  // MAC0 = result * DQA + DQB, IR0 = MAC0 >> 12
+  emit->Ldrsh(regs.acc, GetGTERegPtr(59));
+  emit->Ldrsw(regs.temp, GetGTERegPtr(60));
+  emit->Madd(regs.acc, regs.acc, regs.temp2, regs.temp);
+  EmitGTECheckMACOverflow(emit, regs, regs.acc, 31, 0);
+  emit->Str(regs.acc.W(), GetGTERegPtr(24));
+  emit->Asr(regs.acc, regs.acc, 12);
+  EmitGTESaturate(emit, regs, regs.acc.W(), 0, 0x1000, GTE::FLAGS::GetIRSaturatedBit(0));
+  emit->Str(regs.acc.W(), GetGTERegPtr(8));
+}
+
+bool CodeGenerator::EmitInlineGTEInstruction(GTE::Instruction inst)
+{
+  Value flags_value = m_register_cache.AllocateScratch(RegSize_32, RARG1);
+  Value acc_value = m_register_cache.AllocateScratch(RegSize_64, RARG2);
+  Value temp_value = m_register_cache.AllocateScratch(RegSize_64, RARG3);
+  Value temp2_value = m_register_cache.AllocateScratch(RegSize_64, RARG4);
+  const GTEInlineRegs regs{GetHostReg32(flags_value), GetHostReg64(acc_value), GetHostReg64(temp_value),
+                           GetHostReg64(temp2_value), GetHostReg64(RSCRATCH)};
+
+  const bool sf = (inst.sf != 0);
+  const bool lm = inst.lm;
+
+  m_emit->Mov(regs.flags, 0);
+
+  switch (inst.command)
+  {
+    case 0x01: // RTPS
+    case 0x30: // RTPT
+    {
+      const u32 num_vertices = (inst.command == 0x01) ? 1 : 3;
+      for (u32 vertex = 0; vertex < num_vertices; vertex++)
+      {
+        EmitGTETransformVertex(m_emit, regs, vertex * 2, sf, lm);
+        EmitLoadGlobalAddress(acc_value.GetHostRegister(), GTE::GetUNRTable());
+        EmitGTEProjectVertex(m_emit, regs, vertex == (num_vertices - 1));
+      }
+    }
+    break;
+
+    case 0x06: // NCLIP
+    {
+      // MAC0 = SX0*SY1 + SX1*SY2 + SX2*SY0 - SX0*SY2 - SX1*SY0 - SX2*SY1
+      static constexpr std::array<std::pair<u32, u32>, 6> products = {
+        {{12, 13}, {13, 14}, {14, 12}, {12, 14}, {13, 12}, {14, 13}}};
+      m_emit->Mov(regs.acc, 0);
+      for (u32 i = 0; i < 6; i++)
+      {
+        m_emit->Ldrsh(regs.temp, GetGTERegPtr(products[i].first, 0));
+        m_emit->Ldrsh(regs.temp2, GetGTERegPtr(products[i].second, 1));
+        if (i < 3)
+          m_emit->Madd(regs.acc, regs.temp, regs.temp2, regs.acc);
+        else
+          m_emit->Msub(regs.acc, regs.temp, regs.temp2, regs.acc);
+      }
+
+      EmitGTECheckMACOverflow(m_emit, regs, regs.acc, 31, 0);
+      m_emit->Str(regs.acc.W(), GetGTERegPtr(24));
+    }
+    break;
+
+    case 0x12: // MVMVA
+    {
+      static constexpr std::array<u32, 3> matrix_indices = {{32, 40, 48}};
+      static constexpr std::array<u32, 4> vector_indices = {{0, 2, 4, 9}};
+      static constexpr std::array<u32, 4> translation_indices = {{37, 45, 53, 0}};
+      const u32 matrix_index = matrix_indices[inst.mvmva_multiply_matrix];
+      const u32 vector_index = vector_indices[inst.mvmva_multiply_vector];
+      const u32 translation_index = translation_indices[inst.mvmva_translation_vector];
+
+      // the vector can be IR1..3, so all of MAC1..3 are computed before IR1..3 are written
+      for (u32 row = 0; row < 3; row++)
+      {
+        EmitGTEMatrixRow(m_emit, regs, row, matrix_index, vector_index, translation_index);
+        if (sf)
+          m_emit->Asr(regs.acc, regs.acc, 12);
+        m_emit->Str(regs.acc.W(), GetGTERegPtr(25 + row));
+      }
+
+      for (u32 row = 0; row < 3; row++)
+      {
+        m_emit->Ldr(regs.acc.W(), GetGTERegPtr(25 + row));
+        EmitGTESaturate(m_emit, regs, regs.acc.W(), lm ? 0 : -0x8000, 0x7FFF, GTE::FLAGS::GetIRSaturatedBit(row + 1));
+        m_emit->Str(regs.acc.W(), GetGTERegPtr(9 + row));
+      }
+    }
+    break;
+
+    case 0x2D: // AVSZ3
+    case 0x2E: // AVSZ4
+    {
+      // MAC0 = ZSF * sum(SZ), OTZ = MAC0 >> 12
+      const bool avsz4 = (inst.command == 0x2E);
+      m_emit->Ldrh(regs.acc.W(), GetGTERegPtr(avsz4 ? 16 : 17));
+      for (u32 i = avsz4 ? 17 : 18; i < 20; i++)
+      {
+        m_emit->Ldrh(regs.temp.W(), GetGTERegPtr(i));
+        m_emit->Add(regs.acc.W(), regs.acc.W(), regs.temp.W());
+      }
+      m_emit->Ldrsh(regs.temp, GetGTERegPtr(avsz4 ? 62 : 61));
+      m_emit->Mul(regs.acc, regs.acc, regs.temp);
+      EmitGTECheckMACOverflow(m_emit, regs, regs.acc, 31, 0);
+      m_emit->Str(regs.acc.W(), GetGTERegPtr(24));
+      m_emit->Asr(regs.acc, regs.acc, 12);
+      EmitGTESaturate(m_emit, regs, regs.acc.W(), 0, 0xFFFF, GTE::FLAGS::SZ1_OTZ_SATURATED);
+      m_emit->Str(regs.acc.W(), GetGTERegPtr(7));
+    }
+    break;
+
+    default:
+      UnreachableCode();
+      return false;
+  }
+
+  // FLAG.31 is set if any of the error bits are
+  m_emit->Mov(regs.scratch.W(), GTE::FLAGS::ERROR_MASK);
+  m_emit->Tst(regs.flags, regs.scratch.W());
+  m_emit->Orr(regs.scratch.W(), regs.flags, 0x80000000u);
+  m_emit->Csel(regs.flags, regs.scratch.W(), regs.flags, a64::ne);
+  m_emit->Str(regs.flags, GetGTERegPtr(63));
+  return true;
+}
+
 } // namespace CPU::Recompiler
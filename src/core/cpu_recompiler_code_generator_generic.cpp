@@ -49,6 +49,10 @@ Value CodeGenerator::EmitLoadGuestMemory(const CodeBlockInstruction& cbi, const
       }
       else
       {
+        // RAM lives in a memory arena mapped at runtime, so the address can't be reused in another session.
+        if (static_cast<u8*>(ptr) >= Bus::g_ram && static_cast<u8*>(ptr) < (Bus::g_ram + Bus::RAM_SIZE))
+          m_can_persist_host_code = false;
+
         EmitLoadGlobal(result.GetHostRegister(), size, ptr);
       }
 
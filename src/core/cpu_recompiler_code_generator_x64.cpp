@@ -5,6 +5,7 @@
 #include "cpu_core_private.h"
 #include "cpu_recompiler_code_generator.h"
 #include "cpu_recompiler_thunks.h"
+#include "gte.h"
 #include "settings.h"
 #include "timing_event.h"
 Log_SetChannel(Recompiler::CodeGenerator);
@@ -250,6 +251,18 @@ void CodeGenerator::EmitExceptionExit()
   m_emit->ret();
 }
 
+void CodeGenerator::EmitTraceSideExit()
+{
+  AddPendingCycles(false);
+
+  // same as the end of a block, the pending load delay is left for the next one
+  m_register_cache.FlushAllGuestRegisters(false, false);
+  m_register_cache.WriteLoadDelayToCPU(false);
+
+  m_register_cache.PopCalleeSavedRegisters(false);
+  m_emit->ret();
+}
+
 void CodeGenerator::EmitExceptionExitOnBool(const Value& value)
 {
   Assert(!value.IsConstant() && value.IsInHostRegister());
@@ -1439,6 +1452,7 @@ void CodeGenerator::EmitCall(const void* ptr)
   {
     m_emit->mov(GetHostReg64(RRETURN), reinterpret_cast<size_t>(ptr));
     m_emit->call(GetHostReg64(RRETURN));
+    m_can_persist_host_code = false;
   }
 }
 
@@ -1969,7 +1983,7 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   SwitchToNearCode();
   m_register_cache.UninhibitAllocation();
 
-  m_block->loadstore_backpatch_info.push_back(bpi);
+  m_loadstore_backpatch_info->push_back(bpi);
 }
 
 void CodeGenerator::EmitLoadGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address, RegSize size,
@@ -2229,7 +2243,7 @@ void CodeGenerator::EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   SwitchToNearCode();
   m_register_cache.UninhibitAllocation();
 
-  m_block->loadstore_backpatch_info.push_back(bpi);
+  m_loadstore_backpatch_info->push_back(bpi);
 }
 
 void CodeGenerator::EmitStoreGuestMemorySlowmem(const CodeBlockInstruction& cbi, const Value& address,
@@ -2357,6 +2371,7 @@ void CodeGenerator::EmitLoadGlobal(HostReg host_reg, RegSize size, const void* p
   {
     Value temp = m_register_cache.AllocateScratch(RegSize_64);
     m_emit->mov(GetHostReg64(temp), reinterpret_cast<size_t>(ptr));
+    m_can_persist_host_code = false;
     switch (size)
     {
       case RegSize_8:
@@ -2455,6 +2470,7 @@ void CodeGenerator::EmitStoreGlobal(void* ptr, const Value& value)
   {
     Value address_temp = m_register_cache.AllocateScratch(RegSize_64);
     m_emit->mov(GetHostReg64(address_temp), reinterpret_cast<size_t>(ptr));
+    m_can_persist_host_code = false;
     switch (value.size)
     {
       case RegSize_8:
@@ -2641,6 +2657,7 @@ void CodeGenerator::EmitBranch(const void* address, bool allow_scratch)
   Value temp = m_register_cache.AllocateScratch(RegSize_64);
   m_emit->mov(GetHostReg64(temp), reinterpret_cast<uintptr_t>(address));
   m_emit->jmp(GetHostReg64(temp));
+  m_can_persist_host_code = false;
 }
 
 void CodeGenerator::EmitBranch(LabelType* label)
@@ -2884,9 +2901,14 @@ void CodeGenerator::EmitLoadGlobalAddress(HostReg host_reg, const void* ptr)
   const s64 displacement =
     static_cast<s64>(reinterpret_cast<size_t>(ptr) - reinterpret_cast<size_t>(m_emit->getCurr())) + 2;
   if (Xbyak::inner::IsInInt32(static_cast<u64>(displacement)))
+  {
     m_emit->lea(GetHostReg64(host_reg), m_emit->dword[m_emit->rip + ptr]);
+  }
   else
+  {
     m_emit->mov(GetHostReg64(host_reg), reinterpret_cast<size_t>(ptr));
+    m_can_persist_host_code = false;
+  }
 }
 
 CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
@@ -3020,4 +3042,370 @@ CodeCache::SingleBlockDispatcherFunction CodeGenerator::CompileSingleBlockDispat
   return reinterpret_cast<CodeCache::SingleBlockDispatcherFunction>(ptr);
 }
 
+namespace {
+/// Host registers used by the inline GTE code. None of them are in the allocation order, so they never hold guest
+/// registers, and the code doesn't call out so nothing else needs to be preserved.
+struct GTEInlineRegs
+{
+  Xbyak::Reg32 flags;   // accumulated FLAG register
+  Xbyak::Reg64 acc;     // 64-bit MAC accumulator
+  Xbyak::Reg64 temp;    // general temporaries
+  Xbyak::Reg64 temp2;   //
+  Xbyak::Reg64 scratch; // RCX, for variable shifts and overflow checks
+};
+} // namespace
+
+static Xbyak::Address GetGTERegPtr32(CodeEmitter* emit, u32 index)
+{
+  return emit->dword[GetCPUPtrReg() + static_cast<u32>(offsetof(State, gte_regs.r32[0]) + (index * sizeof(u32)))];
+}
+
+static Xbyak::Address GetGTERegPtr16(CodeEmitter* emit, u32 index, u32 element)
+{
+  return emit->word[GetCPUPtrReg() + static_cast<u32>(offsetof(State, gte_regs.r32[0]) + (index * sizeof(u32)) +
+                                                      (element * sizeof(u16)))];
+}
+
+/// Sets the overflow/underflow flag if value doesn't fit in a signed (bits + 1)-bit integer.
+static void EmitGTECheckMACOverflow(CodeEmitter* emit, const GTEInlineRegs& regs, const Xbyak::Reg64& value, u32 bits,
+                                    u32 index)
+{
+  // in range when (value >> bits) is 0 or -1
+  Xbyak::Label done, underflow;
+  emit->mov(regs.scratch, value);
+  emit->sar(regs.scratch, static_cast<u8>(bits));
+  emit->add(regs.scratch, 1);
+  emit->cmp(regs.scratch, 1);
+  emit->jbe(done);
+  emit->jl(underflow);
+  emit->or_(regs.flags, GTE::FLAGS::GetMACOverflowBit(index));
+  emit->jmp(done);
+  emit->L(underflow);
+  emit->or_(regs.flags, GTE::FLAGS::GetMACUnderflowBit(index));
+  emit->L(done);
+}
+
+/// Clamps value to [min_value, max_value], setting flag (if any) when it is out of range.
+static void EmitGTESaturate(CodeEmitter* emit, const GTEInlineRegs& regs, const Xbyak::Reg32& value, s32 min_value,
+                            s32 max_value, u32 flag)
+{
+  Xbyak::Label not_below_min, done;
+  emit->cmp(value, min_value);
+  emit->jge(not_below_min);
+  emit->mov(value, min_value);
+  if (flag != 0)
+    emit->or_(regs.flags, flag);
+  emit->jmp(done);
+  emit->L(not_below_min);
+  emit->cmp(value, max_value);
+  emit->jle(done);
+  emit->mov(value, max_value);
+  if (flag != 0)
+    emit->or_(regs.flags, flag);
+  emit->L(done);
+}
+
+/// acc = (T[row] << 12) + M[row] * V, with the sign-extending overflow checks of the GTE on each partial sum.
+/// The translation is skipped if translation_index is zero.
+static void EmitGTEMatrixRow(CodeEmitter* emit, const GTEInlineRegs& regs, u32 row, u32 matrix_index,
+                             u32 vector_index, u32 translation_index)
+{
+  for (u32 col = 0; col < 3; col++)
+  {
+    emit->movsx(regs.temp, GetGTERegPtr16(emit, matrix_index, (row * 3) + col));
+
+    // IR1..3 are one per register, the vectors are packed
+    if (vector_index < 6)
+      emit->movsx(regs.temp2, GetGTERegPtr16(emit, vector_index, col));
+    else
+      emit->movsx(regs.temp2, GetGTERegPtr16(emit, vector_index + col, 0));
+
+    emit->imul(regs.temp, regs.temp2);
+
+    if (col == 0 && translation_index == 0)
+    {
+      // a single product can't overflow
+      emit->mov(regs.acc, regs.temp);
+      continue;
+    }
+
+    if (col == 0)
+    {
+      emit->movsxd(regs.acc, GetGTERegPtr32(emit, translation_index + row));
+      emit->shl(regs.acc, 12);
+    }
+
+    emit->add(regs.acc, regs.temp);
+    EmitGTECheckMACOverflow(emit, regs, regs.acc, 43, row + 1);
+
+    // the final sum is not truncated to 44 bits before it's shifted
+    if (col != 2)
+    {
+      emit->shl(regs.acc, 20);
+      emit->sar(regs.acc, 20);
+    }
+  }
+}
+
+/// Transforms the vertex for RTPS/RTPT, and pushes its depth. Leaves the new SZ3 in temp.
+static void EmitGTETransformVertex(CodeEmitter* emit, const GTEInlineRegs& regs, u32 vertex_index, bool sf, bool lm)
+{
+  const s32 ir_min = lm ? 0 : -0x8000;
+
+  for (u32 row = 0; row < 2; row++)
+  {
+    EmitGTEMatrixRow(emit, regs, row, 32, vertex_index, 37);
+    if (sf)
+      emit->sar(regs.acc, 12);
+    emit->mov(GetGTERegPtr32(emit, 25 + row), regs.acc.cvt32());
+    EmitGTESaturate(emit, regs, regs.acc.cvt32(), ir_min, 0x7FFF, GTE::FLAGS::GetIRSaturatedBit(row + 1));
+    emit->mov(GetGTERegPtr32(emit, 9 + row), regs.acc.cvt32());
+  }
+
+  EmitGTEMatrixRow(emit, regs, 2, 32, vertex_index, 37);
+  emit->mov(regs.temp, regs.acc);
+  if (sf)
+    emit->sar(regs.temp, 12);
+  emit->mov(GetGTERegPtr32(emit, 27), regs.temp.cvt32());
+  EmitGTESaturate(emit, regs, regs.temp.cvt32(), ir_min, 0x7FFF, 0);
+  emit->mov(GetGTERegPtr32(emit, 11), regs.temp.cvt32());
+
+  // the IR3 flag is based on MAC3 >> 12 regardless of sf
+  Xbyak::Label ir3_in_range;
+  emit->mov(regs.temp, regs.acc);
+  emit->sar(regs.temp, 12);
+  emit->movsx(regs.temp2.cvt32(), regs.temp.cvt16());
+  emit->cmp(regs.temp2.cvt32(), regs.temp.cvt32());
+  emit->je(ir3_in_range);
+  emit->or_(regs.flags, GTE::FLAGS::GetIRSaturatedBit(3));
+  emit->L(ir3_in_range);
+
+  // SZ0 <- SZ1 <- SZ2 <- SZ3 <- MAC3 >> 12
+  EmitGTESaturate(emit, regs, regs.temp.cvt32(), 0, 0xFFFF, GTE::FLAGS::SZ1_OTZ_SATURATED);
+  for (u32 i = 16; i < 19; i++)
+  {
+    emit->mov(regs.temp2.cvt32(), GetGTERegPtr32(emit, i + 1));
+    emit->mov(GetGTERegPtr32(emit, i), regs.temp2.cvt32());
+  }
+  emit->mov(GetGTERegPtr32(emit, 19), regs.temp.cvt32());
+}
+
+/// Perspective division and projection for RTPS/RTPT. Expects SZ3 in temp and the UNR table address in acc.
+static void EmitGTEProjectVertex(CodeEmitter* emit, const GTEInlineRegs& regs, bool last)
+{
+  const Xbyak::Reg32 divisor = regs.temp.cvt32();
+  const Xbyak::Reg32 result = regs.temp2.cvt32();
+  const Xbyak::Reg32 scratch = regs.scratch.cvt32();
+
+  // result = UNR division of H by SZ3
+  Xbyak::Label no_overflow, divide_done;
+  emit->movzx(result, GetGTERegPtr16(emit, 58, 0));
+  emit->lea(scratch, emit->ptr[regs.temp + regs.temp]);
+  emit->cmp(scratch, result);
+  emit->ja(no_overflow);
+  emit->or_(regs.flags, GTE::FLAGS::DIVIDE_OVERFLOW);
+  emit->mov(result, 0x1FFFF);
+  emit->jmp(divide_done);
+
+  // normalize so that bit 15 of the divisor is set, SZ3 can't be zero here
+  emit->L(no_overflow);
+  emit->bsr(scratch, divisor);
+  emit->xor_(scratch, 15);
+  emit->shl(result, emit->cl);
+  emit->shl(divisor, emit->cl);
+
+  // x = 0x101 + table[((divisor & 0x7FFF) + 0x40) >> 7]
+  emit->lea(scratch, emit->ptr[regs.temp - 0x7FC0]);
+  emit->shr(scratch, 7);
+  emit->movzx(scratch, emit->byte[regs.acc + regs.scratch]);
+  emit->add(scratch, 0x101);
+
+  // d = ((divisor * -x) + 0x80) >> 8, recip = ((x * (0x20000 + d)) + 0x80) >> 8
+  emit->imul(divisor, scratch);
+  emit->neg(divisor);
+  emit->add(divisor, 0x80);
+  emit->sar(divisor, 8);
+  emit->add(divisor, 0x20000);
+  emit->imul(divisor, scratch);
+  emit->add(divisor, 0x80);
+  emit->sar(divisor, 8);
+
+  // result = min(((lhs * recip) + 0x8000) >> 16, 0x1FFFF)
+  emit->imul(regs.temp2, regs.temp);
+  emit->add(regs.temp2, 0x8000);
+  emit->shr(regs.temp2, 16);
+  emit->mov(scratch, 0x1FFFF);
+  emit->cmp(result, scratch);
+  emit->cmova(result, scratch);
+  emit->L(divide_done);
+
+  // SX2 = (result * IR1 + OFX) >> 16
+  emit->movsx(regs.acc, GetGTERegPtr16(emit, 9, 0));
+  emit->imul(regs.acc, regs.temp2);
+  emit->movsxd(regs.temp, GetGTERegPtr32(emit, 56));
+  emit->add(regs.acc, regs.temp);
+  EmitGTECheckMACOverflow(emit, regs, regs.acc, 31, 0);
+  emit->sar(regs.acc, 16);
+  EmitGTESaturate(emit, regs, regs.acc.cvt32(), -0x400, 0x3FF, GTE::FLAGS::SX2_SATURATED);
+
+  // SY2 = (result * IR2 + OFY) >> 16
+  emit->movsx(regs.temp, GetGTERegPtr16(emit, 10, 0));
+  emit->imul(regs.temp, regs.temp2);
+  emit->movsxd(regs.scratch, GetGTERegPtr32(emit, 57));
+  emit->add(regs.temp, regs.scratch);
+  EmitGTECheckMACOverflow(emit, regs, regs.temp, 31, 0);
+  emit->sar(regs.temp, 16);
+  EmitGTESaturate(emit, regs, regs.temp.cvt32(), -0x400, 0x3FF, GTE::FLAGS::SY2_SATURATED);
+
+  // SXY0 <- SXY1 <- SXY2 <- (SX2, SY2)
+  emit->shl(regs.temp.cvt32(), 16);
+  emit->movzx(regs.acc.cvt32(), regs.acc.cvt16());
+  emit->or_(regs.temp.cvt32(), regs.acc.cvt32());
+  for (u32 i = 12; i < 14; i++)
+  {
+    emit->mov(scratch, GetGTERegPtr32(emit, i + 1));
+    emit->mov(GetGTERegPtr32(emit, i), scratch);
+  }
+  emit->mov(GetGTERegPtr32(emit, 14), regs.temp.cvt32());
+
+  if (!last)
+    return;
+
+  // MAC0 = result * DQA + DQB, IR0 = MAC0 >> 12
+  emit->movsx(regs.acc, GetGTERegPtr16(emit, 59, 0));
+  emit->imul(regs.acc, regs.temp2);
+  emit->movsxd(regs.temp, GetGTERegPtr32(emit, 60));
+  emit->add(regs.acc, regs.temp);
+  EmitGTECheckMACOverflow(emit, regs, regs.acc, 31, 0);
+  emit->mov(GetGTERegPtr32(emit, 24), regs.acc.cvt32());
+  emit->sar(regs.acc, 12);
+  EmitGTESaturate(emit, regs, regs.acc.cvt32(), 0, 0x1000, GTE::FLAGS::GetIRSaturatedBit(0));
+  emit->mov(GetGTERegPtr32(emit, 8), regs.acc.cvt32());
+}
+
+bool CodeGenerator::EmitInlineGTEInstruction(GTE::Instruction inst)
+{
+  // RCX has to be used for variable shifts, RDX is the accumulator
+#if defined(ABI_WIN64)
+  static constexpr HostReg temp_reg = RARG3;
+  static constexpr HostReg temp2_reg = RARG4;
+#else
+  static constexpr HostReg temp_reg = RARG1;
+  static constexpr HostReg temp2_reg = RARG2;
+#endif
+
+  Value flags_value = m_register_cache.AllocateScratch(RegSize_32, RRETURN);
+  Value acc_value = m_register_cache.AllocateScratch(RegSize_64, Xbyak::Operand::RDX);
+  Value temp_value = m_register_cache.AllocateScratch(RegSize_64, temp_reg);
+  Value temp2_value = m_register_cache.AllocateScratch(RegSize_64, temp2_reg);
+  Value scratch_value = m_register_cache.AllocateScratch(RegSize_64, Xbyak::Operand::RCX);
+  const GTEInlineRegs regs{GetHostReg32(flags_value), GetHostReg64(acc_value), GetHostReg64(temp_value),
+                           GetHostReg64(temp2_value), GetHostReg64(scratch_value)};
+
+  const bool sf = (inst.sf != 0);
+  const bool lm = inst.lm;
+
+  m_emit->xor_(regs.flags, regs.flags);
+
+  switch (inst.command)
+  {
+    case 0x01: // RTPS
+    case 0x30: // RTPT
+    {
+      const u32 num_vertices = (inst.command == 0x01) ? 1 : 3;
+      for (u32 vertex = 0; vertex < num_vertices; vertex++)
+      {
+        EmitGTETransformVertex(m_emit, regs, vertex * 2, sf, lm);
+        EmitLoadGlobalAddress(acc_value.GetHostRegister(), GTE::GetUNRTable());
+        EmitGTEProjectVertex(m_emit, regs, vertex == (num_vertices - 1));
+      }
+    }
+    break;
+
+    case 0x06: // NCLIP
+    {
+      // MAC0 = SX0*SY1 + SX1*SY2 + SX2*SY0 - SX0*SY2 - SX1*SY0 - SX2*SY1
+      static constexpr std::array<std::pair<u32, u32>, 6> products = {
+        {{12, 13}, {13, 14}, {14, 12}, {12, 14}, {13, 12}, {14, 13}}};
+      for (u32 i = 0; i < 6; i++)
+      {
+        m_emit->movsx(regs.temp, GetGTERegPtr16(m_emit, products[i].first, 0));
+        m_emit->movsx(regs.temp2, GetGTERegPtr16(m_emit, products[i].second, 1));
+        m_emit->imul(regs.temp, regs.temp2);
+        if (i == 0)
+          m_emit->mov(regs.acc, regs.temp);
+        else if (i < 3)
+          m_emit->add(regs.acc, regs.temp);
+        else
+          m_emit->sub(regs.acc, regs.temp);
+      }
+
+      EmitGTECheckMACOverflow(m_emit, regs, regs.acc, 31, 0);
+      m_emit->mov(GetGTERegPtr32(m_emit, 24), regs.acc.cvt32());
+    }
+    break;
+
+    case 0x12: // MVMVA
+    {
+      static constexpr std::array<u32, 3> matrix_indices = {{32, 40, 48}};
+      static constexpr std::array<u32, 4> vector_indices = {{0, 2, 4, 9}};
+      static constexpr std::array<u32, 4> translation_indices = {{37, 45, 53, 0}};
+      const u32 matrix_index = matrix_indices[inst.mvmva_multiply_matrix];
+      const u32 vector_index = vector_indices[inst.mvmva_multiply_vector];
+      const u32 translation_index = translation_indices[inst.mvmva_translation_vector];
+
+      // the vector can be IR1..3, so all of MAC1..3 are computed before IR1..3 are written
+      for (u32 row = 0; row < 3; row++)
+      {
+        EmitGTEMatrixRow(m_emit, regs, row, matrix_index, vector_index, translation_index);
+        if (sf)
+          m_emit->sar(regs.acc, 12);
+        m_emit->mov(GetGTERegPtr32(m_emit, 25 + row), regs.acc.cvt32());
+      }
+
+      for (u32 row = 0; row < 3; row++)
+      {
+        m_emit->mov(regs.acc.cvt32(), GetGTERegPtr32(m_emit, 25 + row));
+        EmitGTESaturate(m_emit, regs, regs.acc.cvt32(), lm ? 0 : -0x8000, 0x7FFF,
+                        GTE::FLAGS::GetIRSaturatedBit(row + 1));
+        m_emit->mov(GetGTERegPtr32(m_emit, 9 + row), regs.acc.cvt32());
+      }
+    }
+    break;
+
+    case 0x2D: // AVSZ3
+    case 0x2E: // AVSZ4
+    {
+      // MAC0 = ZSF * sum(SZ), OTZ = MAC0 >> 12
+      const bool avsz4 = (inst.command == 0x2E);
+      m_emit->movzx(regs.acc.cvt32(), GetGTERegPtr16(m_emit, avsz4 ? 16 : 17, 0));
+      for (u32 i = avsz4 ? 17 : 18; i < 20; i++)
+      {
+        m_emit->movzx(regs.temp.cvt32(), GetGTERegPtr16(m_emit, i, 0));
+        m_emit->add(regs.acc.cvt32(), regs.temp.cvt32());
+      }
+      m_emit->movsx(regs.temp, GetGTERegPtr16(m_emit, avsz4 ? 62 : 61, 0));
+      m_emit->imul(regs.acc, regs.temp);
+      EmitGTECheckMACOverflow(m_emit, regs, regs.acc, 31, 0);
+      m_emit->mov(GetGTERegPtr32(m_emit, 24), regs.acc.cvt32());
+      m_emit->sar(regs.acc, 12);
+      EmitGTESaturate(m_emit, regs, regs.acc.cvt32(), 0, 0xFFFF, GTE::FLAGS::SZ1_OTZ_SATURATED);
+      m_emit->mov(GetGTERegPtr32(m_emit, 7), regs.acc.cvt32());
+    }
+    break;
+
+    default:
+      UnreachableCode();
+      return false;
+  }
+
+  // FLAG.31 is set if any of the error bits are
+  m_emit->mov(regs.scratch.cvt32(), regs.flags);
+  m_emit->or_(regs.scratch.cvt32(), 0x80000000u);
+  m_emit->test(regs.flags, GTE::FLAGS::ERROR_MASK);
+  m_emit->cmovnz(regs.flags, regs.scratch.cvt32());
+  m_emit->mov(GetGTERegPtr32(m_emit, 63), regs.flags);
+  return true;
+}
+
 } // namespace CPU::Recompiler
@@ -222,7 +222,7 @@ bool RegisterCache::AllocateHostReg(HostReg reg, HostRegState state /*= HostRegS
     m_state.host_reg_state[reg] |= HostRegState::CalleeSavedAllocated;
   }
 
-  return reg;
+  return true;
 }
 
 void RegisterCache::DiscardHostReg(HostReg reg)
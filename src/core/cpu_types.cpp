@@ -363,4 +363,204 @@ bool IsInvalidInstruction(const Instruction& instruction)
   return true;
 }
 
+static constexpr u64 RegisterBit(Reg reg)
+{
+  return (UINT64_C(1) << static_cast<u8>(reg));
+}
+
+bool GetInstructionRegisterUsage(const Instruction& instruction, u64* reads, u64* writes)
+{
+  u64 r = 0;
+  u64 w = 0;
+  switch (instruction.op)
+  {
+    case InstructionOp::funct:
+    {
+      switch (instruction.r.funct)
+      {
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+          r = RegisterBit(instruction.r.rt);
+          w = RegisterBit(instruction.r.rd);
+          break;
+
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::add:
+        case InstructionFunct::addu:
+        case InstructionFunct::sub:
+        case InstructionFunct::subu:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          r = RegisterBit(instruction.r.rs) | RegisterBit(instruction.r.rt);
+          w = RegisterBit(instruction.r.rd);
+          break;
+
+        case InstructionFunct::jr:
+          r = RegisterBit(instruction.r.rs);
+          break;
+
+        case InstructionFunct::jalr:
+          r = RegisterBit(instruction.r.rs);
+          w = RegisterBit(instruction.r.rd);
+          break;
+
+        case InstructionFunct::syscall:
+        case InstructionFunct::break_:
+          break;
+
+        case InstructionFunct::mfhi:
+          r = RegisterBit(Reg::hi);
+          w = RegisterBit(instruction.r.rd);
+          break;
+
+        case InstructionFunct::mflo:
+          r = RegisterBit(Reg::lo);
+          w = RegisterBit(instruction.r.rd);
+          break;
+
+        case InstructionFunct::mthi:
+          r = RegisterBit(instruction.r.rs);
+          w = RegisterBit(Reg::hi);
+          break;
+
+        case InstructionFunct::mtlo:
+          r = RegisterBit(instruction.r.rs);
+          w = RegisterBit(Reg::lo);
+          break;
+
+        case InstructionFunct::mult:
+        case InstructionFunct::multu:
+        case InstructionFunct::div:
+        case InstructionFunct::divu:
+          r = RegisterBit(instruction.r.rs) | RegisterBit(instruction.r.rt);
+          w = RegisterBit(Reg::hi) | RegisterBit(Reg::lo);
+          break;
+
+        default:
+          *reads = ~UINT64_C(0);
+          *writes = ~UINT64_C(0);
+          return false;
+      }
+    }
+    break;
+
+    case InstructionOp::b:
+    {
+      // bltzal/bgezal write the return address whether or not the branch is taken
+      r = RegisterBit(instruction.i.rs);
+      if ((static_cast<u8>(instruction.i.rt.GetValue()) & u8(0x1E)) == u8(0x10))
+        w = RegisterBit(Reg::ra);
+    }
+    break;
+
+    case InstructionOp::j:
+      break;
+
+    case InstructionOp::jal:
+      w = RegisterBit(Reg::ra);
+      break;
+
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+      r = RegisterBit(instruction.i.rs) | RegisterBit(instruction.i.rt);
+      break;
+
+    case InstructionOp::blez:
+    case InstructionOp::bgtz:
+      r = RegisterBit(instruction.i.rs);
+      break;
+
+    case InstructionOp::addi:
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+    case InstructionOp::lb:
+    case InstructionOp::lh:
+    case InstructionOp::lw:
+    case InstructionOp::lbu:
+    case InstructionOp::lhu:
+      r = RegisterBit(instruction.i.rs);
+      w = RegisterBit(instruction.i.rt);
+      break;
+
+    case InstructionOp::lui:
+      w = RegisterBit(instruction.i.rt);
+      break;
+
+    case InstructionOp::lwl:
+    case InstructionOp::lwr:
+      // the unaligned loads merge with the current value
+      r = RegisterBit(instruction.i.rs) | RegisterBit(instruction.i.rt);
+      w = RegisterBit(instruction.i.rt);
+      break;
+
+    case InstructionOp::sb:
+    case InstructionOp::sh:
+    case InstructionOp::sw:
+    case InstructionOp::swl:
+    case InstructionOp::swr:
+      r = RegisterBit(instruction.i.rs) | RegisterBit(instruction.i.rt);
+      break;
+
+    case InstructionOp::lwc2:
+    case InstructionOp::swc2:
+      r = RegisterBit(instruction.i.rs);
+      break;
+
+    case InstructionOp::cop0:
+    case InstructionOp::cop2:
+    {
+      if (!instruction.cop.IsCommonInstruction())
+      {
+        // GTE commands and rfe don't touch the GPRs
+        if (instruction.op == InstructionOp::cop2 || instruction.cop.Cop0Op() == Cop0Instruction::rfe)
+          break;
+
+        *reads = ~UINT64_C(0);
+        *writes = ~UINT64_C(0);
+        return false;
+      }
+
+      switch (instruction.cop.CommonOp())
+      {
+        case CopCommonInstruction::mfcn:
+        case CopCommonInstruction::cfcn:
+          w = RegisterBit(instruction.r.rt);
+          break;
+
+        case CopCommonInstruction::mtcn:
+        case CopCommonInstruction::ctcn:
+          r = RegisterBit(instruction.r.rt);
+          break;
+
+        default:
+          *reads = ~UINT64_C(0);
+          *writes = ~UINT64_C(0);
+          return false;
+      }
+    }
+    break;
+
+    default:
+      *reads = ~UINT64_C(0);
+      *writes = ~UINT64_C(0);
+      return false;
+  }
+
+  // r0 is hardwired, so accesses to it don't matter
+  *reads = r & ~RegisterBit(Reg::zero);
+  *writes = w & ~RegisterBit(Reg::zero);
+  return true;
+}
+
 } // namespace CPU
\ No newline at end of file
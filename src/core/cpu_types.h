@@ -233,6 +233,10 @@ bool IsExitBlockInstruction(const Instruction& instruction);
 bool CanInstructionTrap(const Instruction& instruction, bool in_user_mode);
 bool IsInvalidInstruction(const Instruction& instruction);
 
+/// Returns the registers read and written by an instruction as masks of (1 << Reg). Returns false and sets every bit
+/// if the instruction isn't understood well enough to tell.
+bool GetInstructionRegisterUsage(const Instruction& instruction, u64* reads, u64* writes);
+
 struct Registers
 {
   union
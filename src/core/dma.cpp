@@ -512,13 +512,21 @@ TickCount DMA::TransferMemoryToDevice(Channel channel, u32 address, u32 incremen
     {
       if (g_gpu->BeginDMAWrite())
       {
-        u8* ram_pointer = Bus::g_ram;
-        for (u32 i = 0; i < word_count; i++)
+        if (increment == sizeof(u32))
         {
-          u32 value;
-          std::memcpy(&value, &ram_pointer[address], sizeof(u32));
-          g_gpu->DMAWrite(address, value);
-          address = (address + increment) & ADDRESS_MASK;
+          // linked list packets and most block transfers go forwards, so they can be copied in bulk
+          g_gpu->DMAWriteRAM(address, word_count);
+        }
+        else
+        {
+          u8* ram_pointer = Bus::g_ram;
+          for (u32 i = 0; i < word_count; i++)
+          {
+            u32 value;
+            std::memcpy(&value, &ram_pointer[address], sizeof(u32));
+            g_gpu->DMAWrite(address, value);
+            address = (address + increment) & ADDRESS_MASK;
+          }
         }
         g_gpu->EndDMAWrite();
       }
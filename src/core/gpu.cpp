@@ -1,4 +1,5 @@
 #include "gpu.h"
+#include "bus.h"
 #include "common/file_system.h"
 #include "common/heap_array.h"
 #include "common/log.h"
@@ -367,6 +368,41 @@ void GPU::DMARead(u32* words, u32 word_count)
     words[i] = ReadGPUREAD();
 }
 
+void GPU::DMAWriteRAM(u32 address, u32 word_count)
+{
+  if (word_count > m_fifo.GetSpace())
+  {
+    // overflowing the FIFO, leave it to DMAWrite() to behave the same as it always has
+    for (u32 i = 0; i < word_count; i++)
+    {
+      u32 value;
+      std::memcpy(&value, &Bus::g_ram[address], sizeof(value));
+      DMAWrite(address, value);
+      address = (address + sizeof(u32)) & Bus::RAM_MASK;
+    }
+    return;
+  }
+
+  while (word_count > 0)
+  {
+    // split where the FIFO or RAM wraps around
+    const u32 span = std::min(word_count, std::min(m_fifo.GetContiguousSpace(),
+                                                   static_cast<u32>((Bus::RAM_SIZE - address) / sizeof(u32))));
+    const u8* src = &Bus::g_ram[address];
+    u64* dst = m_fifo.GetWritePointer();
+    for (u32 i = 0; i < span; i++)
+    {
+      u32 value;
+      std::memcpy(&value, src + (i * sizeof(u32)), sizeof(value));
+      dst[i] = (ZeroExtend64(address + (i * sizeof(u32))) << 32) | ZeroExtend64(value);
+    }
+
+    m_fifo.AdvanceTail(span);
+    address = (address + (span * sizeof(u32))) & Bus::RAM_MASK;
+    word_count -= span;
+  }
+}
+
 void GPU::EndDMAWrite()
 {
   m_fifo_pushed = true;
@@ -848,7 +884,9 @@ void GPU::CRTCTickEvent(TickCount ticks)
 
         // flush any pending draws and "scan out" the image
         FlushRender();
-        UpdateDisplay();
+        if (!m_skip_display_updates)
+          UpdateDisplay();
+        FrameDone();
         System::FrameDone();
 
         // switch fields early. this is needed so we draw to the correct one.
@@ -1396,6 +1434,14 @@ void GPU::DispatchRenderCommand() {}
 
 void GPU::FlushRender() {}
 
+void GPU::FrameDone() {}
+
+bool GPU::StartRecordingCommands(const char* filename, u32 num_frames)
+{
+  Log_ErrorPrintf("Command recording is not supported by this renderer.");
+  return false;
+}
+
 void GPU::SetDrawMode(u16 value)
 {
   GPUDrawModeReg new_mode_reg{static_cast<u16>(value & GPUDrawModeReg::MASK)};
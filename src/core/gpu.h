@@ -99,6 +99,10 @@ public:
   {
     m_fifo.Push((ZeroExtend64(address) << 32) | ZeroExtend64(value));
   }
+
+  /// Same as calling DMAWrite() for each word of a forward transfer from RAM, but copies straight into the FIFO.
+  void DMAWriteRAM(u32 address, u32 word_count);
+
   void EndDMAWrite();
 
   /// Returns true if no data is being sent from VRAM to the DAC or that no portion of VRAM would be visible on screen.
@@ -119,6 +123,9 @@ public:
     return (!m_force_progressive_scan) && m_GPUSTAT.SkipDrawingToActiveField();
   }
 
+  /// Skips scanning out to the host display at vblank. Used for frames which will never be presented.
+  ALWAYS_INLINE void SetSkipDisplayUpdates(bool skip) { m_skip_display_updates = skip; }
+
   /// Returns the number of pending GPU ticks.
   TickCount GetPendingCRTCTicks() const;
   TickCount GetPendingCommandTicks() const;
@@ -163,6 +170,9 @@ public:
   // Dumps raw VRAM to a file.
   bool DumpVRAMToFile(const char* filename);
 
+  // Records the renderer's command stream for the next num_frames frames to a file, for offline replay.
+  virtual bool StartRecordingCommands(const char* filename, u32 num_frames);
+
 protected:
   TickCount CRTCTicksToSystemTicks(TickCount crtc_ticks, TickCount fractional_ticks) const;
   TickCount SystemTicksToCRTCTicks(TickCount sysclk_ticks, TickCount* fractional_ticks) const;
@@ -293,6 +303,7 @@ protected:
   virtual void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height);
   virtual void DispatchRenderCommand();
   virtual void FlushRender();
+  virtual void FrameDone();
   virtual void ClearDisplay();
   virtual void UpdateDisplay();
   virtual void DrawRendererStats(bool is_idle_frame);
@@ -455,6 +466,7 @@ protected:
   bool m_drawing_area_changed = false;
   bool m_force_progressive_scan = false;
   bool m_force_ntsc_timings = false;
+  bool m_skip_display_updates = false;
 
   struct CRTCState
   {
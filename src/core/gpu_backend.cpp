@@ -1,10 +1,31 @@
 #include "gpu_backend.h"
 #include "common/align.h"
+#include "common/cpu_detect.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
+#include "gpu_command_recording.h"
 #include "settings.h"
+#include <algorithm>
+#include <cstring>
 Log_SetChannel(GPUBackend);
 
+#if defined(CPU_X64)
+#include <emmintrin.h>
+#elif defined(CPU_AARCH64) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static ALWAYS_INLINE void SpinPause()
+{
+#if defined(CPU_X64)
+  _mm_pause();
+#elif defined(CPU_AARCH64) && defined(_MSC_VER)
+  __yield();
+#elif defined(CPU_AARCH64)
+  __asm__ __volatile__("yield");
+#endif
+}
+
 std::unique_ptr<GPUBackend> g_gpu_backend;
 
 GPUBackend::GPUBackend() = default;
@@ -40,6 +61,7 @@ void GPUBackend::UpdateSettings()
 
 void GPUBackend::Shutdown()
 {
+  StopRecording();
   StopGPUThread();
 }
 
@@ -143,6 +165,10 @@ u32 GPUBackend::GetPendingCommandSize() const
 
 void GPUBackend::PushCommand(GPUBackendCommand* cmd)
 {
+  // must be captured before the write pointer is published, otherwise the GPU thread could overwrite it
+  if (m_recording)
+    m_recording->AppendCommand(cmd);
+
   if (!m_use_gpu_thread)
   {
     // single-thread mode
@@ -151,24 +177,189 @@ void GPUBackend::PushCommand(GPUBackendCommand* cmd)
   }
   else
   {
+    m_pushed_fence++;
+    MarkVRAMRegionWritten(cmd, m_pushed_fence);
+
     const u32 new_write_ptr = m_command_fifo_write_ptr.fetch_add(cmd->size) + cmd->size;
     DebugAssert(new_write_ptr <= COMMAND_QUEUE_SIZE);
-    if (GetPendingCommandSize() >= THRESHOLD_TO_WAKE_GPU)
-      WakeGPUThread();
+
+    // Waking the GPU thread is expensive, so if it keeps falling asleep, let it build up a larger batch next time.
+    if (GetPendingCommandSize() >= m_wake_threshold && WakeGPUThread())
+      m_wake_threshold = std::min<u32>(m_wake_threshold * 2, MAX_THRESHOLD_TO_WAKE_GPU);
+  }
+}
+
+template<typename T>
+void GPUBackend::EnumerateFenceTiles(u32 x, u32 y, u32 width, u32 height, const T& callback)
+{
+  if (width == 0 || height == 0)
+    return;
+
+  // regions can wrap around the edges of vram
+  const u32 first_tile_x = (x % VRAM_WIDTH) >> FENCE_TILE_SHIFT;
+  const u32 first_tile_y = (y % VRAM_HEIGHT) >> FENCE_TILE_SHIFT;
+  const u32 num_tiles_x = std::min<u32>(
+    (((x % VRAM_WIDTH) + width - 1) >> FENCE_TILE_SHIFT) - first_tile_x + 1, FENCE_TILES_X);
+  const u32 num_tiles_y = std::min<u32>(
+    (((y % VRAM_HEIGHT) + height - 1) >> FENCE_TILE_SHIFT) - first_tile_y + 1, FENCE_TILES_Y);
+  for (u32 ty = 0; ty < num_tiles_y; ty++)
+  {
+    const u32 row = ((first_tile_y + ty) % FENCE_TILES_Y) * FENCE_TILES_X;
+    for (u32 tx = 0; tx < num_tiles_x; tx++)
+      callback(row + ((first_tile_x + tx) % FENCE_TILES_X));
   }
 }
 
-void GPUBackend::WakeGPUThread()
+void GPUBackend::MarkVRAMRegionWritten(const GPUBackendCommand* cmd, u64 fence)
+{
+  u32 x, y, width, height;
+  switch (cmd->type)
+  {
+    case GPUBackendCommandType::FillVRAM:
+    {
+      const GPUBackendFillVRAMCommand* ccmd = static_cast<const GPUBackendFillVRAMCommand*>(cmd);
+      x = ccmd->x;
+      y = ccmd->y;
+      width = ccmd->width;
+      height = ccmd->height;
+    }
+    break;
+
+    case GPUBackendCommandType::UpdateVRAM:
+    {
+      const GPUBackendUpdateVRAMCommand* ccmd = static_cast<const GPUBackendUpdateVRAMCommand*>(cmd);
+      x = ccmd->x;
+      y = ccmd->y;
+      width = ccmd->width;
+      height = ccmd->height;
+    }
+    break;
+
+    case GPUBackendCommandType::CopyVRAM:
+    {
+      const GPUBackendCopyVRAMCommand* ccmd = static_cast<const GPUBackendCopyVRAMCommand*>(cmd);
+      x = ccmd->dst_x;
+      y = ccmd->dst_y;
+      width = ccmd->width;
+      height = ccmd->height;
+    }
+    break;
+
+    case GPUBackendCommandType::SetDrawingArea:
+    {
+      m_fence_drawing_area = static_cast<const GPUBackendSetDrawingAreaCommand*>(cmd)->new_area;
+      return;
+    }
+
+    case GPUBackendCommandType::DrawPolygon:
+    case GPUBackendCommandType::DrawRectangle:
+    case GPUBackendCommandType::DrawLine:
+    {
+      // draws are always clipped to the drawing area
+      if (m_fence_drawing_area.left > m_fence_drawing_area.right ||
+          m_fence_drawing_area.top > m_fence_drawing_area.bottom)
+      {
+        return;
+      }
+
+      x = m_fence_drawing_area.left;
+      y = m_fence_drawing_area.top;
+      width = m_fence_drawing_area.right - m_fence_drawing_area.left + 1;
+      height = m_fence_drawing_area.bottom - m_fence_drawing_area.top + 1;
+    }
+    break;
+
+    default:
+      return;
+  }
+
+  EnumerateFenceTiles(x, y, width, height, [this, fence](u32 tile) { m_vram_tile_fences[tile] = fence; });
+}
+
+u64 GPUBackend::GetVRAMRegionFence(u32 x, u32 y, u32 width, u32 height) const
+{
+  u64 fence = 0;
+  EnumerateFenceTiles(x, y, width, height,
+                      [this, &fence](u32 tile) { fence = std::max(fence, m_vram_tile_fences[tile]); });
+  return fence;
+}
+
+void GPUBackend::PushRecordedCommand(const GPUBackendCommand* cmd)
+{
+  GPUBackendCommand* new_cmd = static_cast<GPUBackendCommand*>(AllocateCommand(cmd->type, cmd->size));
+  std::memcpy(new_cmd, cmd, cmd->size);
+  PushCommand(new_cmd);
+}
+
+bool GPUBackend::StartRecording(const char* filename, u32 num_frames)
+{
+  if (num_frames == 0)
+    return false;
+
+  StopRecording();
+  Sync();
+
+  m_recording = std::make_unique<GPUCommandRecording>();
+  m_recording->Begin(m_vram_ptr);
+  m_recording_filename = filename;
+  m_recording_frames_remaining = num_frames;
+
+  // the drawing area isn't part of vram, so it has to be the first command
+  GPUBackendSetDrawingAreaCommand cmd = {};
+  cmd.type = GPUBackendCommandType::SetDrawingArea;
+  cmd.size = sizeof(cmd);
+  cmd.new_area = m_drawing_area;
+  m_recording->AppendCommand(&cmd);
+
+  Log_InfoPrintf("Recording %u frames of GPU commands to '%s'", num_frames, filename);
+  return true;
+}
+
+void GPUBackend::StopRecording()
+{
+  if (!m_recording)
+    return;
+
+  if (m_recording->GetFrameCount() == 0)
+    m_recording->EndFrame();
+
+  m_recording->SaveToFile(m_recording_filename.c_str());
+  m_recording.reset();
+  m_recording_filename = {};
+  m_recording_frames_remaining = 0;
+}
+
+void GPUBackend::EndRecordingFrame()
+{
+  if (!m_recording)
+    return;
+
+  m_recording->EndFrame();
+  if ((--m_recording_frames_remaining) == 0)
+    StopRecording();
+}
+
+bool GPUBackend::WakeGPUThread()
 {
   std::unique_lock<std::mutex> lock(m_sync_mutex);
   if (!m_gpu_thread_sleeping.load())
-    return;
+    return false;
 
   m_wake_gpu_thread_cv.notify_one();
+  return true;
 }
 
 void GPUBackend::StartGPUThread()
 {
+  // everything pushed so far was executed synchronously
+  m_executed_fence = m_pushed_fence;
+  m_completed_fence.store(m_pushed_fence);
+  m_requested_fence.store(m_pushed_fence);
+  m_wake_threshold = MIN_THRESHOLD_TO_WAKE_GPU;
+
+  // spinning only helps when the other thread can make progress at the same time
+  m_spin_iterations = (std::thread::hardware_concurrency() > 1) ? SPIN_ITERATIONS : 0;
+
   m_gpu_loop_done.store(false);
   m_use_gpu_thread = true;
   m_gpu_thread = std::thread(&GPUBackend::RunGPULoop, this);
@@ -190,15 +381,62 @@ void GPUBackend::StopGPUThread()
 void GPUBackend::Sync()
 {
   if (!m_use_gpu_thread)
+  {
+    // draws can still be batched up in the backend
+    FlushRender();
     return;
+  }
+
+  WaitForFence(m_pushed_fence);
+}
 
-  GPUBackendSyncCommand* cmd =
-    static_cast<GPUBackendSyncCommand*>(AllocateCommand(GPUBackendCommandType::Sync, sizeof(GPUBackendSyncCommand)));
-  PushCommand(cmd);
+void GPUBackend::SyncRegion(u32 x, u32 y, u32 width, u32 height)
+{
+  if (!m_use_gpu_thread)
+  {
+    FlushRender();
+    return;
+  }
+
+  WaitForFence(GetVRAMRegionFence(x, y, width, height));
+}
+
+void GPUBackend::WaitForFence(u64 fence)
+{
+  if (m_completed_fence.load(std::memory_order_acquire) >= fence)
+    return;
+
+  // Work was left sitting in the queue while we needed it, so wake the GPU thread sooner from now on.
+  m_wake_threshold = std::max<u32>(m_wake_threshold / 2, MIN_THRESHOLD_TO_WAKE_GPU);
+
+  m_requested_fence.store(fence);
   WakeGPUThread();
 
-  m_sync_event.Wait();
-  m_sync_event.Reset();
+  for (u32 i = 0; i < m_spin_iterations; i++)
+  {
+    if (m_completed_fence.load(std::memory_order_acquire) >= fence)
+      return;
+
+    SpinPause();
+  }
+
+  std::unique_lock<std::mutex> lock(m_sync_mutex);
+  m_sync_cpu_thread_cv.wait(lock, [this, fence]() { return m_completed_fence.load() >= fence; });
+}
+
+void GPUBackend::CompleteFence(u64 fence)
+{
+  // batched draws have to land in vram before the cpu thread can look at it
+  FlushRender();
+
+  // the request has to be read after publishing, otherwise a waiter could slip in between and never be woken
+  const u64 previous_fence = m_completed_fence.exchange(fence);
+  const u64 requested_fence = m_requested_fence.load();
+  if (requested_fence > previous_fence && requested_fence <= fence)
+  {
+    std::unique_lock<std::mutex> lock(m_sync_mutex);
+    m_sync_cpu_thread_cv.notify_one();
+  }
 }
 
 void GPUBackend::RunGPULoop()
@@ -209,6 +447,20 @@ void GPUBackend::RunGPULoop()
     u32 read_ptr = m_command_fifo_read_ptr.load();
     if (read_ptr == write_ptr)
     {
+      // don't leave batched draws sitting around while we're idle
+      if (m_completed_fence.load(std::memory_order_relaxed) != m_executed_fence)
+        CompleteFence(m_executed_fence);
+
+      // the cpu thread is often just about to push more, so avoid a sleep/wake round trip if it does
+      bool has_work = false;
+      for (u32 i = 0; i < m_spin_iterations && !has_work; i++)
+      {
+        SpinPause();
+        has_work = (m_command_fifo_write_ptr.load() != read_ptr);
+      }
+      if (has_work)
+        continue;
+
       std::unique_lock<std::mutex> lock(m_sync_mutex);
       m_gpu_thread_sleeping.store(true);
       m_wake_gpu_thread_cv.wait(lock, [this]() { return m_gpu_loop_done.load() || GetPendingCommandSize() > 0; });
@@ -238,16 +490,19 @@ void GPUBackend::RunGPULoop()
         }
         break;
 
-        case GPUBackendCommandType::Sync:
+        default:
         {
-          DebugAssert(read_ptr == write_ptr);
-          m_sync_event.Signal();
+          HandleCommand(cmd);
+
+          // let the cpu thread go as soon as the command it is waiting for is done
+          m_executed_fence++;
+          if (m_executed_fence >= m_requested_fence.load(std::memory_order_relaxed) &&
+              m_completed_fence.load(std::memory_order_relaxed) < m_requested_fence.load(std::memory_order_relaxed))
+          {
+            CompleteFence(m_executed_fence);
+          }
         }
         break;
-
-        default:
-          HandleCommand(cmd);
-          break;
       }
     }
 
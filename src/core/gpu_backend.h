@@ -1,11 +1,12 @@
 #pragma once
-#include "common/event.h"
 #include "common/heap_array.h"
 #include "gpu_types.h"
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 
 #ifdef _MSC_VER
@@ -13,6 +14,8 @@
 #pragma warning(disable : 4324) // warning C4324: 'GPUBackend': structure was padded due to alignment specifier
 #endif
 
+class GPUCommandRecording;
+
 class GPUBackend
 {
 public:
@@ -35,15 +38,36 @@ public:
   GPUBackendDrawLineCommand* NewDrawLineCommand(u32 num_vertices);
 
   void PushCommand(GPUBackendCommand* cmd);
+
+  /// Waits until all pushed commands have been executed.
   void Sync();
 
+  /// Waits until all pushed commands which write to the specified VRAM region have been executed.
+  /// Commands which only touch other parts of VRAM may still be in flight afterwards.
+  void SyncRegion(u32 x, u32 y, u32 width, u32 height);
+
+  /// Pushes a copy of a command which was previously captured with a recording.
+  void PushRecordedCommand(const GPUBackendCommand* cmd);
+
+  /// Starts capturing pushed commands, along with the current VRAM contents, for the next num_frames frames.
+  /// The caller must ensure GetVRAM() is up to date before starting.
+  bool StartRecording(const char* filename, u32 num_frames);
+
+  /// Writes out any partially-captured recording and stops capturing.
+  void StopRecording();
+
+  /// Marks the end of a frame in the recording, saving it once the requested number of frames have been captured.
+  void EndRecordingFrame();
+
+  ALWAYS_INLINE bool IsRecording() const { return static_cast<bool>(m_recording); }
+
   /// Processes all pending GPU commands.
   void RunGPULoop();
 
 protected:
   void* AllocateCommand(GPUBackendCommandType command, u32 size);
   u32 GetPendingCommandSize() const;
-  void WakeGPUThread();
+  bool WakeGPUThread();
   void StartGPUThread();
   void StopGPUThread();
 
@@ -60,11 +84,17 @@ protected:
 
   void HandleCommand(const GPUBackendCommand* cmd);
 
+  template<typename T>
+  static void EnumerateFenceTiles(u32 x, u32 y, u32 width, u32 height, const T& callback);
+  void MarkVRAMRegionWritten(const GPUBackendCommand* cmd, u64 fence);
+  u64 GetVRAMRegionFence(u32 x, u32 y, u32 width, u32 height) const;
+  void WaitForFence(u64 fence);
+  void CompleteFence(u64 fence);
+
   u16* m_vram_ptr = nullptr;
 
   Common::Rectangle<u32> m_drawing_area{};
 
-  Common::Event m_sync_event;
   std::atomic_bool m_gpu_thread_sleeping{false};
   std::atomic_bool m_gpu_loop_done{false};
   std::thread m_gpu_thread;
@@ -73,17 +103,39 @@ protected:
   std::mutex m_sync_mutex;
   std::condition_variable m_sync_cpu_thread_cv;
   std::condition_variable m_wake_gpu_thread_cv;
-  bool m_sync_done = false;
+
+  std::unique_ptr<GPUCommandRecording> m_recording;
+  std::string m_recording_filename;
+  u32 m_recording_frames_remaining = 0;
 
   enum : u32
   {
     COMMAND_QUEUE_SIZE = 4 * 1024 * 1024,
-    THRESHOLD_TO_WAKE_GPU = 256
+    MIN_THRESHOLD_TO_WAKE_GPU = 256,
+    MAX_THRESHOLD_TO_WAKE_GPU = 64 * 1024,
+    SPIN_ITERATIONS = 4096,
+
+    FENCE_TILE_SHIFT = 6,
+    FENCE_TILES_X = VRAM_WIDTH >> FENCE_TILE_SHIFT,
+    FENCE_TILES_Y = VRAM_HEIGHT >> FENCE_TILE_SHIFT
   };
 
+  // CPU thread state. Each pushed command gets a fence number, and the last fence which wrote to each tile of VRAM is
+  // kept so reads only have to wait for the commands which could have modified the region.
+  std::array<u64, FENCE_TILES_X * FENCE_TILES_Y> m_vram_tile_fences{};
+  Common::Rectangle<u32> m_fence_drawing_area{};
+  u64 m_pushed_fence = 0;
+  u32 m_wake_threshold = MIN_THRESHOLD_TO_WAKE_GPU;
+  u32 m_spin_iterations = 0;
+
+  // GPU thread state.
+  u64 m_executed_fence = 0;
+
   HeapArray<u8, COMMAND_QUEUE_SIZE> m_command_fifo_data;
   alignas(64) std::atomic<u32> m_command_fifo_read_ptr{0};
   alignas(64) std::atomic<u32> m_command_fifo_write_ptr{0};
+  alignas(64) std::atomic<u64> m_completed_fence{0};
+  alignas(64) std::atomic<u64> m_requested_fence{0};
 };
 
 #ifdef _MSC_VER
@@ -0,0 +1,237 @@
+#include "gpu_command_recording.h"
+#include "common/file_system.h"
+#include "common/log.h"
+#include "zlib.h"
+#include <cstring>
+Log_SetChannel(GPUCommandRecording);
+
+GPUCommandRecording::GPUCommandRecording() = default;
+
+GPUCommandRecording::~GPUCommandRecording() = default;
+
+const u8* GPUCommandRecording::GetFrameCommandsStart(u32 frame) const
+{
+  return m_command_data.data() + ((frame > 0) ? m_frame_end_offsets[frame - 1] : 0u);
+}
+
+const u8* GPUCommandRecording::GetFrameCommandsEnd(u32 frame) const
+{
+  return m_command_data.data() + m_frame_end_offsets[frame];
+}
+
+void GPUCommandRecording::Begin(const u16* vram)
+{
+  m_initial_vram.assign(vram, vram + (VRAM_WIDTH * VRAM_HEIGHT));
+  m_frame_end_offsets.clear();
+  m_command_data.clear();
+}
+
+void GPUCommandRecording::AppendCommand(const GPUBackendCommand* cmd)
+{
+  if (cmd->type == GPUBackendCommandType::Wraparound || cmd->type == GPUBackendCommandType::Sync)
+    return;
+
+  const u8* cmd_bytes = reinterpret_cast<const u8*>(cmd);
+  m_command_data.insert(m_command_data.end(), cmd_bytes, cmd_bytes + cmd->size);
+}
+
+void GPUCommandRecording::EndFrame()
+{
+  m_frame_end_offsets.push_back(static_cast<u32>(m_command_data.size()));
+}
+
+/// Checks that a command's size covers its fields, including the vertices or VRAM data which follow them. The fixed
+/// fields are only read once the size is known to cover them.
+static bool IsValidCommand(const GPUBackendCommand* cmd)
+{
+  switch (cmd->type)
+  {
+    case GPUBackendCommandType::FillVRAM:
+      return cmd->size >= sizeof(GPUBackendFillVRAMCommand);
+
+    case GPUBackendCommandType::UpdateVRAM:
+    {
+      if (cmd->size < sizeof(GPUBackendUpdateVRAMCommand))
+        return false;
+
+      const GPUBackendUpdateVRAMCommand* ccmd = static_cast<const GPUBackendUpdateVRAMCommand*>(cmd);
+      const u64 data_size = static_cast<u64>(ccmd->width) * ccmd->height * sizeof(u16);
+      return (cmd->size - sizeof(GPUBackendUpdateVRAMCommand)) >= data_size;
+    }
+
+    case GPUBackendCommandType::CopyVRAM:
+      return cmd->size >= sizeof(GPUBackendCopyVRAMCommand);
+
+    case GPUBackendCommandType::SetDrawingArea:
+      return cmd->size >= sizeof(GPUBackendSetDrawingAreaCommand);
+
+    case GPUBackendCommandType::DrawPolygon:
+    {
+      if (cmd->size < sizeof(GPUBackendDrawPolygonCommand))
+        return false;
+
+      // the renderers use three or four vertices depending on the command, not the count
+      const GPUBackendDrawPolygonCommand* ccmd = static_cast<const GPUBackendDrawPolygonCommand*>(cmd);
+      const u32 vertices_size = ZeroExtend32(ccmd->num_vertices) * sizeof(GPUBackendDrawPolygonCommand::Vertex);
+      return ccmd->num_vertices == (ccmd->rc.quad_polygon ? 4 : 3) &&
+             (cmd->size - sizeof(GPUBackendDrawPolygonCommand)) >= vertices_size;
+    }
+
+    case GPUBackendCommandType::DrawRectangle:
+      return cmd->size >= sizeof(GPUBackendDrawRectangleCommand);
+
+    case GPUBackendCommandType::DrawLine:
+    {
+      if (cmd->size < sizeof(GPUBackendDrawLineCommand))
+        return false;
+
+      const GPUBackendDrawLineCommand* ccmd = static_cast<const GPUBackendDrawLineCommand*>(cmd);
+      const u32 vertices_size = ZeroExtend32(ccmd->num_vertices) * sizeof(GPUBackendDrawLineCommand::Vertex);
+      return ccmd->num_vertices > 0 && (cmd->size - sizeof(GPUBackendDrawLineCommand)) >= vertices_size;
+    }
+
+    default:
+      // wraparound and sync commands aren't recorded
+      return false;
+  }
+}
+
+bool GPUCommandRecording::LoadFromFile(const char* filename)
+{
+  std::optional<std::vector<u8>> file_data = FileSystem::ReadBinaryFile(filename);
+  if (!file_data.has_value())
+  {
+    Log_ErrorPrintf("Failed to read '%s'", filename);
+    return false;
+  }
+
+  GPU_COMMAND_RECORDING_HEADER header;
+  if (file_data->size() < sizeof(header))
+  {
+    Log_ErrorPrintf("'%s' is too small to be a GPU command recording", filename);
+    return false;
+  }
+
+  std::memcpy(&header, file_data->data(), sizeof(header));
+  if (header.magic != GPU_COMMAND_RECORDING_MAGIC || header.version != GPU_COMMAND_RECORDING_VERSION ||
+      header.vram_width != VRAM_WIDTH || header.vram_height != VRAM_HEIGHT)
+  {
+    Log_ErrorPrintf("'%s' has an invalid header (magic %08X, version %u, vram %ux%u)", filename, header.magic,
+                    header.version, header.vram_width, header.vram_height);
+    return false;
+  }
+
+  // the frame count comes from the file, so don't let the size of the offsets wrap around
+  const u32 vram_size = VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16);
+  const u64 offsets_size64 = static_cast<u64>(header.num_frames) * sizeof(u32);
+  if ((file_data->size() - sizeof(header)) < header.data_compressed_size ||
+      header.data_uncompressed_size < (vram_size + offsets_size64))
+  {
+    Log_ErrorPrintf("'%s' is truncated", filename);
+    return false;
+  }
+
+  // deflate can't shrink data by more than ~1032:1, so a larger size is corrupt and would only waste an allocation
+  static constexpr u64 MAX_DEFLATE_RATIO = 1032;
+  if (header.data_uncompressed_size > GPU_COMMAND_RECORDING_MAX_SIZE ||
+      header.data_uncompressed_size > (static_cast<u64>(header.data_compressed_size) * MAX_DEFLATE_RATIO))
+  {
+    Log_ErrorPrintf("'%s' has an invalid data size (%u compressed, %u uncompressed)", filename,
+                    header.data_compressed_size, header.data_uncompressed_size);
+    return false;
+  }
+
+  const u32 offsets_size = static_cast<u32>(offsets_size64);
+
+  std::vector<u8> data(header.data_uncompressed_size);
+  uLongf data_size = static_cast<uLongf>(data.size());
+  const int err = uncompress(data.data(), &data_size, file_data->data() + sizeof(header), header.data_compressed_size);
+  if (err != Z_OK || data_size != data.size())
+  {
+    Log_ErrorPrintf("uncompress() failed: %d", err);
+    return false;
+  }
+
+  const u32 command_data_size = header.data_uncompressed_size - vram_size - offsets_size;
+  m_initial_vram.resize(VRAM_WIDTH * VRAM_HEIGHT);
+  m_frame_end_offsets.resize(header.num_frames);
+  m_command_data.resize(command_data_size);
+  std::memcpy(m_initial_vram.data(), data.data(), vram_size);
+  std::memcpy(m_frame_end_offsets.data(), data.data() + vram_size, offsets_size);
+  std::memcpy(m_command_data.data(), data.data() + vram_size + offsets_size, command_data_size);
+
+  // make sure the command stream can be walked without running off the end
+  u32 offset = 0;
+  for (u32 frame = 0; frame < header.num_frames; frame++)
+  {
+    const u32 frame_end = m_frame_end_offsets[frame];
+    if (frame_end < offset || frame_end > command_data_size)
+    {
+      Log_ErrorPrintf("Frame %u has an invalid end offset %u", frame, frame_end);
+      return false;
+    }
+
+    while (offset < frame_end)
+    {
+      const GPUBackendCommand* cmd = reinterpret_cast<const GPUBackendCommand*>(&m_command_data[offset]);
+      if ((frame_end - offset) < sizeof(GPUBackendCommand) || (cmd->size % 4) != 0 ||
+          cmd->size > (frame_end - offset) || !IsValidCommand(cmd))
+      {
+        Log_ErrorPrintf("Invalid command at offset %u in frame %u", offset, frame);
+        return false;
+      }
+
+      offset += cmd->size;
+    }
+  }
+
+  return true;
+}
+
+bool GPUCommandRecording::SaveToFile(const char* filename) const
+{
+  const u32 vram_size = VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16);
+  const u32 offsets_size = static_cast<u32>(m_frame_end_offsets.size() * sizeof(u32));
+  if ((static_cast<u64>(vram_size) + offsets_size + m_command_data.size()) > GPU_COMMAND_RECORDING_MAX_SIZE)
+  {
+    Log_ErrorPrintf("Recording is too large to save (%u frames, %u bytes of commands)", GetFrameCount(),
+                    GetCommandDataSize());
+    return false;
+  }
+
+  std::vector<u8> data(vram_size + offsets_size + m_command_data.size());
+  std::memcpy(data.data(), m_initial_vram.data(), vram_size);
+  std::memcpy(data.data() + vram_size, m_frame_end_offsets.data(), offsets_size);
+  if (!m_command_data.empty())
+    std::memcpy(data.data() + vram_size + offsets_size, m_command_data.data(), m_command_data.size());
+
+  uLongf compressed_size = compressBound(static_cast<uLong>(data.size()));
+  std::vector<u8> file_data(sizeof(GPU_COMMAND_RECORDING_HEADER) + compressed_size);
+  const int err = compress2(file_data.data() + sizeof(GPU_COMMAND_RECORDING_HEADER), &compressed_size, data.data(),
+                            static_cast<uLong>(data.size()), Z_BEST_SPEED);
+  if (err != Z_OK)
+  {
+    Log_ErrorPrintf("compress2() failed: %d", err);
+    return false;
+  }
+
+  GPU_COMMAND_RECORDING_HEADER header = {};
+  header.magic = GPU_COMMAND_RECORDING_MAGIC;
+  header.version = GPU_COMMAND_RECORDING_VERSION;
+  header.num_frames = GetFrameCount();
+  header.vram_width = VRAM_WIDTH;
+  header.vram_height = VRAM_HEIGHT;
+  header.data_compressed_size = static_cast<u32>(compressed_size);
+  header.data_uncompressed_size = static_cast<u32>(data.size());
+  std::memcpy(file_data.data(), &header, sizeof(header));
+  file_data.resize(sizeof(header) + compressed_size);
+
+  if (!FileSystem::WriteBinaryFile(filename, file_data.data(), file_data.size()))
+  {
+    Log_ErrorPrintf("Failed to write '%s'", filename);
+    return false;
+  }
+
+  Log_InfoPrintf("Wrote %u frames (%u bytes of commands) to '%s'", header.num_frames, GetCommandDataSize(), filename);
+  return true;
+}
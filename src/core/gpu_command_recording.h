@@ -0,0 +1,56 @@
+#pragma once
+#include "gpu_types.h"
+#include "types.h"
+#include <vector>
+
+static constexpr u32 GPU_COMMAND_RECORDING_MAGIC = 0x52475344; // DSGR
+static constexpr u32 GPU_COMMAND_RECORDING_VERSION = 1;
+static constexpr u32 GPU_COMMAND_RECORDING_MAX_SIZE = 1024 * 1024 * 1024; // uncompressed
+
+#pragma pack(push, 4)
+struct GPU_COMMAND_RECORDING_HEADER
+{
+  u32 magic;
+  u32 version;
+  u32 num_frames;
+  u32 vram_width;
+  u32 vram_height;
+
+  // data is zlib-compressed: initial vram, frame end offsets, command stream
+  u32 data_compressed_size;
+  u32 data_uncompressed_size;
+};
+#pragma pack(pop)
+
+/// Captured backend command stream, along with the VRAM contents at the start of the capture.
+class GPUCommandRecording
+{
+public:
+  GPUCommandRecording();
+  ~GPUCommandRecording();
+
+  ALWAYS_INLINE const u16* GetInitialVRAM() const { return m_initial_vram.data(); }
+  ALWAYS_INLINE u32 GetFrameCount() const { return static_cast<u32>(m_frame_end_offsets.size()); }
+  ALWAYS_INLINE u32 GetCommandDataSize() const { return static_cast<u32>(m_command_data.size()); }
+
+  /// Returns the range of command data which was pushed during the specified frame.
+  const u8* GetFrameCommandsStart(u32 frame) const;
+  const u8* GetFrameCommandsEnd(u32 frame) const;
+
+  /// Clears any previous recording and captures the initial VRAM contents.
+  void Begin(const u16* vram);
+
+  /// Appends a command to the current frame. Sync and wraparound commands are not recorded.
+  void AppendCommand(const GPUBackendCommand* cmd);
+
+  /// Closes off the current frame.
+  void EndFrame();
+
+  bool LoadFromFile(const char* filename);
+  bool SaveToFile(const char* filename) const;
+
+private:
+  std::vector<u16> m_initial_vram;
+  std::vector<u32> m_frame_end_offsets;
+  std::vector<u8> m_command_data;
+};
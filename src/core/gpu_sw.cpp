@@ -50,6 +50,8 @@ bool GPU_SW::Initialize(HostDisplay* host_display)
   if (!GPU::Initialize(host_display) || !m_backend.Initialize())
     return false;
 
+  UpdateDisplayTextureBuffer();
+
   static constexpr auto formats_for_16bit = make_array(HostDisplayPixelFormat::RGB565, HostDisplayPixelFormat::RGBA5551,
                                                        HostDisplayPixelFormat::RGBA8, HostDisplayPixelFormat::BGRA8);
   static constexpr auto formats_for_24bit =
@@ -86,6 +88,19 @@ void GPU_SW::UpdateSettings()
 {
   GPU::UpdateSettings();
   m_backend.UpdateSettings();
+  UpdateDisplayTextureBuffer();
+}
+
+void GPU_SW::UpdateDisplayTextureBuffer()
+{
+  // Interlaced frames are woven into this buffer, so it has to cover the whole (upscaled) VRAM.
+  const u32 scale = m_backend.GetResolutionScale();
+  const size_t size = VRAM_WIDTH * VRAM_HEIGHT * sizeof(u32) * scale * scale;
+  if (m_display_texture_buffer.size() != size)
+  {
+    m_display_texture_buffer.clear();
+    m_display_texture_buffer.resize(size);
+  }
 }
 
 template<HostDisplayPixelFormat out_format, typename out_type>
@@ -233,6 +248,12 @@ ALWAYS_INLINE void CopyOutRow16<HostDisplayPixelFormat::BGRA8, u32>(const u16* s
 template<HostDisplayPixelFormat display_format>
 void GPU_SW::CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved)
 {
+  if (m_backend.GetResolutionShift() > 0)
+  {
+    CopyOut15BitUpscaled<display_format>(src_x, src_y, width, height, field, interlaced, interleaved);
+    return;
+  }
+
   u8* dst_ptr;
   u32 dst_stride;
 
@@ -301,6 +322,76 @@ void GPU_SW::CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field
   }
 }
 
+template<HostDisplayPixelFormat display_format>
+void GPU_SW::CopyOut15BitUpscaled(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced,
+                                  bool interleaved)
+{
+  using OutputPixelType = std::conditional_t<
+    display_format == HostDisplayPixelFormat::RGBA8 || display_format == HostDisplayPixelFormat::BGRA8, u32, u16>;
+
+  const u32 shift = m_backend.GetResolutionShift();
+  const u32 scale = m_backend.GetResolutionScale();
+  const u16* vram_ptr = m_backend.GetRenderVRAM();
+  const u32 vram_width = VRAM_WIDTH << shift;
+  const u32 output_width = width << shift;
+  const u32 output_height = height << shift;
+
+  u8* dst_ptr;
+  u32 dst_stride;
+  if (!interlaced)
+  {
+    if (!m_host_display->BeginSetDisplayPixels(display_format, output_width, output_height,
+                                               reinterpret_cast<void**>(&dst_ptr), &dst_stride))
+    {
+      return;
+    }
+  }
+  else
+  {
+    dst_stride = vram_width * sizeof(OutputPixelType);
+    dst_ptr = m_display_texture_buffer.data() + (field != 0 ? (dst_stride << shift) : 0);
+  }
+
+  // Rows are handled in native lines, each of which is scale lines in the output, so fields weave the same way.
+  const u8 interlaced_shift = BoolToUInt8(interlaced);
+  const u8 interleaved_shift = BoolToUInt8(interleaved);
+  const u32 rows = height >> interlaced_shift;
+  const u32 scaled_src_x = src_x << shift;
+  for (u32 row = 0; row < rows; row++)
+  {
+    const u32 native_src_y = (src_y + (row << interleaved_shift)) % VRAM_HEIGHT;
+    for (u32 line = 0; line < scale; line++)
+    {
+      const u16* src_row_ptr = &vram_ptr[((native_src_y << shift) + line) * vram_width];
+      OutputPixelType* dst_row_ptr = reinterpret_cast<OutputPixelType*>(
+        dst_ptr + ((((row << interlaced_shift) << shift) + line) * dst_stride));
+
+      if ((scaled_src_x + output_width) <= vram_width)
+      {
+        CopyOutRow16<display_format>(src_row_ptr + scaled_src_x, dst_row_ptr, output_width);
+      }
+      else
+      {
+        for (u32 col = 0; col < output_width; col++)
+        {
+          dst_row_ptr[col] =
+            VRAM16ToOutput<display_format, OutputPixelType>(src_row_ptr[(scaled_src_x + col) % vram_width]);
+        }
+      }
+    }
+  }
+
+  if (!interlaced)
+  {
+    m_host_display->EndSetDisplayPixels();
+  }
+  else
+  {
+    m_host_display->SetDisplayPixels(display_format, output_width, output_height, m_display_texture_buffer.data(),
+                                     dst_stride);
+  }
+}
+
 void GPU_SW::CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
                           bool interlaced, bool interleaved)
 {
@@ -462,6 +553,9 @@ void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 heigh
 void GPU_SW::CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width,
                           u32 height, u32 field, bool interlaced, bool interleaved)
 {
+  // 24-bit output isn't drawn to by the GPU in practice, so it's displayed at native resolution.
+  m_backend.DownsampleVRAM(0, src_y, VRAM_WIDTH, height);
+
   switch (display_format)
   {
     case HostDisplayPixelFormat::RGBA5551:
@@ -487,6 +581,19 @@ void GPU_SW::ClearDisplay()
   std::memset(m_display_texture_buffer.data(), 0, m_display_texture_buffer.size());
 }
 
+void GPU_SW::FrameDone()
+{
+  m_backend.EndRecordingFrame();
+}
+
+bool GPU_SW::StartRecordingCommands(const char* filename, u32 num_frames)
+{
+  // recordings always start from native resolution vram
+  m_backend.Sync();
+  m_backend.DownsampleVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+  return m_backend.StartRecording(filename, num_frames);
+}
+
 void GPU_SW::UpdateDisplay()
 {
   // fill display texture
@@ -833,7 +940,8 @@ void GPU_SW::DispatchRenderCommand()
 
 void GPU_SW::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
 {
-  m_backend.Sync();
+  m_backend.SyncRegion(x, y, width, height);
+  m_backend.DownsampleVRAM(x, y, width, height);
 }
 
 void GPU_SW::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
@@ -1,5 +1,4 @@
 #pragma once
-#include "common/heap_array.h"
 #include "gpu.h"
 #include "gpu_sw_backend.h"
 #include "host_display.h"
@@ -21,6 +20,8 @@ public:
   void Reset() override;
   void UpdateSettings() override;
 
+  bool StartRecordingCommands(const char* filename, u32 num_frames) override;
+
 protected:
   void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
   void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
@@ -32,6 +33,9 @@ protected:
   void CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
                     bool interlaced, bool interleaved);
 
+  template<HostDisplayPixelFormat display_format>
+  void CopyOut15BitUpscaled(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved);
+
   template<HostDisplayPixelFormat display_format>
   void CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
                     bool interleaved);
@@ -40,13 +44,16 @@ protected:
 
   void ClearDisplay() override;
   void UpdateDisplay() override;
+  void FrameDone() override;
 
   void DispatchRenderCommand() override;
 
   void FillBackendCommandParameters(GPUBackendCommand* cmd);
   void FillDrawCommand(GPUBackendDrawCommand* cmd, GPURenderCommand rc);
 
-  HeapArray<u8, VRAM_WIDTH * VRAM_HEIGHT * sizeof(u32)> m_display_texture_buffer;
+  void UpdateDisplayTextureBuffer();
+
+  std::vector<u8> m_display_texture_buffer;
   HostDisplayPixelFormat m_16bit_display_format = HostDisplayPixelFormat::RGB565;
   HostDisplayPixelFormat m_24bit_display_format = HostDisplayPixelFormat::RGBA8;
 
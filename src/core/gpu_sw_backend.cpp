@@ -1,23 +1,61 @@
 #include "gpu_sw_backend.h"
 #include "common/assert.h"
+#include "common/cpu_detect.h"
 #include "common/log.h"
 #include "gpu_sw_backend.h"
 #include "host_display.h"
+#include "settings.h"
 #include "system.h"
 #include <algorithm>
+#include <cstring>
 Log_SetChannel(GPU_SW_Backend);
 
+#if defined(CPU_X64)
+#include <emmintrin.h>
+#define VECTOR_SPANS 1
+#elif defined(CPU_AARCH64)
+#ifdef _MSC_VER
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#define VECTOR_SPANS 1
+#endif
+
 GPU_SW_Backend::GPU_SW_Backend() : GPUBackend()
 {
   m_vram.fill(0);
   m_vram_ptr = m_vram.data();
+  m_render_vram = m_vram.data();
+  m_batch_write_ranges.fill(TileColumnRange{VRAM_WIDTH, 0});
+  m_batch_read_ranges.fill(TileColumnRange{VRAM_WIDTH, 0});
 }
 
-GPU_SW_Backend::~GPU_SW_Backend() = default;
+GPU_SW_Backend::~GPU_SW_Backend()
+{
+  StopWorkerThreads();
+}
 
 bool GPU_SW_Backend::Initialize()
 {
-  return GPUBackend::Initialize();
+  if (!GPUBackend::Initialize())
+    return false;
+
+  UpdateResolutionScale();
+  StartWorkerThreads(g_settings.gpu_sw_worker_threads);
+  return true;
+}
+
+void GPU_SW_Backend::UpdateSettings()
+{
+  GPUBackend::UpdateSettings();
+  UpdateResolutionScale();
+
+  if (m_worker_threads.size() != std::min(g_settings.gpu_sw_worker_threads, MAX_WORKER_THREADS))
+  {
+    StopWorkerThreads();
+    StartWorkerThreads(g_settings.gpu_sw_worker_threads);
+  }
 }
 
 void GPU_SW_Backend::Reset()
@@ -25,9 +63,145 @@ void GPU_SW_Backend::Reset()
   GPUBackend::Reset();
 
   m_vram.fill(0);
+  std::fill(m_upscaled_vram.begin(), m_upscaled_vram.end(), u16(0));
+}
+
+void GPU_SW_Backend::Shutdown()
+{
+  GPUBackend::Shutdown();
+  StopWorkerThreads();
+}
+
+void GPU_SW_Backend::UpdateResolutionScale()
+{
+  const u32 requested_scale = std::max(g_settings.gpu_resolution_scale, 1u);
+  u32 shift = 0;
+  while ((2u << shift) <= std::min(requested_scale, MAX_RESOLUTION_SCALE))
+    shift++;
+
+  if (shift == m_resolution_shift)
+    return;
+
+  if ((1u << shift) != requested_scale)
+  {
+    Log_WarningPrintf("Resolution scale %ux is not supported by the software renderer, using %ux.", requested_scale,
+                      1u << shift);
+  }
+
+  // Carry the current contents over to the new resolution.
+  DownsampleVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+  m_resolution_shift = shift;
+
+  if (shift == 0)
+  {
+    std::vector<u16>().swap(m_upscaled_vram);
+    m_render_vram = m_vram.data();
+    m_render_stride = VRAM_WIDTH;
+  }
+  else
+  {
+    m_upscaled_vram.resize((VRAM_WIDTH * VRAM_HEIGHT) << (shift * 2));
+    m_render_vram = m_upscaled_vram.data();
+    m_render_stride = VRAM_WIDTH << shift;
+
+    for (u32 y = 0; y < (VRAM_HEIGHT << shift); y++)
+    {
+      const u16* src_row_ptr = &m_vram[(y >> shift) * VRAM_WIDTH];
+      u16* dst_row_ptr = &m_render_vram[y * m_render_stride];
+      for (u32 x = 0; x < m_render_stride; x++)
+        dst_row_ptr[x] = src_row_ptr[x >> shift];
+    }
+  }
+
+  Log_InfoPrintf("Software renderer resolution scale set to %ux (VRAM %ux%u).", 1u << shift, VRAM_WIDTH << shift,
+                 VRAM_HEIGHT << shift);
+}
+
+void GPU_SW_Backend::DownsampleVRAM(u32 x, u32 y, u32 width, u32 height)
+{
+  if (m_resolution_shift == 0)
+    return;
+
+  // Take the top-left sample of each block, so data written by the CPU reads back unchanged.
+  for (u32 row = 0; row < height; row++)
+  {
+    const u32 native_y = (y + row) % VRAM_HEIGHT;
+    const u16* src_row_ptr = &m_render_vram[(native_y << m_resolution_shift) * m_render_stride];
+    u16* dst_row_ptr = &m_vram[native_y * VRAM_WIDTH];
+    for (u32 col = 0; col < width; col++)
+    {
+      const u32 native_x = (x + col) % VRAM_WIDTH;
+      dst_row_ptr[native_x] = src_row_ptr[native_x << m_resolution_shift];
+    }
+  }
+}
+
+Common::Rectangle<u32> GPU_SW_Backend::ScaleClipRectangle(const Common::Rectangle<u32>& clip) const
+{
+  return Common::Rectangle<u32>(clip.left << m_resolution_shift, clip.top << m_resolution_shift,
+                                ((clip.right + 1) << m_resolution_shift) - 1,
+                                ((clip.bottom + 1) << m_resolution_shift) - 1);
 }
 
 void GPU_SW_Backend::DrawPolygon(const GPUBackendDrawPolygonCommand* cmd)
+{
+  if (IsUsingWorkerThreads())
+  {
+    s32 min_x = cmd->vertices[0].x;
+    s32 max_x = cmd->vertices[0].x;
+    s32 min_y = cmd->vertices[0].y;
+    s32 max_y = cmd->vertices[0].y;
+    for (u32 i = 1; i < cmd->num_vertices; i++)
+    {
+      min_x = std::min(min_x, cmd->vertices[i].x);
+      max_x = std::max(max_x, cmd->vertices[i].x);
+      min_y = std::min(min_y, cmd->vertices[i].y);
+      max_y = std::max(max_y, cmd->vertices[i].y);
+    }
+
+    // edge stepping can round out by a pixel
+    if (QueueDraw(cmd, min_x - 1, min_y - 1, max_x + 1, max_y + 1))
+      return;
+  }
+
+  RasterizePolygon(cmd, m_drawing_area);
+}
+
+void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+{
+  if (IsUsingWorkerThreads() && QueueDraw(cmd, cmd->x, cmd->y, cmd->x + static_cast<s32>(cmd->width) - 1,
+                                          cmd->y + static_cast<s32>(cmd->height) - 1))
+  {
+    return;
+  }
+
+  RasterizeRectangle(cmd, m_drawing_area);
+}
+
+void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd)
+{
+  if (IsUsingWorkerThreads())
+  {
+    s32 min_x = cmd->vertices[0].x;
+    s32 max_x = cmd->vertices[0].x;
+    s32 min_y = cmd->vertices[0].y;
+    s32 max_y = cmd->vertices[0].y;
+    for (u32 i = 1; i < cmd->num_vertices; i++)
+    {
+      min_x = std::min(min_x, cmd->vertices[i].x);
+      max_x = std::max(max_x, cmd->vertices[i].x);
+      min_y = std::min(min_y, cmd->vertices[i].y);
+      max_y = std::max(max_y, cmd->vertices[i].y);
+    }
+
+    if (QueueDraw(cmd, min_x - 1, min_y - 1, max_x + 1, max_y + 1))
+      return;
+  }
+
+  RasterizeLine(cmd, m_drawing_area);
+}
+
+void GPU_SW_Backend::RasterizePolygon(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& clip)
 {
   const GPURenderCommand rc{cmd->rc.bits};
   const bool dithering_enable = rc.IsDitheringEnabled() && cmd->draw_mode.dither_enable;
@@ -35,29 +209,43 @@ void GPU_SW_Backend::DrawPolygon(const GPUBackendDrawPolygonCommand* cmd)
   const DrawTriangleFunction DrawFunction = GetDrawTriangleFunction(
     rc.shading_enable, rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable, dithering_enable);
 
-  (this->*DrawFunction)(cmd, &cmd->vertices[0], &cmd->vertices[1], &cmd->vertices[2]);
+  const GPUBackendDrawPolygonCommand::Vertex* vertices = cmd->vertices;
+  std::array<GPUBackendDrawPolygonCommand::Vertex, 4> scaled_vertices;
+  if (m_resolution_shift > 0)
+  {
+    const s32 scale = static_cast<s32>(GetResolutionScale());
+    for (u32 i = 0; i < cmd->num_vertices; i++)
+    {
+      scaled_vertices[i] = cmd->vertices[i];
+      scaled_vertices[i].x *= scale;
+      scaled_vertices[i].y *= scale;
+    }
+    vertices = scaled_vertices.data();
+  }
+
+  const Common::Rectangle<u32> scaled_clip = ScaleClipRectangle(clip);
+  (this->*DrawFunction)(cmd, scaled_clip, &vertices[0], &vertices[1], &vertices[2]);
   if (rc.quad_polygon)
-    (this->*DrawFunction)(cmd, &cmd->vertices[2], &cmd->vertices[1], &cmd->vertices[3]);
+    (this->*DrawFunction)(cmd, scaled_clip, &vertices[2], &vertices[1], &vertices[3]);
 }
 
-void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+void GPU_SW_Backend::RasterizeRectangle(const GPUBackendDrawRectangleCommand* cmd, const Common::Rectangle<u32>& clip)
 {
   const GPURenderCommand rc{cmd->rc.bits};
-  const bool dithering_enable = rc.IsDitheringEnabled() && cmd->draw_mode.dither_enable;
 
   const DrawRectangleFunction DrawFunction =
     GetDrawRectangleFunction(rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable);
 
-  (this->*DrawFunction)(cmd);
+  (this->*DrawFunction)(cmd, ScaleClipRectangle(clip));
 }
 
-void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd)
+void GPU_SW_Backend::RasterizeLine(const GPUBackendDrawLineCommand* cmd, const Common::Rectangle<u32>& clip)
 {
   const DrawLineFunction DrawFunction =
     GetDrawLineFunction(cmd->rc.shading_enable, cmd->rc.transparency_enable, cmd->IsDitheringEnabled());
 
   for (u16 i = 1; i < cmd->num_vertices; i++)
-    (this->*DrawFunction)(cmd, &cmd->vertices[i - 1], &cmd->vertices[i]);
+    (this->*DrawFunction)(cmd, clip, &cmd->vertices[i - 1], &cmd->vertices[i]);
 }
 
 constexpr GPU_SW_Backend::DitherLUT GPU_SW_Backend::ComputeDitherLUT()
@@ -79,6 +267,45 @@ constexpr GPU_SW_Backend::DitherLUT GPU_SW_Backend::ComputeDitherLUT()
 
 static constexpr GPU_SW_Backend::DitherLUT s_dither_lut = GPU_SW_Backend::ComputeDitherLUT();
 
+u16 ALWAYS_INLINE_RELEASE GPU_SW_Backend::GetTexel(const GPUBackendDrawCommand* cmd, u8 texcoord_x,
+                                                   u8 texcoord_y) const
+{
+  // Apply texture window
+  // TODO: Precompute the second half
+  texcoord_x = (texcoord_x & cmd->window.and_x) | cmd->window.or_x;
+  texcoord_y = (texcoord_y & cmd->window.and_y) | cmd->window.or_y;
+
+  switch (cmd->draw_mode.texture_mode)
+  {
+    case GPUTextureMode::Palette4Bit:
+    {
+      const u16 palette_value =
+        GetNativePixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 4)) % VRAM_WIDTH,
+                 (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
+      const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
+
+      return GetNativePixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH,
+                            cmd->palette.GetYBase());
+    }
+
+    case GPUTextureMode::Palette8Bit:
+    {
+      const u16 palette_value =
+        GetNativePixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 2)) % VRAM_WIDTH,
+                 (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
+      const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
+      return GetNativePixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH,
+                            cmd->palette.GetYBase());
+    }
+
+    default:
+    {
+      return GetNativePixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x)) % VRAM_WIDTH,
+                      (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
+    }
+  }
+}
+
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
 void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawCommand* cmd, u32 x, u32 y, u8 color_r,
                                                       u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y)
@@ -87,45 +314,8 @@ void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawComman
   bool transparent;
   if constexpr (texture_enable)
   {
-    // Apply texture window
-    // TODO: Precompute the second half
-    texcoord_x = (texcoord_x & cmd->window.and_x) | cmd->window.or_x;
-    texcoord_y = (texcoord_y & cmd->window.and_y) | cmd->window.or_y;
-
     VRAMPixel texture_color;
-    switch (cmd->draw_mode.texture_mode)
-    {
-      case GPUTextureMode::Palette4Bit:
-      {
-        const u16 palette_value =
-          GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 4)) % VRAM_WIDTH,
-                   (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-        const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
-
-        texture_color.bits =
-          GetPixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH, cmd->palette.GetYBase());
-      }
-      break;
-
-      case GPUTextureMode::Palette8Bit:
-      {
-        const u16 palette_value =
-          GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 2)) % VRAM_WIDTH,
-                   (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-        const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
-        texture_color.bits =
-          GetPixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH, cmd->palette.GetYBase());
-      }
-      break;
-
-      default:
-      {
-        texture_color.bits = GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x)) % VRAM_WIDTH,
-                                      (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-      }
-      break;
-    }
-
+    texture_color.bits = GetTexel(cmd, texcoord_x, texcoord_y);
     if (texture_color.bits == 0)
       return;
 
@@ -210,32 +400,366 @@ void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawComman
   SetPixel(static_cast<u32>(x), static_cast<u32>(y), color.bits | cmd->params.GetMaskOR());
 }
 
+#ifdef VECTOR_SPANS
+
+// Thin wrappers over the 8x16-bit vector operations needed to shade a span, so the shading itself is only written once.
+#if defined(CPU_X64)
+using SpanVector = __m128i;
+static ALWAYS_INLINE SpanVector SpanLoad(const u16* ptr)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+static ALWAYS_INLINE SpanVector SpanLoad(const s16* ptr)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+static ALWAYS_INLINE void SpanStore(u16* ptr, SpanVector v)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), v);
+}
+static ALWAYS_INLINE SpanVector SpanSet(s16 v)
+{
+  return _mm_set1_epi16(v);
+}
+static ALWAYS_INLINE SpanVector SpanAnd(SpanVector a, SpanVector b)
+{
+  return _mm_and_si128(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanOr(SpanVector a, SpanVector b)
+{
+  return _mm_or_si128(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanAndNot(SpanVector a, SpanVector b)
+{
+  return _mm_andnot_si128(b, a);
+}
+static ALWAYS_INLINE SpanVector SpanAdd(SpanVector a, SpanVector b)
+{
+  return _mm_add_epi16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanSubSaturate(SpanVector a, SpanVector b)
+{
+  return _mm_subs_epu16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanMul(SpanVector a, SpanVector b)
+{
+  return _mm_mullo_epi16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanMin(SpanVector a, SpanVector b)
+{
+  return _mm_min_epi16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanMax(SpanVector a, SpanVector b)
+{
+  return _mm_max_epi16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanCompareEqual(SpanVector a, SpanVector b)
+{
+  return _mm_cmpeq_epi16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanSelect(SpanVector mask, SpanVector a, SpanVector b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+template<int n>
+static ALWAYS_INLINE SpanVector SpanShiftLeft(SpanVector v)
+{
+  return _mm_slli_epi16(v, n);
+}
+template<int n>
+static ALWAYS_INLINE SpanVector SpanShiftRightLogical(SpanVector v)
+{
+  return _mm_srli_epi16(v, n);
+}
+template<int n>
+static ALWAYS_INLINE SpanVector SpanShiftRightArithmetic(SpanVector v)
+{
+  return _mm_srai_epi16(v, n);
+}
+#elif defined(CPU_AARCH64)
+using SpanVector = int16x8_t;
+static ALWAYS_INLINE SpanVector SpanLoad(const u16* ptr)
+{
+  return vreinterpretq_s16_u16(vld1q_u16(ptr));
+}
+static ALWAYS_INLINE SpanVector SpanLoad(const s16* ptr)
+{
+  return vld1q_s16(ptr);
+}
+static ALWAYS_INLINE void SpanStore(u16* ptr, SpanVector v)
+{
+  vst1q_u16(ptr, vreinterpretq_u16_s16(v));
+}
+static ALWAYS_INLINE SpanVector SpanSet(s16 v)
+{
+  return vdupq_n_s16(v);
+}
+static ALWAYS_INLINE SpanVector SpanAnd(SpanVector a, SpanVector b)
+{
+  return vandq_s16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanOr(SpanVector a, SpanVector b)
+{
+  return vorrq_s16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanAndNot(SpanVector a, SpanVector b)
+{
+  return vbicq_s16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanAdd(SpanVector a, SpanVector b)
+{
+  return vaddq_s16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanSubSaturate(SpanVector a, SpanVector b)
+{
+  return vreinterpretq_s16_u16(vqsubq_u16(vreinterpretq_u16_s16(a), vreinterpretq_u16_s16(b)));
+}
+static ALWAYS_INLINE SpanVector SpanMul(SpanVector a, SpanVector b)
+{
+  return vmulq_s16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanMin(SpanVector a, SpanVector b)
+{
+  return vminq_s16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanMax(SpanVector a, SpanVector b)
+{
+  return vmaxq_s16(a, b);
+}
+static ALWAYS_INLINE SpanVector SpanCompareEqual(SpanVector a, SpanVector b)
+{
+  return vreinterpretq_s16_u16(vceqq_s16(a, b));
+}
+static ALWAYS_INLINE SpanVector SpanSelect(SpanVector mask, SpanVector a, SpanVector b)
+{
+  return vbslq_s16(vreinterpretq_u16_s16(mask), a, b);
+}
+template<int n>
+static ALWAYS_INLINE SpanVector SpanShiftLeft(SpanVector v)
+{
+  return vshlq_n_s16(v, n);
+}
+template<int n>
+static ALWAYS_INLINE SpanVector SpanShiftRightLogical(SpanVector v)
+{
+  return vreinterpretq_s16_u16(vshrq_n_u16(vreinterpretq_u16_s16(v), n));
+}
+template<int n>
+static ALWAYS_INLINE SpanVector SpanShiftRightArithmetic(SpanVector v)
+{
+  return vshrq_n_s16(v, n);
+}
+#endif
+
+using SpanDitherLUT = std::array<std::array<std::array<s16, GPU_SW_Backend::SPAN_VECTOR_WIDTH>, DITHER_MATRIX_SIZE>,
+                                 DITHER_MATRIX_SIZE>;
+
+static constexpr SpanDitherLUT ComputeSpanDitherLUT()
+{
+  // Dither offsets for each lane of a span, indexed by the row and the column of the first pixel.
+  SpanDitherLUT lut = {};
+  for (u32 i = 0; i < DITHER_MATRIX_SIZE; i++)
+  {
+    for (u32 j = 0; j < DITHER_MATRIX_SIZE; j++)
+    {
+      for (u32 lane = 0; lane < GPU_SW_Backend::SPAN_VECTOR_WIDTH; lane++)
+        lut[i][j][lane] = static_cast<s16>(DITHER_MATRIX[i][(j + lane) % DITHER_MATRIX_SIZE]);
+    }
+  }
+  return lut;
+}
+
+static constexpr SpanDitherLUT s_span_dither_lut = ComputeSpanDitherLUT();
+
+/// Vector equivalent of s_dither_lut: adds the dither offset, drops to 5 bits and clamps.
+static ALWAYS_INLINE SpanVector SpanDither(SpanVector value, SpanVector dither)
+{
+  return SpanMin(SpanMax(SpanShiftRightArithmetic<3>(SpanAdd(value, dither)), SpanSet(0)), SpanSet(0x1F));
+}
+
+template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
+void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixels(const GPUBackendDrawCommand* cmd, u32 x, u32 y,
+                                                       const u16* color_r, const u16* color_g, const u16* color_b,
+                                                       const u16* texels)
+{
+  const SpanVector channel_mask = SpanSet(0x1F);
+  const SpanVector zero = SpanSet(0);
+  const SpanVector dither = dithering_enable ? SpanLoad(s_span_dither_lut[y & 3u][x & 3u].data()) :
+                                               SpanSet(static_cast<s16>(DITHER_MATRIX[2][3]));
+
+  SpanVector color, r, g, b;
+  SpanVector transparent;
+  SpanVector draw;
+  if constexpr (texture_enable)
+  {
+    const SpanVector texture_color = SpanLoad(texels);
+    draw = SpanAndNot(SpanSet(-1), SpanCompareEqual(texture_color, zero));
+    transparent = SpanShiftRightArithmetic<15>(texture_color);
+
+    if constexpr (raw_texture_enable)
+    {
+      color = texture_color;
+      r = SpanAnd(texture_color, channel_mask);
+      g = SpanAnd(SpanShiftRightLogical<5>(texture_color), channel_mask);
+      b = SpanAnd(SpanShiftRightLogical<10>(texture_color), channel_mask);
+    }
+    else
+    {
+      r = SpanAnd(texture_color, channel_mask);
+      g = SpanAnd(SpanShiftRightLogical<5>(texture_color), channel_mask);
+      b = SpanAnd(SpanShiftRightLogical<10>(texture_color), channel_mask);
+      r = SpanDither(SpanShiftRightLogical<4>(SpanMul(r, SpanLoad(color_r))), dither);
+      g = SpanDither(SpanShiftRightLogical<4>(SpanMul(g, SpanLoad(color_g))), dither);
+      b = SpanDither(SpanShiftRightLogical<4>(SpanMul(b, SpanLoad(color_b))), dither);
+      color = SpanOr(SpanOr(r, SpanShiftLeft<5>(g)),
+                     SpanOr(SpanShiftLeft<10>(b), SpanAnd(texture_color, SpanSet(-32768))));
+    }
+  }
+  else
+  {
+    draw = SpanSet(-1);
+    transparent = SpanSet(-1);
+
+    r = SpanDither(SpanLoad(color_r), dither);
+    g = SpanDither(SpanLoad(color_g), dither);
+    b = SpanDither(SpanLoad(color_b), dither);
+    color = SpanOr(r, SpanOr(SpanShiftLeft<5>(g), SpanShiftLeft<10>(b)));
+  }
+
+  u16* const dst = GetPixelPtr(x, y);
+  const SpanVector bg_color = SpanLoad(dst);
+  if constexpr (transparency_enable)
+  {
+    const SpanVector bg_r = SpanAnd(bg_color, channel_mask);
+    const SpanVector bg_g = SpanAnd(SpanShiftRightLogical<5>(bg_color), channel_mask);
+    const SpanVector bg_b = SpanAnd(SpanShiftRightLogical<10>(bg_color), channel_mask);
+
+    SpanVector blend_r, blend_g, blend_b;
+    switch (cmd->draw_mode.transparency_mode)
+    {
+      case GPUTransparencyMode::HalfBackgroundPlusHalfForeground:
+        blend_r = SpanMin(SpanAdd(SpanShiftRightLogical<1>(bg_r), SpanShiftRightLogical<1>(r)), channel_mask);
+        blend_g = SpanMin(SpanAdd(SpanShiftRightLogical<1>(bg_g), SpanShiftRightLogical<1>(g)), channel_mask);
+        blend_b = SpanMin(SpanAdd(SpanShiftRightLogical<1>(bg_b), SpanShiftRightLogical<1>(b)), channel_mask);
+        break;
+      case GPUTransparencyMode::BackgroundPlusForeground:
+        blend_r = SpanMin(SpanAdd(bg_r, r), channel_mask);
+        blend_g = SpanMin(SpanAdd(bg_g, g), channel_mask);
+        blend_b = SpanMin(SpanAdd(bg_b, b), channel_mask);
+        break;
+      case GPUTransparencyMode::BackgroundMinusForeground:
+        blend_r = SpanSubSaturate(bg_r, r);
+        blend_g = SpanSubSaturate(bg_g, g);
+        blend_b = SpanSubSaturate(bg_b, b);
+        break;
+      case GPUTransparencyMode::BackgroundPlusQuarterForeground:
+      default:
+        blend_r = SpanMin(SpanAdd(bg_r, SpanShiftRightLogical<2>(r)), channel_mask);
+        blend_g = SpanMin(SpanAdd(bg_g, SpanShiftRightLogical<2>(g)), channel_mask);
+        blend_b = SpanMin(SpanAdd(bg_b, SpanShiftRightLogical<2>(b)), channel_mask);
+        break;
+    }
+
+    const SpanVector blended = SpanOr(SpanOr(blend_r, SpanShiftLeft<5>(blend_g)),
+                                      SpanOr(SpanShiftLeft<10>(blend_b), SpanAnd(color, SpanSet(-32768))));
+    color = SpanSelect(transparent, blended, color);
+  }
+
+  const SpanVector mask_and = SpanSet(static_cast<s16>(cmd->params.GetMaskAND()));
+  draw = SpanAnd(draw, SpanCompareEqual(SpanAnd(bg_color, mask_and), zero));
+  color = SpanOr(color, SpanSet(static_cast<s16>(cmd->params.GetMaskOR())));
+  SpanStore(dst, SpanSelect(draw, color, bg_color));
+}
+
+#endif // VECTOR_SPANS
+
+static bool ColumnsOverlap(u32 start, u32 width, u32 x_start, u32 x_end)
+{
+  // The texture page or palette can wrap around the right edge of VRAM.
+  const u32 end = start + width - 1;
+  if (end >= VRAM_WIDTH)
+    return (x_end >= start || x_start <= (end - VRAM_WIDTH));
+  else
+    return (x_start <= end && x_end >= start);
+}
+
+/// Returns true if drawing row y from x_start to x_end (inclusive) could overwrite texels the same row samples later.
+/// The vector path fetches a whole group of texels before writing any pixels, so these rows are shaded per-pixel.
+static bool RowMaySampleItself(const GPUBackendDrawCommand* cmd, u32 y, u32 x_start, u32 x_end)
+{
+  const Common::Rectangle<u32> page = cmd->draw_mode.GetTexturePageRectangle();
+  if (y >= page.top && y < page.bottom && ColumnsOverlap(page.left, page.GetWidth(), x_start, x_end))
+    return true;
+
+  if (!cmd->draw_mode.IsUsingPalette() || y != cmd->palette.GetYBase())
+    return false;
+
+  const u32 palette_width = (cmd->draw_mode.texture_mode == GPUTextureMode::Palette4Bit) ? 16u : 256u;
+  return ColumnsOverlap(cmd->palette.GetXBase(), palette_width, x_start, x_end);
+}
+
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd, const Common::Rectangle<u32>& clip)
 {
-  const s32 origin_x = cmd->x;
-  const s32 origin_y = cmd->y;
+  const u32 shift = m_resolution_shift;
+  const s32 origin_x = cmd->x * static_cast<s32>(GetResolutionScale());
+  const s32 origin_y = cmd->y * static_cast<s32>(GetResolutionScale());
+  const u32 width = ZeroExtend32(cmd->width) << shift;
+  const u32 height = ZeroExtend32(cmd->height) << shift;
   const auto [r, g, b] = UnpackColorRGB24(cmd->color);
   const auto [origin_texcoord_x, origin_texcoord_y] = UnpackTexcoord(cmd->texcoord);
 
-  for (u32 offset_y = 0; offset_y < cmd->height; offset_y++)
+#ifdef VECTOR_SPANS
+  std::array<u16, SPAN_VECTOR_WIDTH> span_r, span_g, span_b, texels;
+  span_r.fill(r);
+  span_g.fill(g);
+  span_b.fill(b);
+#endif
+
+  for (u32 offset_y = 0; offset_y < height; offset_y++)
   {
     const s32 y = origin_y + static_cast<s32>(offset_y);
-    if (y < static_cast<s32>(m_drawing_area.top) || y > static_cast<s32>(m_drawing_area.bottom) ||
-        (cmd->params.interlaced_rendering && cmd->params.active_line_lsb == (Truncate8(static_cast<u32>(y)) & 1u)))
+    if (y < static_cast<s32>(clip.top) || y > static_cast<s32>(clip.bottom) ||
+        (cmd->params.interlaced_rendering &&
+         cmd->params.active_line_lsb == (Truncate8(static_cast<u32>(y) >> shift) & 1u)))
     {
       continue;
     }
 
-    const u8 texcoord_y = Truncate8(ZeroExtend32(origin_texcoord_y) + offset_y);
+    const u8 texcoord_y = Truncate8(ZeroExtend32(origin_texcoord_y) + (offset_y >> shift));
+    const s32 start_offset_x = std::max<s32>(static_cast<s32>(clip.left) - origin_x, 0);
+    const s32 end_offset_x = std::min<s32>(static_cast<s32>(clip.right) + 1 - origin_x, static_cast<s32>(width));
+    s32 offset_x = start_offset_x;
 
-    for (u32 offset_x = 0; offset_x < cmd->width; offset_x++)
+#ifdef VECTOR_SPANS
+    if (end_offset_x > start_offset_x &&
+        (!texture_enable ||
+         !RowMaySampleItself(cmd, static_cast<u32>(y) >> shift, static_cast<u32>(origin_x + start_offset_x) >> shift,
+                             static_cast<u32>(origin_x + end_offset_x - 1) >> shift)))
     {
-      const s32 x = origin_x + static_cast<s32>(offset_x);
-      if (x < static_cast<s32>(m_drawing_area.left) || x > static_cast<s32>(m_drawing_area.right))
-        continue;
+      for (; (end_offset_x - offset_x) >= static_cast<s32>(SPAN_VECTOR_WIDTH); offset_x += SPAN_VECTOR_WIDTH)
+      {
+        if constexpr (texture_enable)
+        {
+          for (u32 i = 0; i < SPAN_VECTOR_WIDTH; i++)
+          {
+            texels[i] = GetTexel(
+              cmd, Truncate8(ZeroExtend32(origin_texcoord_x) + ((static_cast<u32>(offset_x) + i) >> shift)),
+              texcoord_y);
+          }
+        }
+
+        ShadePixels<texture_enable, raw_texture_enable, transparency_enable, false>(
+          cmd, static_cast<u32>(origin_x + offset_x), static_cast<u32>(y), span_r.data(), span_g.data(),
+          span_b.data(), texels.data());
+      }
+    }
+#endif
 
-      const u8 texcoord_x = Truncate8(ZeroExtend32(origin_texcoord_x) + offset_x);
+    for (; offset_x < end_offset_x; offset_x++)
+    {
+      const s32 x = origin_x + offset_x;
+      const u8 texcoord_x = Truncate8(ZeroExtend32(origin_texcoord_x) + (static_cast<u32>(offset_x) >> shift));
 
       ShadePixel<texture_enable, raw_texture_enable, transparency_enable, false>(
         cmd, static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
@@ -291,23 +815,23 @@ bool ALWAYS_INLINE_RELEASE GPU_SW_Backend::CalcIDeltas(i_deltas& idl, const GPUB
 
   if constexpr (shading_enable)
   {
-    idl.dr_dx = (u32)(CALCIS(r, y) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
-    idl.dr_dy = (u32)(CALCIS(x, r) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.dr_dx = (u32)(s64(CALCIS(r, y)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.dr_dy = (u32)(s64(CALCIS(x, r)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
 
-    idl.dg_dx = (u32)(CALCIS(g, y) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
-    idl.dg_dy = (u32)(CALCIS(x, g) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.dg_dx = (u32)(s64(CALCIS(g, y)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.dg_dy = (u32)(s64(CALCIS(x, g)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
 
-    idl.db_dx = (u32)(CALCIS(b, y) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
-    idl.db_dy = (u32)(CALCIS(x, b) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.db_dx = (u32)(s64(CALCIS(b, y)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.db_dy = (u32)(s64(CALCIS(x, b)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
   }
 
   if constexpr (texture_enable)
   {
-    idl.du_dx = (u32)(CALCIS(u, y) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
-    idl.du_dy = (u32)(CALCIS(x, u) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.du_dx = (u32)(s64(CALCIS(u, y)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.du_dy = (u32)(s64(CALCIS(x, u)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
 
-    idl.dv_dx = (u32)(CALCIS(v, y) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
-    idl.dv_dy = (u32)(CALCIS(x, v) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.dv_dx = (u32)(s64(CALCIS(v, y)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
+    idl.dv_dy = (u32)(s64(CALCIS(x, v)) * (1 << COORD_FBS) / denom) << COORD_POST_PADDING;
   }
 
   return true;
@@ -351,26 +875,29 @@ void ALWAYS_INLINE_RELEASE GPU_SW_Backend::AddIDeltas_DY(i_group& ig, const i_de
 
 template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
          bool dithering_enable>
-void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s32 x_start, s32 x_bound, i_group ig,
-                              const i_deltas& idl)
+void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& clip, s32 y,
+                              s32 x_start, s32 x_bound, i_group ig, const i_deltas& idl)
 {
-  if (cmd->params.interlaced_rendering && cmd->params.active_line_lsb == (Truncate8(static_cast<u32>(y)) & 1u))
+  if (cmd->params.interlaced_rendering &&
+      cmd->params.active_line_lsb == (Truncate8(static_cast<u32>(y) >> m_resolution_shift) & 1u))
+  {
     return;
+  }
 
   s32 x_ig_adjust = x_start;
   s32 w = x_bound - x_start;
-  s32 x = TruncateGPUVertexPosition(x_start);
+  s32 x = TruncateScaledPosition(x_start);
 
-  if (x < static_cast<s32>(m_drawing_area.left))
+  if (x < static_cast<s32>(clip.left))
   {
-    s32 delta = static_cast<s32>(m_drawing_area.left) - x;
+    s32 delta = static_cast<s32>(clip.left) - x;
     x_ig_adjust += delta;
     x += delta;
     w -= delta;
   }
 
-  if ((x + w) > (static_cast<s32>(m_drawing_area.right) + 1))
-    w = static_cast<s32>(m_drawing_area.right) + 1 - x;
+  if ((x + w) > (static_cast<s32>(clip.right) + 1))
+    w = static_cast<s32>(clip.right) + 1 - x;
 
   if (w <= 0)
     return;
@@ -378,6 +905,38 @@ void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s3
   AddIDeltas_DX<shading_enable, texture_enable>(ig, idl, x_ig_adjust);
   AddIDeltas_DY<shading_enable, texture_enable>(ig, idl, y);
 
+#ifdef VECTOR_SPANS
+  if (!texture_enable ||
+      !RowMaySampleItself(cmd, static_cast<u32>(y) >> m_resolution_shift, static_cast<u32>(x) >> m_resolution_shift,
+                          static_cast<u32>(x + w - 1) >> m_resolution_shift))
+  {
+    std::array<u16, SPAN_VECTOR_WIDTH> span_r, span_g, span_b, texels;
+    for (; w >= static_cast<s32>(SPAN_VECTOR_WIDTH); w -= SPAN_VECTOR_WIDTH)
+    {
+      for (u32 i = 0; i < SPAN_VECTOR_WIDTH; i++)
+      {
+        span_r[i] = Truncate8(ig.r >> (COORD_FBS + COORD_POST_PADDING));
+        span_g[i] = Truncate8(ig.g >> (COORD_FBS + COORD_POST_PADDING));
+        span_b[i] = Truncate8(ig.b >> (COORD_FBS + COORD_POST_PADDING));
+        if constexpr (texture_enable)
+        {
+          texels[i] = GetTexel(cmd, Truncate8(ig.u >> (COORD_FBS + COORD_POST_PADDING)),
+                               Truncate8(ig.v >> (COORD_FBS + COORD_POST_PADDING)));
+        }
+
+        AddIDeltas_DX<shading_enable, texture_enable>(ig, idl);
+      }
+
+      ShadePixels<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
+        cmd, static_cast<u32>(x), static_cast<u32>(y), span_r.data(), span_g.data(), span_b.data(), texels.data());
+      x += SPAN_VECTOR_WIDTH;
+    }
+
+    if (w <= 0)
+      return;
+  }
+#endif
+
   do
   {
     const u32 r = ig.r >> (COORD_FBS + COORD_POST_PADDING);
@@ -397,7 +956,7 @@ void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s3
 
 template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
          bool dithering_enable>
-void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
+void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& clip,
                                   const GPUBackendDrawPolygonCommand::Vertex* v0,
                                   const GPUBackendDrawPolygonCommand::Vertex* v1,
                                   const GPUBackendDrawPolygonCommand::Vertex* v2)
@@ -442,10 +1001,11 @@ void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
   if (v0->y == v2->y)
     return;
 
-  if (static_cast<u32>(std::abs(v2->x - v0->x)) >= MAX_PRIMITIVE_WIDTH ||
-      static_cast<u32>(std::abs(v2->x - v1->x)) >= MAX_PRIMITIVE_WIDTH ||
-      static_cast<u32>(std::abs(v1->x - v0->x)) >= MAX_PRIMITIVE_WIDTH ||
-      static_cast<u32>(v2->y - v0->y) >= MAX_PRIMITIVE_HEIGHT)
+  const u32 max_width = MAX_PRIMITIVE_WIDTH << m_resolution_shift;
+  const u32 max_height = MAX_PRIMITIVE_HEIGHT << m_resolution_shift;
+  if (static_cast<u32>(std::abs(v2->x - v0->x)) >= max_width ||
+      static_cast<u32>(std::abs(v2->x - v1->x)) >= max_width ||
+      static_cast<u32>(std::abs(v1->x - v0->x)) >= max_width || static_cast<u32>(v2->y - v0->y) >= max_height)
   {
     return;
   }
@@ -553,32 +1113,32 @@ void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
         lc -= ls;
         rc -= rs;
 
-        s32 y = TruncateGPUVertexPosition(yi);
+        s32 y = TruncateScaledPosition(yi);
 
-        if (y < static_cast<s32>(m_drawing_area.top))
+        if (y < static_cast<s32>(clip.top))
           break;
 
-        if (y > static_cast<s32>(m_drawing_area.bottom))
+        if (y > static_cast<s32>(clip.bottom))
           continue;
 
         DrawSpan<shading_enable, texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-          cmd, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
+          cmd, clip, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
       }
     }
     else
     {
       while (yi < yb)
       {
-        s32 y = TruncateGPUVertexPosition(yi);
+        s32 y = TruncateScaledPosition(yi);
 
-        if (y > static_cast<s32>(m_drawing_area.bottom))
+        if (y > static_cast<s32>(clip.bottom))
           break;
 
-        if (y >= static_cast<s32>(m_drawing_area.top))
+        if (y >= static_cast<s32>(clip.top))
         {
 
           DrawSpan<shading_enable, texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-            cmd, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
+            cmd, clip, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
         }
 
         yi++;
@@ -655,8 +1215,8 @@ static ALWAYS_INLINE_RELEASE s64 LineDivide(s64 delta, s32 dk)
 }
 
 template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBackendDrawLineCommand::Vertex* p0,
-                              const GPUBackendDrawLineCommand::Vertex* p1)
+void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const Common::Rectangle<u32>& clip,
+                              const GPUBackendDrawLineCommand::Vertex* p0, const GPUBackendDrawLineCommand::Vertex* p1)
 {
   const s32 i_dx = std::abs(p1->x - p0->x);
   const s32 i_dy = std::abs(p1->y - p0->y);
@@ -716,15 +1276,32 @@ void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBac
     const s32 y = (cur_point.y >> Line_XY_FractBits) & 2047;
 
     if ((!cmd->params.interlaced_rendering || cmd->params.active_line_lsb != (Truncate8(static_cast<u32>(y)) & 1u)) &&
-        x >= static_cast<s32>(m_drawing_area.left) && x <= static_cast<s32>(m_drawing_area.right) &&
-        y >= static_cast<s32>(m_drawing_area.top) && y <= static_cast<s32>(m_drawing_area.bottom))
+        x >= static_cast<s32>(clip.left) && x <= static_cast<s32>(clip.right) &&
+        y >= static_cast<s32>(clip.top) && y <= static_cast<s32>(clip.bottom))
     {
       const u8 r = shading_enable ? static_cast<u8>(cur_point.r >> Line_RGB_FractBits) : p0->r;
       const u8 g = shading_enable ? static_cast<u8>(cur_point.g >> Line_RGB_FractBits) : p0->g;
       const u8 b = shading_enable ? static_cast<u8>(cur_point.b >> Line_RGB_FractBits) : p0->b;
 
-      ShadePixel<false, false, transparency_enable, dithering_enable>(cmd, static_cast<u32>(x), static_cast<u32>(y), r,
-                                                                      g, b, 0, 0);
+      if (m_resolution_shift == 0)
+      {
+        ShadePixel<false, false, transparency_enable, dithering_enable>(cmd, static_cast<u32>(x),
+                                                                        static_cast<u32>(y), r, g, b, 0, 0);
+      }
+      else
+      {
+        // Lines are stepped at native resolution, and keep their thickness when upscaled.
+        const u32 scale = GetResolutionScale();
+        for (u32 sy = 0; sy < scale; sy++)
+        {
+          for (u32 sx = 0; sx < scale; sx++)
+          {
+            ShadePixel<false, false, transparency_enable, dithering_enable>(
+              cmd, (static_cast<u32>(x) << m_resolution_shift) + sx, (static_cast<u32>(y) << m_resolution_shift) + sy,
+              r, g, b, 0, 0);
+          }
+        }
+      }
     }
 
     cur_point.x += step.dx_dk;
@@ -770,7 +1347,22 @@ GPU_SW_Backend::GetDrawRectangleFunction(bool texture_enable, bool raw_texture_e
 void GPU_SW_Backend::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color, GPUBackendCommandParameters params)
 {
   const u16 color16 = RGBA8888ToRGBA5551(color);
-  if ((x + width) <= VRAM_WIDTH && !params.interlaced_rendering)
+  if (m_resolution_shift > 0)
+  {
+    const u32 shift = m_resolution_shift;
+    const u32 scaled_height = VRAM_HEIGHT << shift;
+    for (u32 yoffs = 0; yoffs < (height << shift); yoffs++)
+    {
+      const u32 row = ((y << shift) + yoffs) % scaled_height;
+      if (params.interlaced_rendering && ((row >> shift) & u32(1)) == params.active_line_lsb)
+        continue;
+
+      u16* row_ptr = &m_render_vram[row * m_render_stride];
+      for (u32 xoffs = 0; xoffs < (width << shift); xoffs++)
+        row_ptr[((x << shift) + xoffs) % m_render_stride] = color16;
+    }
+  }
+  else if ((x + width) <= VRAM_WIDTH && !params.interlaced_rendering)
   {
     for (u32 yoffs = 0; yoffs < height; yoffs++)
     {
@@ -814,9 +1406,40 @@ void GPU_SW_Backend::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color, GP
 void GPU_SW_Backend::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data,
                                 GPUBackendCommandParameters params)
 {
-  // Fast path when the copy is not oversized.
-  if ((x + width) <= VRAM_WIDTH && (y + height) <= VRAM_HEIGHT && !params.IsMaskingEnabled())
+  if (m_resolution_shift > 0)
   {
+    const u32 shift = m_resolution_shift;
+    const u32 scale = GetResolutionScale();
+    const u16* src_ptr = static_cast<const u16*>(data);
+    const u16 mask_and = params.GetMaskAND();
+    const u16 mask_or = params.GetMaskOR();
+
+    for (u32 row = 0; row < height; row++)
+    {
+      u16* dst_row_ptr = &m_render_vram[(((y + row) % VRAM_HEIGHT) << shift) * m_render_stride];
+      for (u32 col = 0; col < width; col++)
+      {
+        // Like native VRAM, the source only advances when the (top-left) destination pixel is written.
+        u16* dst_block_ptr = &dst_row_ptr[((x + col) % VRAM_WIDTH) << shift];
+        if (((*dst_block_ptr) & mask_and) != 0)
+          continue;
+
+        const u16 value = *(src_ptr++) | mask_or;
+        for (u32 sy = 0; sy < scale; sy++)
+        {
+          u16* pixel_ptr = &dst_block_ptr[sy * m_render_stride];
+          for (u32 sx = 0; sx < scale; sx++)
+          {
+            if ((pixel_ptr[sx] & mask_and) == 0)
+              pixel_ptr[sx] = value;
+          }
+        }
+      }
+    }
+  }
+  else if ((x + width) <= VRAM_WIDTH && (y + height) <= VRAM_HEIGHT && !params.IsMaskingEnabled())
+  {
+    // Fast path when the copy is not oversized.
     const u16* src_ptr = static_cast<const u16*>(data);
     u16* dst_ptr = &m_vram_ptr[y * VRAM_WIDTH + x];
     for (u32 yoffs = 0; yoffs < height; yoffs++)
@@ -887,17 +1510,30 @@ void GPU_SW_Backend::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wi
   const u16 mask_or = params.GetMaskOR();
 
   // Copy in reverse when src_x < dst_x, this is verified on console.
-  if (src_x < dst_x || ((src_x + width - 1) % VRAM_WIDTH) < ((dst_x + width - 1) % VRAM_WIDTH))
+  const bool reverse = (src_x < dst_x || ((src_x + width - 1) % VRAM_WIDTH) < ((dst_x + width - 1) % VRAM_WIDTH));
+
+  // Upscaled VRAM is copied at full resolution.
+  const u32 shift = m_resolution_shift;
+  const u32 scaled_width = VRAM_WIDTH << shift;
+  const u32 scaled_height = VRAM_HEIGHT << shift;
+  src_x <<= shift;
+  src_y <<= shift;
+  dst_x <<= shift;
+  dst_y <<= shift;
+  width <<= shift;
+  height <<= shift;
+
+  if (reverse)
   {
     for (u32 row = 0; row < height; row++)
     {
-      const u16* src_row_ptr = &m_vram_ptr[((src_y + row) % VRAM_HEIGHT) * VRAM_WIDTH];
-      u16* dst_row_ptr = &m_vram_ptr[((dst_y + row) % VRAM_HEIGHT) * VRAM_WIDTH];
+      const u16* src_row_ptr = &m_render_vram[((src_y + row) % scaled_height) * m_render_stride];
+      u16* dst_row_ptr = &m_render_vram[((dst_y + row) % scaled_height) * m_render_stride];
 
       for (s32 col = static_cast<s32>(width - 1); col >= 0; col--)
       {
-        const u16 src_pixel = src_row_ptr[(src_x + static_cast<u32>(col)) % VRAM_WIDTH];
-        u16* dst_pixel_ptr = &dst_row_ptr[(dst_x + static_cast<u32>(col)) % VRAM_WIDTH];
+        const u16 src_pixel = src_row_ptr[(src_x + static_cast<u32>(col)) % scaled_width];
+        u16* dst_pixel_ptr = &dst_row_ptr[(dst_x + static_cast<u32>(col)) % scaled_width];
         if ((*dst_pixel_ptr & mask_and) == 0)
           *dst_pixel_ptr = src_pixel | mask_or;
       }
@@ -907,13 +1543,13 @@ void GPU_SW_Backend::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wi
   {
     for (u32 row = 0; row < height; row++)
     {
-      const u16* src_row_ptr = &m_vram_ptr[((src_y + row) % VRAM_HEIGHT) * VRAM_WIDTH];
-      u16* dst_row_ptr = &m_vram_ptr[((dst_y + row) % VRAM_HEIGHT) * VRAM_WIDTH];
+      const u16* src_row_ptr = &m_render_vram[((src_y + row) % scaled_height) * m_render_stride];
+      u16* dst_row_ptr = &m_render_vram[((dst_y + row) % scaled_height) * m_render_stride];
 
       for (u32 col = 0; col < width; col++)
       {
-        const u16 src_pixel = src_row_ptr[(src_x + col) % VRAM_WIDTH];
-        u16* dst_pixel_ptr = &dst_row_ptr[(dst_x + col) % VRAM_WIDTH];
+        const u16 src_pixel = src_row_ptr[(src_x + col) % scaled_width];
+        u16* dst_pixel_ptr = &dst_row_ptr[(dst_x + col) % scaled_width];
         if ((*dst_pixel_ptr & mask_and) == 0)
           *dst_pixel_ptr = src_pixel | mask_or;
       }
@@ -921,6 +1557,256 @@ void GPU_SW_Backend::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wi
   }
 }
 
-void GPU_SW_Backend::FlushRender() {}
+void GPU_SW_Backend::FlushRender()
+{
+  if (m_batch_primitives.empty())
+    return;
+
+  {
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_workers_remaining = static_cast<u32>(m_worker_threads.size());
+    m_worker_generation++;
+    m_worker_work_cv.notify_all();
+  }
+
+  // this thread takes the first set of tiles
+  DrawTiles(0);
+
+  {
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_worker_done_cv.wait(lock, [this]() { return m_workers_remaining == 0; });
+  }
+
+  m_batch_commands.clear();
+  m_batch_primitives.clear();
+  m_batch_write_ranges.fill(TileColumnRange{VRAM_WIDTH, 0});
+  m_batch_read_ranges.fill(TileColumnRange{VRAM_WIDTH, 0});
+}
+
+void GPU_SW_Backend::StartWorkerThreads(u32 count)
+{
+  count = std::min(count, MAX_WORKER_THREADS);
+  if (count == 0)
+    return;
+
+  // workers start out waiting for the first generation, in case a flush happens before they get going
+  m_workers_shutdown = false;
+  m_worker_generation = 0;
+  m_worker_threads.reserve(count);
+  for (u32 i = 0; i < count; i++)
+    m_worker_threads.emplace_back(&GPU_SW_Backend::WorkerThreadEntryPoint, this, i + 1);
+
+  Log_InfoPrintf("Started %u software renderer worker threads.", count);
+}
+
+void GPU_SW_Backend::StopWorkerThreads()
+{
+  if (m_worker_threads.empty())
+    return;
+
+  FlushRender();
+
+  {
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_workers_shutdown = true;
+    m_worker_work_cv.notify_all();
+  }
+
+  for (std::thread& thread : m_worker_threads)
+    thread.join();
+  m_worker_threads.clear();
+}
+
+void GPU_SW_Backend::WorkerThreadEntryPoint(u32 index)
+{
+  std::unique_lock<std::mutex> lock(m_worker_mutex);
+  u32 last_generation = 0;
+  for (;;)
+  {
+    m_worker_work_cv.wait(
+      lock, [this, last_generation]() { return m_workers_shutdown || m_worker_generation != last_generation; });
+    if (m_workers_shutdown)
+      break;
+
+    last_generation = m_worker_generation;
+    lock.unlock();
+    DrawTiles(index);
+    lock.lock();
+
+    if ((--m_workers_remaining) == 0)
+      m_worker_done_cv.notify_one();
+  }
+}
+
+void GPU_SW_Backend::DrawTiles(u32 worker_index)
+{
+  const u32 worker_count = static_cast<u32>(m_worker_threads.size()) + 1;
+  for (u32 tile = worker_index; tile < TILE_COUNT; tile += worker_count)
+  {
+    Common::Rectangle<u32> clip = m_drawing_area;
+    clip.top = std::max(clip.top, tile * TILE_HEIGHT);
+    clip.bottom = std::min(clip.bottom, (tile * TILE_HEIGHT) + (TILE_HEIGHT - 1));
+    if (clip.top > clip.bottom)
+      continue;
+
+    const TileMask tile_bit = TileMask(1) << tile;
+    for (const BatchPrimitive& prim : m_batch_primitives)
+    {
+      if (!(prim.tiles & tile_bit))
+        continue;
+
+      const GPUBackendCommand* cmd = reinterpret_cast<const GPUBackendCommand*>(&m_batch_commands[prim.offset]);
+      switch (cmd->type)
+      {
+        case GPUBackendCommandType::DrawPolygon:
+          RasterizePolygon(static_cast<const GPUBackendDrawPolygonCommand*>(cmd), clip);
+          break;
+
+        case GPUBackendCommandType::DrawRectangle:
+          RasterizeRectangle(static_cast<const GPUBackendDrawRectangleCommand*>(cmd), clip);
+          break;
+
+        case GPUBackendCommandType::DrawLine:
+          RasterizeLine(static_cast<const GPUBackendDrawLineCommand*>(cmd), clip);
+          break;
+
+        default:
+          break;
+      }
+    }
+  }
+}
+
+bool GPU_SW_Backend::GetPrimitiveBounds(s32 min_x, s32 min_y, s32 max_x, s32 max_y,
+                                        Common::Rectangle<u32>* bounds) const
+{
+  const Common::Rectangle<u32>& area = m_drawing_area;
+  if (area.left > area.right || area.top > area.bottom || max_x < min_x || max_y < min_y)
+    return false;
+
+  // Coordinates outside the 11-bit range wrap around in the rasterizer, so they could land anywhere.
+  if (min_x < -1024 || max_x > 1023 || min_y < -1024 || max_y > 1023)
+  {
+    *bounds = area;
+    return true;
+  }
+
+  if (max_x < static_cast<s32>(area.left) || min_x > static_cast<s32>(area.right) ||
+      max_y < static_cast<s32>(area.top) || min_y > static_cast<s32>(area.bottom))
+  {
+    return false;
+  }
+
+  bounds->Set(std::max(static_cast<u32>(std::max(min_x, 0)), area.left),
+              std::max(static_cast<u32>(std::max(min_y, 0)), area.top), std::min(static_cast<u32>(max_x), area.right),
+              std::min(static_cast<u32>(max_y), area.bottom));
+  return true;
+}
+
+bool GPU_SW_Backend::RangesOverlap(const TileColumnRanges& ranges, const Common::Rectangle<u32>& area)
+{
+  for (u32 tile = area.top / TILE_HEIGHT; tile <= (area.bottom / TILE_HEIGHT); tile++)
+  {
+    const TileColumnRange& range = ranges[tile];
+    if (range.left <= range.right && range.left <= area.right && area.left <= range.right)
+      return true;
+  }
+
+  return false;
+}
+
+void GPU_SW_Backend::AddToRanges(TileColumnRanges& ranges, const Common::Rectangle<u32>& area)
+{
+  for (u32 tile = area.top / TILE_HEIGHT; tile <= (area.bottom / TILE_HEIGHT); tile++)
+  {
+    TileColumnRange& range = ranges[tile];
+    range.left = std::min(range.left, static_cast<u16>(area.left));
+    range.right = std::max(range.right, static_cast<u16>(area.right));
+  }
+}
+
+bool GPU_SW_Backend::QueueDraw(const GPUBackendDrawCommand* cmd, s32 min_x, s32 min_y, s32 max_x, s32 max_y)
+{
+  Common::Rectangle<u32> bounds;
+  if (!GetPrimitiveBounds(min_x, min_y, max_x, max_y, &bounds))
+    return true;
+
+  // Earlier draws in the batch have to sample before we overwrite their texels.
+  if (RangesOverlap(m_batch_read_ranges, bounds))
+    FlushRender();
+
+  // Areas the draw can sample from, split where they wrap around horizontally.
+  std::array<Common::Rectangle<u32>, 4> read_areas;
+  u32 num_read_areas = 0;
+  if (cmd->rc.texture_enable)
+  {
+    const auto add_read_area = [&read_areas, &num_read_areas](u32 x, u32 y, u32 width, u32 height) {
+      const u32 bottom = y + height - 1;
+      if ((x + width) > VRAM_WIDTH)
+      {
+        read_areas[num_read_areas++].Set(x, y, VRAM_WIDTH - 1, bottom);
+        read_areas[num_read_areas++].Set(0, y, x + width - VRAM_WIDTH - 1, bottom);
+      }
+      else
+      {
+        read_areas[num_read_areas++].Set(x, y, x + width - 1, bottom);
+      }
+    };
+
+    const u32 page_x = cmd->draw_mode.GetTexturePageBaseX();
+    const u32 page_y = cmd->draw_mode.GetTexturePageBaseY();
+    switch (cmd->draw_mode.texture_mode)
+    {
+      case GPUTextureMode::Palette4Bit:
+        add_read_area(page_x, page_y, 64, 256);
+        add_read_area(cmd->palette.GetXBase(), cmd->palette.GetYBase(), 16, 1);
+        break;
+
+      case GPUTextureMode::Palette8Bit:
+        add_read_area(page_x, page_y, 128, 256);
+        add_read_area(cmd->palette.GetXBase(), cmd->palette.GetYBase(), 256, 1);
+        break;
+
+      default:
+        add_read_area(page_x, page_y, 256, 256);
+        break;
+    }
+
+    for (u32 i = 0; i < num_read_areas; i++)
+    {
+      const Common::Rectangle<u32>& ra = read_areas[i];
+      if (ra.left <= bounds.right && bounds.left <= ra.right && ra.top <= bounds.bottom && bounds.top <= ra.bottom)
+      {
+        // Sampling from its own output depends on the order rows are drawn in, so draw it on this thread.
+        FlushRender();
+        return false;
+      }
+
+      // Earlier draws in the batch have to land before we sample from them.
+      if (RangesOverlap(m_batch_write_ranges, ra))
+        FlushRender();
+    }
+  }
+
+  if (m_batch_primitives.size() >= MAX_BATCH_PRIMITIVES)
+    FlushRender();
+
+  BatchPrimitive prim;
+  prim.offset = static_cast<u32>(m_batch_commands.size());
+  prim.tiles = 0;
+
+  m_batch_commands.resize(m_batch_commands.size() + cmd->size);
+  std::memcpy(&m_batch_commands[prim.offset], cmd, cmd->size);
+
+  for (u32 tile = bounds.top / TILE_HEIGHT; tile <= (bounds.bottom / TILE_HEIGHT); tile++)
+    prim.tiles |= TileMask(1) << tile;
+
+  AddToRanges(m_batch_write_ranges, bounds);
+  for (u32 i = 0; i < num_read_areas; i++)
+    AddToRanges(m_batch_read_ranges, read_areas[i]);
+
+  m_batch_primitives.push_back(prim);
+  return true;
+}
 
 void GPU_SW_Backend::DrawingAreaChanged() {}
@@ -1,7 +1,10 @@
 #pragma once
 #include "gpu_backend.h"
 #include <array>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 class GPU_SW_Backend final : public GPUBackend
@@ -11,18 +14,49 @@ public:
   ~GPU_SW_Backend() override;
 
   bool Initialize() override;
+  void UpdateSettings() override;
   void Reset() override;
+  void Shutdown() override;
 
-  ALWAYS_INLINE_RELEASE u16 GetPixel(const u32 x, const u32 y) const { return m_vram[VRAM_WIDTH * y + x]; }
-  ALWAYS_INLINE_RELEASE const u16* GetPixelPtr(const u32 x, const u32 y) const { return &m_vram[VRAM_WIDTH * y + x]; }
-  ALWAYS_INLINE_RELEASE u16* GetPixelPtr(const u32 x, const u32 y) { return &m_vram[VRAM_WIDTH * y + x]; }
-  ALWAYS_INLINE_RELEASE void SetPixel(const u32 x, const u32 y, const u16 value) { m_vram[VRAM_WIDTH * y + x] = value; }
+  /// Maximum supported resolution scale. Scales are rounded down to a power of two.
+  static constexpr u32 MAX_RESOLUTION_SCALE = 4;
+
+  ALWAYS_INLINE u32 GetResolutionScale() const { return 1u << m_resolution_shift; }
+  ALWAYS_INLINE u32 GetResolutionShift() const { return m_resolution_shift; }
+
+  /// Returns the VRAM primitives are drawn to, which is (VRAM_WIDTH x VRAM_HEIGHT) * GetResolutionScale().
+  ALWAYS_INLINE const u16* GetRenderVRAM() const { return m_render_vram; }
+
+  /// Refreshes the native copy of VRAM from the upscaled copy, before it is read by the CPU.
+  /// All writes to the region must have completed, i.e. after Sync() or SyncRegion().
+  void DownsampleVRAM(u32 x, u32 y, u32 width, u32 height);
+
+  // Pixel accessors for rasterization, which operate on the render VRAM.
+  ALWAYS_INLINE_RELEASE u16 GetPixel(const u32 x, const u32 y) const { return m_render_vram[m_render_stride * y + x]; }
+  ALWAYS_INLINE_RELEASE const u16* GetPixelPtr(const u32 x, const u32 y) const
+  {
+    return &m_render_vram[m_render_stride * y + x];
+  }
+  ALWAYS_INLINE_RELEASE u16* GetPixelPtr(const u32 x, const u32 y) { return &m_render_vram[m_render_stride * y + x]; }
+  ALWAYS_INLINE_RELEASE void SetPixel(const u32 x, const u32 y, const u16 value)
+  {
+    m_render_vram[m_render_stride * y + x] = value;
+  }
+
+  /// Reads a pixel of the render VRAM by native coordinates, for texture lookups.
+  ALWAYS_INLINE_RELEASE u16 GetNativePixel(const u32 x, const u32 y) const
+  {
+    return m_render_vram[m_render_stride * (y << m_resolution_shift) + (x << m_resolution_shift)];
+  }
 
   // this is actually (31 * 255) >> 4) == 494, but to simplify addressing we use the next power of two (512)
   static constexpr u32 DITHER_LUT_SIZE = 512;
   using DitherLUT = std::array<std::array<std::array<u8, 512>, DITHER_MATRIX_SIZE>, DITHER_MATRIX_SIZE>;
   static constexpr DitherLUT ComputeDitherLUT();
 
+  /// Number of pixels shaded at once by ShadePixels().
+  static constexpr u32 SPAN_VECTOR_WIDTH = 8;
+
 protected:
   static constexpr u8 Convert5To8(u8 x5) { return (x5 << 3) | (x5 & 7); }
   static constexpr u8 Convert8To5(u8 x8) { return (x8 >> 3); }
@@ -102,17 +136,99 @@ protected:
   void FlushRender() override;
   void DrawingAreaChanged() override;
 
+  void UpdateResolutionScale();
+
+  /// Wraps a scaled coordinate the same way TruncateGPUVertexPosition() wraps a native coordinate.
+  ALWAYS_INLINE s32 TruncateScaledPosition(s32 x) const
+  {
+    const u32 shift = 21 - m_resolution_shift;
+    return (x << shift) >> shift;
+  }
+
+  /// Converts a native clip rectangle to the render VRAM.
+  Common::Rectangle<u32> ScaleClipRectangle(const Common::Rectangle<u32>& clip) const;
+
+  /// Rasterizes a primitive, only touching pixels inside the clip rectangle (inclusive). The clip rectangle is in
+  /// native coordinates, primitives are scaled up when drawing to upscaled VRAM.
+  void RasterizePolygon(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& clip);
+  void RasterizeRectangle(const GPUBackendDrawRectangleCommand* cmd, const Common::Rectangle<u32>& clip);
+  void RasterizeLine(const GPUBackendDrawLineCommand* cmd, const Common::Rectangle<u32>& clip);
+
+  //////////////////////////////////////////////////////////////////////////
+  // Tiled rendering
+  //////////////////////////////////////////////////////////////////////////
+  // VRAM is split into bands of rows, which are interleaved between the worker threads. Draws are binned into the
+  // bands they touch, and each band is drawn by a single thread in submission order, so blending and mask bit
+  // behavior are the same as drawing on one thread.
+  static constexpr u32 TILE_HEIGHT = 16;
+  static constexpr u32 TILE_COUNT = VRAM_HEIGHT / TILE_HEIGHT;
+  static constexpr u32 MAX_BATCH_PRIMITIVES = 2048;
+  static constexpr u32 MAX_WORKER_THREADS = 16;
+
+  using TileMask = u32;
+  static_assert(TILE_COUNT <= sizeof(TileMask) * 8);
+
+  struct BatchPrimitive
+  {
+    u32 offset;
+    TileMask tiles;
+  };
+
+  /// Columns touched by the current batch in each tile, for detecting draws which depend on each other's output.
+  struct TileColumnRange
+  {
+    u16 left;
+    u16 right;
+  };
+  using TileColumnRanges = std::array<TileColumnRange, TILE_COUNT>;
+
+  bool IsUsingWorkerThreads() const { return !m_worker_threads.empty(); }
+  void StartWorkerThreads(u32 count);
+  void StopWorkerThreads();
+  void WorkerThreadEntryPoint(u32 index);
+  void DrawTiles(u32 worker_index);
+
+  /// Returns the area the primitive can touch, or false if it won't draw anything.
+  bool GetPrimitiveBounds(s32 min_x, s32 min_y, s32 max_x, s32 max_y, Common::Rectangle<u32>* bounds) const;
+  static bool RangesOverlap(const TileColumnRanges& ranges, const Common::Rectangle<u32>& area);
+  static void AddToRanges(TileColumnRanges& ranges, const Common::Rectangle<u32>& area);
+
+  /// Adds the draw to the current batch. Returns false if it has to be drawn immediately instead.
+  bool QueueDraw(const GPUBackendDrawCommand* cmd, s32 min_x, s32 min_y, s32 max_x, s32 max_y);
+
+  std::vector<std::thread> m_worker_threads;
+  std::mutex m_worker_mutex;
+  std::condition_variable m_worker_work_cv;
+  std::condition_variable m_worker_done_cv;
+  u32 m_worker_generation = 0;
+  u32 m_workers_remaining = 0;
+  bool m_workers_shutdown = false;
+
+  std::vector<u8> m_batch_commands;
+  std::vector<BatchPrimitive> m_batch_primitives;
+  TileColumnRanges m_batch_write_ranges;
+  TileColumnRanges m_batch_read_ranges;
+
   //////////////////////////////////////////////////////////////////////////
   // Rasterization
   //////////////////////////////////////////////////////////////////////////
+  u16 GetTexel(const GPUBackendDrawCommand* cmd, u8 texcoord_x, u8 texcoord_y) const;
+
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
   void ShadePixel(const GPUBackendDrawCommand* cmd, u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x,
                   u8 texcoord_y);
 
+  /// Shades SPAN_VECTOR_WIDTH consecutive pixels of row y starting at x, which must all be inside the clip area.
+  /// Texels are fetched by the caller, since they can't be gathered with vector loads.
+  template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
+  void ShadePixels(const GPUBackendDrawCommand* cmd, u32 x, u32 y, const u16* color_r, const u16* color_g,
+                   const u16* color_b, const u16* texels);
+
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-  void DrawRectangle(const GPUBackendDrawRectangleCommand* cmd);
+  void DrawRectangle(const GPUBackendDrawRectangleCommand* cmd, const Common::Rectangle<u32>& clip);
 
-  using DrawRectangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawRectangleCommand* cmd);
+  using DrawRectangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawRectangleCommand* cmd,
+                                                         const Common::Rectangle<u32>& clip);
   DrawRectangleFunction GetDrawRectangleFunction(bool texture_enable, bool raw_texture_enable,
                                                  bool transparency_enable);
 
@@ -146,15 +262,17 @@ protected:
 
   template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
            bool dithering_enable>
-  void DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s32 x_start, s32 x_bound, i_group ig,
-                const i_deltas& idl);
+  void DrawSpan(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& clip, s32 y, s32 x_start,
+                s32 x_bound, i_group ig, const i_deltas& idl);
 
   template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
            bool dithering_enable>
-  void DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const GPUBackendDrawPolygonCommand::Vertex* v0,
-                    const GPUBackendDrawPolygonCommand::Vertex* v1, const GPUBackendDrawPolygonCommand::Vertex* v2);
+  void DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& clip,
+                    const GPUBackendDrawPolygonCommand::Vertex* v0, const GPUBackendDrawPolygonCommand::Vertex* v1,
+                    const GPUBackendDrawPolygonCommand::Vertex* v2);
 
   using DrawTriangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawPolygonCommand* cmd,
+                                                        const Common::Rectangle<u32>& clip,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v0,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v1,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v2);
@@ -162,13 +280,20 @@ protected:
                                                bool transparency_enable, bool dithering_enable);
 
   template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-  void DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBackendDrawLineCommand::Vertex* p0,
-                const GPUBackendDrawLineCommand::Vertex* p1);
+  void DrawLine(const GPUBackendDrawLineCommand* cmd, const Common::Rectangle<u32>& clip,
+                const GPUBackendDrawLineCommand::Vertex* p0, const GPUBackendDrawLineCommand::Vertex* p1);
 
   using DrawLineFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawLineCommand* cmd,
+                                                    const Common::Rectangle<u32>& clip,
                                                     const GPUBackendDrawLineCommand::Vertex* p0,
                                                     const GPUBackendDrawLineCommand::Vertex* p1);
   DrawLineFunction GetDrawLineFunction(bool shading_enable, bool transparency_enable, bool dithering_enable);
 
   std::array<u16, VRAM_WIDTH * VRAM_HEIGHT> m_vram;
+
+  // When upscaling, primitives and VRAM transfers only touch the upscaled copy, and m_vram is just a readback buffer.
+  std::vector<u16> m_upscaled_vram;
+  u16* m_render_vram = nullptr;
+  u32 m_render_stride = VRAM_WIDTH;
+  u32 m_resolution_shift = 0;
 };
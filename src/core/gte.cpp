@@ -1,6 +1,7 @@
 #include "gte.h"
 #include "common/assert.h"
 #include "common/bitutils.h"
+#include "common/cpu_detect.h"
 #include "common/state_wrapper.h"
 #include "cpu_core.h"
 #include "pgxp.h"
@@ -8,6 +9,16 @@
 #include <algorithm>
 #include <array>
 
+#if defined(CPU_X64)
+#include <emmintrin.h>
+#elif defined(CPU_AARCH64)
+#ifdef _MSC_VER
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 namespace GTE {
 
 static constexpr s64 MAC0_MIN_VALUE = -(INT64_C(1) << 31);
@@ -366,6 +377,26 @@ static void PushRGBFromMAC()
   REGS.dr32[22] = r | (g << 8) | (b << 16) | (c << 24); // RGB2 <- Value
 }
 
+static constexpr std::array<u8, 257> s_unr_table = {{
+  0xFF, 0xFD, 0xFB, 0xF9, 0xF7, 0xF5, 0xF3, 0xF1, 0xEF, 0xEE, 0xEC, 0xEA, 0xE8, 0xE6, 0xE4, 0xE3, //
+  0xE1, 0xDF, 0xDD, 0xDC, 0xDA, 0xD8, 0xD6, 0xD5, 0xD3, 0xD1, 0xD0, 0xCE, 0xCD, 0xCB, 0xC9, 0xC8, //  00h..3Fh
+  0xC6, 0xC5, 0xC3, 0xC1, 0xC0, 0xBE, 0xBD, 0xBB, 0xBA, 0xB8, 0xB7, 0xB5, 0xB4, 0xB2, 0xB1, 0xB0, //
+  0xAE, 0xAD, 0xAB, 0xAA, 0xA9, 0xA7, 0xA6, 0xA4, 0xA3, 0xA2, 0xA0, 0x9F, 0x9E, 0x9C, 0x9B, 0x9A, //
+  0x99, 0x97, 0x96, 0x95, 0x94, 0x92, 0x91, 0x90, 0x8F, 0x8D, 0x8C, 0x8B, 0x8A, 0x89, 0x87, 0x86, //
+  0x85, 0x84, 0x83, 0x82, 0x81, 0x7F, 0x7E, 0x7D, 0x7C, 0x7B, 0x7A, 0x79, 0x78, 0x77, 0x75, 0x74, //  40h..7Fh
+  0x73, 0x72, 0x71, 0x70, 0x6F, 0x6E, 0x6D, 0x6C, 0x6B, 0x6A, 0x69, 0x68, 0x67, 0x66, 0x65, 0x64, //
+  0x63, 0x62, 0x61, 0x60, 0x5F, 0x5E, 0x5D, 0x5D, 0x5C, 0x5B, 0x5A, 0x59, 0x58, 0x57, 0x56, 0x55, //
+  0x54, 0x53, 0x53, 0x52, 0x51, 0x50, 0x4F, 0x4E, 0x4D, 0x4D, 0x4C, 0x4B, 0x4A, 0x49, 0x48, 0x48, //
+  0x47, 0x46, 0x45, 0x44, 0x43, 0x43, 0x42, 0x41, 0x40, 0x3F, 0x3F, 0x3E, 0x3D, 0x3C, 0x3C, 0x3B, //  80h..BFh
+  0x3A, 0x39, 0x39, 0x38, 0x37, 0x36, 0x36, 0x35, 0x34, 0x33, 0x33, 0x32, 0x31, 0x31, 0x30, 0x2F, //
+  0x2E, 0x2E, 0x2D, 0x2C, 0x2C, 0x2B, 0x2A, 0x2A, 0x29, 0x28, 0x28, 0x27, 0x26, 0x26, 0x25, 0x24, //
+  0x24, 0x23, 0x22, 0x22, 0x21, 0x20, 0x20, 0x1F, 0x1E, 0x1E, 0x1D, 0x1D, 0x1C, 0x1B, 0x1B, 0x1A, //
+  0x19, 0x19, 0x18, 0x18, 0x17, 0x16, 0x16, 0x15, 0x15, 0x14, 0x14, 0x13, 0x12, 0x12, 0x11, 0x11, //  C0h..FFh
+  0x10, 0x0F, 0x0F, 0x0E, 0x0E, 0x0D, 0x0D, 0x0C, 0x0C, 0x0B, 0x0A, 0x0A, 0x09, 0x09, 0x08, 0x08, //
+  0x07, 0x07, 0x06, 0x06, 0x05, 0x05, 0x04, 0x04, 0x03, 0x03, 0x02, 0x02, 0x01, 0x01, 0x00, 0x00, //
+  0x00 // <-- one extra table entry (for "(d-7FC0h)/80h"=100h)
+}};
+
 ALWAYS_INLINE static u32 UNRDivide(u32 lhs, u32 rhs)
 {
   if (rhs * 2 <= lhs)
@@ -378,28 +409,8 @@ ALWAYS_INLINE static u32 UNRDivide(u32 lhs, u32 rhs)
   lhs <<= shift;
   rhs <<= shift;
 
-  static constexpr std::array<u8, 257> unr_table = {{
-    0xFF, 0xFD, 0xFB, 0xF9, 0xF7, 0xF5, 0xF3, 0xF1, 0xEF, 0xEE, 0xEC, 0xEA, 0xE8, 0xE6, 0xE4, 0xE3, //
-    0xE1, 0xDF, 0xDD, 0xDC, 0xDA, 0xD8, 0xD6, 0xD5, 0xD3, 0xD1, 0xD0, 0xCE, 0xCD, 0xCB, 0xC9, 0xC8, //  00h..3Fh
-    0xC6, 0xC5, 0xC3, 0xC1, 0xC0, 0xBE, 0xBD, 0xBB, 0xBA, 0xB8, 0xB7, 0xB5, 0xB4, 0xB2, 0xB1, 0xB0, //
-    0xAE, 0xAD, 0xAB, 0xAA, 0xA9, 0xA7, 0xA6, 0xA4, 0xA3, 0xA2, 0xA0, 0x9F, 0x9E, 0x9C, 0x9B, 0x9A, //
-    0x99, 0x97, 0x96, 0x95, 0x94, 0x92, 0x91, 0x90, 0x8F, 0x8D, 0x8C, 0x8B, 0x8A, 0x89, 0x87, 0x86, //
-    0x85, 0x84, 0x83, 0x82, 0x81, 0x7F, 0x7E, 0x7D, 0x7C, 0x7B, 0x7A, 0x79, 0x78, 0x77, 0x75, 0x74, //  40h..7Fh
-    0x73, 0x72, 0x71, 0x70, 0x6F, 0x6E, 0x6D, 0x6C, 0x6B, 0x6A, 0x69, 0x68, 0x67, 0x66, 0x65, 0x64, //
-    0x63, 0x62, 0x61, 0x60, 0x5F, 0x5E, 0x5D, 0x5D, 0x5C, 0x5B, 0x5A, 0x59, 0x58, 0x57, 0x56, 0x55, //
-    0x54, 0x53, 0x53, 0x52, 0x51, 0x50, 0x4F, 0x4E, 0x4D, 0x4D, 0x4C, 0x4B, 0x4A, 0x49, 0x48, 0x48, //
-    0x47, 0x46, 0x45, 0x44, 0x43, 0x43, 0x42, 0x41, 0x40, 0x3F, 0x3F, 0x3E, 0x3D, 0x3C, 0x3C, 0x3B, //  80h..BFh
-    0x3A, 0x39, 0x39, 0x38, 0x37, 0x36, 0x36, 0x35, 0x34, 0x33, 0x33, 0x32, 0x31, 0x31, 0x30, 0x2F, //
-    0x2E, 0x2E, 0x2D, 0x2C, 0x2C, 0x2B, 0x2A, 0x2A, 0x29, 0x28, 0x28, 0x27, 0x26, 0x26, 0x25, 0x24, //
-    0x24, 0x23, 0x22, 0x22, 0x21, 0x20, 0x20, 0x1F, 0x1E, 0x1E, 0x1D, 0x1D, 0x1C, 0x1B, 0x1B, 0x1A, //
-    0x19, 0x19, 0x18, 0x18, 0x17, 0x16, 0x16, 0x15, 0x15, 0x14, 0x14, 0x13, 0x12, 0x12, 0x11, 0x11, //  C0h..FFh
-    0x10, 0x0F, 0x0F, 0x0E, 0x0E, 0x0D, 0x0D, 0x0C, 0x0C, 0x0B, 0x0A, 0x0A, 0x09, 0x09, 0x08, 0x08, //
-    0x07, 0x07, 0x06, 0x06, 0x05, 0x05, 0x04, 0x04, 0x03, 0x03, 0x02, 0x02, 0x01, 0x01, 0x00, 0x00, //
-    0x00 // <-- one extra table entry (for "(d-7FC0h)/80h"=100h)
-  }};
-
   const u32 divisor = rhs | 0x8000;
-  const s32 x = static_cast<s32>(0x101 + ZeroExtend32(unr_table[((divisor & 0x7FFF) + 0x40) >> 7]));
+  const s32 x = static_cast<s32>(0x101 + ZeroExtend32(s_unr_table[((divisor & 0x7FFF) + 0x40) >> 7]));
   const s32 d = ((static_cast<s32>(ZeroExtend32(divisor)) * -x) + 0x80) >> 8;
   const u32 recip = static_cast<u32>(((x * (0x20000 + d)) + 0x80) >> 8);
 
@@ -410,22 +421,438 @@ ALWAYS_INLINE static u32 UNRDivide(u32 lhs, u32 rhs)
   return std::min<u32>(0x1FFFF, result);
 }
 
+// The commands with vectorized kernels are templated on whether to use them, so that the scalar implementation stays
+// callable through ExecuteInstructionScalar() on every platform, and the kernels can be tested against it.
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+static constexpr bool USE_VECTOR_KERNELS = true;
+#else
+static constexpr bool USE_VECTOR_KERNELS = false;
+#endif
+
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+
+// The vectorized paths compute MAC1-3 in lanes 0-2, lane 3 is ignored. The intermediate sums are 44 bits, so they are
+// held as a pair of vectors, hi = value SAR 12 and lo = value AND FFFh. The carry out of lo is added to hi, where
+// wrapping at 32 bits is the same as the sign-extension to 44 bits after each addition, so a signed overflow of hi is
+// exactly a MAC overflow.
+
+#if defined(CPU_X64)
+
+using GTEVector = __m128i;
+
+ALWAYS_INLINE static GTEVector VectorZero()
+{
+  return _mm_setzero_si128();
+}
+
+ALWAYS_INLINE static GTEVector VectorBroadcast(s32 value)
+{
+  return _mm_set1_epi32(value);
+}
+
+ALWAYS_INLINE static GTEVector VectorSet(s32 x, s32 y, s32 z)
+{
+  return _mm_setr_epi32(x, y, z, 0);
+}
+
+// Loads four registers, the last is ignored.
+ALWAYS_INLINE static GTEVector VectorLoad(const void* ptr)
+{
+  return _mm_loadu_si128(static_cast<const __m128i*>(ptr));
+}
+
+ALWAYS_INLINE static void VectorStore(u32* ptr, GTEVector v)
+{
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(ptr), v);
+  _mm_store_ss(reinterpret_cast<float*>(ptr + 2), _mm_castsi128_ps(_mm_unpackhi_epi64(v, v)));
+}
+
+ALWAYS_INLINE static s32 VectorGetZ(GTEVector v)
+{
+  return _mm_cvtsi128_si32(_mm_unpackhi_epi64(v, v));
+}
+
+ALWAYS_INLINE static GTEVector VectorAdd(GTEVector lhs, GTEVector rhs)
+{
+  return _mm_add_epi32(lhs, rhs);
+}
+
+ALWAYS_INLINE static GTEVector VectorSub(GTEVector lhs, GTEVector rhs)
+{
+  return _mm_sub_epi32(lhs, rhs);
+}
+
+ALWAYS_INLINE static GTEVector VectorAnd(GTEVector lhs, GTEVector rhs)
+{
+  return _mm_and_si128(lhs, rhs);
+}
+
+// Returns ~lhs & rhs.
+ALWAYS_INLINE static GTEVector VectorAndNot(GTEVector lhs, GTEVector rhs)
+{
+  return _mm_andnot_si128(lhs, rhs);
+}
+
+ALWAYS_INLINE static GTEVector VectorOr(GTEVector lhs, GTEVector rhs)
+{
+  return _mm_or_si128(lhs, rhs);
+}
+
+ALWAYS_INLINE static GTEVector VectorXor(GTEVector lhs, GTEVector rhs)
+{
+  return _mm_xor_si128(lhs, rhs);
+}
+
+template<int N>
+ALWAYS_INLINE static GTEVector VectorShiftLeft(GTEVector v)
+{
+  return _mm_slli_epi32(v, N);
+}
+
+template<int N>
+ALWAYS_INLINE static GTEVector VectorShiftRight(GTEVector v)
+{
+  return _mm_srai_epi32(v, N);
+}
+
+ALWAYS_INLINE static GTEVector VectorClamp(GTEVector v, s32 min, s32 max, GTEVector* saturated)
+{
+  const GTEVector min_v = VectorBroadcast(min);
+  const GTEVector max_v = VectorBroadcast(max);
+  const GTEVector below = _mm_cmplt_epi32(v, min_v);
+  const GTEVector above = _mm_cmpgt_epi32(v, max_v);
+  *saturated = _mm_or_si128(below, above);
+  return _mm_or_si128(_mm_andnot_si128(*saturated, v),
+                      _mm_or_si128(_mm_and_si128(below, min_v), _mm_and_si128(above, max_v)));
+}
+
+// Multiplies lanes holding 16-bit values by a 16-bit scalar.
+ALWAYS_INLINE static GTEVector VectorMul16(GTEVector v, s16 scalar)
+{
+  // the upper half of each lane is multiplied by zero
+  return _mm_madd_epi16(v, _mm_set1_epi32(static_cast<s32>(ZeroExtend32(static_cast<u16>(scalar)))));
+}
+
+// Multiplies lanes holding 16-bit values by the R, G and B components of a colour.
+ALWAYS_INLINE static GTEVector VectorMulColor(GTEVector v, u32 rgbc)
+{
+  const GTEVector zero = _mm_setzero_si128();
+  const GTEVector rgb = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<s32>(rgbc)), zero), zero);
+  return _mm_madd_epi16(v, rgb);
+}
+
+// Returns the lanes with the sign bit set, lane 0 in bit 2 to match the order of the FLAG bits.
+ALWAYS_INLINE static u32 VectorGetFlagBits(GTEVector mask)
+{
+  static constexpr u8 reversed_bits[8] = {0, 4, 2, 6, 1, 5, 3, 7};
+  return reversed_bits[_mm_movemask_ps(_mm_castsi128_ps(mask)) & 7];
+}
+
+// Vector of 16-bit components, held twice as XYZ?XYZ?.
+using GTEVertex = __m128i;
+
+ALWAYS_INLINE static GTEVertex LoadVertex(const s16 V[3])
+{
+  // reads the padding after the vector
+  const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(V));
+  return _mm_unpacklo_epi64(v, v);
+}
+
+ALWAYS_INLINE static GTEVertex VertexFromComponents(s16 x, s16 y, s16 z)
+{
+  return _mm_setr_epi16(x, y, z, 0, x, y, z, 0);
+}
+
+// IR is already saturated to 16 bits.
+ALWAYS_INLINE static GTEVertex VertexFromIR(GTEVector ir)
+{
+  return _mm_packs_epi32(ir, ir);
+}
+
+// Returns the products of each column of M with its vector component, i.e. products[j][i] = M[i][j] * V[j].
+ALWAYS_INLINE static void GetMatVecProducts(const s16 M[3][3], GTEVertex V, GTEVector products[3])
+{
+  // The first eight elements are multiplied in one go, against the vector repeated as XYZXYZXY, and M33 separately.
+  const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&M[0][0]));
+  const __m128i v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(V, _MM_SHUFFLE(0, 2, 1, 0)), _MM_SHUFFLE(1, 0, 2, 1));
+
+  const __m128i lo = _mm_mullo_epi16(m, v);
+  const __m128i hi = _mm_mulhi_epi16(m, v);
+  const __m128 a = _mm_castsi128_ps(_mm_unpacklo_epi16(lo, hi)); // M11*X M12*Y M13*Z M21*X
+  const __m128 b = _mm_castsi128_ps(_mm_unpackhi_epi16(lo, hi)); // M22*Y M23*Z M31*X M32*Y
+  const __m128 c = _mm_castsi128_ps(
+    _mm_madd_epi16(_mm_cvtsi32_si128(static_cast<s32>(ZeroExtend32(static_cast<u16>(M[2][2])))), _mm_srli_si128(V, 4)));
+
+  products[0] = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 2, 3, 0)));
+  products[1] = _mm_shuffle_epi32(_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 0, 1, 1))),
+                                  _MM_SHUFFLE(3, 3, 2, 0));
+  products[2] = _mm_castps_si128(_mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c,
+                                                _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+#elif defined(CPU_AARCH64)
+
+using GTEVector = int32x4_t;
+
+ALWAYS_INLINE static GTEVector VectorZero()
+{
+  return vdupq_n_s32(0);
+}
+
+ALWAYS_INLINE static GTEVector VectorBroadcast(s32 value)
+{
+  return vdupq_n_s32(value);
+}
+
+ALWAYS_INLINE static GTEVector VectorSet(s32 x, s32 y, s32 z)
+{
+  const s32 values[4] = {x, y, z, 0};
+  return vld1q_s32(values);
+}
+
+// Loads four registers, the last is ignored.
+ALWAYS_INLINE static GTEVector VectorLoad(const void* ptr)
+{
+  return vld1q_s32(static_cast<const s32*>(ptr));
+}
+
+ALWAYS_INLINE static void VectorStore(u32* ptr, GTEVector v)
+{
+  vst1_s32(reinterpret_cast<s32*>(ptr), vget_low_s32(v));
+  vst1q_lane_s32(reinterpret_cast<s32*>(ptr + 2), v, 2);
+}
+
+ALWAYS_INLINE static s32 VectorGetZ(GTEVector v)
+{
+  return vgetq_lane_s32(v, 2);
+}
+
+ALWAYS_INLINE static GTEVector VectorAdd(GTEVector lhs, GTEVector rhs)
+{
+  return vaddq_s32(lhs, rhs);
+}
+
+ALWAYS_INLINE static GTEVector VectorSub(GTEVector lhs, GTEVector rhs)
+{
+  return vsubq_s32(lhs, rhs);
+}
+
+ALWAYS_INLINE static GTEVector VectorAnd(GTEVector lhs, GTEVector rhs)
+{
+  return vandq_s32(lhs, rhs);
+}
+
+// Returns ~lhs & rhs.
+ALWAYS_INLINE static GTEVector VectorAndNot(GTEVector lhs, GTEVector rhs)
+{
+  return vbicq_s32(rhs, lhs);
+}
+
+ALWAYS_INLINE static GTEVector VectorOr(GTEVector lhs, GTEVector rhs)
+{
+  return vorrq_s32(lhs, rhs);
+}
+
+ALWAYS_INLINE static GTEVector VectorXor(GTEVector lhs, GTEVector rhs)
+{
+  return veorq_s32(lhs, rhs);
+}
+
+template<int N>
+ALWAYS_INLINE static GTEVector VectorShiftLeft(GTEVector v)
+{
+  return vshlq_n_s32(v, N);
+}
+
+template<int N>
+ALWAYS_INLINE static GTEVector VectorShiftRight(GTEVector v)
+{
+  return vshrq_n_s32(v, N);
+}
+
+ALWAYS_INLINE static GTEVector VectorClamp(GTEVector v, s32 min, s32 max, GTEVector* saturated)
+{
+  const GTEVector min_v = VectorBroadcast(min);
+  const GTEVector max_v = VectorBroadcast(max);
+  *saturated = vreinterpretq_s32_u32(vorrq_u32(vcltq_s32(v, min_v), vcgtq_s32(v, max_v)));
+  return vminq_s32(vmaxq_s32(v, min_v), max_v);
+}
+
+// Multiplies lanes holding 16-bit values by a 16-bit scalar.
+ALWAYS_INLINE static GTEVector VectorMul16(GTEVector v, s16 scalar)
+{
+  return vmulq_n_s32(v, scalar);
+}
+
+// Multiplies lanes holding 16-bit values by the R, G and B components of a colour.
+ALWAYS_INLINE static GTEVector VectorMulColor(GTEVector v, u32 rgbc)
+{
+  const uint16x8_t rgb = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(rgbc)));
+  return vmulq_s32(v, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(rgb))));
+}
+
+// Returns the lanes with the sign bit set, lane 0 in bit 2 to match the order of the FLAG bits.
+ALWAYS_INLINE static u32 VectorGetFlagBits(GTEVector mask)
+{
+  static constexpr u32 lane_bits[4] = {4, 2, 1, 0};
+  return vaddvq_u32(vandq_u32(vreinterpretq_u32_s32(vshrq_n_s32(mask, 31)), vld1q_u32(lane_bits)));
+}
+
+// Vector of 16-bit components, as XYZ?.
+using GTEVertex = int16x4_t;
+
+ALWAYS_INLINE static GTEVertex LoadVertex(const s16 V[3])
+{
+  // reads the padding after the vector
+  return vld1_s16(V);
+}
+
+ALWAYS_INLINE static GTEVertex VertexFromComponents(s16 x, s16 y, s16 z)
+{
+  const s16 values[4] = {x, y, z, 0};
+  return vld1_s16(values);
+}
+
+// IR is already saturated to 16 bits.
+ALWAYS_INLINE static GTEVertex VertexFromIR(GTEVector ir)
+{
+  return vmovn_s32(ir);
+}
+
+// Returns the products of each column of M with its vector component, i.e. products[j][i] = M[i][j] * V[j].
+ALWAYS_INLINE static void GetMatVecProducts(const s16 M[3][3], GTEVertex V, GTEVector products[3])
+{
+  // De-interleaving reads three elements past the end of the matrix, which must be followed by other registers.
+  const int16x4x3_t columns = vld3_s16(&M[0][0]);
+  products[0] = vmull_lane_s16(columns.val[0], V, 0);
+  products[1] = vmull_lane_s16(columns.val[1], V, 1);
+  products[2] = vmull_lane_s16(columns.val[2], V, 2);
+}
+
+#endif
+
+// MAC overflow and IR saturation of each lane, in the sign bits. These are accumulated over a whole command, as
+// merging them into FLAG after every step is a long dependency chain through memory.
+struct VectorFlags
+{
+  GTEVector mac_overflow = VectorZero();
+  GTEVector mac_underflow = VectorZero();
+  GTEVector ir_saturated = VectorZero();
+};
+
+ALWAYS_INLINE static void UpdateFlags(const VectorFlags& flags)
+{
+  REGS.FLAG.bits |= (VectorGetFlagBits(flags.mac_overflow) << 28) | (VectorGetFlagBits(flags.mac_underflow) << 25) |
+                    (VectorGetFlagBits(flags.ir_saturated) << 22);
+}
+
+// Adds a product to the split MAC values.
+ALWAYS_INLINE static void AccumulateMAC(GTEVector* hi, GTEVector* lo, GTEVector product, VectorFlags* flags)
+{
+  const GTEVector sum = VectorAdd(*lo, product);
+  const GTEVector carry = VectorShiftRight<12>(sum);
+  const GTEVector new_hi = VectorAdd(*hi, carry);
+  const GTEVector wrapped = VectorAnd(VectorXor(*hi, new_hi), VectorXor(carry, new_hi));
+  flags->mac_overflow = VectorOr(flags->mac_overflow, VectorAndNot(carry, wrapped));
+  flags->mac_underflow = VectorOr(flags->mac_underflow, VectorAnd(carry, wrapped));
+  *hi = new_hi;
+  *lo = VectorAnd(sum, VectorBroadcast(0xFFF));
+}
+
+// Returns the low 32 bits of the split MAC values SAR (sf*12).
+ALWAYS_INLINE static GTEVector ShiftMAC(GTEVector hi, GTEVector lo, u8 shift)
+{
+  return shift ? hi : VectorOr(VectorShiftLeft<12>(hi), lo);
+}
+
+// Vectorized TruncateAndSetMACAndIR() for MAC1-3, returns IR.
+ALWAYS_INLINE static GTEVector SetMACAndIR(GTEVector mac, bool lm, VectorFlags* flags)
+{
+  GTEVector saturated;
+  const GTEVector ir = VectorClamp(mac, lm ? 0 : IR123_MIN_VALUE, IR123_MAX_VALUE, &saturated);
+  VectorStore(&REGS.dr32[25], mac);
+  VectorStore(&REGS.dr32[9], ir);
+  flags->ir_saturated = VectorOr(flags->ir_saturated, saturated);
+  return ir;
+}
+
+// [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (T*1000h + M*V) SAR (sf*12), returns IR.
+ALWAYS_INLINE static GTEVector VectorMulMatVec(const s16 M[3][3], GTEVector T, GTEVertex V, u8 shift, bool lm,
+                                               VectorFlags* flags)
+{
+  GTEVector products[3];
+  GetMatVecProducts(M, V, products);
+
+  GTEVector hi = T, lo = VectorZero();
+  AccumulateMAC(&hi, &lo, products[0], flags);
+  AccumulateMAC(&hi, &lo, products[1], flags);
+  AccumulateMAC(&hi, &lo, products[2], flags);
+  return SetMACAndIR(ShiftMAC(hi, lo, shift), lm, flags);
+}
+
+// [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4
+ALWAYS_INLINE static GTEVector VectorMulColorIR(GTEVector ir)
+{
+  // The products are at most 28 bits, so this can't overflow.
+  return VectorShiftLeft<4>(VectorMulColor(ir, REGS.dr32[6]));
+}
+
+ALWAYS_INLINE static void VectorInterpolateColor(GTEVector in_MAC, u8 shift, bool lm, VectorFlags* flags)
+{
+  // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
+  //   [IR1,IR2,IR3] = (([RFC,GFC,BFC] SHL 12) - [MAC1,MAC2,MAC3]) SAR (sf*12)
+  GTEVector hi = VectorLoad(REGS.FC), lo = VectorZero();
+  AccumulateMAC(&hi, &lo, VectorSub(VectorZero(), in_MAC), flags);
+  const GTEVector ir = SetMACAndIR(ShiftMAC(hi, lo, shift), false, flags);
+
+  //   [MAC1,MAC2,MAC3] = (([IR1,IR2,IR3] * IR0) + [MAC1,MAC2,MAC3])
+  // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)
+  // The input MAC is at most 28 bits, so this can't overflow.
+  const GTEVector value = VectorAdd(VectorMul16(ir, REGS.IR0), in_MAC);
+  SetMACAndIR(shift ? VectorShiftRight<12>(value) : value, lm, flags);
+}
+
+#endif
+
+template<bool vectorized>
 static void MulMatVec(const s16 M[3][3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
 {
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  if constexpr (vectorized)
+  {
+    VectorFlags flags;
+    VectorMulMatVec(M, VectorZero(), VertexFromComponents(Vx, Vy, Vz), shift, lm, &flags);
+    UpdateFlags(flags);
+  }
+  else
+#endif
+  {
 #define dot3(i)                                                                                                        \
   TruncateAndSetMACAndIR<i + 1>(SignExtendMACResult<i + 1>((s64(M[i][0]) * s64(Vx)) + (s64(M[i][1]) * s64(Vy))) +      \
                                   (s64(M[i][2]) * s64(Vz)),                                                            \
                                 shift, lm)
 
-  dot3(0);
-  dot3(1);
-  dot3(2);
+    dot3(0);
+    dot3(1);
+    dot3(2);
 
 #undef dot3
+  }
 }
 
+template<bool vectorized>
 static void MulMatVec(const s16 M[3][3], const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift, bool lm)
 {
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  if constexpr (vectorized)
+  {
+    VectorFlags flags;
+    VectorMulMatVec(M, VectorLoad(T), VertexFromComponents(Vx, Vy, Vz), shift, lm, &flags);
+    UpdateFlags(flags);
+  }
+  else
+#endif
+  {
 #define dot3(i)                                                                                                        \
   TruncateAndSetMACAndIR<i + 1>(                                                                                       \
     SignExtendMACResult<i + 1>(SignExtendMACResult<i + 1>((s64(T[i]) << 12) + (s64(M[i][0]) * s64(Vx))) +              \
@@ -433,11 +860,12 @@ static void MulMatVec(const s16 M[3][3], const s32 T[3], const s16 Vx, const s16
       (s64(M[i][2]) * s64(Vz)),                                                                                        \
     shift, lm)
 
-  dot3(0);
-  dot3(1);
-  dot3(2);
+    dot3(0);
+    dot3(1);
+    dot3(2);
 
 #undef dot3
+  }
 }
 
 static void MulMatVecBuggy(const s16 M[3][3], const s32 T[3], const s16 Vx, const s16 Vy, const s16 Vz, u8 shift,
@@ -461,35 +889,38 @@ static void MulMatVecBuggy(const s16 M[3][3], const s32 T[3], const s16 Vx, cons
 #undef dot3
 }
 
+template<bool vectorized>
 static void Execute_MVMVA(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  // TODO: Remove memcpy..
-  s16 M[3][3];
+  // The garbage matrix has an extra row, as MulMatVec() can read past the end of the matrix.
+  s16 garbage_M[4][3];
+  const s16(*M)[3];
   switch (inst.mvmva_multiply_matrix)
   {
     case 0:
-      std::memcpy(M, REGS.RT, sizeof(s16) * 3 * 3);
+      M = REGS.RT;
       break;
     case 1:
-      std::memcpy(M, REGS.LLM, sizeof(s16) * 3 * 3);
+      M = REGS.LLM;
       break;
     case 2:
-      std::memcpy(M, REGS.LCM, sizeof(s16) * 3 * 3);
+      M = REGS.LCM;
       break;
     default:
     {
       // buggy
-      M[0][0] = -static_cast<s16>(ZeroExtend16(REGS.RGBC[0]) << 4);
-      M[0][1] = static_cast<s16>(ZeroExtend16(REGS.RGBC[0]) << 4);
-      M[0][2] = REGS.IR0;
-      M[1][0] = REGS.RT[0][2];
-      M[1][1] = REGS.RT[0][2];
-      M[1][2] = REGS.RT[0][2];
-      M[2][0] = REGS.RT[1][1];
-      M[2][1] = REGS.RT[1][1];
-      M[2][2] = REGS.RT[1][1];
+      garbage_M[0][0] = -static_cast<s16>(ZeroExtend16(REGS.RGBC[0]) << 4);
+      garbage_M[0][1] = static_cast<s16>(ZeroExtend16(REGS.RGBC[0]) << 4);
+      garbage_M[0][2] = REGS.IR0;
+      garbage_M[1][0] = REGS.RT[0][2];
+      garbage_M[1][1] = REGS.RT[0][2];
+      garbage_M[1][2] = REGS.RT[0][2];
+      garbage_M[2][0] = REGS.RT[1][1];
+      garbage_M[2][1] = REGS.RT[1][1];
+      garbage_M[2][2] = REGS.RT[1][1];
+      M = garbage_M;
     }
     break;
   }
@@ -519,20 +950,19 @@ static void Execute_MVMVA(Instruction inst)
       break;
   }
 
-  static const s32 zero_T[3] = {};
   switch (inst.mvmva_translation_vector)
   {
     case 0:
-      MulMatVec(M, REGS.TR, Vx, Vy, Vz, inst.GetShift(), inst.lm);
+      MulMatVec<vectorized>(M, REGS.TR, Vx, Vy, Vz, inst.GetShift(), inst.lm);
       break;
     case 1:
-      MulMatVec(M, REGS.BK, Vx, Vy, Vz, inst.GetShift(), inst.lm);
+      MulMatVec<vectorized>(M, REGS.BK, Vx, Vy, Vz, inst.GetShift(), inst.lm);
       break;
     case 2:
       MulMatVecBuggy(M, REGS.FC, Vx, Vy, Vz, inst.GetShift(), inst.lm);
       break;
     default:
-      MulMatVec(M, zero_T, Vx, Vy, Vz, inst.GetShift(), inst.lm);
+      MulMatVec<vectorized>(M, Vx, Vy, Vz, inst.GetShift(), inst.lm);
       break;
   }
 
@@ -580,6 +1010,7 @@ static void Execute_OP(Instruction inst)
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void RTPS(const s16 V[3], u8 shift, bool lm, bool last)
 {
 #define dot3(i)                                                                                                        \
@@ -590,24 +1021,55 @@ static void RTPS(const s16 V[3], u8 shift, bool lm, bool last)
   // IR1 = MAC1 = (TRX*1000h + RT11*VX0 + RT12*VY0 + RT13*VZ0) SAR (sf*12)
   // IR2 = MAC2 = (TRY*1000h + RT21*VX0 + RT22*VY0 + RT23*VZ0) SAR (sf*12)
   // IR3 = MAC3 = (TRZ*1000h + RT31*VX0 + RT32*VY0 + RT33*VZ0) SAR (sf*12)
-  const s64 x = dot3(0);
-  const s64 y = dot3(1);
-  const s64 z = dot3(2);
-  TruncateAndSetMAC<1>(x, shift);
-  TruncateAndSetMAC<2>(y, shift);
-  TruncateAndSetMAC<3>(z, shift);
-  TruncateAndSetIR<1>(REGS.MAC1, lm);
-  TruncateAndSetIR<2>(REGS.MAC2, lm);
-
+  //
   // The command does saturate IR1,IR2,IR3 to -8000h..+7FFFh (regardless of lm bit). When using RTP with sf=0, then the
   // IR3 saturation flag (FLAG.22) gets set <only> if "MAC3 SAR 12" exceeds -8000h..+7FFFh (although IR3 is saturated
   // when "MAC3" exceeds -8000h..+7FFFh).
-  TruncateAndSetIR<3>(s32(z >> 12), false);
-  REGS.dr32[11] = std::clamp(REGS.MAC3, lm ? 0 : IR123_MIN_VALUE, IR123_MAX_VALUE);
+  //
+  // PGXP needs the full-precision results, which the vectorized path doesn't produce.
+  const bool precise = !vectorized || (g_settings.gpu_pgxp_enable && g_settings.gpu_pgxp_preserve_proj_fp);
+  s64 x = 0, y = 0, z = 0;
+  s32 z_sar_12;
+  if (precise)
+  {
+    x = dot3(0);
+    y = dot3(1);
+    z = dot3(2);
+    TruncateAndSetMAC<1>(x, shift);
+    TruncateAndSetMAC<2>(y, shift);
+    TruncateAndSetMAC<3>(z, shift);
+    TruncateAndSetIR<1>(REGS.MAC1, lm);
+    TruncateAndSetIR<2>(REGS.MAC2, lm);
+    TruncateAndSetIR<3>(s32(z >> 12), false);
+    REGS.dr32[11] = std::clamp(REGS.MAC3, lm ? 0 : IR123_MIN_VALUE, IR123_MAX_VALUE);
+    z_sar_12 = s32(z >> 12);
+  }
+  else
+  {
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+    GTEVector products[3];
+    GetMatVecProducts(REGS.RT, LoadVertex(V), products);
+
+    VectorFlags flags;
+    GTEVector hi = VectorLoad(REGS.TR), lo = VectorZero();
+    AccumulateMAC(&hi, &lo, products[0], &flags);
+    AccumulateMAC(&hi, &lo, products[1], &flags);
+    AccumulateMAC(&hi, &lo, products[2], &flags);
+    SetMACAndIR(ShiftMAC(hi, lo, shift), lm, &flags);
+
+    // IR3's saturation flag comes from MAC3 SAR 12 instead, which is the hi part.
+    GTEVector z_saturated;
+    VectorClamp(hi, IR123_MIN_VALUE, IR123_MAX_VALUE, &z_saturated);
+    const GTEVector z_lane = VectorSet(0, 0, -1);
+    flags.ir_saturated = VectorOr(VectorAndNot(z_lane, flags.ir_saturated), VectorAnd(z_lane, z_saturated));
+    UpdateFlags(flags);
+    z_sar_12 = VectorGetZ(hi);
+#endif
+  }
 #undef dot3
 
   // SZ3 = MAC3 SAR ((1-sf)*12)                           ;ScreenZ FIFO 0..+FFFFh
-  PushSZ(s32(z >> 12));
+  PushSZ(z_sar_12);
 
   // MAC0=(((H*20000h/SZ3)+1)/2)*IR1+OFX, SX2=MAC0/10000h ;ScrX FIFO -400h..+3FFh
   // MAC0=(((H*20000h/SZ3)+1)/2)*IR2+OFY, SY2=MAC0/10000h ;ScrY FIFO -400h..+3FFh
@@ -793,13 +1255,15 @@ static void RTPS(const s16 V[3], u8 shift, bool lm, bool last)
   }
 }
 
+template<bool vectorized>
 static void Execute_RTPS(Instruction inst)
 {
   REGS.FLAG.Clear();
-  RTPS(REGS.V0, inst.GetShift(), inst.lm, true);
+  RTPS<vectorized>(REGS.V0, inst.GetShift(), inst.lm, true);
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_RTPT(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -807,9 +1271,9 @@ static void Execute_RTPT(Instruction inst)
   const u8 shift = inst.GetShift();
   const bool lm = inst.lm;
 
-  RTPS(REGS.V0, shift, lm, false);
-  RTPS(REGS.V1, shift, lm, false);
-  RTPS(REGS.V2, shift, lm, true);
+  RTPS<vectorized>(REGS.V0, shift, lm, false);
+  RTPS<vectorized>(REGS.V1, shift, lm, false);
+  RTPS<vectorized>(REGS.V2, shift, lm, true);
 
   REGS.FLAG.UpdateError();
 }
@@ -862,42 +1326,68 @@ static void Execute_AVSZ4(Instruction inst)
   REGS.FLAG.UpdateError();
 }
 
-static ALWAYS_INLINE void InterpolateColor(s64 in_MAC1, s64 in_MAC2, s64 in_MAC3, u8 shift, bool lm)
+template<bool vectorized>
+static ALWAYS_INLINE void InterpolateColor(s32 in_MAC1, s32 in_MAC2, s32 in_MAC3, u8 shift, bool lm)
 {
-  // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
-  //   [IR1,IR2,IR3] = (([RFC,GFC,BFC] SHL 12) - [MAC1,MAC2,MAC3]) SAR (sf*12)
-  TruncateAndSetMACAndIR<1>((s64(REGS.FC[0]) << 12) - in_MAC1, shift, false);
-  TruncateAndSetMACAndIR<2>((s64(REGS.FC[1]) << 12) - in_MAC2, shift, false);
-  TruncateAndSetMACAndIR<3>((s64(REGS.FC[2]) << 12) - in_MAC3, shift, false);
-
-  //   [MAC1,MAC2,MAC3] = (([IR1,IR2,IR3] * IR0) + [MAC1,MAC2,MAC3])
-  // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)
-  TruncateAndSetMACAndIR<1>(s64(s32(REGS.IR1) * s32(REGS.IR0)) + in_MAC1, shift, lm);
-  TruncateAndSetMACAndIR<2>(s64(s32(REGS.IR2) * s32(REGS.IR0)) + in_MAC2, shift, lm);
-  TruncateAndSetMACAndIR<3>(s64(s32(REGS.IR3) * s32(REGS.IR0)) + in_MAC3, shift, lm);
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  if constexpr (vectorized)
+  {
+    VectorFlags flags;
+    VectorInterpolateColor(VectorSet(in_MAC1, in_MAC2, in_MAC3), shift, lm, &flags);
+    UpdateFlags(flags);
+  }
+  else
+#endif
+  {
+    // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
+    //   [IR1,IR2,IR3] = (([RFC,GFC,BFC] SHL 12) - [MAC1,MAC2,MAC3]) SAR (sf*12)
+    TruncateAndSetMACAndIR<1>((s64(REGS.FC[0]) << 12) - in_MAC1, shift, false);
+    TruncateAndSetMACAndIR<2>((s64(REGS.FC[1]) << 12) - in_MAC2, shift, false);
+    TruncateAndSetMACAndIR<3>((s64(REGS.FC[2]) << 12) - in_MAC3, shift, false);
+
+    //   [MAC1,MAC2,MAC3] = (([IR1,IR2,IR3] * IR0) + [MAC1,MAC2,MAC3])
+    // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)
+    TruncateAndSetMACAndIR<1>(s64(s32(REGS.IR1) * s32(REGS.IR0)) + in_MAC1, shift, lm);
+    TruncateAndSetMACAndIR<2>(s64(s32(REGS.IR2) * s32(REGS.IR0)) + in_MAC2, shift, lm);
+    TruncateAndSetMACAndIR<3>(s64(s32(REGS.IR3) * s32(REGS.IR0)) + in_MAC3, shift, lm);
+  }
 }
 
+template<bool vectorized>
 static void NCS(const s16 V[3], u8 shift, bool lm)
 {
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
-  MulMatVec(REGS.LLM, V[0], V[1], V[2], shift, lm);
-
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
-  MulMatVec(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  if constexpr (vectorized)
+  {
+    VectorFlags flags;
+    const GTEVector ir = VectorMulMatVec(REGS.LLM, VectorZero(), LoadVertex(V), shift, lm, &flags);
+    VectorMulMatVec(REGS.LCM, VectorLoad(REGS.BK), VertexFromIR(ir), shift, lm, &flags);
+    UpdateFlags(flags);
+  }
+  else
+#endif
+  {
+    MulMatVec<vectorized>(REGS.LLM, V[0], V[1], V[2], shift, lm);
+    MulMatVec<vectorized>(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
+  }
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
 }
 
+template<bool vectorized>
 static void Execute_NCS(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  NCS(REGS.V0, inst.GetShift(), inst.lm);
+  NCS<vectorized>(REGS.V0, inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_NCT(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -905,40 +1395,55 @@ static void Execute_NCT(Instruction inst)
   const u8 shift = inst.GetShift();
   const bool lm = inst.lm;
 
-  NCS(REGS.V0, shift, lm);
-  NCS(REGS.V1, shift, lm);
-  NCS(REGS.V2, shift, lm);
+  NCS<vectorized>(REGS.V0, shift, lm);
+  NCS<vectorized>(REGS.V1, shift, lm);
+  NCS<vectorized>(REGS.V2, shift, lm);
 
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void NCCS(const s16 V[3], u8 shift, bool lm)
 {
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
-  MulMatVec(REGS.LLM, V[0], V[1], V[2], shift, lm);
-
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
-  MulMatVec(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
-
   // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
   // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)       ;<--- for NCDx/NCCx
-  TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4, shift, lm);
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  if constexpr (vectorized)
+  {
+    VectorFlags flags;
+    GTEVector ir = VectorMulMatVec(REGS.LLM, VectorZero(), LoadVertex(V), shift, lm, &flags);
+    ir = VectorMulMatVec(REGS.LCM, VectorLoad(REGS.BK), VertexFromIR(ir), shift, lm, &flags);
+    const GTEVector value = VectorMulColorIR(ir);
+    SetMACAndIR(shift ? VectorShiftRight<12>(value) : value, lm, &flags);
+    UpdateFlags(flags);
+  }
+  else
+#endif
+  {
+    MulMatVec<vectorized>(REGS.LLM, V[0], V[1], V[2], shift, lm);
+    MulMatVec<vectorized>(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
+    TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4, shift, lm);
+    TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4, shift, lm);
+    TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4, shift, lm);
+  }
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
 }
 
+template<bool vectorized>
 static void Execute_NCCS(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  NCCS(REGS.V0, inst.GetShift(), inst.lm);
+  NCCS<vectorized>(REGS.V0, inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_NCCT(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -946,43 +1451,57 @@ static void Execute_NCCT(Instruction inst)
   const u8 shift = inst.GetShift();
   const bool lm = inst.lm;
 
-  NCCS(REGS.V0, shift, lm);
-  NCCS(REGS.V1, shift, lm);
-  NCCS(REGS.V2, shift, lm);
+  NCCS<vectorized>(REGS.V0, shift, lm);
+  NCCS<vectorized>(REGS.V1, shift, lm);
+  NCCS<vectorized>(REGS.V2, shift, lm);
 
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void NCDS(const s16 V[3], u8 shift, bool lm)
 {
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (LLM*V0) SAR (sf*12)
-  MulMatVec(REGS.LLM, V[0], V[1], V[2], shift, lm);
-
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
-  MulMatVec(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
-
   // No need to assign these to MAC[1-3], as it'll never overflow.
   // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4          ;<--- for NCDx/NCCx
-  const s32 in_MAC1 = (s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4;
-  const s32 in_MAC2 = (s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4;
-  const s32 in_MAC3 = (s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4;
-
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0                   ;<--- for NCDx only
-  InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  if constexpr (vectorized)
+  {
+    VectorFlags flags;
+    GTEVector ir = VectorMulMatVec(REGS.LLM, VectorZero(), LoadVertex(V), shift, lm, &flags);
+    ir = VectorMulMatVec(REGS.LCM, VectorLoad(REGS.BK), VertexFromIR(ir), shift, lm, &flags);
+    VectorInterpolateColor(VectorMulColorIR(ir), shift, lm, &flags);
+    UpdateFlags(flags);
+  }
+  else
+#endif
+  {
+    MulMatVec<vectorized>(REGS.LLM, V[0], V[1], V[2], shift, lm);
+    MulMatVec<vectorized>(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
+
+    const s32 in_MAC1 = (s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4;
+    const s32 in_MAC2 = (s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4;
+    const s32 in_MAC3 = (s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4;
+    InterpolateColor<vectorized>(in_MAC1, in_MAC2, in_MAC3, shift, lm);
+  }
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
 }
 
+template<bool vectorized>
 static void Execute_NCDS(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  NCDS(REGS.V0, inst.GetShift(), inst.lm);
+  NCDS<vectorized>(REGS.V0, inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_NCDT(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -990,13 +1509,14 @@ static void Execute_NCDT(Instruction inst)
   const u8 shift = inst.GetShift();
   const bool lm = inst.lm;
 
-  NCDS(REGS.V0, shift, lm);
-  NCDS(REGS.V1, shift, lm);
-  NCDS(REGS.V2, shift, lm);
+  NCDS<vectorized>(REGS.V0, shift, lm);
+  NCDS<vectorized>(REGS.V1, shift, lm);
+  NCDS<vectorized>(REGS.V2, shift, lm);
 
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_CC(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -1005,13 +1525,26 @@ static void Execute_CC(Instruction inst)
   const bool lm = inst.lm;
 
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
-  MulMatVec(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
-
   // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4
   // [MAC1,MAC2,MAC3] = [MAC1,MAC2,MAC3] SAR (sf*12)
-  TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4, shift, lm);
-  TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4, shift, lm);
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  if constexpr (vectorized)
+  {
+    const GTEVertex V = VertexFromComponents(REGS.IR1, REGS.IR2, REGS.IR3);
+    VectorFlags flags;
+    const GTEVector ir = VectorMulMatVec(REGS.LCM, VectorLoad(REGS.BK), V, shift, lm, &flags);
+    const GTEVector value = VectorMulColorIR(ir);
+    SetMACAndIR(shift ? VectorShiftRight<12>(value) : value, lm, &flags);
+    UpdateFlags(flags);
+  }
+  else
+#endif
+  {
+    MulMatVec<vectorized>(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
+    TruncateAndSetMACAndIR<1>(s64(s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4, shift, lm);
+    TruncateAndSetMACAndIR<2>(s64(s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4, shift, lm);
+    TruncateAndSetMACAndIR<3>(s64(s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4, shift, lm);
+  }
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
@@ -1019,6 +1552,7 @@ static void Execute_CC(Instruction inst)
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_CDP(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -1027,17 +1561,29 @@ static void Execute_CDP(Instruction inst)
   const bool lm = inst.lm;
 
   // [IR1,IR2,IR3] = [MAC1,MAC2,MAC3] = (BK*1000h + LCM*IR) SAR (sf*12)
-  MulMatVec(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
-
   // No need to assign these to MAC[1-3], as it'll never overflow.
   // [MAC1,MAC2,MAC3] = [R*IR1,G*IR2,B*IR3] SHL 4
-  const s32 in_MAC1 = (s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4;
-  const s32 in_MAC2 = (s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4;
-  const s32 in_MAC3 = (s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4;
-
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0                   ;<--- for CDP only
   // [MAC1, MAC2, MAC3] = [MAC1, MAC2, MAC3] SAR(sf * 12)
-  InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  if constexpr (vectorized)
+  {
+    const GTEVertex V = VertexFromComponents(REGS.IR1, REGS.IR2, REGS.IR3);
+    VectorFlags flags;
+    const GTEVector ir = VectorMulMatVec(REGS.LCM, VectorLoad(REGS.BK), V, shift, lm, &flags);
+    VectorInterpolateColor(VectorMulColorIR(ir), shift, lm, &flags);
+    UpdateFlags(flags);
+  }
+  else
+#endif
+  {
+    MulMatVec<vectorized>(REGS.LCM, REGS.BK, REGS.IR1, REGS.IR2, REGS.IR3, shift, lm);
+
+    const s32 in_MAC1 = (s32(ZeroExtend32(REGS.RGBC[0])) * s32(REGS.IR1)) << 4;
+    const s32 in_MAC2 = (s32(ZeroExtend32(REGS.RGBC[1])) * s32(REGS.IR2)) << 4;
+    const s32 in_MAC3 = (s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4;
+    InterpolateColor<vectorized>(in_MAC1, in_MAC2, in_MAC3, shift, lm);
+  }
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
@@ -1045,6 +1591,7 @@ static void Execute_CDP(Instruction inst)
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void DPCS(const u8 color[3], u8 shift, bool lm)
 {
   // In: [IR1,IR2,IR3]=Vector, FC=Far Color, IR0=Interpolation value, CODE=MSB of RGBC
@@ -1054,21 +1601,23 @@ static void DPCS(const u8 color[3], u8 shift, bool lm)
   TruncateAndSetMAC<3>((s64(ZeroExtend64(color[2])) << 16), 0);
 
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
-  InterpolateColor(REGS.MAC1, REGS.MAC2, REGS.MAC3, shift, lm);
+  InterpolateColor<vectorized>(REGS.MAC1, REGS.MAC2, REGS.MAC3, shift, lm);
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
 }
 
+template<bool vectorized>
 static void Execute_DPCS(Instruction inst)
 {
   REGS.FLAG.Clear();
 
-  DPCS(REGS.RGBC, inst.GetShift(), inst.lm);
+  DPCS<vectorized>(REGS.RGBC, inst.GetShift(), inst.lm);
 
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_DPCT(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -1077,11 +1626,12 @@ static void Execute_DPCT(Instruction inst)
   const bool lm = inst.lm;
 
   for (u32 i = 0; i < 3; i++)
-    DPCS(REGS.RGB0, shift, lm);
+    DPCS<vectorized>(REGS.RGB0, shift, lm);
 
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_DCPL(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -1096,7 +1646,7 @@ static void Execute_DCPL(Instruction inst)
   const s32 in_MAC3 = (s32(ZeroExtend32(REGS.RGBC[2])) * s32(REGS.IR3)) << 4;
 
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
-  InterpolateColor(in_MAC1, in_MAC2, in_MAC3, shift, lm);
+  InterpolateColor<vectorized>(in_MAC1, in_MAC2, in_MAC3, shift, lm);
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
@@ -1104,6 +1654,7 @@ static void Execute_DCPL(Instruction inst)
   REGS.FLAG.UpdateError();
 }
 
+template<bool vectorized>
 static void Execute_INTPL(Instruction inst)
 {
   REGS.FLAG.Clear();
@@ -1114,7 +1665,7 @@ static void Execute_INTPL(Instruction inst)
   // No need to assign these to MAC[1-3], as it'll never overflow.
   // [MAC1,MAC2,MAC3] = [IR1,IR2,IR3] SHL 12               ;<--- for INTPL only
   // [MAC1,MAC2,MAC3] = MAC+(FC-MAC)*IR0
-  InterpolateColor(s32(REGS.IR1) << 12, s32(REGS.IR2) << 12, s32(REGS.IR3) << 12, shift, lm);
+  InterpolateColor<vectorized>(s32(REGS.IR1) << 12, s32(REGS.IR2) << 12, s32(REGS.IR3) << 12, shift, lm);
 
   // Color FIFO = [MAC1/16,MAC2/16,MAC3/16,CODE], [IR1,IR2,IR3] = [MAC1,MAC2,MAC3]
   PushRGBFromMAC();
@@ -1160,13 +1711,13 @@ static void Execute_GPF(Instruction inst)
   REGS.FLAG.UpdateError();
 }
 
-void ExecuteInstruction(u32 inst_bits)
+template<bool vectorized>
+static void ExecuteInstructionImpl(Instruction inst)
 {
-  const Instruction inst{inst_bits};
   switch (inst.command)
   {
     case 0x01:
-      Execute_RTPS(inst);
+      Execute_RTPS<vectorized>(inst);
       break;
 
     case 0x06:
@@ -1183,43 +1734,43 @@ void ExecuteInstruction(u32 inst_bits)
       break;
 
     case 0x10:
-      Execute_DPCS(inst);
+      Execute_DPCS<vectorized>(inst);
       break;
 
     case 0x11:
-      Execute_INTPL(inst);
+      Execute_INTPL<vectorized>(inst);
       break;
 
     case 0x12:
-      Execute_MVMVA(inst);
+      Execute_MVMVA<vectorized>(inst);
       break;
 
     case 0x13:
-      Execute_NCDS(inst);
+      Execute_NCDS<vectorized>(inst);
       break;
 
     case 0x14:
-      Execute_CDP(inst);
+      Execute_CDP<vectorized>(inst);
       break;
 
     case 0x16:
-      Execute_NCDT(inst);
+      Execute_NCDT<vectorized>(inst);
       break;
 
     case 0x1B:
-      Execute_NCCS(inst);
+      Execute_NCCS<vectorized>(inst);
       break;
 
     case 0x1C:
-      Execute_CC(inst);
+      Execute_CC<vectorized>(inst);
       break;
 
     case 0x1E:
-      Execute_NCS(inst);
+      Execute_NCS<vectorized>(inst);
       break;
 
     case 0x20:
-      Execute_NCT(inst);
+      Execute_NCT<vectorized>(inst);
       break;
 
     case 0x28:
@@ -1227,11 +1778,11 @@ void ExecuteInstruction(u32 inst_bits)
       break;
 
     case 0x29:
-      Execute_DCPL(inst);
+      Execute_DCPL<vectorized>(inst);
       break;
 
     case 0x2A:
-      Execute_DPCT(inst);
+      Execute_DPCT<vectorized>(inst);
       break;
 
     case 0x2D:
@@ -1243,7 +1794,7 @@ void ExecuteInstruction(u32 inst_bits)
       break;
 
     case 0x30:
-      Execute_RTPT(inst);
+      Execute_RTPT<vectorized>(inst);
       break;
 
     case 0x3D:
@@ -1255,7 +1806,7 @@ void ExecuteInstruction(u32 inst_bits)
       break;
 
     case 0x3F:
-      Execute_NCCT(inst);
+      Execute_NCCT<vectorized>(inst);
       break;
 
     default:
@@ -1264,13 +1815,28 @@ void ExecuteInstruction(u32 inst_bits)
   }
 }
 
+void ExecuteInstruction(u32 inst_bits)
+{
+  ExecuteInstructionImpl<USE_VECTOR_KERNELS>(Instruction{inst_bits});
+}
+
+void ExecuteInstructionScalar(u32 inst_bits)
+{
+  ExecuteInstructionImpl<false>(Instruction{inst_bits});
+}
+
+const u8* GetUNRTable()
+{
+  return s_unr_table.data();
+}
+
 InstructionImpl GetInstructionImpl(u32 inst_bits)
 {
   const Instruction inst{inst_bits};
   switch (inst.command)
   {
     case 0x01:
-      return &Execute_RTPS;
+      return &Execute_RTPS<USE_VECTOR_KERNELS>;
 
     case 0x06:
     {
@@ -1284,43 +1850,43 @@ InstructionImpl GetInstructionImpl(u32 inst_bits)
       return &Execute_OP;
 
     case 0x10:
-      return &Execute_DPCS;
+      return &Execute_DPCS<USE_VECTOR_KERNELS>;
 
     case 0x11:
-      return &Execute_INTPL;
+      return &Execute_INTPL<USE_VECTOR_KERNELS>;
 
     case 0x12:
-      return &Execute_MVMVA;
+      return &Execute_MVMVA<USE_VECTOR_KERNELS>;
 
     case 0x13:
-      return &Execute_NCDS;
+      return &Execute_NCDS<USE_VECTOR_KERNELS>;
 
     case 0x14:
-      return &Execute_CDP;
+      return &Execute_CDP<USE_VECTOR_KERNELS>;
 
     case 0x16:
-      return &Execute_NCDT;
+      return &Execute_NCDT<USE_VECTOR_KERNELS>;
 
     case 0x1B:
-      return &Execute_NCCS;
+      return &Execute_NCCS<USE_VECTOR_KERNELS>;
 
     case 0x1C:
-      return &Execute_CC;
+      return &Execute_CC<USE_VECTOR_KERNELS>;
 
     case 0x1E:
-      return &Execute_NCS;
+      return &Execute_NCS<USE_VECTOR_KERNELS>;
 
     case 0x20:
-      return &Execute_NCT;
+      return &Execute_NCT<USE_VECTOR_KERNELS>;
 
     case 0x28:
       return &Execute_SQR;
 
     case 0x29:
-      return &Execute_DCPL;
+      return &Execute_DCPL<USE_VECTOR_KERNELS>;
 
     case 0x2A:
-      return &Execute_DPCT;
+      return &Execute_DPCT<USE_VECTOR_KERNELS>;
 
     case 0x2D:
       return &Execute_AVSZ3;
@@ -1329,7 +1895,7 @@ InstructionImpl GetInstructionImpl(u32 inst_bits)
       return &Execute_AVSZ4;
 
     case 0x30:
-      return &Execute_RTPT;
+      return &Execute_RTPT<USE_VECTOR_KERNELS>;
 
     case 0x3D:
       return &Execute_GPF;
@@ -1338,7 +1904,7 @@ InstructionImpl GetInstructionImpl(u32 inst_bits)
       return &Execute_GPL;
 
     case 0x3F:
-      return &Execute_NCCT;
+      return &Execute_NCCT<USE_VECTOR_KERNELS>;
 
     default:
       Panic("Missing handler");
@@ -18,7 +18,13 @@ u32* GetRegisterPtr(u32 index);
 
 void ExecuteInstruction(u32 inst_bits);
 
+// executes without the vectorized kernels, used to check them against the scalar implementation
+void ExecuteInstructionScalar(u32 inst_bits);
+
 using InstructionImpl = void (*)(Instruction);
 InstructionImpl GetInstructionImpl(u32 inst_bits);
 
+// reciprocal table for the RTPS/RTPT division, for code which implements it inline
+const u8* GetUNRTable();
+
 } // namespace GTE
@@ -38,10 +38,31 @@ union FLAGS
 
   static constexpr u32 WRITE_MASK = UINT32_C(0xFFFFF000);
 
+  // Bits 30..23, 18..13 OR'ed
+  static constexpr u32 ERROR_MASK = UINT32_C(0x7F87E000);
+
+  static constexpr u32 SZ1_OTZ_SATURATED = UINT32_C(1) << 18;
+  static constexpr u32 DIVIDE_OVERFLOW = UINT32_C(1) << 17;
+  static constexpr u32 SX2_SATURATED = UINT32_C(1) << 14;
+  static constexpr u32 SY2_SATURATED = UINT32_C(1) << 13;
+
+  // Masks for the indexed bits, used when the register value is built directly (e.g. by the recompiler).
+  static constexpr u32 GetMACOverflowBit(u32 index)
+  {
+    return (index == 0) ? (UINT32_C(1) << 16) : (UINT32_C(1) << (31 - index));
+  }
+  static constexpr u32 GetMACUnderflowBit(u32 index)
+  {
+    return (index == 0) ? (UINT32_C(1) << 15) : (UINT32_C(1) << (28 - index));
+  }
+  static constexpr u32 GetIRSaturatedBit(u32 index)
+  {
+    return (index == 0) ? (UINT32_C(1) << 12) : (UINT32_C(1) << (25 - index));
+  }
+
   ALWAYS_INLINE void Clear() { bits = 0; }
 
-  // Bits 30..23, 18..13 OR'ed
-  ALWAYS_INLINE void UpdateError() { error = (bits & UINT32_C(0x7F87E000)) != UINT32_C(0); }
+  ALWAYS_INLINE void UpdateError() { error = (bits & ERROR_MASK) != UINT32_C(0); }
 };
 
 union Regs
@@ -16,6 +16,7 @@
 #include "host_display.h"
 #include "pgxp.h"
 #include "save_state_version.h"
+#include "save_state_writer.h"
 #include "system.h"
 #include "texture_replacements.h"
 #include <cmath>
@@ -39,12 +40,14 @@ HostInterface::HostInterface()
   // we can get the program directory at construction time
   const std::string program_path = FileSystem::GetProgramPath();
   m_program_directory = FileSystem::GetPathDirectory(program_path.c_str());
+
+  m_save_state_writer = std::make_unique<SaveStateWriter>();
 }
 
 HostInterface::~HostInterface()
 {
-  // system should be shut down prior to the destructor
-  Assert(System::IsShutdown() && !m_audio_stream && !m_display);
+  // system should be shut down prior to the destructor, and any queued save states written
+  Assert(System::IsShutdown() && !m_audio_stream && !m_display && !m_save_state_writer->HasPendingWrites());
   Assert(g_host_interface == this);
   g_host_interface = nullptr;
 }
@@ -58,6 +61,9 @@ void HostInterface::Shutdown()
 {
   if (!System::IsShutdown())
     System::Shutdown();
+
+  // make sure save-on-exit states hit the disk
+  m_save_state_writer->WaitForPendingWrites();
 }
 
 void HostInterface::CreateAudioStream()
@@ -402,6 +408,9 @@ bool HostInterface::HasAnyBIOSImages()
 
 bool HostInterface::LoadState(const char* filename)
 {
+  // the state we're loading could still be in the process of being written
+  m_save_state_writer->WaitForPendingWrites();
+
   std::unique_ptr<ByteStream> stream = FileSystem::OpenFile(filename, BYTESTREAM_OPEN_READ | BYTESTREAM_OPEN_STREAMED);
   if (!stream)
     return false;
@@ -429,27 +438,31 @@ bool HostInterface::LoadState(const char* filename)
   return true;
 }
 
-bool HostInterface::SaveState(const char* filename)
+bool HostInterface::SaveState(const char* filename, std::function<void(bool)> callback /* = {} */)
 {
-  std::unique_ptr<ByteStream> stream =
-    FileSystem::OpenFile(filename, BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
-                                     BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
-  if (!stream)
-    return false;
-
-  const bool result = System::SaveState(stream.get());
-  if (!result)
+  // only the snapshot is taken on this thread, compression and file I/O happens on the writer thread
+  std::unique_ptr<GrowableMemoryByteStream> snapshot = m_save_state_writer->GetSnapshotBuffer();
+  if (!System::SaveState(snapshot.get(), 128, false))
   {
     ReportFormattedError(TranslateString("OSDMessage", "Saving state to '%s' failed."), filename);
-    stream->Discard();
-  }
-  else
-  {
-    AddFormattedOSDMessage(5.0f, TranslateString("OSDMessage", "State saved to '%s'."), filename);
-    stream->Commit();
+    m_save_state_writer->ReturnSnapshotBuffer(std::move(snapshot));
+    return false;
   }
 
-  return result;
+  m_save_state_writer->QueueWrite(
+    filename, std::move(snapshot), g_settings.compress_save_states,
+    [this, filename = std::string(filename), callback = std::move(callback)](bool result) {
+      // ReportError() can block on the UI, so failures are reported through the OSD instead
+      if (result)
+        AddFormattedOSDMessage(5.0f, TranslateString("OSDMessage", "State saved to '%s'."), filename.c_str());
+      else
+        AddFormattedOSDMessage(10.0f, TranslateString("OSDMessage", "Saving state to '%s' failed."), filename.c_str());
+
+      if (callback)
+        callback(result);
+    });
+
+  return true;
 }
 
 void HostInterface::OnSystemCreated() {}
@@ -460,7 +473,7 @@ void HostInterface::OnSystemDestroyed() {}
 
 void HostInterface::OnSystemPerformanceCountersUpdated() {}
 
-void HostInterface::OnSystemStateSaved(bool global, s32 slot) {}
+void HostInterface::OnSystemStateSaved(const std::string& game_code, bool global, s32 slot) {}
 
 void HostInterface::OnRunningGameChanged() {}
 
@@ -484,14 +497,23 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetBoolValue("Main", "StartFullscreen", false);
   si.SetBoolValue("Main", "PauseOnFocusLoss", false);
   si.SetBoolValue("Main", "SaveStateOnExit", true);
+  si.SetBoolValue("Main", "CompressSaveStates", true);
   si.SetBoolValue("Main", "ConfirmPowerOff", true);
   si.SetBoolValue("Main", "LoadDevicesFromSaveStates", false);
   si.SetBoolValue("Main", "ApplyGameSettings", true);
   si.SetBoolValue("Main", "DisableAllEnhancements", false);
+  si.SetBoolValue("Main", "RewindEnable", false);
+  si.SetIntValue("Main", "RewindSaveInterval", 1);
+  si.SetIntValue("Main", "RewindSaveSlots", 3600);
+  si.SetIntValue("Main", "RewindMaxMemory", 32);
+  si.SetIntValue("Main", "RunaheadFrameCount", 0);
 
   si.SetStringValue("CPU", "ExecutionMode", Settings::GetCPUExecutionModeName(Settings::DEFAULT_CPU_EXECUTION_MODE));
   si.SetBoolValue("CPU", "RecompilerMemoryExceptions", false);
   si.SetBoolValue("CPU", "ICache", false);
+  si.SetBoolValue("CPU", "RecompilerPersistentCache", false);
+  si.SetBoolValue("CPU", "RecompilerBackgroundCompile", false);
+  si.SetBoolValue("CPU", "RecompilerSuperblocks", false);
   si.SetBoolValue("CPU", "FastmemMode", Settings::GetCPUFastmemModeName(Settings::DEFAULT_CPU_FASTMEM_MODE));
 
   si.SetStringValue("GPU", "Renderer", Settings::GetRendererName(Settings::DEFAULT_GPU_RENDERER));
@@ -500,6 +522,7 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetBoolValue("GPU", "UseDebugDevice", false);
   si.SetBoolValue("GPU", "PerSampleShading", false);
   si.SetBoolValue("GPU", "UseThread", true);
+  si.SetIntValue("GPU", "SoftwareWorkerThreads", 0);
   si.SetBoolValue("GPU", "ThreadedPresentation", true);
   si.SetBoolValue("GPU", "TrueColor", false);
   si.SetBoolValue("GPU", "ScaledDithering", true);
@@ -541,6 +564,7 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetFloatValue("Display", "MaxFPS", 0.0f);
 
   si.SetBoolValue("CDROM", "ReadThread", true);
+  si.SetIntValue("CDROM", "ReadaheadSectors", static_cast<int>(Settings::DEFAULT_CDROM_READAHEAD_SECTORS));
   si.SetBoolValue("CDROM", "RegionCheck", true);
   si.SetBoolValue("CDROM", "LoadImageToRAM", false);
   si.SetBoolValue("CDROM", "MuteCDAudio", false);
@@ -702,7 +726,8 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
       System::UpdateThrottlePeriod();
 
     if (g_settings.cpu_execution_mode != old_settings.cpu_execution_mode ||
-        g_settings.cpu_fastmem_mode != old_settings.cpu_fastmem_mode)
+        g_settings.cpu_fastmem_mode != old_settings.cpu_fastmem_mode ||
+        g_settings.cpu_recompiler_background_compile != old_settings.cpu_recompiler_background_compile)
     {
       AddFormattedOSDMessage(
         5.0f, TranslateString("OSDMessage", "Switching to %s CPU execution mode."),
@@ -722,6 +747,16 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
       CPU::CodeCache::Flush();
     }
 
+    if (g_settings.cpu_execution_mode == CPUExecutionMode::Recompiler &&
+        g_settings.cpu_recompiler_superblocks != old_settings.cpu_recompiler_superblocks)
+    {
+      AddOSDMessage(g_settings.cpu_recompiler_superblocks ?
+                      TranslateStdString("OSDMessage", "CPU superblocks enabled, flushing all blocks.") :
+                      TranslateStdString("OSDMessage", "CPU superblocks disabled, flushing all blocks."),
+                    5.0f);
+      CPU::CodeCache::Flush();
+    }
+
     if (g_settings.cpu_execution_mode != CPUExecutionMode::Interpreter &&
         g_settings.cpu_recompiler_icache != old_settings.cpu_recompiler_icache)
     {
@@ -739,6 +774,7 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
         g_settings.gpu_multisamples != old_settings.gpu_multisamples ||
         g_settings.gpu_per_sample_shading != old_settings.gpu_per_sample_shading ||
         g_settings.gpu_use_thread != old_settings.gpu_use_thread ||
+        g_settings.gpu_sw_worker_threads != old_settings.gpu_sw_worker_threads ||
         g_settings.gpu_fifo_size != old_settings.gpu_fifo_size ||
         g_settings.gpu_max_run_ahead != old_settings.gpu_max_run_ahead ||
         g_settings.gpu_true_color != old_settings.gpu_true_color ||
@@ -782,9 +818,25 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
         PGXP::Initialize();
     }
 
+    // the recompiler only inlines RTPS/RTPT when the widescreen hack is disabled
+    if (g_settings.gpu_widescreen_hack != old_settings.gpu_widescreen_hack && g_settings.IsUsingCodeCache())
+      CPU::CodeCache::Flush();
+
     if (g_settings.cdrom_read_thread != old_settings.cdrom_read_thread)
       g_cdrom.SetUseReadThread(g_settings.cdrom_read_thread);
 
+    if (g_settings.cdrom_readahead_sectors != old_settings.cdrom_readahead_sectors)
+      g_cdrom.SetReadaheadSectors(g_settings.cdrom_readahead_sectors);
+
+    if (g_settings.rewind_enable != old_settings.rewind_enable ||
+        g_settings.rewind_save_interval != old_settings.rewind_save_interval ||
+        g_settings.rewind_save_slots != old_settings.rewind_save_slots ||
+        g_settings.rewind_max_memory != old_settings.rewind_max_memory ||
+        g_settings.runahead_frames != old_settings.runahead_frames)
+    {
+      System::UpdateMemorySaveStateSettings();
+    }
+
     if (g_settings.memory_card_types != old_settings.memory_card_types ||
         g_settings.memory_card_paths != old_settings.memory_card_paths ||
         (g_settings.memory_card_use_playlist_title != old_settings.memory_card_use_playlist_title &&
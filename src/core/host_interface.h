@@ -19,6 +19,7 @@ class ByteStream;
 class CDImage;
 class HostDisplay;
 class GameList;
+class SaveStateWriter;
 
 struct SystemBootParameters;
 
@@ -155,7 +156,10 @@ protected:
   virtual void OnSystemCreated();
   virtual void OnSystemPaused(bool paused);
   virtual void OnSystemDestroyed();
-  virtual void OnSystemStateSaved(bool global, s32 slot);
+
+  /// Called once a state has been written to disk. May be called from the save state writer thread.
+  virtual void OnSystemStateSaved(const std::string& game_code, bool global, s32 slot);
+
   virtual void OnControllerTypeChanged(u32 slot);
 
   /// Restores all settings to defaults.
@@ -194,11 +198,14 @@ protected:
   /// Updates software cursor state, based on controllers.
   void UpdateSoftwareCursor();
 
-  bool SaveState(const char* filename);
+  /// Snapshots the state to memory and queues it to be written to the specified file in the background.
+  /// The callback is invoked from the writer thread once the write completes.
+  bool SaveState(const char* filename, std::function<void(bool)> callback = {});
   void CreateAudioStream();
 
   std::unique_ptr<HostDisplay> m_display;
   std::unique_ptr<AudioStream> m_audio_stream;
+  std::unique_ptr<SaveStateWriter> m_save_state_writer;
   std::string m_program_directory;
   std::string m_user_directory;
 };
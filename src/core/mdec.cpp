@@ -1,4 +1,5 @@
 #include "mdec.h"
+#include "common/cpu_detect.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
 #include "cpu_core.h"
@@ -10,6 +11,16 @@
 #endif
 Log_SetChannel(MDEC);
 
+#if defined(CPU_X64)
+#include <emmintrin.h>
+#elif defined(CPU_AARCH64)
+#ifdef _MSC_VER
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 MDEC g_mdec;
 
 MDEC::MDEC() = default;
@@ -417,10 +428,7 @@ bool MDEC::DecodeColoredMacroblock()
   ResetDecoder();
   m_state = State::WritingMacroblock;
 
-  yuv_to_rgb(0, 0, m_blocks[0], m_blocks[1], m_blocks[2]);
-  yuv_to_rgb(8, 0, m_blocks[0], m_blocks[1], m_blocks[3]);
-  yuv_to_rgb(0, 8, m_blocks[0], m_blocks[1], m_blocks[4]);
-  yuv_to_rgb(8, 8, m_blocks[0], m_blocks[1], m_blocks[5]);
+  yuv_to_rgb();
   m_total_blocks_decoded += 4;
 
   ScheduleBlockCopyOut(s_ticks_per_block[static_cast<u8>(m_status.data_output_depth)] * 6);
@@ -620,7 +628,160 @@ bool MDEC::rl_decode_block(s16* blk, const u8* qt)
   return false;
 }
 
+#if defined(CPU_X64)
+
+// Broadcasts the Kth pair of 16-bit values, for use with madd which sums two products per lane.
+template<u32 K>
+static __m128i BroadcastPair(__m128i v)
+{
+  return _mm_shuffle_epi32(v, _MM_SHUFFLE(K, K, K, K));
+}
+
+template<u32 K>
+static void IDCTRowPass(__m128i& A, __m128i& Bhi, __m128i& Blo, __m128i a, __m128i b, __m128i scale_pair,
+                        __m128i low_mask)
+{
+  A = _mm_add_epi32(A, _mm_madd_epi16(BroadcastPair<K>(a), scale_pair));
+
+  const __m128i p = _mm_madd_epi16(BroadcastPair<K>(b), scale_pair);
+  Bhi = _mm_add_epi32(Bhi, _mm_srai_epi32(p, 15));
+  Blo = _mm_add_epi32(Blo, _mm_and_si128(p, low_mask));
+}
+
 void MDEC::IDCT(s16* blk)
+{
+  // Coefficients are limited to 11 bits, so the first pass fits in 32 bits.
+  alignas(16) std::array<s32, 64> temp_buffer;
+  __m128i blk_pairs[4][2];
+  for (u32 k = 0; k < 4; k++)
+  {
+    const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&blk[(k * 2) * 8]));
+    const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&blk[(k * 2 + 1) * 8]));
+    blk_pairs[k][0] = _mm_unpacklo_epi16(r0, r1);
+    blk_pairs[k][1] = _mm_unpackhi_epi16(r0, r1);
+  }
+  for (u32 y = 0; y < 8; y++)
+  {
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    for (u32 k = 0; k < 4; k++)
+    {
+      const u32 s0 = ZeroExtend32(static_cast<u16>(m_scale_table[(k * 2) * 8 + y]));
+      const u32 s1 = ZeroExtend32(static_cast<u16>(m_scale_table[(k * 2 + 1) * 8 + y]));
+      const __m128i scale = _mm_set1_epi32(static_cast<s32>(s0 | (s1 << 16)));
+      lo = _mm_add_epi32(lo, _mm_madd_epi16(blk_pairs[k][0], scale));
+      hi = _mm_add_epi32(hi, _mm_madd_epi16(blk_pairs[k][1], scale));
+    }
+    _mm_store_si128(reinterpret_cast<__m128i*>(&temp_buffer[y * 8]), lo);
+    _mm_store_si128(reinterpret_cast<__m128i*>(&temp_buffer[y * 8 + 4]), hi);
+  }
+
+  // The second pass needs 46 bits, but only bits 31-40 of the sum make it to the output. Split each 29-bit temp value
+  // into a high part and a 15-bit low part which both fit in 16 bits, and carry the low products separately so that
+  // the result is exact modulo 2^32 in the bits we care about.
+  __m128i scale_pairs[4][2];
+  for (u32 k = 0; k < 4; k++)
+  {
+    const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_scale_table[(k * 2) * 8]));
+    const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_scale_table[(k * 2 + 1) * 8]));
+    scale_pairs[k][0] = _mm_unpacklo_epi16(r0, r1);
+    scale_pairs[k][1] = _mm_unpackhi_epi16(r0, r1);
+  }
+
+  const __m128i low_mask = _mm_set1_epi32(0x7FFF);
+  const __m128i round = _mm_set1_epi32(1 << 16);
+  for (u32 y = 0; y < 8; y++)
+  {
+    const __m128i t0 = _mm_load_si128(reinterpret_cast<const __m128i*>(&temp_buffer[y * 8]));
+    const __m128i t1 = _mm_load_si128(reinterpret_cast<const __m128i*>(&temp_buffer[y * 8 + 4]));
+    const __m128i a = _mm_packs_epi32(_mm_srai_epi32(t0, 15), _mm_srai_epi32(t1, 15));
+    const __m128i b = _mm_packs_epi32(_mm_and_si128(t0, low_mask), _mm_and_si128(t1, low_mask));
+
+    __m128i res[2];
+    for (u32 h = 0; h < 2; h++)
+    {
+      __m128i A = _mm_setzero_si128();
+      __m128i Bhi = _mm_setzero_si128();
+      __m128i Blo = _mm_setzero_si128();
+      IDCTRowPass<0>(A, Bhi, Blo, a, b, scale_pairs[0][h], low_mask);
+      IDCTRowPass<1>(A, Bhi, Blo, a, b, scale_pairs[1][h], low_mask);
+      IDCTRowPass<2>(A, Bhi, Blo, a, b, scale_pairs[2][h], low_mask);
+      IDCTRowPass<3>(A, Bhi, Blo, a, b, scale_pairs[3][h], low_mask);
+
+      // sum = (M << 15) + (Blo & 0x7FFF), so (sum >> 32) + ((sum >> 31) & 1) == (M + (1 << 16)) >> 17
+      const __m128i M = _mm_add_epi32(_mm_add_epi32(A, Bhi), _mm_srai_epi32(Blo, 15));
+      const __m128i r = _mm_srai_epi32(_mm_add_epi32(M, round), 17);
+      res[h] = _mm_srai_epi32(_mm_slli_epi32(r, 23), 23);
+    }
+
+    const __m128i out =
+      _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(res[0], res[1]), _mm_set1_epi16(-128)), _mm_set1_epi16(127));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&blk[y * 8]), out);
+  }
+}
+
+#elif defined(CPU_AARCH64)
+
+void MDEC::IDCT(s16* blk)
+{
+  // Coefficients are limited to 11 bits, so the first pass fits in 32 bits.
+  alignas(16) std::array<s32, 64> temp_buffer;
+  for (u32 y = 0; y < 8; y++)
+  {
+    int32x4_t lo = vdupq_n_s32(0);
+    int32x4_t hi = vdupq_n_s32(0);
+    for (u32 u = 0; u < 8; u++)
+    {
+      const int16x8_t row = vld1q_s16(&blk[u * 8]);
+      lo = vmlal_n_s16(lo, vget_low_s16(row), m_scale_table[u * 8 + y]);
+      hi = vmlal_n_s16(hi, vget_high_s16(row), m_scale_table[u * 8 + y]);
+    }
+    vst1q_s32(&temp_buffer[y * 8], lo);
+    vst1q_s32(&temp_buffer[y * 8 + 4], hi);
+  }
+
+  int32x4_t scale_rows[8][2];
+  for (u32 u = 0; u < 8; u++)
+  {
+    const int16x8_t row = vld1q_s16(&m_scale_table[u * 8]);
+    scale_rows[u][0] = vmovl_s16(vget_low_s16(row));
+    scale_rows[u][1] = vmovl_s16(vget_high_s16(row));
+  }
+
+  for (u32 y = 0; y < 8; y++)
+  {
+    int64x2_t sum[4] = {vdupq_n_s64(0), vdupq_n_s64(0), vdupq_n_s64(0), vdupq_n_s64(0)};
+    for (u32 u = 0; u < 8; u++)
+    {
+      const s32 t = temp_buffer[y * 8 + u];
+      sum[0] = vmlal_n_s32(sum[0], vget_low_s32(scale_rows[u][0]), t);
+      sum[1] = vmlal_n_s32(sum[1], vget_high_s32(scale_rows[u][0]), t);
+      sum[2] = vmlal_n_s32(sum[2], vget_low_s32(scale_rows[u][1]), t);
+      sum[3] = vmlal_n_s32(sum[3], vget_high_s32(scale_rows[u][1]), t);
+    }
+
+    // rounding shift is (sum >> 32) + ((sum >> 31) & 1)
+    int32x4_t r0 = vcombine_s32(vmovn_s64(vrshrq_n_s64(sum[0], 32)), vmovn_s64(vrshrq_n_s64(sum[1], 32)));
+    int32x4_t r1 = vcombine_s32(vmovn_s64(vrshrq_n_s64(sum[2], 32)), vmovn_s64(vrshrq_n_s64(sum[3], 32)));
+    r0 = vshrq_n_s32(vshlq_n_s32(r0, 23), 23);
+    r1 = vshrq_n_s32(vshlq_n_s32(r1, 23), 23);
+
+    const int16x8_t out =
+      vminq_s16(vmaxq_s16(vcombine_s16(vqmovn_s32(r0), vqmovn_s32(r1)), vdupq_n_s16(-128)), vdupq_n_s16(127));
+    vst1q_s16(&blk[y * 8], out);
+  }
+}
+
+#else
+
+void MDEC::IDCT(s16* blk)
+{
+  IDCTScalar(blk);
+}
+
+#endif
+
+void MDEC::IDCTScalar(s16* blk)
 {
   std::array<s64, 64> temp_buffer;
   for (u32 x = 0; x < 8; x++)
@@ -647,45 +808,140 @@ void MDEC::IDCT(s16* blk)
   }
 }
 
-void MDEC::yuv_to_rgb(u32 xx, u32 yy, const std::array<s16, 64>& Crblk, const std::array<s16, 64>& Cbblk,
-                      const std::array<s16, 64>& Yblk)
+void MDEC::yuv_to_rgb()
 {
-  for (u32 y = 0; y < 8; y++)
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+  // Each chroma sample covers 2x2 pixels, so convert them once up front instead of for every pixel.
+  const std::array<s16, 64>& Crblk = m_blocks[0];
+  const std::array<s16, 64>& Cbblk = m_blocks[1];
+  alignas(16) std::array<s16, 64> Rblk;
+  alignas(16) std::array<s16, 64> Gblk;
+  alignas(16) std::array<s16, 64> Bblk;
+  for (u32 i = 0; i < 64; i++)
+  {
+    const s16 R = Crblk[i];
+    const s16 B = Cbblk[i];
+    Gblk[i] = static_cast<s16>((-0.3437f * static_cast<float>(B)) + (-0.7143f * static_cast<float>(R)));
+    Rblk[i] = static_cast<s16>(1.402f * static_cast<float>(R));
+    Bblk[i] = static_cast<s16>(1.772f * static_cast<float>(B));
+  }
+
+  const s16 bias = m_status.data_output_signed ? 0 : 128;
+
+  // blocks 2-5 are the top-left, top-right, bottom-left and bottom-right luma
+  for (u32 y = 0; y < 16; y++)
   {
-    for (u32 x = 0; x < 8; x++)
+    for (u32 half = 0; half < 2; half++)
     {
-      s16 R = Crblk[((x + xx) / 2) + ((y + yy) / 2) * 8];
-      s16 B = Cbblk[((x + xx) / 2) + ((y + yy) / 2) * 8];
+      const s16* Yrow = &m_blocks[2 + (y / 8) * 2 + half][(y % 8) * 8];
+      const u32 chroma_offset = (y / 2) * 8 + half * 4;
+      u32* out = &m_block_rgb[y * 16 + half * 8];
+
+#if defined(CPU_X64)
+      const __m128i Y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Yrow));
+      const __m128i min = _mm_set1_epi16(-128);
+      const __m128i max = _mm_set1_epi16(127);
+      const __m128i vbias = _mm_set1_epi16(bias);
+      const __m128i mask = _mm_set1_epi16(0xFF);
+      const auto convert = [&](const std::array<s16, 64>& Cblk) {
+        __m128i C = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&Cblk[chroma_offset]));
+        C = _mm_unpacklo_epi16(C, C);
+        return _mm_and_si128(_mm_add_epi16(_mm_min_epi16(_mm_max_epi16(_mm_add_epi16(Y, C), min), max), vbias), mask);
+      };
+
+      const __m128i RG = _mm_or_si128(convert(Rblk), _mm_slli_epi16(convert(Gblk), 8));
+      const __m128i B = convert(Bblk);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(RG, B));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(RG, B));
+#else
+      const int16x8_t Y = vld1q_s16(Yrow);
+      const auto convert = [&](const std::array<s16, 64>& Cblk) {
+        const int16x4_t C = vld1_s16(&Cblk[chroma_offset]);
+        const int16x4x2_t Cx2 = vzip_s16(C, C);
+        const int16x8_t sum = vaddq_s16(Y, vcombine_s16(Cx2.val[0], Cx2.val[1]));
+        const int16x8_t clamped = vminq_s16(vmaxq_s16(sum, vdupq_n_s16(-128)), vdupq_n_s16(127));
+        return vandq_s16(vaddq_s16(clamped, vdupq_n_s16(bias)), vdupq_n_s16(0xFF));
+      };
+
+      const int16x8_t RG = vorrq_s16(convert(Rblk), vshlq_n_s16(convert(Gblk), 8));
+      const int16x8x2_t RGB = vzipq_s16(RG, convert(Bblk));
+      vst1q_u32(out, vreinterpretq_u32_s16(RGB.val[0]));
+      vst1q_u32(out + 4, vreinterpretq_u32_s16(RGB.val[1]));
+#endif
+    }
+  }
+#else
+  yuv_to_rgb_scalar();
+#endif
+}
+
+void MDEC::yuv_to_rgb_scalar()
+{
+  const std::array<s16, 64>& Crblk = m_blocks[0];
+  const std::array<s16, 64>& Cbblk = m_blocks[1];
+  const s16 bias = m_status.data_output_signed ? 0 : 128;
+
+  for (u32 y = 0; y < 16; y++)
+  {
+    for (u32 x = 0; x < 16; x++)
+    {
+      s16 R = Crblk[(x / 2) + (y / 2) * 8];
+      s16 B = Cbblk[(x / 2) + (y / 2) * 8];
       s16 G = static_cast<s16>((-0.3437f * static_cast<float>(B)) + (-0.7143f * static_cast<float>(R)));
 
       R = static_cast<s16>(1.402f * static_cast<float>(R));
       B = static_cast<s16>(1.772f * static_cast<float>(B));
 
-      s16 Y = Yblk[x + y * 8];
-      R = static_cast<s16>(std::clamp(static_cast<int>(Y) + R, -128, 127));
-      G = static_cast<s16>(std::clamp(static_cast<int>(Y) + G, -128, 127));
-      B = static_cast<s16>(std::clamp(static_cast<int>(Y) + B, -128, 127));
-
-      // TODO: Signed output
-      R += 128;
-      G += 128;
-      B += 128;
+      // blocks 2-5 are the top-left, top-right, bottom-left and bottom-right luma
+      const s16 Y = m_blocks[2 + (y / 8) * 2 + (x / 8)][(x % 8) + (y % 8) * 8];
+      R = static_cast<s16>(std::clamp(static_cast<int>(Y) + R, -128, 127) + bias);
+      G = static_cast<s16>(std::clamp(static_cast<int>(Y) + G, -128, 127) + bias);
+      B = static_cast<s16>(std::clamp(static_cast<int>(Y) + B, -128, 127) + bias);
 
-      m_block_rgb[(x + xx) + ((y + yy) * 16)] = ZeroExtend32(static_cast<u16>(R)) |
-                                                (ZeroExtend32(static_cast<u16>(G)) << 8) |
-                                                (ZeroExtend32(static_cast<u16>(B)) << 16);
+      m_block_rgb[x + y * 16] = ZeroExtend32(static_cast<u8>(R)) | (ZeroExtend32(static_cast<u8>(G)) << 8) |
+                                (ZeroExtend32(static_cast<u8>(B)) << 16);
     }
   }
 }
 
 void MDEC::y_to_mono(const std::array<s16, 64>& Yblk)
 {
+  // SignExtendN<10, s16> shifts after promoting to int and leaves the value unchanged, so only the clamp is vectorized.
+#if defined(CPU_X64)
+  const __m128i bias = _mm_set1_epi16(m_status.data_output_signed ? 0 : 128);
+  const __m128i mask = _mm_set1_epi16(0xFF);
+  for (u32 i = 0; i < 64; i += 8)
+  {
+    __m128i Y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&Yblk[i]));
+    Y = _mm_min_epi16(_mm_max_epi16(Y, _mm_set1_epi16(-128)), _mm_set1_epi16(127));
+    Y = _mm_and_si128(_mm_add_epi16(Y, bias), mask);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_block_rgb[i]), _mm_unpacklo_epi16(Y, _mm_setzero_si128()));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_block_rgb[i + 4]), _mm_unpackhi_epi16(Y, _mm_setzero_si128()));
+  }
+#elif defined(CPU_AARCH64)
+  const int16x8_t bias = vdupq_n_s16(m_status.data_output_signed ? 0 : 128);
+  for (u32 i = 0; i < 64; i += 8)
+  {
+    int16x8_t Y = vld1q_s16(&Yblk[i]);
+    Y = vaddq_s16(vminq_s16(vmaxq_s16(Y, vdupq_n_s16(-128)), vdupq_n_s16(127)), bias);
+    const uint16x8_t Yu = vandq_u16(vreinterpretq_u16_s16(Y), vdupq_n_u16(0xFF));
+    vst1q_u32(&m_block_rgb[i], vmovl_u16(vget_low_u16(Yu)));
+    vst1q_u32(&m_block_rgb[i + 4], vmovl_u16(vget_high_u16(Yu)));
+  }
+#else
+  y_to_mono_scalar(Yblk);
+#endif
+}
+
+void MDEC::y_to_mono_scalar(const std::array<s16, 64>& Yblk)
+{
+  const s16 bias = m_status.data_output_signed ? 0 : 128;
   for (u32 i = 0; i < 64; i++)
   {
     s16 Y = Yblk[i];
     Y = SignExtendN<10, s16>(Y);
     Y = std::clamp<s16>(Y, -128, 127);
-    Y += 128;
+    Y += bias;
     m_block_rgb[i] = static_cast<u32>(Y) & 0xFF;
   }
 }
@@ -117,10 +117,18 @@ private:
   // from nocash spec
   bool rl_decode_block(s16* blk, const u8* qt);
   void IDCT(s16* blk);
-  void yuv_to_rgb(u32 xx, u32 yy, const std::array<s16, 64>& Crblk, const std::array<s16, 64>& Cbblk,
-                  const std::array<s16, 64>& Yblk);
+
+  /// Reference IDCT, used when there's no vectorized version. The vectorized versions must match it exactly.
+  void IDCTScalar(s16* blk);
+
+  /// Converts all six blocks of a colour macroblock to 16x16 RGB.
+  void yuv_to_rgb();
   void y_to_mono(const std::array<s16, 64>& Yblk);
 
+  /// Reference colour conversions, the vectorized versions above must match them exactly.
+  void yuv_to_rgb_scalar();
+  void y_to_mono_scalar(const std::array<s16, 64>& Yblk);
+
   StatusRegister m_status = {};
   bool m_enable_dma_in = false;
   bool m_enable_dma_out = false;
@@ -146,6 +154,9 @@ private:
   std::unique_ptr<TimingEvent> m_block_copy_out_event;
 
   u32 m_total_blocks_decoded = 0;
+
+  // Compares the IDCT and colour conversion implementations directly, without going through the FIFOs.
+  friend class MDECTest;
 };
 
 extern MDEC g_mdec;
\ No newline at end of file
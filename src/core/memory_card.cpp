@@ -36,9 +36,10 @@ void MemoryCard::Reset()
   m_FLAG.no_write_yet = true;
 }
 
-bool MemoryCard::DoState(StateWrapper& sw)
+bool MemoryCard::DoState(StateWrapper& sw, bool is_memory_state)
 {
-  if (sw.IsReading())
+  // Runahead and rewind load memory states every frame, writing the card out each time would stall the emulation.
+  if (sw.IsReading() && !is_memory_state)
     SaveIfChanged(true);
 
   sw.Do(&m_state);
@@ -50,6 +51,10 @@ bool MemoryCard::DoState(StateWrapper& sw)
   sw.Do(&m_data);
   sw.Do(&m_changed);
 
+  // The flush event isn't restored with the state, so make sure any changes from it still get written out.
+  if (sw.IsReading() && is_memory_state && m_changed)
+    QueueFileSave();
+
   return !sw.HasError();
 }
 
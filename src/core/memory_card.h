@@ -23,7 +23,7 @@ public:
   void SetFilename(std::string filename) { m_filename = std::move(filename); }
 
   void Reset();
-  bool DoState(StateWrapper& sw);
+  bool DoState(StateWrapper& sw, bool is_memory_state);
 
   void ResetTransferState();
   bool Transfer(const u8 data_in, u8* data_out);
@@ -48,7 +48,7 @@ void Pad::Reset()
   }
 }
 
-bool Pad::DoState(StateWrapper& sw)
+bool Pad::DoState(StateWrapper& sw, bool is_memory_state)
 {
   for (u32 i = 0; i < NUM_SLOTS; i++)
   {
@@ -144,7 +144,7 @@ bool Pad::DoState(StateWrapper& sw)
       Log_WarningPrintf("Skipping loading memory card %u from save state.", i + 1u);
 
       std::unique_ptr<MemoryCard> card_from_state = std::make_unique<MemoryCard>();
-      if (!sw.DoMarker("MemoryCard") || !card_from_state->DoState(sw))
+      if (!sw.DoMarker("MemoryCard") || !card_from_state->DoState(sw, is_memory_state))
         return false;
 
       // does the content of the memory card match?
@@ -200,7 +200,7 @@ bool Pad::DoState(StateWrapper& sw)
 
     if (m_memory_cards[i])
     {
-      if (!sw.DoMarker("MemoryCard") || !m_memory_cards[i]->DoState(sw))
+      if (!sw.DoMarker("MemoryCard") || !m_memory_cards[i]->DoState(sw, is_memory_state))
         return false;
     }
   }
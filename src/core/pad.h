@@ -20,7 +20,7 @@ public:
   void Initialize();
   void Shutdown();
   void Reset();
-  bool DoState(StateWrapper& sw);
+  bool DoState(StateWrapper& sw, bool is_memory_state);
 
   Controller* GetController(u32 slot) const { return m_controllers[slot].get(); }
   void SetController(u32 slot, std::unique_ptr<Controller> dev);
@@ -7,6 +7,12 @@ static constexpr u32 SAVE_STATE_MINIMUM_VERSION = 42;
 
 static_assert(SAVE_STATE_VERSION >= SAVE_STATE_MINIMUM_VERSION);
 
+enum : u32
+{
+  SAVE_STATE_COMPRESSION_TYPE_NONE = 0,
+  SAVE_STATE_COMPRESSION_TYPE_DEFLATE = 1
+};
+
 #pragma pack(push, 4)
 struct SAVE_STATE_HEADER
 {
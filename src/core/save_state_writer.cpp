@@ -0,0 +1,148 @@
+#include "save_state_writer.h"
+#include "common/byte_stream.h"
+#include "common/file_system.h"
+#include "common/log.h"
+#include "common/timer.h"
+#include "system.h"
+Log_SetChannel(SaveStateWriter);
+
+SaveStateWriter::SaveStateWriter() = default;
+
+SaveStateWriter::~SaveStateWriter()
+{
+  StopThread();
+}
+
+std::unique_ptr<GrowableMemoryByteStream> SaveStateWriter::GetSnapshotBuffer()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_free_buffers.empty() && m_num_buffers < NUM_SNAPSHOT_BUFFERS)
+  {
+    m_num_buffers++;
+    return ByteStream_CreateGrowableMemoryStream(nullptr, INITIAL_SNAPSHOT_BUFFER_SIZE);
+  }
+
+  if (m_free_buffers.empty())
+  {
+    Log_WarningPrintf("All snapshot buffers are in use, waiting for a write to complete");
+    m_done_cv.wait(lock, [this]() { return !m_free_buffers.empty(); });
+  }
+
+  std::unique_ptr<GrowableMemoryByteStream> buffer = std::move(m_free_buffers.back());
+  m_free_buffers.pop_back();
+  return buffer;
+}
+
+void SaveStateWriter::ReturnSnapshotBuffer(std::unique_ptr<GrowableMemoryByteStream> buffer)
+{
+  // keep the memory around for the next snapshot
+  buffer->Resize(0);
+  buffer->SeekAbsolute(0);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_free_buffers.push_back(std::move(buffer));
+  m_done_cv.notify_all();
+}
+
+void SaveStateWriter::QueueWrite(std::string filename, std::unique_ptr<GrowableMemoryByteStream> snapshot,
+                                 bool compress, CompletionCallback callback)
+{
+  if (!m_thread.joinable())
+    StartThread();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_pending_writes.push_back(PendingWrite{std::move(filename), std::move(snapshot), std::move(callback), compress});
+  m_work_cv.notify_one();
+}
+
+bool SaveStateWriter::HasPendingWrites()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  return (!m_pending_writes.empty() || m_write_in_progress);
+}
+
+void SaveStateWriter::WaitForPendingWrites()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done_cv.wait(lock, [this]() { return (m_pending_writes.empty() && !m_write_in_progress); });
+}
+
+void SaveStateWriter::StartThread()
+{
+  m_shutdown_flag = false;
+  m_thread = std::thread(&SaveStateWriter::WorkerThreadEntryPoint, this);
+}
+
+void SaveStateWriter::StopThread()
+{
+  if (!m_thread.joinable())
+    return;
+
+  // writes which are still queued are completed before the thread exits
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_shutdown_flag = true;
+    m_work_cv.notify_one();
+  }
+
+  m_thread.join();
+}
+
+void SaveStateWriter::WorkerThreadEntryPoint()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;)
+  {
+    m_work_cv.wait(lock, [this]() { return (!m_pending_writes.empty() || m_shutdown_flag); });
+    if (m_pending_writes.empty())
+      break;
+
+    PendingWrite write = std::move(m_pending_writes.front());
+    m_pending_writes.pop_front();
+    m_write_in_progress = true;
+    lock.unlock();
+
+    const bool result = WriteSnapshot(write);
+    ReturnSnapshotBuffer(std::move(write.snapshot));
+    if (write.callback)
+      write.callback(result);
+
+    lock.lock();
+    m_write_in_progress = false;
+    m_done_cv.notify_all();
+  }
+}
+
+bool SaveStateWriter::WriteSnapshot(const PendingWrite& write)
+{
+  Common::Timer timer;
+
+  std::unique_ptr<ByteStream> stream =
+    FileSystem::OpenFile(write.filename.c_str(), BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE |
+                                                   BYTESTREAM_OPEN_TRUNCATE | BYTESTREAM_OPEN_ATOMIC_UPDATE |
+                                                   BYTESTREAM_OPEN_STREAMED);
+  if (!stream)
+  {
+    Log_ErrorPrintf("Failed to open '%s' for writing", write.filename.c_str());
+    return false;
+  }
+
+  if (!System::WriteStateSnapshot(stream.get(), write.snapshot->GetMemoryPointer(),
+                                  static_cast<u32>(write.snapshot->GetSize()), write.compress))
+  {
+    Log_ErrorPrintf("Failed to write state to '%s'", write.filename.c_str());
+    stream->Discard();
+    return false;
+  }
+
+  const u32 size = static_cast<u32>(stream->GetPosition());
+  if (!stream->Commit())
+  {
+    Log_ErrorPrintf("Failed to commit state to '%s'", write.filename.c_str());
+    return false;
+  }
+
+  Log_InfoPrintf("Wrote %u byte state to '%s' in %.2f ms", size, write.filename.c_str(),
+                 timer.GetTimeMilliseconds());
+  return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "types.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class GrowableMemoryByteStream;
+
+/// Writes save states to disk on a background thread. The emulation thread snapshots the state into one of a small
+/// pool of reusable memory buffers, and the compression and file I/O happens on the writer thread.
+class SaveStateWriter
+{
+public:
+  /// Invoked on the writer thread once the state has been written, or the write has failed.
+  using CompletionCallback = std::function<void(bool result)>;
+
+  enum : u32
+  {
+    NUM_SNAPSHOT_BUFFERS = 2,
+    INITIAL_SNAPSHOT_BUFFER_SIZE = 8 * 1024 * 1024
+  };
+
+  SaveStateWriter();
+  ~SaveStateWriter();
+
+  /// Returns an empty buffer to snapshot a state into. Blocks if all buffers are waiting to be written.
+  std::unique_ptr<GrowableMemoryByteStream> GetSnapshotBuffer();
+
+  /// Returns a buffer which was not queued for writing, e.g. because the snapshot failed.
+  void ReturnSnapshotBuffer(std::unique_ptr<GrowableMemoryByteStream> buffer);
+
+  /// Queues an uncompressed state snapshot to be written to the specified file.
+  void QueueWrite(std::string filename, std::unique_ptr<GrowableMemoryByteStream> snapshot, bool compress,
+                  CompletionCallback callback);
+
+  /// Returns true if any writes have not yet completed.
+  bool HasPendingWrites();
+
+  /// Blocks until all queued writes have completed.
+  void WaitForPendingWrites();
+
+private:
+  struct PendingWrite
+  {
+    std::string filename;
+    std::unique_ptr<GrowableMemoryByteStream> snapshot;
+    CompletionCallback callback;
+    bool compress;
+  };
+
+  void StartThread();
+  void StopThread();
+  void WorkerThreadEntryPoint();
+
+  static bool WriteSnapshot(const PendingWrite& write);
+
+  std::mutex m_mutex;
+  std::thread m_thread;
+  std::condition_variable m_work_cv;
+  std::condition_variable m_done_cv;
+
+  std::vector<std::unique_ptr<GrowableMemoryByteStream>> m_free_buffers;
+  std::deque<PendingWrite> m_pending_writes;
+  u32 m_num_buffers = 0;
+  bool m_write_in_progress = false;
+  bool m_shutdown_flag = false;
+};
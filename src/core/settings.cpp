@@ -118,11 +118,18 @@ void Settings::Load(SettingsInterface& si)
   start_fullscreen = si.GetBoolValue("Main", "StartFullscreen", false);
   pause_on_focus_loss = si.GetBoolValue("Main", "PauseOnFocusLoss", false);
   save_state_on_exit = si.GetBoolValue("Main", "SaveStateOnExit", true);
+  compress_save_states = si.GetBoolValue("Main", "CompressSaveStates", true);
   confim_power_off = si.GetBoolValue("Main", "ConfirmPowerOff", true);
   load_devices_from_save_states = si.GetBoolValue("Main", "LoadDevicesFromSaveStates", false);
   apply_game_settings = si.GetBoolValue("Main", "ApplyGameSettings", true);
   auto_load_cheats = si.GetBoolValue("Main", "AutoLoadCheats", false);
   disable_all_enhancements = si.GetBoolValue("Main", "DisableAllEnhancements", false);
+  rewind_enable = si.GetBoolValue("Main", "RewindEnable", false);
+  rewind_save_interval = static_cast<u32>(std::max(si.GetIntValue("Main", "RewindSaveInterval", 1), 1));
+  rewind_save_slots = static_cast<u32>(std::max(si.GetIntValue("Main", "RewindSaveSlots", 3600), 1));
+  rewind_max_memory = static_cast<u32>(std::max(si.GetIntValue("Main", "RewindMaxMemory", 32), 1));
+  runahead_frames = static_cast<u32>(
+    std::clamp(si.GetIntValue("Main", "RunaheadFrameCount", 0), 0, static_cast<int>(MAX_RUNAHEAD_FRAMES)));
 
   cpu_execution_mode =
     ParseCPUExecutionMode(
@@ -134,6 +141,9 @@ void Settings::Load(SettingsInterface& si)
   UpdateOverclockActive();
   cpu_recompiler_memory_exceptions = si.GetBoolValue("CPU", "RecompilerMemoryExceptions", false);
   cpu_recompiler_icache = si.GetBoolValue("CPU", "RecompilerICache", false);
+  cpu_recompiler_persistent_cache = si.GetBoolValue("CPU", "RecompilerPersistentCache", false);
+  cpu_recompiler_background_compile = si.GetBoolValue("CPU", "RecompilerBackgroundCompile", false);
+  cpu_recompiler_superblocks = si.GetBoolValue("CPU", "RecompilerSuperblocks", false);
   cpu_fastmem_mode = ParseCPUFastmemMode(
                        si.GetStringValue("CPU", "FastmemMode", GetCPUFastmemModeName(DEFAULT_CPU_FASTMEM_MODE)).c_str())
                        .value_or(DEFAULT_CPU_FASTMEM_MODE);
@@ -146,6 +156,7 @@ void Settings::Load(SettingsInterface& si)
   gpu_use_debug_device = si.GetBoolValue("GPU", "UseDebugDevice", false);
   gpu_per_sample_shading = si.GetBoolValue("GPU", "PerSampleShading", false);
   gpu_use_thread = si.GetBoolValue("GPU", "UseThread", true);
+  gpu_sw_worker_threads = static_cast<u32>(si.GetIntValue("GPU", "SoftwareWorkerThreads", 0));
   gpu_threaded_presentation = si.GetBoolValue("GPU", "ThreadedPresentation", true);
   gpu_true_color = si.GetBoolValue("GPU", "TrueColor", true);
   gpu_scaled_dithering = si.GetBoolValue("GPU", "ScaledDithering", false);
@@ -197,6 +208,9 @@ void Settings::Load(SettingsInterface& si)
   display_max_fps = si.GetFloatValue("Display", "MaxFPS", 0.0f);
 
   cdrom_read_thread = si.GetBoolValue("CDROM", "ReadThread", true);
+  cdrom_readahead_sectors = std::min<u32>(
+    static_cast<u32>(si.GetIntValue("CDROM", "ReadaheadSectors", static_cast<int>(DEFAULT_CDROM_READAHEAD_SECTORS))),
+    MAX_CDROM_READAHEAD_SECTORS);
   cdrom_region_check = si.GetBoolValue("CDROM", "RegionCheck", true);
   cdrom_load_image_to_ram = si.GetBoolValue("CDROM", "LoadImageToRAM", false);
   cdrom_mute_cd_audio = si.GetBoolValue("CDROM", "MuteCDAudio", false);
@@ -290,11 +304,17 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("Main", "StartFullscreen", start_fullscreen);
   si.SetBoolValue("Main", "PauseOnFocusLoss", pause_on_focus_loss);
   si.SetBoolValue("Main", "SaveStateOnExit", save_state_on_exit);
+  si.SetBoolValue("Main", "CompressSaveStates", compress_save_states);
   si.SetBoolValue("Main", "ConfirmPowerOff", confim_power_off);
   si.SetBoolValue("Main", "LoadDevicesFromSaveStates", load_devices_from_save_states);
   si.SetBoolValue("Main", "ApplyGameSettings", apply_game_settings);
   si.SetBoolValue("Main", "AutoLoadCheats", auto_load_cheats);
   si.SetBoolValue("Main", "DisableAllEnhancements", disable_all_enhancements);
+  si.SetBoolValue("Main", "RewindEnable", rewind_enable);
+  si.SetIntValue("Main", "RewindSaveInterval", static_cast<int>(rewind_save_interval));
+  si.SetIntValue("Main", "RewindSaveSlots", static_cast<int>(rewind_save_slots));
+  si.SetIntValue("Main", "RewindMaxMemory", static_cast<int>(rewind_max_memory));
+  si.SetIntValue("Main", "RunaheadFrameCount", static_cast<int>(runahead_frames));
 
   si.SetStringValue("CPU", "ExecutionMode", GetCPUExecutionModeName(cpu_execution_mode));
   si.SetBoolValue("CPU", "OverclockEnable", cpu_overclock_enable);
@@ -302,6 +322,9 @@ void Settings::Save(SettingsInterface& si) const
   si.SetIntValue("CPU", "OverclockDenominator", cpu_overclock_denominator);
   si.SetBoolValue("CPU", "RecompilerMemoryExceptions", cpu_recompiler_memory_exceptions);
   si.SetBoolValue("CPU", "RecompilerICache", cpu_recompiler_icache);
+  si.SetBoolValue("CPU", "RecompilerPersistentCache", cpu_recompiler_persistent_cache);
+  si.SetBoolValue("CPU", "RecompilerBackgroundCompile", cpu_recompiler_background_compile);
+  si.SetBoolValue("CPU", "RecompilerSuperblocks", cpu_recompiler_superblocks);
   si.SetStringValue("CPU", "FastmemMode", GetCPUFastmemModeName(cpu_fastmem_mode));
 
   si.SetStringValue("GPU", "Renderer", GetRendererName(gpu_renderer));
@@ -311,6 +334,7 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("GPU", "UseDebugDevice", gpu_use_debug_device);
   si.SetBoolValue("GPU", "PerSampleShading", gpu_per_sample_shading);
   si.SetBoolValue("GPU", "UseThread", gpu_use_thread);
+  si.SetIntValue("GPU", "SoftwareWorkerThreads", static_cast<long>(gpu_sw_worker_threads));
   si.SetBoolValue("GPU", "ThreadedPresentation", gpu_threaded_presentation);
   si.SetBoolValue("GPU", "TrueColor", gpu_true_color);
   si.SetBoolValue("GPU", "ScaledDithering", gpu_scaled_dithering);
@@ -353,6 +377,7 @@ void Settings::Save(SettingsInterface& si) const
   si.SetFloatValue("Display", "MaxFPS", display_max_fps);
 
   si.SetBoolValue("CDROM", "ReadThread", cdrom_read_thread);
+  si.SetIntValue("CDROM", "ReadaheadSectors", static_cast<int>(cdrom_readahead_sectors));
   si.SetBoolValue("CDROM", "RegionCheck", cdrom_region_check);
   si.SetBoolValue("CDROM", "LoadImageToRAM", cdrom_load_image_to_ram);
   si.SetBoolValue("CDROM", "MuteCDAudio", cdrom_mute_cd_audio);
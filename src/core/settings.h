@@ -77,6 +77,9 @@ struct Settings
   bool cpu_overclock_active = false;
   bool cpu_recompiler_memory_exceptions = false;
   bool cpu_recompiler_icache = false;
+  bool cpu_recompiler_persistent_cache = false;
+  bool cpu_recompiler_background_compile = false;
+  bool cpu_recompiler_superblocks = false;
   CPUFastmemMode cpu_fastmem_mode = CPUFastmemMode::Disabled;
 
   float emulation_speed = 1.0f;
@@ -88,18 +91,26 @@ struct Settings
   bool start_fullscreen = false;
   bool pause_on_focus_loss = false;
   bool save_state_on_exit = true;
+  bool compress_save_states = true;
   bool confim_power_off = true;
   bool load_devices_from_save_states = false;
   bool apply_game_settings = true;
   bool auto_load_cheats = false;
   bool disable_all_enhancements = false;
 
+  bool rewind_enable = false;
+  u32 rewind_save_interval = 1;
+  u32 rewind_save_slots = 3600;
+  u32 rewind_max_memory = 32;
+  u32 runahead_frames = 0;
+
   GPURenderer gpu_renderer = GPURenderer::Software;
   std::string gpu_adapter;
   std::string display_post_process_chain;
   u32 gpu_resolution_scale = 1;
   u32 gpu_multisamples = 1;
   bool gpu_use_thread = true;
+  u32 gpu_sw_worker_threads = 0;
   bool gpu_threaded_presentation = true;
   bool gpu_use_debug_device = false;
   bool gpu_per_sample_shading = false;
@@ -139,6 +150,7 @@ struct Settings
   float gpu_pgxp_depth_clear_threshold = 300.0f / 4096.0f;
 
   bool cdrom_read_thread = true;
+  u32 cdrom_readahead_sectors = DEFAULT_CDROM_READAHEAD_SECTORS;
   bool cdrom_region_check = true;
   bool cdrom_load_image_to_ram = false;
   bool cdrom_mute_cd_audio = false;
@@ -234,6 +246,13 @@ struct Settings
             !cpu_recompiler_memory_exceptions);
   }
 
+  /// ICache emulation assumes a block's instructions are contiguous, which traces aren't.
+  ALWAYS_INLINE bool IsUsingSuperblocks() const
+  {
+    return (cpu_recompiler_superblocks && cpu_execution_mode == CPUExecutionMode::Recompiler &&
+            !cpu_recompiler_icache);
+  }
+
   ALWAYS_INLINE s32 GetAudioOutputVolume(bool fast_forwarding) const
   {
     return audio_output_muted ? 0 : (fast_forwarding ? audio_fast_forward_volume : audio_output_volume);
@@ -256,6 +275,9 @@ struct Settings
     DEFAULT_GPU_MAX_RUN_AHEAD = 128,
     DEFAULT_VRAM_WRITE_DUMP_WIDTH_THRESHOLD = 128,
     DEFAULT_VRAM_WRITE_DUMP_HEIGHT_THRESHOLD = 128,
+    DEFAULT_CDROM_READAHEAD_SECTORS = 8,
+    MAX_CDROM_READAHEAD_SECTORS = 32,
+    MAX_RUNAHEAD_FRAMES = 10,
   };
 
   void Load(SettingsInterface& si);
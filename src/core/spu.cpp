@@ -1,6 +1,7 @@
 #include "spu.h"
 #include "cdrom.h"
 #include "common/audio_stream.h"
+#include "common/cpu_detect.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
 #include "common/wav_writer.h"
@@ -13,6 +14,16 @@
 #endif
 Log_SetChannel(SPU);
 
+#if defined(CPU_X64)
+#include <emmintrin.h>
+#elif defined(CPU_AARCH64)
+#ifdef _MSC_VER
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 SPU g_spu;
 
 SPU::SPU() = default;
@@ -172,7 +183,6 @@ bool SPU::DoState(StateWrapper& sw)
 
   if (sw.IsReading())
   {
-    g_host_interface->GetAudioStream()->EmptyBuffers();
     UpdateEventInterval();
     UpdateTransferEvent();
   }
@@ -1396,13 +1406,13 @@ void SPU::ReadADPCMBlock(u16 address, ADPCMBlock* block)
   }
 }
 
-ALWAYS_INLINE_RELEASE std::tuple<s32, s32> SPU::SampleVoice(u32 voice_index)
+ALWAYS_INLINE_RELEASE s32 SPU::SampleVoice(u32 voice_index, s16 noise_level, s32 modulator_volume)
 {
   Voice& voice = m_voices[voice_index];
   if (!voice.IsOn() && !m_SPUCNT.irq9_enable)
   {
     voice.last_volume = 0;
-    return {};
+    return 0;
   }
 
   if (!voice.has_samples)
@@ -1426,7 +1436,7 @@ ALWAYS_INLINE_RELEASE std::tuple<s32, s32> SPU::SampleVoice(u32 voice_index)
     // interpolate/sample and apply ADSR volume
     s32 sample;
     if (IsVoiceNoiseEnabled(voice_index))
-      sample = GetVoiceNoiseLevel();
+      sample = noise_level;
     else
       sample = voice.Interpolate();
 
@@ -1446,7 +1456,7 @@ ALWAYS_INLINE_RELEASE std::tuple<s32, s32> SPU::SampleVoice(u32 voice_index)
   u16 step = voice.regs.adpcm_sample_rate;
   if (IsPitchModulationEnabled(voice_index))
   {
-    const s32 factor = std::clamp<s32>(m_voices[voice_index - 1].last_volume, -0x8000, 0x7FFF) + 0x8000;
+    const s32 factor = std::clamp<s32>(modulator_volume, -0x8000, 0x7FFF) + 0x8000;
     step = Truncate16(static_cast<u32>((SignExtend32(step) * factor) >> 15));
   }
   step = std::min<u16>(step, 0x3FFF);
@@ -1483,12 +1493,274 @@ ALWAYS_INLINE_RELEASE std::tuple<s32, s32> SPU::SampleVoice(u32 voice_index)
     }
   }
 
-  // apply per-channel volume
-  const s32 left = ApplyVolume(volume, voice.left_volume.current_level);
-  const s32 right = ApplyVolume(volume, voice.right_volume.current_level);
+  // per-channel volume is applied when mixing, with the level from before the tick
   voice.left_volume.Tick();
   voice.right_volume.Tick();
-  return std::make_tuple(left, right);
+  return volume;
+}
+
+bool SPU::CanBatchVoices(u32 num_frames) const
+{
+  // Capture buffers are written every frame. Reverb writes between the base address and the end of RAM, unless a
+  // destination offset is large enough to wrap around past the end of the work area (see ReverbMemoryAddress()).
+  static constexpr u32 CAPTURE_BUFFER_END = CAPTURE_BUFFER_SIZE_PER_CHANNEL * 4;
+  static constexpr u32 REVERB_MASK = (RAM_SIZE - 1) / 2;
+  const bool reverb_writes = m_SPUCNT.reverb_master_enable;
+  const u32 reverb_start = std::min(m_reverb_base_address, m_reverb_current_address) * 2;
+  if (reverb_writes)
+  {
+    const auto write_wraps = [this](u16 dest) {
+      return (m_reverb_base_address + ((ZeroExtend32(dest) << 2) & REVERB_MASK)) > REVERB_MASK;
+    };
+    for (u32 i = 0; i < 2; i++)
+    {
+      if (write_wraps(m_reverb_registers.IIR_DEST_A[i]) || write_wraps(m_reverb_registers.IIR_DEST_B[i]) ||
+          write_wraps(m_reverb_registers.MIX_DEST_A[i]) || write_wraps(m_reverb_registers.MIX_DEST_B[i]))
+      {
+        return false;
+      }
+    }
+  }
+
+  // Worst case the voice is at the maximum pitch for every frame, plus the partially-played block it starts in. Loops
+  // can only jump back to the repeat address, or somewhere already played, so that's the range from each start point.
+  const u32 max_blocks = ((num_frames * 0x4000u) / (NUM_SAMPLES_PER_ADPCM_BLOCK << 12)) + 2;
+  const u32 max_bytes = (max_blocks + 1) * sizeof(ADPCMBlock);
+  const auto overlaps_written_ram = [&](u16 address) {
+    const u32 start = (ZeroExtend32(address) * 8) & RAM_MASK;
+    const u32 end = start + max_bytes;
+    return (start < CAPTURE_BUFFER_END || end > RAM_SIZE || (reverb_writes && end > reverb_start));
+  };
+
+  for (u32 i = 0; i < NUM_VOICES; i++)
+  {
+    const Voice& voice = m_voices[i];
+    const bool key_on = ConvertToBoolUnchecked((m_key_on_register >> i) & 1u);
+    if (!voice.IsOn() && !m_SPUCNT.irq9_enable && !key_on)
+      continue;
+
+    if (overlaps_written_ram(voice.current_address) ||
+        overlaps_written_ram(voice.regs.adpcm_repeat_address & ~u16(1)) ||
+        (key_on && overlaps_written_ram(voice.regs.adpcm_start_address & ~u16(1))))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool SPU::SampleVoiceFrames(u32 voice_index, u32 first_frame, u32 last_frame)
+{
+  VoiceBatch& batch = m_voice_batch;
+  Voice& voice = m_voices[voice_index];
+  s32* volume = batch.volume[voice_index & 1u].data();
+  if (first_frame == last_frame)
+    return false;
+
+  // voices are only turned on by key on, which doesn't happen within a run
+  if (!voice.IsOn() && !m_SPUCNT.irq9_enable)
+  {
+    std::fill(volume + first_frame, volume + last_frame, 0);
+    voice.last_volume = 0;
+    return false;
+  }
+
+  const s32* modulator_volume = batch.volume[(voice_index - 1) & 1u].data();
+  for (u32 i = first_frame; i < last_frame; i++)
+  {
+    batch.left_volume[i] = voice.left_volume.current_level;
+    batch.right_volume[i] = voice.right_volume.current_level;
+    volume[i] = SampleVoice(voice_index, batch.noise_level[i], modulator_volume[i]);
+  }
+
+  return true;
+}
+
+#if defined(CPU_X64)
+
+// SSE2 has no 32-bit multiply-low, so build it from the two 32x32->64 multiplies.
+static ALWAYS_INLINE __m128i ApplyVolumeVector(__m128i sample, __m128i volume)
+{
+  const __m128i even = _mm_mul_epu32(sample, volume);
+  const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(sample, 32), _mm_srli_epi64(volume, 32));
+  const __m128i product = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                             _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+  return _mm_srai_epi32(product, 15);
+}
+
+void SPU::MixVoiceFrames(u32 voice_index, u32 num_frames)
+{
+  VoiceBatch& batch = m_voice_batch;
+  const s32* volume = batch.volume[voice_index & 1u].data();
+  const __m128i reverb_mask = _mm_set1_epi32(IsVoiceReverbEnabled(voice_index) ? -1 : 0);
+
+  // runs past the end of the batch, but those frames are never read
+  for (u32 i = 0; i < num_frames; i += 4)
+  {
+    const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(&volume[i]));
+    const __m128i left =
+      ApplyVolumeVector(v, _mm_load_si128(reinterpret_cast<const __m128i*>(&batch.left_volume[i])));
+    const __m128i right =
+      ApplyVolumeVector(v, _mm_load_si128(reinterpret_cast<const __m128i*>(&batch.right_volume[i])));
+
+    __m128i* left_sum = reinterpret_cast<__m128i*>(&batch.left_sum[i]);
+    __m128i* right_sum = reinterpret_cast<__m128i*>(&batch.right_sum[i]);
+    __m128i* reverb_in_left = reinterpret_cast<__m128i*>(&batch.reverb_in_left[i]);
+    __m128i* reverb_in_right = reinterpret_cast<__m128i*>(&batch.reverb_in_right[i]);
+    _mm_store_si128(left_sum, _mm_add_epi32(_mm_load_si128(left_sum), left));
+    _mm_store_si128(right_sum, _mm_add_epi32(_mm_load_si128(right_sum), right));
+    _mm_store_si128(reverb_in_left, _mm_add_epi32(_mm_load_si128(reverb_in_left), _mm_and_si128(left, reverb_mask)));
+    _mm_store_si128(reverb_in_right,
+                    _mm_add_epi32(_mm_load_si128(reverb_in_right), _mm_and_si128(right, reverb_mask)));
+  }
+}
+
+#elif defined(CPU_AARCH64)
+
+void SPU::MixVoiceFrames(u32 voice_index, u32 num_frames)
+{
+  VoiceBatch& batch = m_voice_batch;
+  const s32* volume = batch.volume[voice_index & 1u].data();
+  const int32x4_t reverb_mask = vdupq_n_s32(IsVoiceReverbEnabled(voice_index) ? -1 : 0);
+
+  // runs past the end of the batch, but those frames are never read
+  for (u32 i = 0; i < num_frames; i += 4)
+  {
+    const int32x4_t v = vld1q_s32(&volume[i]);
+    const int32x4_t left = vshrq_n_s32(vmulq_s32(v, vld1q_s32(&batch.left_volume[i])), 15);
+    const int32x4_t right = vshrq_n_s32(vmulq_s32(v, vld1q_s32(&batch.right_volume[i])), 15);
+    vst1q_s32(&batch.left_sum[i], vaddq_s32(vld1q_s32(&batch.left_sum[i]), left));
+    vst1q_s32(&batch.right_sum[i], vaddq_s32(vld1q_s32(&batch.right_sum[i]), right));
+    vst1q_s32(&batch.reverb_in_left[i], vaddq_s32(vld1q_s32(&batch.reverb_in_left[i]), vandq_s32(left, reverb_mask)));
+    vst1q_s32(&batch.reverb_in_right[i],
+              vaddq_s32(vld1q_s32(&batch.reverb_in_right[i]), vandq_s32(right, reverb_mask)));
+  }
+}
+
+#else
+
+void SPU::MixVoiceFrames(u32 voice_index, u32 num_frames)
+{
+  VoiceBatch& batch = m_voice_batch;
+  const s32* volume = batch.volume[voice_index & 1u].data();
+  const bool reverb = IsVoiceReverbEnabled(voice_index);
+  for (u32 i = 0; i < num_frames; i++)
+  {
+    const s32 left = ApplyVolume(volume[i], static_cast<s16>(batch.left_volume[i]));
+    const s32 right = ApplyVolume(volume[i], static_cast<s16>(batch.right_volume[i]));
+    batch.left_sum[i] += left;
+    batch.right_sum[i] += right;
+    if (reverb)
+    {
+      batch.reverb_in_left[i] += left;
+      batch.reverb_in_right[i] += right;
+    }
+  }
+}
+
+#endif
+
+void SPU::SampleVoiceBatch(u32 num_frames)
+{
+  VoiceBatch& batch = m_voice_batch;
+
+  // Noise is updated at the end of each frame, after the voices have been sampled.
+  for (u32 i = 0; i < num_frames; i++)
+  {
+    batch.noise_level[i] = GetVoiceNoiseLevel();
+    UpdateNoise();
+  }
+
+  const u32 padded_frames = (num_frames + 3) & ~3u;
+  std::fill_n(batch.left_sum.begin(), padded_frames, 0);
+  std::fill_n(batch.right_sum.begin(), padded_frames, 0);
+  std::fill_n(batch.reverb_in_left.begin(), padded_frames, 0);
+  std::fill_n(batch.reverb_in_right.begin(), padded_frames, 0);
+
+  const u32 key_on_register = m_key_on_register;
+  m_key_on_register = 0;
+  const u32 key_off_register = m_key_off_register;
+  m_key_off_register = 0;
+
+  for (u32 voice = 0; voice < NUM_VOICES; voice++)
+  {
+    // key on/off applies after the voice's first frame
+    bool active = SampleVoiceFrames(voice, 0, 1);
+
+    if (key_off_register & (1u << voice))
+      m_voices[voice].KeyOff();
+
+    if (key_on_register & (1u << voice))
+    {
+      m_endx_register &= ~(1u << voice);
+      m_voices[voice].KeyOn();
+    }
+
+    active |= SampleVoiceFrames(voice, 1, num_frames);
+    if (active)
+      MixVoiceFrames(voice, num_frames);
+
+    if (voice == 1 || voice == 3)
+      std::copy_n(batch.volume[voice & 1u].begin(), num_frames, batch.capture_volume[voice / 2].begin());
+  }
+}
+
+void SPU::SampleVoiceFrame()
+{
+  VoiceBatch& batch = m_voice_batch;
+  s32 left_sum = 0;
+  s32 right_sum = 0;
+  s32 reverb_in_left = 0;
+  s32 reverb_in_right = 0;
+
+  u32 key_on_register = m_key_on_register;
+  m_key_on_register = 0;
+  u32 key_off_register = m_key_off_register;
+  m_key_off_register = 0;
+  u32 reverb_on_register = m_reverb_on_register;
+
+  const s16 noise_level = GetVoiceNoiseLevel();
+  s32 modulator_volume = 0;
+  for (u32 voice = 0; voice < NUM_VOICES; voice++)
+  {
+    const s16 left_volume = m_voices[voice].left_volume.current_level;
+    const s16 right_volume = m_voices[voice].right_volume.current_level;
+    const s32 volume = SampleVoice(voice, noise_level, modulator_volume);
+    modulator_volume = volume;
+
+    const s32 left = ApplyVolume(volume, left_volume);
+    const s32 right = ApplyVolume(volume, right_volume);
+    left_sum += left;
+    right_sum += right;
+
+    if (reverb_on_register & 1u)
+    {
+      reverb_in_left += left;
+      reverb_in_right += right;
+    }
+    reverb_on_register >>= 1;
+
+    if (key_off_register & 1u)
+      m_voices[voice].KeyOff();
+    key_off_register >>= 1;
+
+    if (key_on_register & 1u)
+    {
+      m_endx_register &= ~(1u << voice);
+      m_voices[voice].KeyOn();
+    }
+    key_on_register >>= 1;
+  }
+
+  UpdateNoise();
+
+  batch.left_sum[0] = left_sum;
+  batch.right_sum[0] = right_sum;
+  batch.reverb_in_left[0] = reverb_in_left;
+  batch.reverb_in_right[0] = reverb_in_right;
+  batch.capture_volume[0][0] = m_voices[1].last_volume;
+  batch.capture_volume[1][0] = m_voices[3].last_volume;
 }
 
 void SPU::UpdateNoise()
@@ -1699,68 +1971,29 @@ void SPU::ProcessReverb(s16 left_in, s16 right_in, s32* left_out, s32* right_out
   s_last_reverb_output[1] = *right_out = ApplyVolume(out[1], m_reverb_registers.vROUT);
 }
 
-void SPU::Execute(TickCount ticks)
+void SPU::GenerateFrames(s16* output_frame, u32 num_frames_to_generate, bool batch_voices)
 {
-  u32 remaining_frames;
-  if (g_settings.cpu_overclock_active)
+  for (u32 frames_done = 0; frames_done < num_frames_to_generate;)
   {
-    // (X * D) / N / 768 -> (X * D) / (N * 768)
-    const u64 num = (static_cast<u64>(ticks) * g_settings.cpu_overclock_denominator) + static_cast<u32>(m_ticks_carry);
-    remaining_frames = static_cast<u32>(num / m_cpu_tick_divider);
-    m_ticks_carry = static_cast<TickCount>(num % m_cpu_tick_divider);
-  }
-  else
-  {
-    remaining_frames = static_cast<u32>((ticks + m_ticks_carry) / SYSCLK_TICKS_PER_SPU_TICK);
-    m_ticks_carry = (ticks + m_ticks_carry) % SYSCLK_TICKS_PER_SPU_TICK;
-  }
-
-  while (remaining_frames > 0)
-  {
-    AudioStream* const output_stream = g_host_interface->GetAudioStream();
-    s16* output_frame_start;
-    u32 output_frame_space = remaining_frames;
-    output_stream->BeginWrite(&output_frame_start, &output_frame_space);
-
-    s16* output_frame = output_frame_start;
-    const u32 frames_in_this_batch = std::min(remaining_frames, output_frame_space);
-    for (u32 i = 0; i < frames_in_this_batch; i++)
+    u32 num_frames = std::min(num_frames_to_generate - frames_done, MAX_VOICE_BATCH_FRAMES);
+    if (batch_voices && num_frames > 1 && CanBatchVoices(num_frames))
     {
-      s32 left_sum = 0;
-      s32 right_sum = 0;
-      s32 reverb_in_left = 0;
-      s32 reverb_in_right = 0;
-
-      u32 key_on_register = m_key_on_register;
-      m_key_on_register = 0;
-      u32 key_off_register = m_key_off_register;
-      m_key_off_register = 0;
-      u32 reverb_on_register = m_reverb_on_register;
-
-      for (u32 voice = 0; voice < NUM_VOICES; voice++)
-      {
-        const auto [left, right] = SampleVoice(voice);
-        left_sum += left;
-        right_sum += right;
-
-        if (reverb_on_register & 1u)
-        {
-          reverb_in_left += left;
-          reverb_in_right += right;
-        }
-        reverb_on_register >>= 1;
+      SampleVoiceBatch(num_frames);
+    }
+    else
+    {
+      num_frames = 1;
+      SampleVoiceFrame();
+    }
 
-        if (key_off_register & 1u)
-          m_voices[voice].KeyOff();
-        key_off_register >>= 1;
+    frames_done += num_frames;
 
-        if (key_on_register & 1u)
-        {
-          m_endx_register &= ~(1u << voice);
-          m_voices[voice].KeyOn();
-        }
-        key_on_register >>= 1;
-      }
+    for (u32 i = 0; i < num_frames; i++)
+    {
+      s32 left_sum = m_voice_batch.left_sum[i];
+      s32 right_sum = m_voice_batch.right_sum[i];
+      s32 reverb_in_left = m_voice_batch.reverb_in_left[i];
+      s32 reverb_in_right = m_voice_batch.reverb_in_right[i];
 
       if (!m_SPUCNT.mute_n)
       {
@@ -1768,9 +2001,6 @@ void SPU::Execute(TickCount ticks)
         right_sum = 0;
       }
 
-      // Update noise once per frame.
-      UpdateNoise();
-
       // Mix in CD audio.
       const auto [cd_audio_left, cd_audio_right] = g_cdrom.GetAudioFrame();
       if (m_SPUCNT.cd_audio_enable)
@@ -1806,12 +2036,41 @@ void SPU::Execute(TickCount ticks)
       // Write to capture buffers.
       WriteToCaptureBuffer(0, cd_audio_left);
       WriteToCaptureBuffer(1, cd_audio_right);
-      WriteToCaptureBuffer(2, static_cast<s16>(Clamp16(m_voices[1].last_volume)));
-      WriteToCaptureBuffer(3, static_cast<s16>(Clamp16(m_voices[3].last_volume)));
+      WriteToCaptureBuffer(2, static_cast<s16>(Clamp16(m_voice_batch.capture_volume[0][i])));
+      WriteToCaptureBuffer(3, static_cast<s16>(Clamp16(m_voice_batch.capture_volume[1][i])));
       IncrementCaptureBufferPosition();
     }
+  }
+}
+
+void SPU::Execute(TickCount ticks)
+{
+  u32 remaining_frames;
+  if (g_settings.cpu_overclock_active)
+  {
+    // (X * D) / N / 768 -> (X * D) / (N * 768)
+    const u64 num = (static_cast<u64>(ticks) * g_settings.cpu_overclock_denominator) + static_cast<u32>(m_ticks_carry);
+    remaining_frames = static_cast<u32>(num / m_cpu_tick_divider);
+    m_ticks_carry = static_cast<TickCount>(num % m_cpu_tick_divider);
+  }
+  else
+  {
+    remaining_frames = static_cast<u32>((ticks + m_ticks_carry) / SYSCLK_TICKS_PER_SPU_TICK);
+    m_ticks_carry = (ticks + m_ticks_carry) % SYSCLK_TICKS_PER_SPU_TICK;
+  }
+
+  while (remaining_frames > 0)
+  {
+    AudioStream* const output_stream =
+      m_audio_stream_override ? m_audio_stream_override : g_host_interface->GetAudioStream();
+    s16* output_frame_start;
+    u32 output_frame_space = remaining_frames;
+    output_stream->BeginWrite(&output_frame_start, &output_frame_space);
+
+    const u32 frames_in_this_batch = std::min(remaining_frames, output_frame_space);
+    GenerateFrames(output_frame_start, frames_in_this_batch, true);
 
-    if (m_dump_writer)
+    if (m_dump_writer && !m_audio_stream_override)
       m_dump_writer->WriteFrames(output_frame_start, frames_in_this_batch);
 
     output_stream->EndWrite(frames_in_this_batch);
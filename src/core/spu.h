@@ -6,6 +6,7 @@
 #include <array>
 #include <memory>
 
+class AudioStream;
 class StateWrapper;
 
 namespace Common {
@@ -53,6 +54,9 @@ public:
   /// Stops dumping audio to file, if started.
   bool StopDumpingAudio();
 
+  /// Sends generated samples to the specified stream instead of the host's output stream. Pass null to restore.
+  ALWAYS_INLINE void SetAudioStreamOverride(AudioStream* stream) { m_audio_stream_override = stream; }
+
   /// Access to SPU RAM.
   const std::array<u8, RAM_SIZE>& GetRAM() const { return m_ram; }
   std::array<u8, RAM_SIZE>& GetRAM() { return m_ram; }
@@ -73,6 +77,7 @@ private:
   static constexpr u32 NUM_REVERB_REGS = 32;
   static constexpr u32 FIFO_SIZE_IN_HALFWORDS = 32;
   static constexpr TickCount TRANSFER_TICKS_PER_HALFWORD = 32;
+  static constexpr u32 MAX_VOICE_BATCH_FRAMES = 64;
 
   enum class RAMTransferMode : u8
   {
@@ -282,6 +287,26 @@ private:
     void TickADSR();
   };
 
+  /// Output of the voices for a run of frames. Each voice is processed for the whole run before moving on to the next,
+  /// and the results are mixed here before the rest of the per-frame processing (CD audio, reverb, main volume).
+  struct alignas(16) VoiceBatch
+  {
+    std::array<s16, MAX_VOICE_BATCH_FRAMES> noise_level;
+
+    // Volume after ADSR for the current and previous voice. The previous voice is needed for pitch modulation.
+    std::array<std::array<s32, MAX_VOICE_BATCH_FRAMES>, 2> volume;
+    std::array<s32, MAX_VOICE_BATCH_FRAMES> left_volume;
+    std::array<s32, MAX_VOICE_BATCH_FRAMES> right_volume;
+
+    std::array<s32, MAX_VOICE_BATCH_FRAMES> left_sum;
+    std::array<s32, MAX_VOICE_BATCH_FRAMES> right_sum;
+    std::array<s32, MAX_VOICE_BATCH_FRAMES> reverb_in_left;
+    std::array<s32, MAX_VOICE_BATCH_FRAMES> reverb_in_right;
+
+    // Voices 1 and 3 are written to the capture buffers.
+    std::array<std::array<s32, MAX_VOICE_BATCH_FRAMES>, 2> capture_volume;
+  };
+
   struct ReverbRegisters
   {
     s16 vLOUT;
@@ -351,7 +376,24 @@ private:
   void IncrementCaptureBufferPosition();
 
   void ReadADPCMBlock(u16 address, ADPCMBlock* block);
-  std::tuple<s32, s32> SampleVoice(u32 voice_index);
+
+  s32 SampleVoice(u32 voice_index, s16 noise_level, s32 modulator_volume);
+
+  /// Returns true if voices may be processed for more than one frame at a time. This isn't the case if a voice might
+  /// read sample data that the capture buffers or reverb will write to during the run.
+  bool CanBatchVoices(u32 num_frames) const;
+
+  /// Samples a voice for frames [first_frame, last_frame) of the batch. Returns false if the voice was off.
+  bool SampleVoiceFrames(u32 voice_index, u32 first_frame, u32 last_frame);
+
+  /// Applies the channel volumes of a voice, and adds it to the batch's mix.
+  void MixVoiceFrames(u32 voice_index, u32 num_frames);
+
+  /// Generates the output of all voices for the next frames, processing key on/off after the first.
+  void SampleVoiceBatch(u32 num_frames);
+
+  /// Generates the output of all voices for a single frame, used when the voices can't be batched.
+  void SampleVoiceFrame();
 
   void UpdateNoise();
 
@@ -360,6 +402,9 @@ private:
   void ReverbWrite(u32 address, s16 data);
   void ProcessReverb(s16 left_in, s16 right_in, s32* left_out, s32* right_out);
 
+  /// Generates frames of output, running the voices in batches where possible unless batch_voices is false.
+  void GenerateFrames(s16* output_frame, u32 num_frames_to_generate, bool batch_voices);
+
   void Execute(TickCount ticks);
   void UpdateEventInterval();
 
@@ -372,6 +417,7 @@ private:
 
   std::unique_ptr<TimingEvent> m_tick_event;
   std::unique_ptr<TimingEvent> m_transfer_event;
+  AudioStream* m_audio_stream_override = nullptr;
   std::unique_ptr<Common::WAVWriter> m_dump_writer;
   TickCount m_ticks_carry = 0;
   TickCount m_cpu_ticks_per_spu_tick = 0;
@@ -416,10 +462,14 @@ private:
   s32 m_reverb_resample_buffer_position = 0;
 
   std::array<Voice, NUM_VOICES> m_voices{};
+  VoiceBatch m_voice_batch{};
 
   InlineFIFOQueue<u16, FIFO_SIZE_IN_HALFWORDS> m_transfer_fifo;
 
   std::array<u8, RAM_SIZE> m_ram{};
+
+  // Drives the voice and reverb processing directly, without the timing events or an audio stream.
+  friend class SPUTest;
 };
 
 extern SPU g_spu;
\ No newline at end of file
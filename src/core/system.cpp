@@ -3,6 +3,7 @@
 #include "bus.h"
 #include "cdrom.h"
 #include "cheats.h"
+#include "common/align.h"
 #include "common/audio_stream.h"
 #include "common/file_system.h"
 #include "common/iso_reader.h"
@@ -29,8 +30,12 @@
 #include "spu.h"
 #include "texture_replacements.h"
 #include "timers.h"
+#include "zlib.h"
+#include <array>
 #include <cctype>
+#include <cinttypes>
 #include <cstdio>
+#include <deque>
 #include <fstream>
 #include <limits>
 Log_SetChannel(System);
@@ -60,13 +65,38 @@ static bool SetExpansionROM(const char* filename);
 static std::unique_ptr<CDImage> OpenCDImage(const char* path, bool force_preload);
 
 static bool DoLoadState(ByteStream* stream, bool force_software_renderer, bool update_display);
-static bool DoState(StateWrapper& sw, bool update_display);
+static bool CompressStateData(ByteStream* stream, u32 compression_type, const void* data, u32 data_size,
+                              u32* compressed_size);
+static std::unique_ptr<ByteStream> DecompressStateData(ByteStream* stream, u32 compression_type, u32 compressed_size,
+                                                       u32 uncompressed_size);
+static bool DoState(StateWrapper& sw, bool update_display, bool is_memory_state);
 static bool CreateGPU(GPURenderer renderer);
 
 static bool Initialize(bool force_software_renderer);
 
 static void UpdateRunningGame(const char* path, CDImage* image);
 
+/// Loads/saves the recompiler's persistent code cache for the running game.
+static std::string GetPersistentCodeCacheFileName();
+static void LoadPersistentCodeCache();
+static void SavePersistentCodeCache();
+
+static void DoRunFrame();
+
+static bool SaveMemoryState(GrowableMemoryByteStream* stream);
+static bool LoadMemoryState(GrowableMemoryByteStream* stream, bool update_display);
+static void DoMemorySaveStates();
+
+static void DoRunahead();
+
+static void SaveRewindState();
+static void DoRewind();
+static u32 EncodeRewindDelta(std::vector<u8>* delta, const u8* old_data, u32 old_size, const u8* new_data,
+                             u32 new_size);
+static bool ApplyRewindDelta(GrowableMemoryByteStream* stream, const u8* delta, u32 delta_size);
+static u32 CompressRewindDelta(std::vector<u8>* compressed, const u8* delta, u32 delta_size);
+static bool DecompressRewindDelta(std::vector<u8>* delta, u32* delta_size, const std::vector<u8>& compressed);
+
 static State s_state = State::Shutdown;
 
 static ConsoleRegion s_region = ConsoleRegion::NTSC_U;
@@ -106,6 +136,28 @@ static std::string s_media_playlist_filename;
 
 static std::unique_ptr<CheatList> s_cheat_list;
 
+// Rewind buffer. Only the most recent capture is kept in full, each older capture is stored as a deflated XOR/RLE
+// delta which turns the next-newest capture back into it, so stepping backwards pops one delta at a time. The oldest
+// deltas are dropped when either the slot count or the memory limit is exceeded.
+static std::unique_ptr<GrowableMemoryByteStream> s_rewind_current_state;
+static std::unique_ptr<GrowableMemoryByteStream> s_rewind_scratch_state;
+static std::deque<std::vector<u8>> s_rewind_deltas;
+static std::vector<u8> s_rewind_delta_buffer;
+static std::vector<u8> s_rewind_compress_buffer;
+static u64 s_rewind_delta_bytes = 0;
+static bool s_rewind_buffer_full = false;
+static s32 s_rewind_save_counter = -1;
+static bool s_rewind_has_state = false;
+static bool s_rewinding = false;
+
+// Runahead state, restored after running the hidden frames. Preallocated so saving doesn't touch the heap.
+static std::unique_ptr<GrowableMemoryByteStream> s_runahead_state;
+static std::unique_ptr<AudioStream> s_runahead_audio_stream;
+static u32 s_runahead_frames = 0;
+
+// Size of the last compressed state's data, so the next snapshot buffer doesn't have to grow.
+static u32 s_last_state_data_size = 4 * 1024 * 1024;
+
 State GetState()
 {
   return s_state;
@@ -534,6 +586,13 @@ std::unique_ptr<CDImage> OpenCDImage(const char* path, bool force_preload)
 
   if (force_preload || g_settings.cdrom_load_image_to_ram)
   {
+    // memory mapped images are already in memory as far as we're concerned, the OS just has to page them in
+    if (media->Precache())
+    {
+      Log_InfoPrintf("Image '%s' is memory mapped, not copying to RAM", path);
+      return media;
+    }
+
     HostInterfaceProgressCallback callback;
     std::unique_ptr<CDImage> memory_image = CDImage::CreateMemoryImage(media.get(), &callback);
     if (memory_image)
@@ -748,6 +807,7 @@ bool Initialize(bool force_software_renderer)
 
   // CPU code cache must happen after GPU, because it might steal our address space.
   CPU::CodeCache::Initialize();
+  LoadPersistentCodeCache();
 
   g_dma.Initialize();
   g_interrupt_controller.Initialize();
@@ -759,6 +819,8 @@ bool Initialize(bool force_software_renderer)
   g_mdec.Initialize();
   g_sio.Initialize();
 
+  UpdateMemorySaveStateSettings();
+
   if (g_settings.cpu_overclock_active)
   {
     g_host_interface->AddFormattedOSDMessage(
@@ -779,6 +841,17 @@ void Shutdown()
 
   g_texture_replacements.Shutdown();
 
+  s_rewind_save_counter = -1;
+  s_rewinding = false;
+  ClearMemorySaveStates();
+  s_rewind_current_state.reset();
+  s_rewind_scratch_state.reset();
+  s_rewind_delta_buffer = {};
+  s_rewind_compress_buffer = {};
+  s_runahead_frames = 0;
+  s_runahead_state.reset();
+  s_runahead_audio_stream.reset();
+
   g_sio.Shutdown();
   g_mdec.Shutdown();
   g_spu.Shutdown();
@@ -788,6 +861,7 @@ void Shutdown()
   g_gpu.reset();
   g_interrupt_controller.Shutdown();
   g_dma.Shutdown();
+  SavePersistentCodeCache();
   CPU::CodeCache::Shutdown();
   Bus::Shutdown();
   CPU::Shutdown();
@@ -839,7 +913,7 @@ bool CreateGPU(GPURenderer renderer)
   return true;
 }
 
-bool DoState(StateWrapper& sw, bool update_display)
+bool DoState(StateWrapper& sw, bool update_display, bool is_memory_state)
 {
   if (!sw.DoMarker("System"))
     return false;
@@ -851,7 +925,9 @@ bool DoState(StateWrapper& sw, bool update_display)
   if (!sw.DoMarker("CPU") || !CPU::DoState(sw))
     return false;
 
-  if (sw.IsReading())
+  // Memory states are loaded often, so keep the compiled blocks around. Bus::DoState() invalidates any code pages
+  // which differ in the incoming state.
+  if (sw.IsReading() && !is_memory_state)
     CPU::CodeCache::Flush();
 
   if (!sw.DoMarker("Bus") || !Bus::DoState(sw))
@@ -872,7 +948,7 @@ bool DoState(StateWrapper& sw, bool update_display)
   if (!sw.DoMarker("CDROM") || !g_cdrom.DoState(sw))
     return false;
 
-  if (!sw.DoMarker("Pad") || !g_pad.DoState(sw))
+  if (!sw.DoMarker("Pad") || !g_pad.DoState(sw, is_memory_state))
     return false;
 
   if (!sw.DoMarker("Timers") || !g_timers.DoState(sw))
@@ -881,6 +957,10 @@ bool DoState(StateWrapper& sw, bool update_display)
   if (!sw.DoMarker("SPU") || !g_spu.DoState(sw))
     return false;
 
+  // Don't drop the queued audio for memory states, since runahead restores one every frame.
+  if (sw.IsReading() && !is_memory_state)
+    g_host_interface->GetAudioStream()->EmptyBuffers();
+
   if (!sw.DoMarker("MDEC") || !g_mdec.DoState(sw))
     return false;
 
@@ -941,6 +1021,7 @@ void Reset()
   s_internal_frame_number = 0;
   TimingEvents::Reset();
   ResetPerformanceCounters();
+  ClearMemorySaveStates();
 
   g_gpu->ResetGraphicsAPIState();
 }
@@ -1074,26 +1155,31 @@ bool DoLoadState(ByteStream* state, bool force_software_renderer, bool update_di
       UpdateMemoryCards();
   }
 
-  if (header.data_compression_type != 0)
-  {
-    g_host_interface->ReportFormattedError("Unknown save state compression type %u", header.data_compression_type);
-    return false;
-  }
-
   if (!state->SeekAbsolute(header.offset_to_data))
     return false;
 
-  StateWrapper sw(state, StateWrapper::Mode::Read, header.version);
-  if (!DoState(sw, update_display))
+  std::unique_ptr<ByteStream> data_stream;
+  if (header.data_compression_type != SAVE_STATE_COMPRESSION_TYPE_NONE)
+  {
+    data_stream = DecompressStateData(state, header.data_compression_type, header.data_compressed_size,
+                                      header.data_uncompressed_size);
+    if (!data_stream)
+      return false;
+  }
+
+  StateWrapper sw(data_stream ? data_stream.get() : state, StateWrapper::Mode::Read, header.version);
+  if (!DoState(sw, update_display, false))
     return false;
 
   if (s_state == State::Starting)
     s_state = State::Running;
 
+  ClearMemorySaveStates();
+
   return true;
 }
 
-bool SaveState(ByteStream* state, u32 screenshot_size /* = 128 */)
+bool SaveState(ByteStream* state, u32 screenshot_size /* = 128 */, bool compress_data /* = false */)
 {
   if (IsShutdown())
     return false;
@@ -1148,18 +1234,37 @@ bool SaveState(ByteStream* state, u32 screenshot_size /* = 128 */)
   {
     header.offset_to_data = static_cast<u32>(state->GetPosition());
 
+    // Compressed states are snapshotted to memory first, so the time spent in the codec isn't spent serializing.
+    std::unique_ptr<GrowableMemoryByteStream> data_stream;
+    if (compress_data)
+      data_stream = ByteStream_CreateGrowableMemoryStream(nullptr, s_last_state_data_size);
+
     g_gpu->RestoreGraphicsAPIState();
 
-    StateWrapper sw(state, StateWrapper::Mode::Write, SAVE_STATE_VERSION);
-    const bool result = DoState(sw, false);
+    StateWrapper sw(data_stream ? data_stream.get() : state, StateWrapper::Mode::Write, SAVE_STATE_VERSION);
+    const bool result = DoState(sw, false, false);
 
     g_gpu->ResetGraphicsAPIState();
 
     if (!result)
       return false;
 
-    header.data_compression_type = 0;
-    header.data_uncompressed_size = static_cast<u32>(state->GetPosition() - header.offset_to_data);
+    if (data_stream)
+    {
+      header.data_compression_type = SAVE_STATE_COMPRESSION_TYPE_DEFLATE;
+      header.data_uncompressed_size = static_cast<u32>(data_stream->GetSize());
+      s_last_state_data_size = header.data_uncompressed_size;
+      if (!CompressStateData(state, header.data_compression_type, data_stream->GetMemoryPointer(),
+                             header.data_uncompressed_size, &header.data_compressed_size))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      header.data_compression_type = SAVE_STATE_COMPRESSION_TYPE_NONE;
+      header.data_uncompressed_size = static_cast<u32>(state->GetPosition() - header.offset_to_data);
+    }
   }
 
   // re-write header
@@ -1173,6 +1278,135 @@ bool SaveState(ByteStream* state, u32 screenshot_size /* = 128 */)
   return true;
 }
 
+bool WriteStateSnapshot(ByteStream* state, const void* snapshot_data, u32 snapshot_size, bool compress_data)
+{
+  SAVE_STATE_HEADER header;
+  if (snapshot_size < sizeof(header))
+    return false;
+
+  std::memcpy(&header, snapshot_data, sizeof(header));
+  if (header.magic != SAVE_STATE_MAGIC || header.data_compression_type != SAVE_STATE_COMPRESSION_TYPE_NONE ||
+      header.offset_to_data > snapshot_size || header.data_uncompressed_size > (snapshot_size - header.offset_to_data))
+  {
+    Log_ErrorPrintf("Invalid state snapshot");
+    return false;
+  }
+
+  if (!compress_data)
+    return state->Write2(snapshot_data, snapshot_size);
+
+  // offsets in the header are relative to the start of the state, so the prefix can be copied as-is
+  const u8* snapshot_bytes = static_cast<const u8*>(snapshot_data);
+  const u64 header_position = state->GetPosition();
+  if (!state->Write2(snapshot_bytes, header.offset_to_data))
+    return false;
+
+  header.data_compression_type = SAVE_STATE_COMPRESSION_TYPE_DEFLATE;
+  if (!CompressStateData(state, header.data_compression_type, snapshot_bytes + header.offset_to_data,
+                         header.data_uncompressed_size, &header.data_compressed_size))
+  {
+    return false;
+  }
+
+  const u64 end_position = state->GetPosition();
+  return (state->SeekAbsolute(header_position) && state->Write2(&header, sizeof(header)) &&
+          state->SeekAbsolute(end_position));
+}
+
+bool CompressStateData(ByteStream* stream, u32 compression_type, const void* data, u32 data_size,
+                       u32* compressed_size)
+{
+  switch (compression_type)
+  {
+    case SAVE_STATE_COMPRESSION_TYPE_DEFLATE:
+    {
+      z_stream zs = {};
+      int err = deflateInit(&zs, Z_BEST_SPEED);
+      if (err != Z_OK)
+      {
+        Log_ErrorPrintf("deflateInit() failed: %d", err);
+        return false;
+      }
+
+      std::array<u8, 64 * 1024> buffer;
+      zs.next_in = static_cast<Bytef*>(const_cast<void*>(data));
+      zs.avail_in = data_size;
+      do
+      {
+        zs.next_out = buffer.data();
+        zs.avail_out = static_cast<uInt>(buffer.size());
+        err = deflate(&zs, Z_FINISH);
+        if (err == Z_STREAM_ERROR)
+        {
+          Log_ErrorPrintf("deflate() failed: %d", err);
+          deflateEnd(&zs);
+          return false;
+        }
+
+        const u32 bytes_out = static_cast<u32>(buffer.size() - zs.avail_out);
+        if (bytes_out > 0 && !stream->Write2(buffer.data(), bytes_out))
+        {
+          deflateEnd(&zs);
+          return false;
+        }
+      } while (err != Z_STREAM_END);
+
+      *compressed_size = static_cast<u32>(zs.total_out);
+      deflateEnd(&zs);
+      Log_DevPrintf("Compressed save state data from %u to %u bytes", data_size, *compressed_size);
+      return true;
+    }
+
+    default:
+      Log_ErrorPrintf("Unknown save state compression type %u", compression_type);
+      return false;
+  }
+}
+
+std::unique_ptr<ByteStream> DecompressStateData(ByteStream* stream, u32 compression_type, u32 compressed_size,
+                                                u32 uncompressed_size)
+{
+  // The sizes come from the file, so don't let a corrupted header allocate or read more than a state can hold.
+  const u64 remaining_size = stream->GetSize() - std::min(stream->GetPosition(), stream->GetSize());
+  if (compressed_size > MAX_SAVE_STATE_SIZE || uncompressed_size > MAX_SAVE_STATE_SIZE ||
+      compressed_size > remaining_size)
+  {
+    Log_ErrorPrintf("Invalid save state data size (%u compressed, %u uncompressed, %" PRIu64 " bytes remaining)",
+                    compressed_size, uncompressed_size, remaining_size);
+    return {};
+  }
+
+  switch (compression_type)
+  {
+    case SAVE_STATE_COMPRESSION_TYPE_DEFLATE:
+    {
+      std::vector<u8> compressed_data(compressed_size);
+      if (!stream->Read2(compressed_data.data(), compressed_size))
+        return {};
+
+      std::unique_ptr<GrowableMemoryByteStream> data_stream =
+        ByteStream_CreateGrowableMemoryStream(nullptr, uncompressed_size);
+      data_stream->Resize(uncompressed_size);
+
+      uLongf data_size = uncompressed_size;
+      const int err =
+        uncompress(data_stream->GetMemoryPointer(), &data_size, compressed_data.data(), compressed_size);
+      if (err != Z_OK || data_size != uncompressed_size)
+      {
+        Log_ErrorPrintf("uncompress() failed: %d (%u of %u bytes)", err, static_cast<u32>(data_size),
+                        uncompressed_size);
+        return {};
+      }
+
+      return data_stream;
+    }
+
+    default:
+      g_host_interface->ReportFormattedError("Unknown save state compression type %u", compression_type);
+      return {};
+  }
+}
+
 void SingleStepCPU()
 {
   const u32 old_frame_number = s_frame_number;
@@ -1195,6 +1429,22 @@ void RunFrame()
 {
   s_frame_timer.Reset();
 
+  if (s_rewinding)
+  {
+    DoRewind();
+    return;
+  }
+
+  if (s_runahead_frames > 0)
+    DoRunahead();
+  else
+    DoRunFrame();
+
+  DoMemorySaveStates();
+}
+
+void DoRunFrame()
+{
   g_gpu->RestoreGraphicsAPIState();
 
   if (CPU::g_state.use_debug_dispatcher)
@@ -1233,6 +1483,393 @@ void RunFrame()
   g_gpu->ResetGraphicsAPIState();
 }
 
+bool SaveMemoryState(GrowableMemoryByteStream* stream)
+{
+  stream->Resize(0);
+  stream->SeekAbsolute(0);
+
+  StateWrapper sw(stream, StateWrapper::Mode::Write, SAVE_STATE_VERSION);
+  return DoState(sw, false, true);
+}
+
+bool LoadMemoryState(GrowableMemoryByteStream* stream, bool update_display)
+{
+  stream->SeekAbsolute(0);
+
+  StateWrapper sw(stream, StateWrapper::Mode::Read, SAVE_STATE_VERSION);
+  return DoState(sw, update_display, true);
+}
+
+void UpdateMemorySaveStateSettings()
+{
+  ClearMemorySaveStates();
+
+  s_runahead_frames = g_settings.runahead_frames;
+  if (s_runahead_frames > 0)
+  {
+    if (!s_runahead_state)
+    {
+      s_runahead_state = ByteStream_CreateGrowableMemoryStream(nullptr, MAX_SAVE_STATE_SIZE);
+      s_runahead_audio_stream = AudioStream::CreateNullAudioStream();
+    }
+
+    Log_InfoPrintf("Runahead is enabled, running %u frames ahead", s_runahead_frames);
+  }
+  else
+  {
+    s_runahead_state.reset();
+    s_runahead_audio_stream.reset();
+  }
+
+  if (!g_settings.rewind_enable)
+  {
+    s_rewind_save_counter = -1;
+    s_rewinding = false;
+    s_rewind_current_state.reset();
+    s_rewind_scratch_state.reset();
+    s_rewind_delta_buffer = {};
+    s_rewind_compress_buffer = {};
+    return;
+  }
+
+  // Preallocate both snapshots so capturing doesn't have to grow the streams.
+  if (!s_rewind_current_state)
+  {
+    s_rewind_current_state = ByteStream_CreateGrowableMemoryStream(nullptr, MAX_SAVE_STATE_SIZE);
+    s_rewind_scratch_state = ByteStream_CreateGrowableMemoryStream(nullptr, MAX_SAVE_STATE_SIZE);
+  }
+
+  s_rewind_save_counter = 0;
+  Log_InfoPrintf("Rewind is enabled, saving every %u frames, keeping up to %u states in %u MB",
+                 g_settings.rewind_save_interval, g_settings.rewind_save_slots, g_settings.rewind_max_memory);
+}
+
+void ClearMemorySaveStates()
+{
+  s_rewind_deltas.clear();
+  s_rewind_delta_bytes = 0;
+  s_rewind_buffer_full = false;
+  s_rewind_has_state = false;
+  if (s_rewind_save_counter > 0)
+    s_rewind_save_counter = 0;
+}
+
+bool IsRewinding()
+{
+  return s_rewinding;
+}
+
+void SetRewinding(bool enabled)
+{
+  s_rewinding = enabled && s_rewind_save_counter >= 0;
+}
+
+void DoMemorySaveStates()
+{
+  if (s_rewind_save_counter < 0)
+    return;
+
+  if (s_rewind_save_counter > 0)
+  {
+    s_rewind_save_counter--;
+    return;
+  }
+
+  s_rewind_save_counter = static_cast<s32>(g_settings.rewind_save_interval) - 1;
+  SaveRewindState();
+}
+
+void SaveRewindState()
+{
+  Common::Timer save_timer;
+
+  if (!SaveMemoryState(s_rewind_scratch_state.get()))
+  {
+    Log_ErrorPrintf("Failed to save rewind state");
+    return;
+  }
+
+  if (s_rewind_has_state)
+  {
+    const u32 delta_size =
+      EncodeRewindDelta(&s_rewind_delta_buffer, s_rewind_current_state->GetMemoryPointer(),
+                        static_cast<u32>(s_rewind_current_state->GetSize()), s_rewind_scratch_state->GetMemoryPointer(),
+                        static_cast<u32>(s_rewind_scratch_state->GetSize()));
+
+    const u32 compressed_size =
+      CompressRewindDelta(&s_rewind_compress_buffer, s_rewind_delta_buffer.data(), delta_size);
+    if (compressed_size == 0)
+    {
+      Log_ErrorPrintf("Failed to compress rewind delta, discarding rewind buffer");
+      ClearMemorySaveStates();
+      return;
+    }
+
+    s_rewind_delta_bytes += compressed_size;
+    s_rewind_deltas.emplace_back(s_rewind_compress_buffer.begin(), s_rewind_compress_buffer.begin() + compressed_size);
+
+    // The current state counts as a slot too.
+    const u64 max_delta_bytes = static_cast<u64>(g_settings.rewind_max_memory) * 1048576;
+    bool dropped_delta = false;
+    while (!s_rewind_deltas.empty() &&
+           (s_rewind_deltas.size() >= g_settings.rewind_save_slots || s_rewind_delta_bytes > max_delta_bytes))
+    {
+      s_rewind_delta_bytes -= s_rewind_deltas.front().size();
+      s_rewind_deltas.pop_front();
+      dropped_delta = true;
+    }
+
+    if (dropped_delta && !s_rewind_buffer_full)
+    {
+      s_rewind_buffer_full = true;
+      Log_InfoPrintf("Rewind buffer is full: %u states covering %u frames, %.2f MB of deltas and %.2f MB of snapshots",
+                     static_cast<u32>(s_rewind_deltas.size() + 1),
+                     static_cast<u32>(s_rewind_deltas.size()) * g_settings.rewind_save_interval,
+                     static_cast<double>(s_rewind_delta_bytes) / 1048576.0,
+                     static_cast<double>(s_rewind_current_state->GetSize() + s_rewind_scratch_state->GetSize()) /
+                       1048576.0);
+    }
+  }
+
+  std::swap(s_rewind_current_state, s_rewind_scratch_state);
+  s_rewind_has_state = true;
+
+  Log_DevPrintf("Saved rewind state (%u bytes, %u deltas using %.2f MB) in %.4f ms",
+                static_cast<u32>(s_rewind_current_state->GetSize()), static_cast<u32>(s_rewind_deltas.size()),
+                static_cast<double>(s_rewind_delta_bytes) / 1048576.0, save_timer.GetTimeMilliseconds());
+}
+
+void DoRewind()
+{
+  if (!s_rewind_has_state)
+    return;
+
+  Common::Timer load_timer;
+
+  // Once we run out of deltas, we stay at the oldest state.
+  if (!s_rewind_deltas.empty())
+  {
+    u32 delta_size;
+    if (!DecompressRewindDelta(&s_rewind_delta_buffer, &delta_size, s_rewind_deltas.back()) ||
+        !ApplyRewindDelta(s_rewind_current_state.get(), s_rewind_delta_buffer.data(), delta_size))
+    {
+      Log_ErrorPrintf("Corrupted rewind delta, discarding rewind buffer");
+      ClearMemorySaveStates();
+      return;
+    }
+
+    s_rewind_delta_bytes -= s_rewind_deltas.back().size();
+    s_rewind_deltas.pop_back();
+  }
+
+  if (!LoadMemoryState(s_rewind_current_state.get(), true))
+  {
+    Log_ErrorPrintf("Failed to load rewind state");
+    ClearMemorySaveStates();
+    return;
+  }
+
+  // Resume capturing from the state we rewound to.
+  s_rewind_save_counter = static_cast<s32>(g_settings.rewind_save_interval) - 1;
+
+  Log_DevPrintf("Rewound to frame %u, %u states remaining, took %.4f ms", s_frame_number,
+                static_cast<u32>(s_rewind_deltas.size()), load_timer.GetTimeMilliseconds());
+}
+
+void DoRunahead()
+{
+  // Run the real frame, which is kept. What it displays will be replaced by the last frame we run ahead.
+  g_gpu->SetSkipDisplayUpdates(true);
+  DoRunFrame();
+
+  if (!SaveMemoryState(s_runahead_state.get()))
+  {
+    Log_ErrorPrintf("Failed to save runahead state, disabling runahead");
+    g_gpu->SetSkipDisplayUpdates(false);
+    s_runahead_frames = 0;
+    return;
+  }
+
+  // Run ahead with the current input, throwing away the audio and only scanning out the final frame.
+  g_spu.SetAudioStreamOverride(s_runahead_audio_stream.get());
+  for (u32 i = 0; i < s_runahead_frames; i++)
+  {
+    g_gpu->SetSkipDisplayUpdates(i != (s_runahead_frames - 1));
+    DoRunFrame();
+  }
+  g_spu.SetAudioStreamOverride(nullptr);
+  g_gpu->SetSkipDisplayUpdates(false);
+
+  if (!LoadMemoryState(s_runahead_state.get(), false))
+  {
+    Log_ErrorPrintf("Failed to load runahead state, disabling runahead");
+    s_runahead_frames = 0;
+  }
+}
+
+// Delta format: the old size, followed by runs of [zero word count, literal word count, literal words], where words are
+// 64-bit XORs of the two snapshots. Bytes past the end of either snapshot are treated as zero.
+ALWAYS_INLINE static u64 ReadRewindDeltaWord(const u8* data, u32 size, u32 offset)
+{
+  u64 value = 0;
+  if ((offset + sizeof(value)) <= size)
+    std::memcpy(&value, data + offset, sizeof(value));
+  else if (offset < size)
+    std::memcpy(&value, data + offset, size - offset);
+
+  return value;
+}
+
+template<typename T>
+ALWAYS_INLINE static void WriteRewindDeltaValue(std::vector<u8>* delta, u32 offset, T value)
+{
+  std::memcpy(delta->data() + offset, &value, sizeof(value));
+}
+
+u32 EncodeRewindDelta(std::vector<u8>* delta, const u8* old_data, u32 old_size, const u8* new_data, u32 new_size)
+{
+  const u32 total_size = Common::AlignUpPow2(std::max(old_size, new_size), sizeof(u64));
+
+  // Worst case is every other word changing. The buffer is reused between captures, so never shrink it.
+  const size_t max_delta_size =
+    sizeof(u32) + (total_size / sizeof(u64)) * (sizeof(u64) + sizeof(u32)) + sizeof(u32) * 2;
+  if (delta->size() < max_delta_size)
+    delta->resize(max_delta_size);
+
+  WriteRewindDeltaValue(delta, 0, old_size);
+
+  u32 out_pos = sizeof(u32);
+  u32 offset = 0;
+  while (offset < total_size)
+  {
+    u32 zero_words = 0;
+    while (offset < total_size &&
+           ReadRewindDeltaWord(old_data, old_size, offset) == ReadRewindDeltaWord(new_data, new_size, offset))
+    {
+      zero_words++;
+      offset += sizeof(u64);
+    }
+
+    if (offset == total_size)
+      break;
+
+    const u32 run_pos = out_pos;
+    out_pos += sizeof(u32) * 2;
+
+    u32 literal_words = 0;
+    while (offset < total_size)
+    {
+      const u64 value =
+        ReadRewindDeltaWord(old_data, old_size, offset) ^ ReadRewindDeltaWord(new_data, new_size, offset);
+      if (value == 0)
+        break;
+
+      WriteRewindDeltaValue(delta, out_pos, value);
+      out_pos += sizeof(u64);
+      literal_words++;
+      offset += sizeof(u64);
+    }
+
+    WriteRewindDeltaValue(delta, run_pos, zero_words);
+    WriteRewindDeltaValue(delta, run_pos + sizeof(u32), literal_words);
+  }
+
+  return out_pos;
+}
+
+bool ApplyRewindDelta(GrowableMemoryByteStream* stream, const u8* delta, u32 delta_size)
+{
+  if (delta_size < sizeof(u32))
+    return false;
+
+  u32 old_size;
+  std::memcpy(&old_size, delta, sizeof(old_size));
+
+  const u32 current_size = static_cast<u32>(stream->GetSize());
+  const u32 total_size = Common::AlignUpPow2(std::max(old_size, current_size), sizeof(u64));
+  stream->Resize(total_size);
+
+  u8* data = stream->GetMemoryPointer();
+  std::memset(data + current_size, 0, total_size - current_size);
+
+  u32 in_pos = sizeof(u32);
+  u32 offset = 0;
+  while (in_pos < delta_size)
+  {
+    if ((in_pos + sizeof(u32) * 2) > delta_size)
+      return false;
+
+    u32 zero_words, literal_words;
+    std::memcpy(&zero_words, delta + in_pos, sizeof(zero_words));
+    std::memcpy(&literal_words, delta + in_pos + sizeof(u32), sizeof(literal_words));
+    in_pos += sizeof(u32) * 2;
+
+    offset += zero_words * sizeof(u64);
+    if ((offset + literal_words * sizeof(u64)) > total_size || (in_pos + literal_words * sizeof(u64)) > delta_size)
+    {
+      return false;
+    }
+
+    for (u32 i = 0; i < literal_words; i++)
+    {
+      u64 current_value, delta_value;
+      std::memcpy(&current_value, data + offset, sizeof(current_value));
+      std::memcpy(&delta_value, delta + in_pos, sizeof(delta_value));
+      current_value ^= delta_value;
+      std::memcpy(data + offset, &current_value, sizeof(current_value));
+      offset += sizeof(u64);
+      in_pos += sizeof(u64);
+    }
+  }
+
+  stream->Resize(old_size);
+  return true;
+}
+
+// Compressed deltas are the size of the XOR/RLE delta, followed by the deflated delta. Most of a delta is run lengths
+// and partially-changed words, which deflate shrinks several times over.
+u32 CompressRewindDelta(std::vector<u8>* compressed, const u8* delta, u32 delta_size)
+{
+  const size_t max_compressed_size = sizeof(u32) + compressBound(delta_size);
+  if (compressed->size() < max_compressed_size)
+    compressed->resize(max_compressed_size);
+
+  std::memcpy(compressed->data(), &delta_size, sizeof(delta_size));
+
+  uLongf data_size = static_cast<uLongf>(max_compressed_size - sizeof(u32));
+  const int err = compress2(compressed->data() + sizeof(u32), &data_size, delta, delta_size, Z_BEST_SPEED);
+  if (err != Z_OK)
+  {
+    Log_ErrorPrintf("compress2() failed: %d", err);
+    return 0;
+  }
+
+  return static_cast<u32>(sizeof(u32) + data_size);
+}
+
+bool DecompressRewindDelta(std::vector<u8>* delta, u32* delta_size, const std::vector<u8>& compressed)
+{
+  if (compressed.size() < sizeof(u32))
+    return false;
+
+  u32 size;
+  std::memcpy(&size, compressed.data(), sizeof(size));
+  if (delta->size() < size)
+    delta->resize(size);
+
+  uLongf data_size = size;
+  const int err = uncompress(delta->data(), &data_size, compressed.data() + sizeof(u32),
+                             static_cast<uLong>(compressed.size() - sizeof(u32)));
+  if (err != Z_OK || data_size != size)
+  {
+    Log_ErrorPrintf("uncompress() failed: %d (%u of %u bytes)", err, static_cast<u32>(data_size), size);
+    return false;
+  }
+
+  *delta_size = size;
+  return true;
+}
+
 float GetTargetSpeed()
 {
   return s_target_speed;
@@ -1677,6 +2314,14 @@ bool DumpVRAM(const char* filename)
   return result;
 }
 
+bool RecordGPUCommands(const char* filename, u32 num_frames)
+{
+  if (!IsValid())
+    return false;
+
+  return g_gpu->StartRecordingCommands(filename, num_frames);
+}
+
 bool DumpSPURAM(const char* filename)
 {
   if (!IsValid())
@@ -1696,6 +2341,7 @@ bool InsertMedia(const char* path)
   if (!image)
     return false;
 
+  SavePersistentCodeCache();
   UpdateRunningGame(path, image.get());
   g_cdrom.InsertMedia(std::move(image));
   Log_InfoPrintf("Inserted media from %s (%s, %s)", s_running_game_path.c_str(), s_running_game_code.c_str(),
@@ -1710,7 +2356,10 @@ bool InsertMedia(const char* path)
 
   // reinitialize recompiler, because especially with preloading this might overlap the fastmem area
   if (g_settings.IsUsingCodeCache())
+  {
     CPU::CodeCache::Reinitialize();
+    LoadPersistentCodeCache();
+  }
 
   return true;
 }
@@ -1720,6 +2369,28 @@ void RemoveMedia()
   g_cdrom.RemoveMedia();
 }
 
+std::string GetPersistentCodeCacheFileName()
+{
+  return g_host_interface->GetUserDirectoryRelativePath("cache" FS_OSPATH_SEPARATOR_STR "%s.jitcache",
+                                                        s_running_game_code.c_str());
+}
+
+void LoadPersistentCodeCache()
+{
+  if (!g_settings.IsUsingRecompiler() || !g_settings.cpu_recompiler_persistent_cache || s_running_game_code.empty())
+    return;
+
+  CPU::CodeCache::LoadPersistentCache(GetPersistentCodeCacheFileName().c_str());
+}
+
+void SavePersistentCodeCache()
+{
+  if (!g_settings.IsUsingRecompiler() || !g_settings.cpu_recompiler_persistent_cache || s_running_game_code.empty())
+    return;
+
+  CPU::CodeCache::SavePersistentCache(GetPersistentCodeCacheFileName().c_str());
+}
+
 void UpdateRunningGame(const char* path, CDImage* image)
 {
   if (s_running_game_path == path)
@@ -140,7 +140,11 @@ void Reset();
 void Shutdown();
 
 bool LoadState(ByteStream* state, bool update_display = true);
-bool SaveState(ByteStream* state, u32 screenshot_size = 128);
+bool SaveState(ByteStream* state, u32 screenshot_size = 128, bool compress_data = false);
+
+/// Writes a state which was saved to memory without compression to a stream, optionally compressing the state data.
+/// Does not access any emulator state, so it is safe to call from any thread.
+bool WriteStateSnapshot(ByteStream* state, const void* snapshot_data, u32 snapshot_size, bool compress_data);
 
 /// Recreates the GPU component, saving/loading the state so it is preserved. Call when the GPU renderer changes.
 bool RecreateGPU(GPURenderer renderer, bool update_display = true);
@@ -148,6 +152,14 @@ bool RecreateGPU(GPURenderer renderer, bool update_display = true);
 void SingleStepCPU();
 void RunFrame();
 
+/// Memory save states - used for rewind and runahead.
+void UpdateMemorySaveStateSettings();
+void ClearMemorySaveStates();
+
+/// Rewinding steps back through the captured states, one per frame, for as long as it is enabled.
+bool IsRewinding();
+void SetRewinding(bool enabled);
+
 /// Sets target emulation speed.
 float GetTargetSpeed();
 void SetTargetSpeed(float speed);
@@ -181,6 +193,9 @@ bool DumpVRAM(const char* filename);
 /// Dumps sound RAM to a file.
 bool DumpSPURAM(const char* filename);
 
+/// Records the GPU command stream for the next num_frames frames to a file.
+bool RecordGPUCommands(const char* filename, u32 num_frames);
+
 bool HasMedia();
 bool InsertMedia(const char* path);
 void RemoveMedia();
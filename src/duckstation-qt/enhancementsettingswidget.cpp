@@ -50,9 +50,10 @@ EnhancementSettingsWidget::EnhancementSettingsWidget(QtHostInterface* host_inter
       "<b><u>May not be compatible with all games.</u></b>"));
   dialog->registerWidgetHelp(
     m_ui.resolutionScale, tr("Resolution Scale"), "1x",
-    tr("Setting this beyond 1x will enhance the resolution of rendered 3D polygons and lines. Only applies "
-       "to the hardware backends. <br>This option is usually safe, with most games looking fine at "
-       "higher resolutions. Higher resolutions require a more powerful GPU."));
+    tr("Setting this beyond 1x will enhance the resolution of rendered 3D polygons and lines. The software "
+       "renderer supports 2x and 4x, other scales are rounded down. <br>This option is usually safe, with most games "
+       "looking fine at higher resolutions. Higher resolutions require a more powerful GPU, or CPU for the software "
+       "renderer."));
   dialog->registerWidgetHelp(
     m_ui.msaaMode, tr("Multisample Antialiasing"), tr("Disabled"),
     tr("Uses multisample antialiasing for rendering 3D objects. Can smooth out jagged edges on polygons at a lower "
@@ -27,12 +27,24 @@ GeneralSettingsWidget::GeneralSettingsWidget(QtHostInterface* host_interface, QW
                                                "HideCursorInFullscreen", true);
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.renderToMain, "Main", "RenderToMainWindow", true);
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.saveStateOnExit, "Main", "SaveStateOnExit", true);
+  SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.compressSaveStates, "Main", "CompressSaveStates",
+                                               true);
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.confirmPowerOff, "Main", "ConfirmPowerOff", true);
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.loadDevicesFromSaveStates, "Main",
                                                "LoadDevicesFromSaveStates", false);
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.applyGameSettings, "Main", "ApplyGameSettings",
                                                true);
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.autoLoadCheats, "Main", "AutoLoadCheats", false);
+  SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.rewindEnable, "Main", "RewindEnable", false);
+  SettingWidgetBinder::BindWidgetToIntSetting(m_host_interface, m_ui.rewindSaveInterval, "Main", "RewindSaveInterval",
+                                              1);
+  SettingWidgetBinder::BindWidgetToIntSetting(m_host_interface, m_ui.rewindSaveSlots, "Main", "RewindSaveSlots", 3600);
+  SettingWidgetBinder::BindWidgetToIntSetting(m_host_interface, m_ui.rewindMaxMemory, "Main", "RewindMaxMemory", 32);
+
+  m_ui.runaheadFrames->addItem(tr("Disabled"));
+  for (u32 i = 1; i <= Settings::MAX_RUNAHEAD_FRAMES; i++)
+    m_ui.runaheadFrames->addItem(tr("%n frame(s)", "", static_cast<int>(i)));
+  SettingWidgetBinder::BindWidgetToIntSetting(m_host_interface, m_ui.runaheadFrames, "Main", "RunaheadFrameCount", 0);
 
   SettingWidgetBinder::BindWidgetToEnumSetting(
     m_host_interface, m_ui.controllerBackend, "Main", "ControllerBackend", &ControllerInterface::ParseBackendName,
@@ -45,6 +57,9 @@ GeneralSettingsWidget::GeneralSettingsWidget(QtHostInterface* host_interface, QW
   dialog->registerWidgetHelp(m_ui.saveStateOnExit, tr("Save State On Exit"), tr("Checked"),
                              tr("Automatically saves the emulator state when powering down or exiting. You can then "
                                 "resume directly from where you left off next time."));
+  dialog->registerWidgetHelp(m_ui.compressSaveStates, tr("Compress Save States"), tr("Checked"),
+                             tr("Compresses save state files, making them several times smaller. Saving and loading "
+                                "takes slightly longer. Uncompressed save states can still be loaded."));
   dialog->registerWidgetHelp(m_ui.startFullscreen, tr("Start Fullscreen"), tr("Unchecked"),
                              tr("Automatically switches to fullscreen mode when a game is started."));
   dialog->registerWidgetHelp(m_ui.hideCursorInFullscreen, tr("Hide Cursor In Fullscreen"), tr("Checked"),
@@ -67,6 +82,24 @@ GeneralSettingsWidget::GeneralSettingsWidget(QtHostInterface* host_interface, QW
     m_ui.applyGameSettings, tr("Apply Per-Game Settings"), tr("Checked"),
     tr("When enabled, per-game settings will be applied, and incompatible enhancements will be disabled. You should "
        "leave this option enabled except when testing enhancements with incompatible games."));
+  dialog->registerWidgetHelp(
+    m_ui.rewindEnable, tr("Enable Rewind"), tr("Unchecked"),
+    tr("Periodically saves the emulator state in memory, so the game can be rewound while the rewind hotkey is held. "
+       "Uses additional memory and CPU time while enabled."));
+  dialog->registerWidgetHelp(m_ui.rewindSaveInterval, tr("Rewind Save Interval"), tr("1 frames"),
+                             tr("Number of frames between each rewind state. Higher values use less memory and CPU "
+                                "time, but rewinding is less smooth."));
+  dialog->registerWidgetHelp(m_ui.rewindSaveSlots, tr("Rewind Save Slots"), tr("3600"),
+                             tr("Number of rewind states which are kept. Together with the save interval, this "
+                                "determines how far back the game can be rewound."));
+  dialog->registerWidgetHelp(m_ui.rewindMaxMemory, tr("Rewind Memory Limit"), tr("32 MB"),
+                             tr("Maximum amount of memory used by the compressed rewind states. When the limit is "
+                                "reached, the oldest states are discarded, so busy games can be rewound less far."));
+  dialog->registerWidgetHelp(
+    m_ui.runaheadFrames, tr("Runahead"), tr("Disabled"),
+    tr("Simulates the given number of frames ahead of the displayed frame, hiding the input latency of the game. "
+       "Each frame of runahead requires the system to be emulated one extra time, so higher values need a faster "
+       "CPU."));
   dialog->registerWidgetHelp(m_ui.controllerBackend, tr("Controller Backend"),
                              qApp->translate("ControllerInterface", ControllerInterface::GetBackendName(
                                                                       ControllerInterface::GetDefaultBackend())),
@@ -711,9 +711,9 @@ void QtHostInterface::OnRunningGameChanged()
   }
 }
 
-void QtHostInterface::OnSystemStateSaved(bool global, s32 slot)
+void QtHostInterface::OnSystemStateSaved(const std::string& game_code, bool global, s32 slot)
 {
-  emit stateSaved(QString::fromStdString(System::GetRunningCode()), global, slot);
+  emit stateSaved(QString::fromStdString(game_code), global, slot);
 }
 
 void QtHostInterface::LoadSettings()
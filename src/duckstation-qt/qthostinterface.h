@@ -202,7 +202,7 @@ protected:
   void OnSystemDestroyed() override;
   void OnSystemPerformanceCountersUpdated() override;
   void OnRunningGameChanged() override;
-  void OnSystemStateSaved(bool global, s32 slot) override;
+  void OnSystemStateSaved(const std::string& game_code, bool global, s32 slot) override;
 
   void LoadSettings() override;
   void SetDefaultSettings(SettingsInterface& si) override;
@@ -1377,16 +1377,41 @@ void SDLHostInterface::DrawSettingsWindow()
         settings_changed |= ImGui::Checkbox("Pause On Start", &m_settings_copy.start_paused);
         settings_changed |= ImGui::Checkbox("Start Fullscreen", &m_settings_copy.start_fullscreen);
         settings_changed |= ImGui::Checkbox("Save State On Exit", &m_settings_copy.save_state_on_exit);
+        settings_changed |= ImGui::Checkbox("Compress Save States", &m_settings_copy.compress_save_states);
         settings_changed |= ImGui::Checkbox("Apply Game Settings", &m_settings_copy.apply_game_settings);
         settings_changed |= ImGui::Checkbox("Automatically Load Cheats", &m_settings_copy.auto_load_cheats);
         settings_changed |=
           ImGui::Checkbox("Load Devices From Save States", &m_settings_copy.load_devices_from_save_states);
+        settings_changed |= ImGui::Checkbox("Enable Rewind", &m_settings_copy.rewind_enable);
+
+        ImGui::Text("Runahead Frames:");
+        ImGui::SameLine(indent);
+
+        int runahead_frames = static_cast<int>(m_settings_copy.runahead_frames);
+        if (ImGui::SliderInt("##runahead_frames", &runahead_frames, 0,
+                             static_cast<int>(Settings::MAX_RUNAHEAD_FRAMES)))
+        {
+          m_settings_copy.runahead_frames = static_cast<u32>(runahead_frames);
+          settings_changed = true;
+        }
       }
 
       ImGui::NewLine();
       if (DrawSettingsSectionHeader("CDROM Emulation"))
       {
         settings_changed |= ImGui::Checkbox("Use Read Thread (Asynchronous)", &m_settings_copy.cdrom_read_thread);
+
+        ImGui::Text("Readahead Sectors:");
+        ImGui::SameLine(indent);
+
+        int readahead_sectors = static_cast<int>(m_settings_copy.cdrom_readahead_sectors);
+        if (ImGui::SliderInt("##readahead_sectors", &readahead_sectors, 0,
+                             static_cast<int>(Settings::MAX_CDROM_READAHEAD_SECTORS)))
+        {
+          m_settings_copy.cdrom_readahead_sectors = static_cast<u32>(readahead_sectors);
+          settings_changed = true;
+        }
+
         settings_changed |= ImGui::Checkbox("Enable Region Check", &m_settings_copy.cdrom_region_check);
         settings_changed |= ImGui::Checkbox("Preload Image To RAM", &m_settings_copy.cdrom_load_image_to_ram);
       }
@@ -1510,6 +1535,14 @@ void SDLHostInterface::DrawSettingsWindow()
 
       settings_changed |= ImGui::Checkbox("Enable Recompiler ICache", &m_settings_copy.cpu_recompiler_icache);
 
+      settings_changed |=
+        ImGui::Checkbox("Enable Recompiler Persistent Cache", &m_settings_copy.cpu_recompiler_persistent_cache);
+
+      settings_changed |=
+        ImGui::Checkbox("Enable Recompiler Background Compile", &m_settings_copy.cpu_recompiler_background_compile);
+
+      settings_changed |= ImGui::Checkbox("Enable Recompiler Superblocks", &m_settings_copy.cpu_recompiler_superblocks);
+
       ImGui::EndTabItem();
     }
 
@@ -1715,12 +1748,23 @@ void SDLHostInterface::DrawSettingsWindow()
         settings_changed = true;
       }
 
+      ImGui::Text("Software Renderer Threads:");
+      ImGui::SameLine(indent);
+
+      int gpu_sw_worker_threads = static_cast<int>(m_settings_copy.gpu_sw_worker_threads);
+      if (ImGui::SliderInt("##gpu_sw_worker_threads", &gpu_sw_worker_threads, 0, 16))
+      {
+        m_settings_copy.gpu_sw_worker_threads = gpu_sw_worker_threads;
+        settings_changed = true;
+      }
+
       if (ImGui::Button("Reset"))
       {
         m_settings_copy.dma_max_slice_ticks = static_cast<TickCount>(Settings::DEFAULT_DMA_MAX_SLICE_TICKS);
         m_settings_copy.dma_halt_ticks = static_cast<TickCount>(Settings::DEFAULT_DMA_HALT_TICKS);
         m_settings_copy.gpu_fifo_size = Settings::DEFAULT_GPU_FIFO_SIZE;
         m_settings_copy.gpu_max_run_ahead = static_cast<TickCount>(Settings::DEFAULT_GPU_MAX_RUN_AHEAD);
+        m_settings_copy.gpu_sw_worker_threads = 0;
         settings_changed = true;
       }
 
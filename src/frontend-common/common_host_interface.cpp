@@ -15,6 +15,7 @@
 #include "core/mdec.h"
 #include "core/pgxp.h"
 #include "core/save_state_version.h"
+#include "core/save_state_writer.h"
 #include "core/spu.h"
 #include "core/system.h"
 #include "core/texture_replacements.h"
@@ -120,6 +121,7 @@ void CommonHostInterface::InitializeUserDirectory()
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("covers").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("dump").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("dump/audio").c_str(), false);
+  result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("dump/gpu").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("dump/textures").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("inputprofiles").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("memcards").c_str(), false);
@@ -540,15 +542,17 @@ bool CommonHostInterface::SaveState(bool global, s32 slot)
   }
 
   std::string save_path = global ? GetGlobalSaveStateFileName(slot) : GetGameSaveStateFileName(code.c_str(), slot);
-  if (!SaveState(save_path.c_str()))
-    return false;
-
-  OnSystemStateSaved(global, slot);
-  return true;
+  return SaveState(save_path.c_str(), [this, code, global, slot](bool result) {
+    if (result)
+      OnSystemStateSaved(code, global, slot);
+  });
 }
 
 bool CommonHostInterface::ResumeSystemFromState(const char* filename, bool boot_on_failure)
 {
+  // the resume state may have been queued for writing when the game was last shut down
+  m_save_state_writer->WaitForPendingWrites();
+
   SystemBootParameters boot_params;
   boot_params.filename = filename;
   if (!BootSystem(boot_params))
@@ -589,6 +593,8 @@ bool CommonHostInterface::ResumeSystemFromState(const char* filename, bool boot_
 
 bool CommonHostInterface::ResumeSystemFromMostRecentState()
 {
+  m_save_state_writer->WaitForPendingWrites();
+
   const std::string path = GetMostRecentResumeSaveStatePath();
   if (path.empty())
   {
@@ -1606,6 +1612,23 @@ void CommonHostInterface::RegisterGeneralHotkeys()
                    if (pressed)
                      DoFrameStep();
                  });
+
+  RegisterHotkey(StaticString(TRANSLATABLE("Hotkeys", "General")), StaticString("Rewind"),
+                 StaticString(TRANSLATABLE("Hotkeys", "Rewind")), [this](bool pressed) {
+                   if (!System::IsValid())
+                     return;
+
+                   if (pressed && !g_settings.rewind_enable)
+                   {
+                     AddOSDMessage(TranslateStdString("OSDMessage", "Rewind is not enabled."), 5.0f);
+                     return;
+                   }
+
+                   System::SetRewinding(pressed);
+                   AddOSDMessage(pressed ? TranslateStdString("OSDMessage", "Rewinding...") :
+                                           TranslateStdString("OSDMessage", "Stopped rewinding."),
+                                 2.0f);
+                 });
 }
 
 void CommonHostInterface::RegisterGraphicsHotkeys()
@@ -1686,6 +1709,12 @@ void CommonHostInterface::RegisterGraphicsHotkeys()
                      g_texture_replacements.Reload();
                    }
                  });
+
+  RegisterHotkey(StaticString(TRANSLATABLE("Hotkeys", "Graphics")), StaticString("RecordGPUCommands"),
+                 StaticString(TRANSLATABLE("Hotkeys", "Record GPU Commands")), [this](bool pressed) {
+                   if (pressed && System::IsValid())
+                     RecordGPUCommands();
+                 });
 }
 
 void CommonHostInterface::RegisterSaveStateHotkeys()
@@ -2463,6 +2492,41 @@ void CommonHostInterface::StopDumpingAudio()
   AddOSDMessage(TranslateStdString("OSDMessage", "Stopped dumping audio."), 5.0f);
 }
 
+bool CommonHostInterface::RecordGPUCommands(const char* filename /* = nullptr */, u32 num_frames /* = 60 */)
+{
+  if (System::IsShutdown())
+    return false;
+
+  std::string auto_filename;
+  if (!filename)
+  {
+    const auto& code = System::GetRunningCode();
+    if (code.empty())
+    {
+      auto_filename = GetUserDirectoryRelativePath("dump/gpu/%s.dsgr", GetTimestampStringForFileName().GetCharArray());
+    }
+    else
+    {
+      auto_filename = GetUserDirectoryRelativePath("dump/gpu/%s_%s.dsgr", code.c_str(),
+                                                   GetTimestampStringForFileName().GetCharArray());
+    }
+
+    filename = auto_filename.c_str();
+  }
+
+  if (System::RecordGPUCommands(filename, num_frames))
+  {
+    AddFormattedOSDMessage(5.0f, TranslateString("OSDMessage", "Recording %u frames of GPU commands to '%s'."),
+                           num_frames, filename);
+    return true;
+  }
+  else
+  {
+    AddFormattedOSDMessage(10.0f, TranslateString("OSDMessage", "Failed to record GPU commands to '%s'."), filename);
+    return false;
+  }
+}
+
 bool CommonHostInterface::SaveScreenshot(const char* filename /* = nullptr */, bool full_resolution /* = true */,
                                          bool apply_aspect_ratio /* = true */, bool compress_on_thread /* = true */)
 {
@@ -149,6 +149,10 @@ public:
   /// Stops dumping audio to file if it has been started.
   void StopDumpingAudio();
 
+  /// Records the GPU command stream for the next num_frames frames. If no file name is provided, one will be generated
+  /// automatically.
+  bool RecordGPUCommands(const char* filename = nullptr, u32 num_frames = 60);
+
   /// Saves a screenshot to the specified file. IF no file name is provided, one will be generated automatically.
   bool SaveScreenshot(const char* filename = nullptr, bool full_resolution = true, bool apply_aspect_ratio = true,
                       bool compress_on_thread = true);
@@ -13,9 +13,15 @@
 #include "core/system.h"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
 #include <string_view>
+#include <thread>
 #include <tinyxml2.h>
+#include <unordered_set>
 #include <utility>
 Log_SetChannel(GameList);
 
@@ -100,6 +106,7 @@ bool GameList::GetExeListEntry(const char* path, GameListEntry* entry)
   entry->path = path;
   entry->region = DiscRegion::Other;
   entry->total_size = ZeroExtend64(file_size);
+  entry->file_size = ffd.Size;
   entry->last_modified_time = ffd.ModificationTime.AsUnixTimestamp();
   entry->type = GameListEntryType::PSExe;
   entry->compatibility_rating = GameListCompatibilityRating::Unknown;
@@ -122,6 +129,7 @@ bool GameList::GetM3UListEntry(const char* path, GameListEntry* entry)
   entry->path = path;
   entry->region = DiscRegion::Other;
   entry->total_size = 0;
+  entry->file_size = ffd.Size;
   entry->last_modified_time = ffd.ModificationTime.AsUnixTimestamp();
   entry->type = GameListEntryType::Playlist;
   entry->compatibility_rating = GameListCompatibilityRating::Unknown;
@@ -217,231 +225,195 @@ bool GameList::GetGameListEntry(const std::string& path, GameListEntry* entry)
   if (!FileSystem::StatFile(path.c_str(), &ffd))
     return false;
 
+  entry->file_size = ffd.Size;
   entry->last_modified_time = ffd.ModificationTime.AsUnixTimestamp();
   return true;
 }
 
-bool GameList::GetGameListEntryFromCache(const std::string& path, GameListEntry* entry)
+bool GameList::GetGameListEntryFromCache(const std::string& path, u64 file_size, u64 last_modified_time,
+                                         GameListEntry* entry)
 {
-  auto iter = m_cache_map.find(path);
-  if (iter == m_cache_map.end())
+  if (m_cache_record_count == 0)
     return false;
 
-  *entry = std::move(iter->second);
-  m_cache_map.erase(iter);
-  return true;
-}
-
-void GameList::LoadCache()
-{
-  if (m_cache_filename.empty())
-    return;
+  const CacheIndexRecord* records_begin = m_cache_records;
+  const CacheIndexRecord* records_end = m_cache_records + m_cache_record_count;
+  const CacheIndexRecord* record =
+    std::lower_bound(records_begin, records_end, std::string_view(path),
+                     [this](const CacheIndexRecord& rec, const std::string_view& key) {
+                       return GetCacheString(rec.path_offset, rec.path_length) < key;
+                     });
+  if (record == records_end || GetCacheString(record->path_offset, record->path_length) != path)
+    return false;
 
-  std::unique_ptr<ByteStream> stream =
-    FileSystem::OpenFile(m_cache_filename.c_str(), BYTESTREAM_OPEN_READ | BYTESTREAM_OPEN_STREAMED);
-  if (!stream)
-    return;
+  // only trust the entry if the file hasn't been touched since it was indexed
+  if (record->file_size != file_size || record->last_modified_time != last_modified_time)
+    return false;
 
-  if (!LoadEntriesFromCache(stream.get()))
+  if (record->region >= static_cast<u8>(DiscRegion::Count) ||
+      record->type > static_cast<u8>(GameListEntryType::Playlist) ||
+      record->compatibility_rating >= static_cast<u8>(GameListCompatibilityRating::Count))
   {
-    Log_WarningPrintf("Deleting corrupted cache file '%s'", m_cache_filename.c_str());
-    stream.reset();
-    m_cache_map.clear();
-    DeleteCacheFile();
-    return;
-  }
-}
-
-static bool ReadString(ByteStream* stream, std::string* dest)
-{
-  u32 size;
-  if (!stream->Read2(&size, sizeof(size)))
+    Log_WarningPrintf("Game list cache entry for '%s' is corrupted", path.c_str());
     return false;
+  }
 
-  dest->resize(size);
-  if (!stream->Read2(dest->data(), size))
+  const std::string_view settings_data(GetCacheString(record->settings_offset, record->settings_length));
+  std::unique_ptr<ReadOnlyMemoryByteStream> settings_stream =
+    ByteStream_CreateReadOnlyMemoryStream(settings_data.data(), static_cast<u32>(settings_data.size()));
+  GameSettings::Entry settings;
+  if (!settings.LoadFromStream(settings_stream.get()))
+  {
+    Log_WarningPrintf("Game list cache entry for '%s' is corrupted (settings)", path.c_str());
     return false;
+  }
 
+  entry->path = path;
+  entry->code = GetCacheString(record->code_offset, record->code_length);
+  entry->title = GetCacheString(record->title_offset, record->title_length);
+  entry->total_size = record->total_size;
+  entry->file_size = record->file_size;
+  entry->last_modified_time = record->last_modified_time;
+  entry->region = static_cast<DiscRegion>(record->region);
+  entry->type = static_cast<GameListEntryType>(record->type);
+  entry->compatibility_rating = static_cast<GameListCompatibilityRating>(record->compatibility_rating);
+  entry->settings = std::move(settings);
+  m_cache_hits++;
   return true;
 }
 
-static bool ReadU8(ByteStream* stream, u8* dest)
-{
-  return stream->Read2(dest, sizeof(u8));
-}
-
-static bool ReadU32(ByteStream* stream, u32* dest)
-{
-  return stream->Read2(dest, sizeof(u32));
-}
-
-static bool ReadU64(ByteStream* stream, u64* dest)
+std::string_view GameList::GetCacheString(u32 offset, u32 length) const
 {
-  return stream->Read2(dest, sizeof(u64));
-}
-
-static bool WriteString(ByteStream* stream, const std::string& str)
-{
-  const u32 size = static_cast<u32>(str.size());
-  return (stream->Write2(&size, sizeof(size)) && (size == 0 || stream->Write2(str.data(), size)));
-}
-
-static bool WriteU8(ByteStream* stream, u8 dest)
-{
-  return stream->Write2(&dest, sizeof(u8));
-}
-
-static bool WriteU32(ByteStream* stream, u32 dest)
-{
-  return stream->Write2(&dest, sizeof(u32));
-}
+  // out-of-range strings come back empty, and won't match anything
+  const u8* data = m_cache_file.GetData() + m_cache_data_offset;
+  const u64 data_size = m_cache_file.GetSize() - m_cache_data_offset;
+  if ((static_cast<u64>(offset) + length) > data_size)
+    return {};
 
-static bool WriteU64(ByteStream* stream, u64 dest)
-{
-  return stream->Write2(&dest, sizeof(u64));
+  return std::string_view(reinterpret_cast<const char*>(data + offset), length);
 }
 
-bool GameList::LoadEntriesFromCache(ByteStream* stream)
+void GameList::LoadCache()
 {
-  u32 file_signature, file_version;
-  if (!ReadU32(stream, &file_signature) || !ReadU32(stream, &file_version) ||
-      file_signature != GAME_LIST_CACHE_SIGNATURE || file_version != GAME_LIST_CACHE_VERSION)
-  {
-    Log_WarningPrintf("Game list cache is corrupted");
-    return false;
-  }
-
-  while (stream->GetPosition() != stream->GetSize())
-  {
-    std::string path;
-    std::string code;
-    std::string title;
-    u64 total_size;
-    u64 last_modified_time;
-    u8 region;
-    u8 type;
-    u8 compatibility_rating;
-
-    if (!ReadString(stream, &path) || !ReadString(stream, &code) || !ReadString(stream, &title) ||
-        !ReadU64(stream, &total_size) || !ReadU64(stream, &last_modified_time) || !ReadU8(stream, &region) ||
-        region >= static_cast<u8>(DiscRegion::Count) || !ReadU8(stream, &type) ||
-        type > static_cast<u8>(GameListEntryType::Playlist) || !ReadU8(stream, &compatibility_rating) ||
-        compatibility_rating >= static_cast<u8>(GameListCompatibilityRating::Count))
-    {
-      Log_WarningPrintf("Game list cache entry is corrupted");
-      return false;
-    }
-
-    GameListEntry ge;
-    ge.path = path;
-    ge.code = std::move(code);
-    ge.title = std::move(title);
-    ge.total_size = total_size;
-    ge.last_modified_time = last_modified_time;
-    ge.region = static_cast<DiscRegion>(region);
-    ge.type = static_cast<GameListEntryType>(type);
-    ge.compatibility_rating = static_cast<GameListCompatibilityRating>(compatibility_rating);
-
-    if (!ge.settings.LoadFromStream(stream))
-    {
-      Log_WarningPrintf("Game list cache entry is corrupted (settings)");
-      return false;
-    }
-
-    auto iter = m_cache_map.find(ge.path);
-    if (iter != m_cache_map.end())
-      iter->second = std::move(ge);
-    else
-      m_cache_map.emplace(std::move(path), std::move(ge));
-  }
+  CloseCache();
+  if (m_cache_filename.empty() || !FileSystem::FileExists(m_cache_filename.c_str()))
+    return;
 
-  return true;
-}
+  if (!m_cache_file.Open(m_cache_filename.c_str()))
+    return;
 
-bool GameList::OpenCacheForWriting()
-{
-  if (m_cache_filename.empty())
-    return false;
+  // the index is looked up by binary search, so reads are scattered all over the file
+  m_cache_file.SetAccessPattern(Common::MappedFile::AccessPattern::Random);
 
-  Assert(!m_cache_write_stream);
-  m_cache_write_stream =
-    FileSystem::OpenFile(m_cache_filename.c_str(), BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE |
-                                                     BYTESTREAM_OPEN_APPEND | BYTESTREAM_OPEN_STREAMED);
-  if (!m_cache_write_stream || !m_cache_write_stream->SeekToEnd())
+  CacheIndexHeader header;
+  if (m_cache_file.GetSize() < sizeof(header))
   {
-    m_cache_write_stream.reset();
-    return false;
+    Log_WarningPrintf("Deleting corrupted cache file '%s'", m_cache_filename.c_str());
+    DeleteCacheFile();
+    return;
   }
 
-  if (m_cache_write_stream->GetPosition() == 0)
+  std::memcpy(&header, m_cache_file.GetData(), sizeof(header));
+  const u64 records_size = static_cast<u64>(header.entry_count) * sizeof(CacheIndexRecord);
+  if (header.signature != GAME_LIST_CACHE_SIGNATURE || header.version != GAME_LIST_CACHE_VERSION ||
+      (sizeof(header) + records_size) > m_cache_file.GetSize())
   {
-    // new cache file, write header
-    if (!WriteU32(m_cache_write_stream.get(), GAME_LIST_CACHE_SIGNATURE) ||
-        !WriteU32(m_cache_write_stream.get(), GAME_LIST_CACHE_VERSION))
-    {
-      Log_ErrorPrintf("Failed to write game list cache header");
-      m_cache_write_stream.reset();
-      FileSystem::DeleteFile(m_cache_filename.c_str());
-      return false;
-    }
+    Log_WarningPrintf("Deleting corrupted cache file '%s'", m_cache_filename.c_str());
+    DeleteCacheFile();
+    return;
   }
 
-  return true;
+  m_cache_records = reinterpret_cast<const CacheIndexRecord*>(m_cache_file.GetData() + sizeof(header));
+  m_cache_record_count = header.entry_count;
+  m_cache_data_offset = static_cast<u32>(sizeof(header) + records_size);
+  Log_DevPrintf("Mapped game list cache with %u entries", m_cache_record_count);
 }
 
-bool GameList::WriteEntryToCache(const GameListEntry* entry, ByteStream* stream)
+void GameList::CloseCache()
 {
-  bool result = WriteString(stream, entry->path);
-  result &= WriteString(stream, entry->code);
-  result &= WriteString(stream, entry->title);
-  result &= WriteU64(stream, entry->total_size);
-  result &= WriteU64(stream, entry->last_modified_time);
-  result &= WriteU8(stream, static_cast<u8>(entry->region));
-  result &= WriteU8(stream, static_cast<u8>(entry->type));
-  result &= WriteU8(stream, static_cast<u8>(entry->compatibility_rating));
-  result &= entry->settings.SaveToStream(stream);
-  return result;
+  m_cache_file.Close();
+  m_cache_records = nullptr;
+  m_cache_record_count = 0;
+  m_cache_data_offset = 0;
+  m_cache_hits = 0;
 }
 
-void GameList::FlushCacheFileStream()
+void GameList::RewriteCacheFile()
 {
-  if (!m_cache_write_stream)
+  if (m_cache_filename.empty())
     return;
 
-  m_cache_write_stream->Flush();
-}
+  // the mapping has to go before the file can be replaced
+  CloseCache();
 
-void GameList::CloseCacheFileStream()
-{
-  if (!m_cache_write_stream)
-    return;
+  std::vector<const GameListEntry*> sorted_entries;
+  sorted_entries.reserve(m_entries.size());
+  for (const GameListEntry& entry : m_entries)
+    sorted_entries.push_back(&entry);
+  std::sort(sorted_entries.begin(), sorted_entries.end(),
+            [](const GameListEntry* lhs, const GameListEntry* rhs) { return (lhs->path < rhs->path); });
+
+  std::vector<CacheIndexRecord> records;
+  records.reserve(sorted_entries.size());
+  std::unique_ptr<GrowableMemoryByteStream> data = ByteStream_CreateGrowableMemoryStream();
+  auto write_string = [&data](const std::string& str, u32* offset, u32* length) {
+    *offset = static_cast<u32>(data->GetPosition());
+    *length = static_cast<u32>(str.size());
+    return (str.empty() || data->Write2(str.data(), static_cast<u32>(str.size()), nullptr));
+  };
+
+  bool result = true;
+  for (const GameListEntry* entry : sorted_entries)
+  {
+    CacheIndexRecord rec = {};
+    rec.file_size = entry->file_size;
+    rec.last_modified_time = entry->last_modified_time;
+    rec.total_size = entry->total_size;
+    rec.region = static_cast<u8>(entry->region);
+    rec.type = static_cast<u8>(entry->type);
+    rec.compatibility_rating = static_cast<u8>(entry->compatibility_rating);
+    result &= write_string(entry->path, &rec.path_offset, &rec.path_length);
+    result &= write_string(entry->code, &rec.code_offset, &rec.code_length);
+    result &= write_string(entry->title, &rec.title_offset, &rec.title_length);
+    rec.settings_offset = static_cast<u32>(data->GetPosition());
+    result &= entry->settings.SaveToStream(data.get());
+    rec.settings_length = static_cast<u32>(data->GetPosition()) - rec.settings_offset;
+    records.push_back(rec);
+  }
 
-  m_cache_write_stream->Commit();
-  m_cache_write_stream.reset();
-}
+  CacheIndexHeader header;
+  header.signature = GAME_LIST_CACHE_SIGNATURE;
+  header.version = GAME_LIST_CACHE_VERSION;
+  header.entry_count = static_cast<u32>(records.size());
+  header.data_size = static_cast<u32>(data->GetSize());
 
-void GameList::RewriteCacheFile()
-{
-  CloseCacheFileStream();
-  DeleteCacheFile();
-  if (OpenCacheForWriting())
+  std::unique_ptr<ByteStream> stream =
+    FileSystem::OpenFile(m_cache_filename.c_str(), BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE |
+                                                     BYTESTREAM_OPEN_TRUNCATE | BYTESTREAM_OPEN_ATOMIC_UPDATE |
+                                                     BYTESTREAM_OPEN_STREAMED);
+  if (!stream)
   {
-    for (const auto& it : m_entries)
-    {
-      if (!WriteEntryToCache(&it, m_cache_write_stream.get()))
-      {
-        Log_ErrorPrintf("Failed to write '%s' to new cache file", it.title.c_str());
-        break;
-      }
-    }
+    Log_ErrorPrintf("Failed to open game list cache '%s' for writing", m_cache_filename.c_str());
+    return;
+  }
 
-    CloseCacheFileStream();
+  result &= stream->Write2(&header, sizeof(header));
+  result &= (records.empty() ||
+             stream->Write2(records.data(), static_cast<u32>(sizeof(CacheIndexRecord) * records.size())));
+  result &= (header.data_size == 0 || stream->Write2(data->GetMemoryPointer(), header.data_size));
+  if (!result || !stream->Commit())
+  {
+    Log_ErrorPrintf("Failed to write game list cache '%s'", m_cache_filename.c_str());
+    stream->Discard();
+    return;
   }
+
+  Log_DevPrintf("Wrote game list cache with %u entries", header.entry_count);
 }
 
 void GameList::DeleteCacheFile()
 {
-  Assert(!m_cache_write_stream);
+  CloseCache();
   if (!FileSystem::FileExists(m_cache_filename.c_str()))
     return;
 
@@ -461,12 +433,24 @@ void GameList::ScanDirectory(const char* path, bool recursive, ProgressCallback*
   FileSystem::FindResultsArray files;
   FileSystem::FindFiles(path, "*", FILESYSTEM_FIND_FILES | (recursive ? FILESYSTEM_FIND_RECURSIVE : 0), &files);
 
-  GameListEntry entry;
   progress->SetProgressRange(static_cast<u32>(files.size()));
   progress->SetProgressValue(0);
 
-  for (const FILESYSTEM_FIND_DATA& ffd : files)
+  std::unordered_set<std::string_view> existing_paths;
+  existing_paths.reserve(m_entries.size());
+  for (const GameListEntry& entry : m_entries)
+    existing_paths.insert(entry.path);
+
+  // files which hit the cache are filled in straight away, the rest are opened on the worker threads
+  std::vector<GameListEntry> new_entries(files.size());
+  std::vector<u8> new_entry_valid(files.size(), 0);
+  std::vector<u32> pending_files;
+  u32 cached_files = 0;
+
+  for (u32 i = 0; i < static_cast<u32>(files.size()); i++)
   {
+    const FILESYSTEM_FIND_DATA& ffd = files[i];
+
     // if this is a .bin, check if we have a .cue. if there is one, skip it
     const char* extension = std::strrchr(ffd.FileName.c_str(), '.');
     if (extension && StringUtil::Strcasecmp(extension, ".bin") == 0)
@@ -485,44 +469,112 @@ void GameList::ScanDirectory(const char* path, bool recursive, ProgressCallback*
 #endif
     }
 
-    std::string entry_path(ffd.FileName);
-    if (std::any_of(m_entries.begin(), m_entries.end(),
-                    [&entry_path](const GameListEntry& other) { return other.path == entry_path; }))
+    if (existing_paths.find(ffd.FileName) != existing_paths.end())
+      continue;
+
+    if (GetGameListEntryFromCache(ffd.FileName, ffd.Size, ffd.ModificationTime.AsUnixTimestamp(), &new_entries[i]))
     {
+      new_entry_valid[i] = 1;
+      cached_files++;
       continue;
     }
-    Log_DebugPrintf("Trying '%s'...", entry_path.c_str());
 
-    // try opening the image
-    if (!GetGameListEntryFromCache(entry_path, &entry) ||
-        entry.last_modified_time != ffd.ModificationTime.AsUnixTimestamp())
+    Log_DebugPrintf("Trying '%s'...", ffd.FileName.c_str());
+    pending_files.push_back(i);
+  }
+
+  if (!pending_files.empty())
+    ScanFiles(files, pending_files, new_entries.data(), new_entry_valid.data(), cached_files, progress);
+
+  // only new or changed games need writing to the cache, files which turned out not to be games aren't cached
+  for (const u32 i : pending_files)
+  {
+    if (new_entry_valid[i])
     {
+      m_cache_dirty = true;
+      break;
+    }
+  }
+
+  for (u32 i = 0; i < static_cast<u32>(files.size()); i++)
+  {
+    if (new_entry_valid[i])
+      m_entries.push_back(std::move(new_entries[i]));
+  }
+
+  progress->SetProgressValue(static_cast<u32>(files.size()));
+  progress->PopState();
+}
+
+void GameList::ScanFiles(const FileSystem::FindResultsArray& files, const std::vector<u32>& pending_files,
+                         GameListEntry* entries, u8* entry_valid, u32 progress_base, ProgressCallback* progress)
+{
+  // the databases are loaded lazily, make sure that happens before the workers read them
+  LoadDatabase();
+  LoadCompatibilityList();
+  LoadGameSettings();
+
+  // opening images is mostly spent waiting on I/O, especially on network storage, so use more threads than cores
+  const u32 num_cpus = std::max<u32>(std::thread::hardware_concurrency(), 1);
+  const u32 num_threads = std::min<u32>(std::min<u32>(num_cpus * 2, MAX_SCAN_THREADS),
+                                        static_cast<u32>(pending_files.size()));
+  Log_DevPrintf("Scanning %zu files on %u threads", pending_files.size(), num_threads);
+
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  std::atomic<u32> next_file{0};
+  std::atomic_bool cancelled{false};
+  u32 files_done = 0;
+  u32 last_file_done = 0;
+
+  auto worker = [&]() {
+    for (;;)
+    {
+      const u32 pending_index = next_file.fetch_add(1);
+      if (pending_index >= pending_files.size() || cancelled.load())
+        break;
+
+      const u32 file_index = pending_files[pending_index];
+      entry_valid[file_index] = GetGameListEntry(files[file_index].FileName, &entries[file_index]);
+
+      std::unique_lock<std::mutex> lock(mutex);
+      files_done++;
+      last_file_done = file_index;
+      done_cv.notify_one();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (u32 i = 0; i < num_threads; i++)
+    threads.emplace_back(worker);
+
+  // progress is only reported from this thread, the callback is usually not thread safe
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    u32 reported_files = 0;
+    while (reported_files < static_cast<u32>(pending_files.size()) && !cancelled.load())
+    {
+      done_cv.wait(lock, [&]() { return (files_done != reported_files); });
+      reported_files = files_done;
+
+      const std::string& entry_path = files[last_file_done].FileName;
+      lock.unlock();
+
       const char* file_part_slash =
         std::max(std::strrchr(entry_path.c_str(), '/'), std::strrchr(entry_path.c_str(), '\\'));
       progress->SetFormattedStatusText("Scanning '%s'...",
                                        file_part_slash ? (file_part_slash + 1) : entry_path.c_str());
-      progress->IncrementProgressValue();
+      progress->SetProgressValue(progress_base + reported_files);
+      if (progress->IsCancelled())
+        cancelled.store(true);
 
-      if (GetGameListEntry(entry_path, &entry))
-      {
-        if (m_cache_write_stream || OpenCacheForWriting())
-        {
-          if (!WriteEntryToCache(&entry, m_cache_write_stream.get()))
-            Log_WarningPrintf("Failed to write entry '%s' to cache", entry.path.c_str());
-        }
-      }
-      else
-      {
-        continue;
-      }
+      lock.lock();
     }
-
-    m_entries.push_back(std::move(entry));
-    entry = {};
   }
 
-  progress->SetProgressValue(static_cast<u32>(files.size()));
-  progress->PopState();
+  for (std::thread& thread : threads)
+    thread.join();
 }
 
 class GameList::RedumpDatVisitor final : public tinyxml2::XMLVisitor
@@ -699,9 +751,13 @@ void GameList::Refresh(bool invalidate_cache, bool invalidate_database, Progress
     }
   }
 
-  // don't need unused cache entries
-  CloseCacheFileStream();
-  m_cache_map.clear();
+  // rewrite the index if anything was scanned, or if it has entries for files which no longer exist
+  if (m_cache_dirty || m_cache_hits != m_cache_record_count)
+    RewriteCacheFile();
+  else
+    CloseCache();
+
+  m_cache_dirty = false;
 }
 
 void GameList::UpdateCompatibilityEntry(GameListCompatibilityEntry new_entry, bool save_to_list /*= true*/)
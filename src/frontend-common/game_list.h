@@ -1,4 +1,6 @@
 #pragma once
+#include "common/file_system.h"
+#include "common/mapped_file.h"
 #include "core/types.h"
 #include "game_settings.h"
 #include <memory>
@@ -45,6 +47,7 @@ struct GameListEntry
   std::string code;
   std::string title;
   u64 total_size;
+  u64 file_size;
   u64 last_modified_time;
   DiscRegion region;
   GameListEntryType type;
@@ -108,11 +111,41 @@ private:
   enum : u32
   {
     GAME_LIST_CACHE_SIGNATURE = 0x45434C47,
-    GAME_LIST_CACHE_VERSION = 21
+    GAME_LIST_CACHE_VERSION = 22,
+    MAX_SCAN_THREADS = 16
   };
 
+  /// The cache is an index which is mapped into memory and searched in place. Records are sorted by path, and
+  /// strings/settings are stored as offsets into the data area which follows the records.
+  struct CacheIndexHeader
+  {
+    u32 signature;
+    u32 version;
+    u32 entry_count;
+    u32 data_size;
+  };
+
+  struct CacheIndexRecord
+  {
+    u64 file_size;
+    u64 last_modified_time;
+    u64 total_size;
+    u32 path_offset;
+    u32 path_length;
+    u32 code_offset;
+    u32 code_length;
+    u32 title_offset;
+    u32 title_length;
+    u32 settings_offset;
+    u32 settings_length;
+    u8 region;
+    u8 type;
+    u8 compatibility_rating;
+    u8 padding[5];
+  };
+  static_assert(sizeof(CacheIndexRecord) == 64, "cache index record is packed");
+
   using DatabaseMap = std::unordered_map<std::string, GameListDatabaseEntry>;
-  using CacheMap = std::unordered_map<std::string, GameListEntry>;
   using CompatibilityMap = std::unordered_map<std::string, GameListCompatibilityEntry>;
 
   struct DirectoryEntry
@@ -130,15 +163,20 @@ private:
   bool GetM3UListEntry(const char* path, GameListEntry* entry);
 
   bool GetGameListEntry(const std::string& path, GameListEntry* entry);
-  bool GetGameListEntryFromCache(const std::string& path, GameListEntry* entry);
+
+  /// Looks up an entry in the cache index, only returning it if the file size and modification time still match.
+  bool GetGameListEntryFromCache(const std::string& path, u64 file_size, u64 last_modified_time,
+                                 GameListEntry* entry);
+  std::string_view GetCacheString(u32 offset, u32 length) const;
+
   void ScanDirectory(const char* path, bool recursive, ProgressCallback* progress);
 
+  /// Opens the specified files on a pool of worker threads, filling in entries/entry_valid at the file's index.
+  void ScanFiles(const FileSystem::FindResultsArray& files, const std::vector<u32>& pending_files,
+                 GameListEntry* entries, u8* entry_valid, u32 progress_base, ProgressCallback* progress);
+
   void LoadCache();
-  bool LoadEntriesFromCache(ByteStream* stream);
-  bool OpenCacheForWriting();
-  bool WriteEntryToCache(const GameListEntry* entry, ByteStream* stream);
-  void FlushCacheFileStream();
-  void CloseCacheFileStream();
+  void CloseCache();
   void RewriteCacheFile();
   void DeleteCacheFile();
 
@@ -153,10 +191,15 @@ private:
 
   DatabaseMap m_database;
   EntryList m_entries;
-  CacheMap m_cache_map;
   CompatibilityMap m_compatibility_list;
   GameSettings::Database m_game_settings;
-  std::unique_ptr<ByteStream> m_cache_write_stream;
+
+  Common::MappedFile m_cache_file;
+  const CacheIndexRecord* m_cache_records = nullptr;
+  u32 m_cache_record_count = 0;
+  u32 m_cache_data_offset = 0;
+  u32 m_cache_hits = 0;
+  bool m_cache_dirty = false;
 
   std::vector<DirectoryEntry> m_search_directories;
   std::string m_cache_filename;
@@ -0,0 +1,171 @@
+#include "common/file_system.h"
+#include "common/log.h"
+#include "common/timer.h"
+#include "core/gpu_command_recording.h"
+#include "core/gpu_sw_backend.h"
+#include "core/settings.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static void PrintUsage(const char* progname)
+{
+  std::fprintf(stderr,
+               "Usage: %s [options] <recording.dsgr>\n"
+               "Replays a GPU command recording against the software renderer, reporting per-frame times.\n"
+               "\n"
+               "  -threads <n>      Number of software renderer worker threads (default 0).\n"
+               "  -scale <n>        Internal resolution scale (default 1).\n"
+               "  -gputhread        Process commands on a separate GPU thread.\n"
+               "  -loops <n>        Number of times to replay the recording (default 1).\n"
+               "  -quiet            Only print the summary, not per-frame times.\n"
+               "  -dumpvram <file>  Write the final native-resolution VRAM contents to a file.\n"
+               "  -verbose          Enable log output.\n",
+               progname);
+}
+
+static void UploadInitialVRAM(GPU_SW_Backend& backend, const GPUCommandRecording& recording)
+{
+  GPUBackendUpdateVRAMCommand* cmd = backend.NewUpdateVRAMCommand(VRAM_WIDTH * VRAM_HEIGHT);
+  cmd->params.bits = 0;
+  cmd->x = 0;
+  cmd->y = 0;
+  cmd->width = static_cast<u16>(VRAM_WIDTH);
+  cmd->height = static_cast<u16>(VRAM_HEIGHT);
+  std::memcpy(cmd->data, recording.GetInitialVRAM(), VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16));
+  backend.PushCommand(cmd);
+  backend.Sync();
+}
+
+static double ReplayFrame(GPU_SW_Backend& backend, const GPUCommandRecording& recording, u32 frame)
+{
+  Common::Timer timer;
+
+  const u8* ptr = recording.GetFrameCommandsStart(frame);
+  const u8* end = recording.GetFrameCommandsEnd(frame);
+  while (ptr < end)
+  {
+    const GPUBackendCommand* cmd = reinterpret_cast<const GPUBackendCommand*>(ptr);
+    backend.PushRecordedCommand(cmd);
+    ptr += cmd->size;
+  }
+
+  backend.Sync();
+  return timer.GetTimeMilliseconds();
+}
+
+int main(int argc, char* argv[])
+{
+  const char* filename = nullptr;
+  const char* dump_vram_filename = nullptr;
+  u32 num_threads = 0;
+  u32 resolution_scale = 1;
+  u32 num_loops = 1;
+  bool use_gpu_thread = false;
+  bool quiet = false;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+#define CHECK_ARG(str) !std::strcmp(argv[i], str)
+#define CHECK_ARG_PARAM(str) (!std::strcmp(argv[i], str) && ((i + 1) < argc))
+
+    if (CHECK_ARG_PARAM("-threads"))
+      num_threads = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    else if (CHECK_ARG_PARAM("-scale"))
+      resolution_scale = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    else if (CHECK_ARG_PARAM("-loops"))
+      num_loops = std::max<u32>(static_cast<u32>(std::strtoul(argv[++i], nullptr, 10)), 1u);
+    else if (CHECK_ARG_PARAM("-dumpvram"))
+      dump_vram_filename = argv[++i];
+    else if (CHECK_ARG("-gputhread"))
+      use_gpu_thread = true;
+    else if (CHECK_ARG("-quiet"))
+      quiet = true;
+    else if (CHECK_ARG("-verbose"))
+      verbose = true;
+    else if (argv[i][0] != '-' && !filename)
+      filename = argv[i];
+    else
+    {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+#undef CHECK_ARG_PARAM
+#undef CHECK_ARG
+  }
+
+  if (!filename)
+  {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Log::SetConsoleOutputParams(true, nullptr, verbose ? LOGLEVEL_INFO : LOGLEVEL_ERROR);
+
+  GPUCommandRecording recording;
+  if (!recording.LoadFromFile(filename))
+  {
+    std::fprintf(stderr, "Failed to load recording '%s'\n", filename);
+    return EXIT_FAILURE;
+  }
+
+  g_settings.gpu_use_thread = use_gpu_thread;
+  g_settings.gpu_sw_worker_threads = num_threads;
+  g_settings.gpu_resolution_scale = resolution_scale;
+
+  GPU_SW_Backend backend;
+  if (!backend.Initialize())
+  {
+    std::fprintf(stderr, "Failed to initialize software renderer\n");
+    return EXIT_FAILURE;
+  }
+
+  const u32 num_frames = recording.GetFrameCount();
+  std::printf("%s: %u frames, %u bytes of commands, scale %ux, %u worker threads%s\n", filename, num_frames,
+              recording.GetCommandDataSize(), backend.GetResolutionScale(), num_threads,
+              use_gpu_thread ? ", GPU thread" : "");
+
+  std::vector<double> frame_times;
+  frame_times.reserve(num_frames * num_loops);
+  for (u32 loop = 0; loop < num_loops; loop++)
+  {
+    backend.Reset();
+    UploadInitialVRAM(backend, recording);
+
+    for (u32 frame = 0; frame < num_frames; frame++)
+    {
+      const double frame_time = ReplayFrame(backend, recording, frame);
+      if (!quiet)
+        std::printf("loop %u frame %u: %.3f ms\n", loop, frame, frame_time);
+
+      frame_times.push_back(frame_time);
+    }
+  }
+
+  if (!frame_times.empty())
+  {
+    double total_time = 0.0;
+    for (const double frame_time : frame_times)
+      total_time += frame_time;
+
+    std::sort(frame_times.begin(), frame_times.end());
+    const double avg_time = total_time / static_cast<double>(frame_times.size());
+    std::printf("total %.3f ms, min %.3f ms, median %.3f ms, avg %.3f ms, max %.3f ms (%.2f fps)\n", total_time,
+                frame_times.front(), frame_times[frame_times.size() / 2], avg_time, frame_times.back(),
+                1000.0 / avg_time);
+  }
+
+  if (dump_vram_filename)
+  {
+    backend.DownsampleVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+    if (!FileSystem::WriteBinaryFile(dump_vram_filename, backend.GetVRAM(), VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16)))
+      std::fprintf(stderr, "Failed to write VRAM to '%s'\n", dump_vram_filename);
+  }
+
+  backend.Shutdown();
+  return EXIT_SUCCESS;
+}